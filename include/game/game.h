@@ -23,8 +23,13 @@ extern double g_accumulator;
 // --- Game functions ---
 
 bool            game_load(void);
+bool            game_loadStep(void);
+bool            game_isLoaded(void);
+bool            game_restoreReplay(void);
 void            game_input(void);
+void            game_runMainThreadTasks(void);
 void            game_update(double frameTime);
 void            game_draw(void);
+bool            game_isIdle(void);
 void            game_unload(void);
 game_Difficulty game_getDifficulty(void);
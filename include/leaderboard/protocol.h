@@ -0,0 +1,75 @@
+// clang-format Language: C
+#pragma once
+
+#include <runs/format.h>
+#include <stdint.h>
+#include <string.h>
+
+// Shared by the game and the leaderboard daemon. Every message is a header followed by size bytes. A submit is a
+// count and then each run, with its replay's bytes straight after it when it has one. The daemon answers a submit with
+// an ack and a query with the top runs. Both ends are expected to have the same endianness.
+
+// --- Constants ---
+
+static const char  LEADERBOARD_MAGIC[4]    = { 'M', 'D', 'L', 'B' };
+constexpr uint32_t LEADERBOARD_VERSION     = 1;
+constexpr uint16_t LEADERBOARD_PORT        = 7878;
+constexpr uint32_t LEADERBOARD_MAX_MESSAGE = 16 * 1024 * 1024;
+constexpr int      LEADERBOARD_MAX_TOP     = 100;  // Runs the daemon keeps under each key
+
+// --- Types ---
+
+typedef enum leaderboard_Type {
+  LEADERBOARD_SUBMIT = 1,
+  LEADERBOARD_ACK,
+  LEADERBOARD_QUERY,
+  LEADERBOARD_TOP
+} leaderboard_Type;
+
+typedef struct leaderboard_Header {
+  char     magic[4];
+  uint32_t version;
+  uint32_t type;
+  uint32_t size;
+} leaderboard_Header;
+
+typedef struct leaderboard_Run {
+  runs_Record record;
+  uint32_t    replaySize;
+  uint32_t    reserved;
+} leaderboard_Run;
+
+typedef struct leaderboard_Ack {
+  uint32_t accepted;  // Runs that passed the daemon's checks, the rest were dropped
+  uint32_t reserved;
+} leaderboard_Ack;
+
+// Player is RUNS_ALL_PLAYERS for everyone, level RUNS_FULL_RUN for whole runs
+typedef struct leaderboard_Query {
+  uint32_t player;
+  uint16_t level;
+  uint8_t  difficulty;
+  uint8_t  sort;
+  uint32_t count;
+  uint32_t reserved;
+} leaderboard_Query;
+
+// Followed by count runs, best first
+typedef struct leaderboard_Top {
+  uint32_t count;
+  uint32_t total;  // Runs ever submitted under the key
+} leaderboard_Top;
+
+static_assert(sizeof(leaderboard_Header) == 16, "leaderboard_Header must match the wire format");
+static_assert(sizeof(leaderboard_Run) == 40, "leaderboard_Run must match the wire format");
+static_assert(sizeof(leaderboard_Ack) == 8, "leaderboard_Ack must match the wire format");
+static_assert(sizeof(leaderboard_Query) == 16, "leaderboard_Query must match the wire format");
+static_assert(sizeof(leaderboard_Top) == 8, "leaderboard_Top must match the wire format");
+
+// --- Protocol functions ---
+
+// Checked by both ends before trusting a header's type or size
+static inline bool leaderboard_isValidHeader(const leaderboard_Header* header) {
+  return memcmp(header->magic, LEADERBOARD_MAGIC, sizeof(header->magic)) == 0 &&
+         header->version == LEADERBOARD_VERSION && header->size <= LEADERBOARD_MAX_MESSAGE;
+}
@@ -0,0 +1,48 @@
+// clang-format Language: C
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Shared by the game's leaderboard client and metrics endpoint and by the leaderboard daemon, so every address is
+// given the same way: "HOST:PORT", "[IPV6]:PORT" or just "PORT", which is on this machine.
+
+// --- Constants ---
+
+constexpr size_t NET_HOST_LENGTH = 256;
+constexpr size_t NET_PORT_LENGTH = 8;
+
+static const char NET_DEFAULT_HOST[] = "127.0.0.1";  // Nothing is reachable from elsewhere unless a host is given
+
+// --- Types ---
+
+typedef struct net_Address {
+  char host[NET_HOST_LENGTH];
+  char port[NET_PORT_LENGTH];
+} net_Address;
+
+// --- Address functions ---
+
+// False if the port isn't a number from 1 to 65535 or the host is too long
+static inline bool net_parseAddress(const char* text, net_Address* address) {
+  const char* colon      = strrchr(text, ':');
+  const char* host       = NET_DEFAULT_HOST;
+  size_t      hostLength = sizeof(NET_DEFAULT_HOST) - 1;
+  const char* port       = text;
+  if (colon != nullptr && colon > text) {
+    bool isBracketed = text[0] == '[' && colon[-1] == ']';
+    host             = isBracketed ? text + 1 : text;
+    hostLength       = isBracketed ? (size_t) (colon - text) - 2 : (size_t) (colon - text);
+    port             = colon + 1;
+  } else if (colon != nullptr) {
+    port = colon + 1;
+  }
+
+  char* end    = nullptr;
+  long  number = strtol(port, &end, 10);
+  if (*port == '\0' || *end != '\0' || number < 1 || number > 65535 || hostLength >= NET_HOST_LENGTH) return false;
+  snprintf(address->host, sizeof(address->host), "%.*s", (int) hostLength, host);
+  snprintf(address->port, sizeof(address->port), "%ld", number);
+  return true;
+}
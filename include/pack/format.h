@@ -0,0 +1,60 @@
+// clang-format Language: C
+#pragma once
+
+#include <stdint.h>
+
+// Shared by the game and the packer: a header, an index sorted by name, then each entry's bytes. Offsets are aligned
+// so the pack can be mapped into memory and entries used in place. Sounds and images are stored decoded, so they're
+// used in place too rather than decoded at startup.
+
+// --- Constants ---
+
+static const char  PACK_MAGIC[4]    = { 'M', 'D', 'P', 'K' };
+constexpr uint32_t PACK_VERSION     = 2;
+constexpr uint32_t PACK_ALIGNMENT   = 64;
+constexpr int      PACK_NAME_LENGTH = 52;
+
+// --- Types ---
+
+typedef struct pack_Header {
+  char     magic[4];
+  uint32_t version;
+  uint32_t entryCount;
+  uint32_t reserved;
+} pack_Header;
+
+// An image is packed both as its file, for the engine to load by name, and decoded
+typedef enum pack_Type {
+  PACK_FILE,   // The file's bytes as they are
+  PACK_WAVE,   // A pack_Wave then the samples
+  PACK_IMAGE,  // A pack_Image then the pixels
+  PACK_TYPE_COUNT
+} pack_Type;
+
+// Names are relative to the asset directory with forward slashes, e.g. "gfx/player.png". Sorted by name then type.
+typedef struct pack_Entry {
+  char     name[PACK_NAME_LENGTH];
+  uint32_t type;    // A pack_Type
+  uint32_t offset;  // From the start of the pack
+  uint32_t size;
+} pack_Entry;
+
+// As raylib's Wave
+typedef struct pack_Wave {
+  uint32_t frameCount;
+  uint32_t sampleRate;
+  uint32_t sampleSize;  // Bits per sample
+  uint32_t channels;
+} pack_Wave;
+
+// Always R8G8B8A8 with no mipmaps
+typedef struct pack_Image {
+  uint32_t width;
+  uint32_t height;
+  uint32_t reserved[2];
+} pack_Image;
+
+static_assert(sizeof(pack_Header) == 16, "pack_Header must match the file layout");
+static_assert(sizeof(pack_Entry) == 64, "pack_Entry must match the file layout");
+static_assert(sizeof(pack_Wave) == 16, "pack_Wave must match the file layout");
+static_assert(sizeof(pack_Image) == 16, "pack_Image must match the file layout");
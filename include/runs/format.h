@@ -0,0 +1,77 @@
+// clang-format Language: C
+#pragma once
+
+#include <stdint.h>
+
+// Shared by the game and the tools. The run log is a header and then fixed size records, only ever appended to. The
+// index is a header, a table of keys sorted by (player, difficulty, level, sort) and then each key's record numbers,
+// best first. Records past the index's record count haven't been indexed yet.
+
+// --- Constants ---
+
+static const char  RUNS_MAGIC[4]       = { 'M', 'D', 'R', 'N' };
+static const char  RUNS_INDEX_MAGIC[4] = { 'M', 'D', 'R', 'I' };
+constexpr uint32_t RUNS_VERSION        = 1;
+constexpr uint16_t RUNS_FULL_RUN       = 0xffff;  // Level of a run through every level
+constexpr uint32_t RUNS_ALL_PLAYERS    = 0;       // Player of the keys that index every player's runs
+
+// --- Types ---
+
+typedef enum runs_Sort { RUNS_SORT_TIME, RUNS_SORT_SCORE, RUNS_SORT_COUNT } runs_Sort;
+
+typedef struct runs_Header {
+  char     magic[4];
+  uint32_t version;
+  uint32_t recordSize;
+  uint32_t reserved;
+} runs_Header;
+
+typedef struct runs_Record {
+  int64_t  date;  // Unix time the run finished
+  double   time;
+  int32_t  score;
+  int32_t  lives;
+  uint32_t player;  // Hash of the player's name, never RUNS_ALL_PLAYERS
+  uint16_t level;
+  uint8_t  difficulty;
+  uint8_t  reserved;
+} runs_Record;
+
+typedef struct runs_IndexHeader {
+  char     magic[4];
+  uint32_t version;
+  uint32_t recordCount;  // Records covered by the index
+  uint32_t keyCount;
+} runs_IndexHeader;
+
+typedef struct runs_Key {
+  uint32_t player;
+  uint16_t level;
+  uint8_t  difficulty;
+  uint8_t  sort;
+  uint32_t first;  // Into the record numbers after the key table
+  uint32_t count;
+} runs_Key;
+
+static_assert(sizeof(runs_Header) == 16, "runs_Header must match the file layout");
+static_assert(sizeof(runs_Record) == 32, "runs_Record must match the file layout");
+static_assert(sizeof(runs_IndexHeader) == 16, "runs_IndexHeader must match the file layout");
+static_assert(sizeof(runs_Key) == 16, "runs_Key must match the file layout");
+
+// --- Order functions ---
+
+// Negative when the first result is better. Fastest or highest first, each breaking a tie with the other.
+static inline int runs_compareResults(runs_Sort sort, double timeA, int scoreA, double timeB, int scoreB) {
+  int byTime  = (timeA > timeB) - (timeA < timeB);
+  int byScore = (scoreA < scoreB) - (scoreA > scoreB);
+  if (sort == RUNS_SORT_TIME) return byTime != 0 ? byTime : byScore;
+  return byScore != 0 ? byScore : byTime;
+}
+
+// The earlier run wins a tie, so the order stays put as the log grows
+static inline int runs_compareRecords(const runs_Record records[], runs_Sort sort, uint32_t a, uint32_t b) {
+  const runs_Record* recordA = &records[a];
+  const runs_Record* recordB = &records[b];
+  int                result  = runs_compareResults(sort, recordA->time, recordA->score, recordB->time, recordB->score);
+  return result != 0 ? result : (a > b) - (a < b);
+}
@@ -0,0 +1,79 @@
+// clang-format Language: C
+#pragma once
+
+#include <stdint.h>
+
+// Shared by the game and the tools. Telemetry is a directory of segment files, each a header and then its events
+// compressed as a raw DEFLATE stream. Events are in time order within a run, merged from the game's threads.
+
+// --- Constants ---
+
+static const char  TELEMETRY_MAGIC[4] = { 'M', 'D', 'T', 'L' };
+constexpr uint32_t TELEMETRY_VERSION  = 1;
+constexpr uint8_t  TELEMETRY_NO_TILE  = 0xff;  // Column and row of events that didn't happen anywhere
+constexpr uint8_t  TELEMETRY_NO_STATE = 0xff;  // Creature state before the first one
+
+// --- Types ---
+
+typedef enum telemetry_Compression { TELEMETRY_STORED, TELEMETRY_DEFLATE } telemetry_Compression;
+
+// Subject and detail are as described for each type
+typedef enum telemetry_Type {
+  TELEMETRY_RUN_START,  // A new game, numbering a new run
+  TELEMETRY_LEVEL_START,
+  TELEMETRY_LEVEL_CLEAR,
+  TELEMETRY_GAME_OVER,
+  TELEMETRY_GAME_WON,
+  TELEMETRY_PICKUP,           // Subject is a telemetry_Pickup
+  TELEMETRY_DEATH,            // Subject is a telemetry_Death, detail the creature's id if it was one
+  TELEMETRY_CREATURE_STATE,   // Subject is the telemetry_State entered, detail the one left
+  TELEMETRY_CREATURE_KILLED,  // Subject is the creature's id
+  TELEMETRY_CHEST_SPAWN,      // Subject is which of the level's chests it was
+  TELEMETRY_TELEPORT,         // Subject is 1 for the player, 0 for a creature, the tile is the one teleported from
+  TELEMETRY_TILE,             // The player entering a tile, first sent as they start moving after each (re)start
+  TELEMETRY_TYPE_COUNT
+} telemetry_Type;
+
+typedef enum telemetry_Pickup {
+  TELEMETRY_PICKUP_COIN,
+  TELEMETRY_PICKUP_SWORD,
+  TELEMETRY_PICKUP_CHEST,
+  TELEMETRY_PICKUP_KEY
+} telemetry_Pickup;
+
+typedef enum telemetry_Death { TELEMETRY_DEATH_CREATURE, TELEMETRY_DEATH_TRAP, TELEMETRY_DEATH_FALL } telemetry_Death;
+
+typedef enum telemetry_State {
+  TELEMETRY_STATE_PEN,
+  TELEMETRY_STATE_PEN_TO_START,
+  TELEMETRY_STATE_START_TO_PEN,
+  TELEMETRY_STATE_FRIGHTENED,
+  TELEMETRY_STATE_DEAD,
+  TELEMETRY_STATE_CHASE,
+  TELEMETRY_STATE_SCATTER
+} telemetry_State;
+
+typedef struct telemetry_SegmentHeader {
+  char     magic[4];
+  uint32_t version;
+  uint32_t eventSize;
+  uint32_t eventCount;
+  uint32_t compression;  // A telemetry_Compression, stored when the events wouldn't compress
+  uint32_t dataSize;     // Bytes after the header
+} telemetry_SegmentHeader;
+
+typedef struct telemetry_Event {
+  float    time;  // Seconds since the run started, in game time so replays reproduce it
+  uint32_t run;   // Numbered from the start of the session
+  uint8_t  type;
+  uint8_t  subject;
+  uint8_t  detail;
+  uint8_t  level;
+  uint8_t  difficulty;
+  uint8_t  col;
+  uint8_t  row;
+  uint8_t  reserved;
+} telemetry_Event;
+
+static_assert(sizeof(telemetry_SegmentHeader) == 24, "telemetry_SegmentHeader must match the file layout");
+static_assert(sizeof(telemetry_Event) == 16, "telemetry_Event must match the file layout");
@@ -8,6 +8,7 @@
 #include <stdlib.h>  // malloc, free
 #include "../internal.h"
 #include "../maze/maze.h"
+#include "../trace/trace.h"
 #include "internal.h"
 
 // --- Constants ---
@@ -159,8 +160,7 @@ bool actor_isColliding(const game_Actor* actor1, const game_Actor* actor2) {
   Vector2 centreActor2 = Vector2AddValue(actor2->pos, ACTOR_SIZE / 2.0f);
   bool    isCollision  = Vector2Distance(centreActor1, centreActor2) < ACTOR_SIZE;
   if (isCollision)
-    LOG_TRACE(
-        game_log,
+    TRACE(
         "Collision detected between actor1 (%f, %f) and actor2 (%f, %f)",
         actor1->pos.x,
         actor1->pos.y,
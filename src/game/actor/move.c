@@ -4,6 +4,8 @@
 #include <stddef.h>
 #include "../internal.h"
 #include "../maze/maze.h"
+#include "../telemetry/telemetry.h"
+#include "../trace/trace.h"
 #include "actor.h"
 #include "internal.h"
 #include "log/log.h"
@@ -77,14 +79,7 @@ static void checkMazeCollision(game_Actor* actor) {
   if (tile != nullptr) {
     Vector2 oldPos = actor->pos;
     resolveActorCollision(actor, &tile->aabb);
-    LOG_TRACE(
-        game_log,
-        "Collision detected, actor moved from: %f, %f to: %f, %f",
-        oldPos.x,
-        oldPos.y,
-        actor->pos.x,
-        actor->pos.y
-    );
+    TRACE("Collision detected, actor moved from: %f, %f to: %f, %f", oldPos.x, oldPos.y, actor->pos.x, actor->pos.y);
     actor->isMoving = false;
   }
 }
@@ -180,8 +175,7 @@ static bool tryAlignToTile(game_Actor* actor, game_Dir dir, game_AABB actorAABB,
     case DIR_DOWN:
       if (overlapX > OVERLAP_EPSILON && overlapX <= slop && fabsf(overlapY) < OVERLAP_EPSILON) {
         alignToPassage(actor, dir, &tileAABB);
-        LOG_TRACE(
-            game_log,
+        TRACE(
             "Actor can move %s, moved from %f, %f, to: %f, %f, slop: %f",
             DIR_STRINGS[dir],
             oldPos.x,
@@ -197,8 +191,7 @@ static bool tryAlignToTile(game_Actor* actor, game_Dir dir, game_AABB actorAABB,
     case DIR_RIGHT:
       if (overlapY > OVERLAP_EPSILON && overlapY <= slop && fabsf(overlapX) < OVERLAP_EPSILON) {
         alignToPassage(actor, dir, &tileAABB);
-        LOG_TRACE(
-            game_log,
+        TRACE(
             "Actor can move %s, moved from %f, %f, to: %f, %f, slop: %f",
             DIR_STRINGS[dir],
             oldPos.x,
@@ -279,12 +272,11 @@ static void checkTeleport(game_Actor* actor, game_Dir dir) {
       (dir == DIR_DOWN && maze_isTeleport(actor->pos, &destPos)) ||
       (dir == DIR_LEFT && maze_isTeleport((Vector2) { actor->pos.x + actor->size.x - 1, actor->pos.y }, &destPos))) {
     if (!actor->hasTeleported) {
-      LOG_TRACE(
-          game_log, "Teleporting actor from %.2f, %.2f to %.2f, %.2f", actor->pos.x, actor->pos.y, destPos.x, destPos.y
-      );
+      TRACE("Teleporting actor from %.2f, %.2f to %.2f, %.2f", actor->pos.x, actor->pos.y, destPos.x, destPos.y);
+      TELEMETRY_EVENT(TELEMETRY_TELEPORT, actor->isPlayer, 0, maze_getTile(actor->pos));
       if (maze_reverseAfterTeleport()) {
         actor->dir = game_getOppositeDir(actor->dir);
-        LOG_TRACE(game_log, "Reversing actor's direction");
+        TRACE("Reversing actor's direction");
       }
       actor->pos           = destPos;
       actor->hasTeleported = true;
@@ -315,7 +307,7 @@ bool actor_canMove(game_Actor* actor, game_Dir dir, float slop) {
   if (!actor->isMoving && canMove) actor->isMoving = true;
 
   if (canMove) {
-    LOG_TRACE(game_log, "Actor can move: %s, pos: %f, %f", DIR_STRINGS[dir], actor->pos.x, actor->pos.y);
+    TRACE("Actor can move: %s, pos: %f, %f", DIR_STRINGS[dir], actor->pos.x, actor->pos.y);
   }
 
   return canMove;
@@ -1,12 +1,15 @@
 #include "asset.h"
 #include <assert.h>
 #include <engine/engine.h>
+#include <log/log.h>
 #include <raylib.h>
+#include "../audio/audio.h"
 #include "../creature/creature.h"
 #include "../internal.h"
 #include "../maze/maze.h"
-#include "../options/options.h"
+#include "../metrics/metrics.h"
 #include "../player/player.h"
+#include "../startup/startup.h"
 #include "internal.h"
 
 // --- Global state ---
@@ -15,83 +18,199 @@ static asset_Assets g_assets;
 
 // --- Helper functions
 
-static bool loadSound(asset_Sound soundData, engine_Sound** sound) {
-  GAME_TRY(*sound = engine_loadSound(soundData.filepath, MAX_SOUNDS));
-  float soundVolume = options_getSfxVolume() * soundData.volume;
-  engine_setSoundVolume(*sound, soundVolume);
-  engine_setSoundPitch(*sound, soundData.pitch);
-  return true;
+static void destroyCreatures(void) {
+  for (int i = 0; i < CREATURE_COUNT; i++) {
+    for (int j = 0; j < DIR_COUNT; j++) {
+      if (g_assets.creatureAnims[i][j] != nullptr) render_destroyAnim(&g_assets.creatureAnims[i][j]);
+    }
+    if (g_assets.creatureSprites[i] != nullptr) render_destroySprite(&g_assets.creatureSprites[i]);
+  }
+  g_assets.creatureLevel = -1;
 }
 
-static bool loadMusic(const asset_Music musicData, engine_Music** music) {
-  GAME_TRY(*music = engine_loadMusic(musicData.filepath));
-  float musicVolume  = options_getMusicVolume();
-  float finalVolume  = musicVolume * musicData.volume;
-  float duckedVolume = musicVolume * musicData.duckedVolume;
-  engine_setMusicDucking(*music, finalVolume, duckedVolume, FADE_IN_RATE, FADE_OUT_RATE);
-  return true;
+static inline int getCreatureSlot(int creatureID) {
+  assert(creatureID >= 0 && creatureID < CREATURE_COUNT * MAX_LEVELS);
+  assert(creatureID / CREATURE_COUNT == g_assets.creatureLevel);
+  return creatureID % CREATURE_COUNT;
 }
 
-// --- Asset functions ---
+static bool loadTexture(const char* file, engine_Texture** texture) {
+  int timer = startup_begin("Texture %s", GetFileName(file));
+  *texture  = render_textureLoad(file);
+  startup_end(timer);
+  return *texture != nullptr;
+}
 
-bool asset_load(void) {
-  GAME_TRY(g_assets.logo = engine_textureLoad(FILE_LOGO));
-  GAME_TRY(g_assets.creatureSpriteSheet = engine_textureLoad(FILE_CREATURES));
-  GAME_TRY(g_assets.playerSpriteSheet = engine_textureLoad(FILE_PLAYER));
-  g_assets.cursorSpriteSheet = maze_getTileSet();
-  GAME_TRY(g_assets.font = engine_fontLoad(FILE_FONT, 6, 10, 32, 160, 0, 2));
-  GAME_TRY(g_assets.fontTiny = engine_fontLoad(FILE_FONT_TINY, 5, 7, 48, 57, 0, 0));
-  for (int i = 0; i < WAIL_SOUND_COUNT; i++) {
-    GAME_TRY(loadSound(WAIL_SOUNDS[i], &g_assets.wailSounds[i]));
+static bool loadFont(
+    const char* file, engine_Font** font, int glyphWidth, int glyphHeight, int firstChar, int lastChar, int xSpacing,
+    int ySpacing
+) {
+  int timer = startup_begin("Font %s", GetFileName(file));
+  *font     = render_fontLoad(file, glyphWidth, glyphHeight, firstChar, lastChar, xSpacing, ySpacing);
+  startup_end(timer);
+  return *font != nullptr;
+}
+
+// What the audio device holds of the sound's samples, converted to its format
+static inline long long getSoundSize(Sound sound) {
+  return (long long) sound.frameCount * sound.stream.channels * sound.stream.sampleSize / 8;
+}
+
+static void keepWave(Sound sound, Wave wave) {
+  if (!g_assets.isKeepingWaves || sound.stream.buffer == nullptr || g_assets.soundWaveCount == MAX_SOUND_WAVES) {
+    asset_unloadWave(wave);
+    return;
+  }
+  g_assets.soundWaves[g_assets.soundWaveCount++] = (asset_SoundWave) { .buffer = sound.stream.buffer, .wave = wave };
+}
+
+static Sound makeSound(Wave wave) {
+  audio_lockEngine();
+  Sound sound = LoadSoundFromWave(wave);
+  audio_unlockEngine();
+  if (sound.stream.buffer != nullptr) metrics_add(METRICS_MEMORY_SOUNDS, getSoundSize(sound));
+  return sound;
+}
+
+static void addSoundLoad(asset_Sound soundData, const float* pitches, int count, Sound* sounds) {
+  assert(g_assets.soundLoadCount < SOUND_FILE_COUNT);
+  assert(count > 0 && count <= MAX_PITCHES);
+  g_assets.soundLoads[g_assets.soundLoadCount++] = (asset_SoundLoad) {
+    .data = soundData, .pitches = pitches, .pitchCount = count, .sounds = sounds
+  };
+}
+
+// The file was decoded and resampled to its pitches in the background, so this only hands the samples to the audio
+// device. Each pitch gets the voices that play it, so playing never makes an alias or sets a pitch.
+static bool loadSounds(int load) {
+  const asset_SoundLoad* soundLoad = &g_assets.soundLoads[load];
+  const char*            file      = soundLoad->data.filepath;
+  Wave                   waves[MAX_PITCHES];
+  if (!asset_takeWaves(load, waves)) {
+    LOG_ERROR(game_log, "Failed to decode sound %s", file);
+    return false;
+  }
+
+  int timer = startup_begin("Sound %s", GetFileName(file));
+  for (int i = 0; i < soundLoad->pitchCount; i++) {
+    soundLoad->sounds[i] = makeSound(waves[i]);
+    keepWave(soundLoad->sounds[i], waves[i]);
+  }
+  startup_end(timer);
+
+  for (int i = 0; i < soundLoad->pitchCount; i++) {
+    if (soundLoad->sounds[i].stream.buffer == nullptr) {
+      LOG_ERROR(game_log, "Failed to load sound %s", file);
+      return false;
+    }
+    GAME_TRY(audio_bindVoices(soundLoad->sounds[i], soundLoad->data.voices));
   }
-  GAME_TRY(loadSound(CHIME_SOUND, &g_assets.chimeSound));
-  GAME_TRY(loadSound(DEATH_SOUND, &g_assets.deathSound));
-  GAME_TRY(loadSound(FALLING_SOUND, &g_assets.fallingSound));
-  GAME_TRY(loadSound(WHISPERS_SOUND, &g_assets.whispersSound));
-  GAME_TRY(loadSound(PICKUP_SOUND, &g_assets.pickupSound));
-  GAME_TRY(loadSound(PICKUP_SOUND, &g_assets.pickupSound));
-  GAME_TRY(loadSound(TWINKLE_SOUND, &g_assets.twinkleSound));
-  GAME_TRY(loadSound(WIN_SOUND, &g_assets.winSound));
-  GAME_TRY(loadSound(GAME_OVER_SOUND, &g_assets.gameOverSound));
-  GAME_TRY(loadSound(LIFE_SOUND, &g_assets.lifeSound));
-  GAME_TRY(loadSound(RES_SOUND, &g_assets.resSound));
-  GAME_TRY(loadMusic(MUSIC, &g_assets.music));
   return true;
 }
 
-void asset_unload(void) {
-  engine_unloadMusic(&g_assets.music);
-  engine_unloadSound(&g_assets.resSound);
-  engine_unloadSound(&g_assets.lifeSound);
-  engine_unloadSound(&g_assets.gameOverSound);
-  engine_unloadSound(&g_assets.winSound);
-  engine_unloadSound(&g_assets.twinkleSound);
-  engine_unloadSound(&g_assets.pickupSound);
-  engine_unloadSound(&g_assets.whispersSound);
-  engine_unloadSound(&g_assets.fallingSound);
-  engine_unloadSound(&g_assets.deathSound);
-  engine_unloadSound(&g_assets.chimeSound);
-  for (int i = 0; i < WAIL_SOUND_COUNT; i++) {
-    engine_unloadSound(&g_assets.wailSounds[i]);
+static void unloadSound(Sound* sound) {
+  if (sound->stream.buffer == nullptr) return;
+
+  for (int i = 0; i < g_assets.soundWaveCount; i++) {
+    if (g_assets.soundWaves[i].buffer == sound->stream.buffer) {
+      asset_unloadWave(g_assets.soundWaves[i].wave);
+      g_assets.soundWaves[i] = g_assets.soundWaves[--g_assets.soundWaveCount];
+      break;
+    }
   }
-  engine_fontUnload(&g_assets.font);
-  engine_textureUnload(&g_assets.playerSpriteSheet);
-  engine_textureUnload(&g_assets.creatureSpriteSheet);
-  engine_textureUnload(&g_assets.logo);
+  metrics_add(METRICS_MEMORY_SOUNDS, -getSoundSize(*sound));
+  audio_lockEngine();
+  UnloadSound(*sound);
+  audio_unlockEngine();
+  *sound = (Sound) {};
+}
+
+// --- Asset functions ---
+
+// Everything the title screen and its menu need
+bool asset_loadTitle(void) {
+  GAME_TRY(loadTexture(FILE_LOGO, &g_assets.logo));
+  GAME_TRY(loadFont(FILE_FONT, &g_assets.font, 6, 10, 32, 160, 0, 2));
+  GAME_TRY(loadFont(FILE_FONT_TINY, &g_assets.fontTiny, 5, 7, 48, 57, 0, 0));
+  return true;
+}
+
+void asset_unloadTitle(void) {
+  render_fontUnload(&g_assets.font);
+  render_fontUnload(&g_assets.fontTiny);
+  render_textureUnload(&g_assets.logo);
+}
+
+bool asset_loadSprites(void) {
+  GAME_TRY(loadTexture(FILE_CREATURES, &g_assets.creatureSpriteSheet));
+  GAME_TRY(loadTexture(FILE_PLAYER, &g_assets.playerSpriteSheet));
+  return true;
+}
+
+void asset_unloadSprites(void) {
+  render_textureUnload(&g_assets.playerSpriteSheet);
+  render_textureUnload(&g_assets.creatureSpriteSheet);
+}
+
+// Starts every sound file decoding in the background, for asset_loadSounds() to load once they're done
+bool asset_decodeSounds(void) {
+  static const float UNPITCHED = 1.0f;
+
+  g_assets.soundLoadCount = 0;
+  for (int i = 0; i < WAIL_SOUND_COUNT; i++) addSoundLoad(WAIL_SOUNDS[i], &UNPITCHED, 1, &g_assets.wailSounds[i]);
+  addSoundLoad(CHIME_SOUND, CHIME_PITCHES, CHIME_PITCH_COUNT, g_assets.chimeSounds);
+  addSoundLoad(DEATH_SOUND, &UNPITCHED, 1, &g_assets.deathSound);
+  addSoundLoad(FALLING_SOUND, &UNPITCHED, 1, &g_assets.fallingSound);
+  addSoundLoad(WHISPERS_SOUND, &UNPITCHED, 1, &g_assets.whispersSound);
+  addSoundLoad(PICKUP_SOUND, &UNPITCHED, 1, &g_assets.pickupSound);
+  addSoundLoad(TWINKLE_SOUND, &UNPITCHED, 1, &g_assets.twinkleSound);
+  addSoundLoad(WIN_SOUND, &UNPITCHED, 1, &g_assets.winSound);
+  addSoundLoad(GAME_OVER_SOUND, &UNPITCHED, 1, &g_assets.gameOverSound);
+  addSoundLoad(LIFE_SOUND, &UNPITCHED, 1, &g_assets.lifeSound);
+  addSoundLoad(RES_SOUND, &UNPITCHED, 1, &g_assets.resSound);
+  asset_startDecoding(g_assets.soundLoads, g_assets.soundLoadCount);
+  return true;
+}
+
+// Frees whatever was decoded but never loaded, so is safe if loading failed or the game closed part way through
+void asset_stopDecodingSounds(void) { asset_stopDecoding(); }
+
+// False while the files are still decoding, loading the sounds would then wait
+bool asset_areSoundsDecoded(void) { return asset_isDecoded(); }
+
+bool asset_loadSounds(void) {
+  for (int i = 0; i < g_assets.soundLoadCount; i++) GAME_TRY(loadSounds(i));
+  asset_stopDecoding();
+  return true;
+}
+
+void asset_unloadSounds(void) {
+  unloadSound(&g_assets.resSound);
+  unloadSound(&g_assets.lifeSound);
+  unloadSound(&g_assets.gameOverSound);
+  unloadSound(&g_assets.winSound);
+  unloadSound(&g_assets.twinkleSound);
+  unloadSound(&g_assets.pickupSound);
+  unloadSound(&g_assets.whispersSound);
+  unloadSound(&g_assets.fallingSound);
+  unloadSound(&g_assets.deathSound);
+  for (int i = 0; i < CHIME_PITCH_COUNT; i++) unloadSound(&g_assets.chimeSounds[i]);
+  for (int i = 0; i < WAIL_SOUND_COUNT; i++) unloadSound(&g_assets.wailSounds[i]);
 }
 
 bool asset_initPlayer(void) {
   GAME_TRY(player_init());
 
+  int timer = startup_begin("Player sprites and anims");
   for (int i = 0; i < PLAYER_STATE_COUNT; i++) {
     GAME_TRY(
-        g_assets.playerSprites[i] = engine_createSprite(
+        g_assets.playerSprites[i] = render_createSprite(
             POS_ADJUST(player_getPos()), (Vector2) { ACTOR_SIZE, ACTOR_SIZE }, (Vector2) { 0.0f, 0.0f }
         )
     );
     for (int j = 0; j < DIR_COUNT; j++) {
       GAME_TRY(
-          g_assets.playerAnim[i][j] = engine_createAnim(
+          g_assets.playerAnim[i][j] = render_createAnim(
               g_assets.playerSprites[i],
               PLAYER_DATA[i].animData[j].row,
               PLAYER_DATA[i].animData[j].startCol,
@@ -107,7 +226,7 @@ bool asset_initPlayer(void) {
   Vector2 offset = PLAYER_LIVES_OFFSET;
   for (int i = 0; i < PLAYER_MAX_LIVES; i++) {
     GAME_TRY(
-        g_assets.playerLivesSprites[i] = engine_createSpriteFromSheet(
+        g_assets.playerLivesSprites[i] = render_createSpriteFromSheet(
             offset,
             (Vector2) { ACTOR_SIZE, ACTOR_SIZE },
             PLAYER_DATA[PLAYER_NORMAL].animData[DIR_LEFT].row,
@@ -119,7 +238,7 @@ bool asset_initPlayer(void) {
   }
 
   GAME_TRY(
-      g_assets.playerNextLifeSprite = engine_createSpriteFromSheet(
+      g_assets.playerNextLifeSprite = render_createSpriteFromSheet(
           PLAYER_NEXT_LIFE_OFFSET,
           (Vector2) { ACTOR_SIZE, ACTOR_SIZE },
           PLAYER_DATA[PLAYER_NORMAL].animData[DIR_LEFT].row,
@@ -127,52 +246,77 @@ bool asset_initPlayer(void) {
           PLAYER_DATA[PLAYER_NORMAL].inset
       )
   );
+  startup_end(timer);
 
   return true;
 }
 
+// Creature visuals are made per level by asset_loadCreatures()
 bool asset_initCreatures(void) {
-  GAME_TRY(creature_init());
-  for (int i = 0; i < CREATURE_TOTAL; i++) {
-    Vector2 null = { 0.0f, 0.0f };
-    GAME_TRY(g_assets.creatureSprites[i] = engine_createSprite(null, CREATURE_DATA[i].size, null));
+  g_assets.creatureLevel = -1;
+  return creature_init();
+}
+
+// Swaps in the level's creature sprites and anims, only one level's worth exist at a time
+bool asset_loadCreatures(int level) {
+  assert(level >= 0 && level < MAX_LEVELS);
+  if (level == g_assets.creatureLevel) return true;
+
+  destroyCreatures();
+  for (int i = 0; i < CREATURE_COUNT; i++) {
+    const asset_ActorData* data = &CREATURE_DATA[(i + level * CREATURE_COUNT) % CREATURE_TOTAL];
+    Vector2                null = { 0.0f, 0.0f };
+
+    g_assets.creatureSprites[i] = render_createSprite(null, data->size, null);
+    if (g_assets.creatureSprites[i] == nullptr) {
+      destroyCreatures();
+      return false;
+    }
     for (int j = 0; j < DIR_COUNT; j++) {
-      GAME_TRY(
-          g_assets.creatureAnims[i][j] = engine_createAnim(
-              g_assets.creatureSprites[i],
-              CREATURE_DATA[i].animData[j].row,
-              CREATURE_DATA[i].animData[j].startCol,
-              CREATURE_DATA[i].animData[j].frameCount,
-              CREATURE_DATA[i].animData[j].frameTime,
-              CREATURE_DATA[i].inset,
-              CREATURE_DATA[i].loop
-          )
+      g_assets.creatureAnims[i][j] = render_createAnim(
+          g_assets.creatureSprites[i],
+          data->animData[j].row,
+          data->animData[j].startCol,
+          data->animData[j].frameCount,
+          data->animData[j].frameTime,
+          data->inset,
+          data->loop
       );
+      if (g_assets.creatureAnims[i][j] == nullptr) {
+        destroyCreatures();
+        return false;
+      }
     }
   }
+  g_assets.creatureLevel = level;
   return true;
 }
 
+// Requires the first level's tileset
 bool asset_initCursor(void) {
-  Vector2 null = (Vector2) { 0.0f, 0.0f };
-  GAME_TRY(g_assets.cursorSprite = engine_createSpriteFromSheet(null, CURSOR_SIZE, CURSOR_ROW, CURSOR_COL, null));
+  g_assets.cursorSpriteSheet = maze_getTileSet();
+  Vector2 null               = (Vector2) { 0.0f, 0.0f };
+  GAME_TRY(g_assets.cursorSprite = render_createSpriteFromSheet(null, CURSOR_SIZE, CURSOR_ROW, CURSOR_COL, null));
   return true;
 }
 
 void asset_shutdownPlayer(void) {
   player_shutdown();
-  for (int i = 0; i < PLAYER_LIVES; i++) {
+  for (int i = 0; i < PLAYER_MAX_LIVES; i++) {
     assert(g_assets.playerLivesSprites[i] != nullptr);
-    engine_destroySprite(&g_assets.playerLivesSprites[i]);
+    render_destroySprite(&g_assets.playerLivesSprites[i]);
     assert(g_assets.playerLivesSprites[i] == nullptr);
   }
+  assert(g_assets.playerNextLifeSprite != nullptr);
+  render_destroySprite(&g_assets.playerNextLifeSprite);
+  assert(g_assets.playerNextLifeSprite == nullptr);
   for (int i = 0; i < PLAYER_STATE_COUNT; i++) {
     assert(g_assets.playerSprites[i] != nullptr);
-    engine_destroySprite(&g_assets.playerSprites[i]);
+    render_destroySprite(&g_assets.playerSprites[i]);
     assert(g_assets.playerSprites[i] == nullptr);
     for (int j = 0; j < DIR_COUNT; j++) {
       assert(g_assets.playerAnim[i][j] != nullptr);
-      engine_destroyAnim(&g_assets.playerAnim[i][j]);
+      render_destroyAnim(&g_assets.playerAnim[i][j]);
       assert(g_assets.playerAnim[i][j] == nullptr);
     }
   }
@@ -180,21 +324,13 @@ void asset_shutdownPlayer(void) {
 
 void asset_shutdownCreatures(void) {
   creature_shutdown();
-  for (int i = 0; i < CREATURE_TOTAL; i++) {
-    assert(g_assets.creatureSprites[i] != nullptr);
-    engine_destroySprite(&g_assets.creatureSprites[i]);
-    assert(g_assets.creatureSprites[i] == nullptr);
-    for (int j = 0; j < DIR_COUNT; j++) {
-      assert(g_assets.creatureAnims[i][j] != nullptr);
-      engine_destroyAnim(&g_assets.creatureAnims[i][j]);
-      assert(g_assets.creatureAnims[i][j] == nullptr);
-    }
-  }
+  destroyCreatures();
 }
 
 void asset_shutdownCursor(void) {
   assert(g_assets.cursorSprite != nullptr);
-  g_assets.cursorSprite = nullptr;
+  render_destroySprite(&g_assets.cursorSprite);
+  assert(g_assets.cursorSprite == nullptr);
 }
 
 engine_Texture* asset_getLogo(void) {
@@ -240,20 +376,16 @@ engine_Anim* asset_getPlayerAnim(game_PlayerState state, game_Dir dir) {
   return g_assets.playerAnim[state][dir];
 }
 
-engine_Sprite* asset_getCreateSprite(int creatureID) {
-  assert(creatureID >= 0 && creatureID < CREATURE_TOTAL);
-  return g_assets.creatureSprites[creatureID];
-}
+engine_Sprite* asset_getCreateSprite(int creatureID) { return g_assets.creatureSprites[getCreatureSlot(creatureID)]; }
 
 engine_Anim* asset_getCreatureAnim(int creatureID, game_Dir dir) {
-  assert(creatureID >= 0 && creatureID < CREATURE_TOTAL);
   assert(dir >= 0 && dir < DIR_COUNT);
-  return g_assets.creatureAnims[creatureID][dir];
+  return g_assets.creatureAnims[getCreatureSlot(creatureID)][dir];
 }
 
 Vector2 asset_getCreatureOffset(int creatureID) {
-  assert(creatureID >= 0 && creatureID < CREATURE_TOTAL);
-  return CREATURE_DATA[creatureID].offset;
+  assert(creatureID >= 0 && creatureID < CREATURE_COUNT * MAX_LEVELS);
+  return CREATURE_DATA[creatureID % CREATURE_TOTAL].offset;
 }
 
 engine_Texture* asset_getCursorSpriteSheet(void) {
@@ -276,65 +408,85 @@ engine_Font* asset_getFontTiny(void) {
   return g_assets.fontTiny;
 }
 
-engine_Sound* asset_getWailSound(int id) {
+Sound asset_getWailSound(int id) {
   assert(id >= 0 && id < WAIL_SOUND_COUNT);
-  assert(g_assets.wailSounds[id] != nullptr);
+  assert(g_assets.wailSounds[id].stream.buffer != nullptr);
   return g_assets.wailSounds[id];
 }
 
-engine_Sound* asset_getChimeSound(void) {
-  assert(g_assets.chimeSound != nullptr);
-  return g_assets.chimeSound;
+// The chime rises as coins are collected
+Sound asset_getChimeSound(int pitch) {
+  assert(pitch >= 0 && pitch < CHIME_PITCH_COUNT);
+  assert(g_assets.chimeSounds[pitch].stream.buffer != nullptr);
+  return g_assets.chimeSounds[pitch];
 }
 
-engine_Sound* asset_getDeathSound(void) {
-  assert(g_assets.deathSound != nullptr);
+Sound asset_getDeathSound(void) {
+  assert(g_assets.deathSound.stream.buffer != nullptr);
   return g_assets.deathSound;
 }
 
-engine_Sound* asset_getFallingSound(void) {
-  assert(g_assets.fallingSound != nullptr);
+Sound asset_getFallingSound(void) {
+  assert(g_assets.fallingSound.stream.buffer != nullptr);
   return g_assets.fallingSound;
 }
 
-engine_Sound* asset_getWhispersSound(void) {
-  assert(g_assets.whispersSound != nullptr);
+Sound asset_getWhispersSound(void) {
+  assert(g_assets.whispersSound.stream.buffer != nullptr);
   return g_assets.whispersSound;
 }
 
-engine_Sound* asset_getPickupSound(void) {
-  assert(g_assets.pickupSound != nullptr);
+Sound asset_getPickupSound(void) {
+  assert(g_assets.pickupSound.stream.buffer != nullptr);
   return g_assets.pickupSound;
 }
 
-engine_Sound* asset_getTwinkleSound(void) {
-  assert(g_assets.twinkleSound != nullptr);
+Sound asset_getTwinkleSound(void) {
+  assert(g_assets.twinkleSound.stream.buffer != nullptr);
   return g_assets.twinkleSound;
 }
 
-engine_Sound* asset_getWinSound(void) {
-  assert(g_assets.winSound != nullptr);
+Sound asset_getWinSound(void) {
+  assert(g_assets.winSound.stream.buffer != nullptr);
   return g_assets.winSound;
 }
 
-engine_Sound* asset_getGameOverSound(void) {
-  assert(g_assets.gameOverSound != nullptr);
+Sound asset_getGameOverSound(void) {
+  assert(g_assets.gameOverSound.stream.buffer != nullptr);
   return g_assets.gameOverSound;
 }
 
-engine_Sound* asset_getLifeSound(void) {
-  assert(g_assets.lifeSound != nullptr);
+Sound asset_getLifeSound(void) {
+  assert(g_assets.lifeSound.stream.buffer != nullptr);
   return g_assets.lifeSound;
 }
 
-engine_Sound* asset_getResSound(void) {
-  assert(g_assets.resSound != nullptr);
+Sound asset_getResSound(void) {
+  assert(g_assets.resSound.stream.buffer != nullptr);
   return g_assets.resSound;
 }
 
-engine_Music* asset_getMusic(void) {
-  assert(g_assets.music != nullptr);
-  return g_assets.music;
+// Call before the sounds load, for asset_getSoundWave()
+void asset_keepSoundWaves(void) { g_assets.isKeepingWaves = true; }
+
+// The samples a sound was made from, with its pitch applied
+const Wave* asset_getSoundWave(Sound sound) {
+  for (int i = 0; i < g_assets.soundWaveCount; i++) {
+    if (g_assets.soundWaves[i].buffer == sound.stream.buffer) return &g_assets.soundWaves[i].wave;
+  }
+  return nullptr;
+}
+
+// Streamed from disk by the music thread, which decodes it itself
+const char* asset_getMusicFile(void) { return MUSIC.filepath; }
+
+// Before the music volume option is applied
+void asset_getMusicDucking(float* volume, float* duckedVolume, float* fadeInRate, float* fadeOutRate) {
+  assert(volume != nullptr && duckedVolume != nullptr && fadeInRate != nullptr && fadeOutRate != nullptr);
+  *volume       = MUSIC.volume;
+  *duckedVolume = MUSIC.duckedVolume;
+  *fadeInRate   = FADE_IN_RATE;
+  *fadeOutRate  = FADE_OUT_RATE;
 }
 
 float asset_getWailVolume(int id) { return WAIL_SOUNDS[id].volume; }
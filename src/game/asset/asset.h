@@ -7,14 +7,23 @@
 
 // --- Constants ---
 
-static const int MAX_SOUNDS = 10;
+constexpr int CHIME_PITCH_COUNT = 5;
+constexpr int SOUND_VOICE_COUNT = 27;  // Every sound's voices summed, each pitch of the chime has its own
 
 // --- Asset functions
 
-bool asset_load(void);
-void asset_unload(void);
+bool asset_loadTitle(void);
+void asset_unloadTitle(void);
+bool asset_loadSprites(void);
+void asset_unloadSprites(void);
+bool asset_decodeSounds(void);
+void asset_stopDecodingSounds(void);
+bool asset_areSoundsDecoded(void);
+bool asset_loadSounds(void);
+void asset_unloadSounds(void);
 bool asset_initPlayer(void);
 bool asset_initCreatures(void);
+bool asset_loadCreatures(int level);
 bool asset_initCursor(void);
 void asset_shutdownPlayer(void);
 void asset_shutdownCreatures(void);
@@ -35,18 +44,21 @@ engine_Texture* asset_getCursorSpriteSheet(void);
 engine_Sprite*  asset_getCursorSprite(void);
 engine_Font*    asset_getFont(void);
 engine_Font*    asset_getFontTiny(void);
-engine_Sound*   asset_getWailSound(int id);
-engine_Sound*   asset_getChimeSound(void);
-engine_Sound*   asset_getDeathSound(void);
-engine_Sound*   asset_getFallingSound(void);
-engine_Sound*   asset_getWhispersSound(void);
-engine_Sound*   asset_getPickupSound(void);
-engine_Sound*   asset_getTwinkleSound(void);
-engine_Sound*   asset_getWinSound(void);
-engine_Sound*   asset_getGameOverSound(void);
-engine_Sound*   asset_getLifeSound(void);
-engine_Sound*   asset_getResSound(void);
-engine_Music*   asset_getMusic(void);
+Sound           asset_getWailSound(int id);
+Sound           asset_getChimeSound(int pitch);
+Sound           asset_getDeathSound(void);
+Sound           asset_getFallingSound(void);
+Sound           asset_getWhispersSound(void);
+Sound           asset_getPickupSound(void);
+Sound           asset_getTwinkleSound(void);
+Sound           asset_getWinSound(void);
+Sound           asset_getGameOverSound(void);
+Sound           asset_getLifeSound(void);
+Sound           asset_getResSound(void);
+void            asset_keepSoundWaves(void);
+const Wave*     asset_getSoundWave(Sound sound);
+const char*     asset_getMusicFile(void);
+void            asset_getMusicDucking(float* volume, float* duckedVolume, float* fadeInRate, float* fadeOutRate);
 float           asset_getWailVolume(int id);
 float           asset_getChimeVolume(void);
 float           asset_getDeathVolume(void);
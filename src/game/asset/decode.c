@@ -0,0 +1,187 @@
+#include <assert.h>
+#include <log/log.h>
+#include <raylib.h>
+#if !defined(__EMSCRIPTEN__)
+#define DECODE_THREAD
+#include <pthread.h>
+#endif
+#include "../pack/pack.h"
+#include "../startup/startup.h"
+#include "asset.h"
+#include "internal.h"
+
+// Sound files are read, decoded and resampled to their pitches on a thread of their own where there are threads, so
+// loading the sounds on the main thread only hands the samples to the audio device. The asset pack has them decoded
+// already, so with a pack only the pitches are resampled.
+
+// --- Types ---
+
+typedef struct asset_Decode {
+  const asset_SoundLoad* load;
+  Wave                   waves[MAX_PITCHES];  // One per pitch, empty if the file failed to decode
+  double                 seconds;
+  bool                   isTaken;
+} asset_Decode;
+
+// --- Global state ---
+
+static struct {
+  asset_Decode decodes[SOUND_FILE_COUNT];
+  int          count;
+  int          decodedCount;  // The decodes are done in order
+#if defined(DECODE_THREAD)
+  pthread_t       thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t  cond;
+  bool            isRunning;
+  bool            isQuitting;
+#endif
+} g_decoder = {
+#if defined(DECODE_THREAD)
+  .mutex = PTHREAD_MUTEX_INITIALIZER,
+  .cond  = PTHREAD_COND_INITIALIZER
+#endif
+};
+
+// --- Helper functions ---
+
+// A single unpitched wave is kept as decoded, or as packed, each pitch of more is a resampled copy
+static void decodeFile(asset_Decode* decode) {
+  const asset_SoundLoad* load  = decode->load;
+  double                 start = startup_getTime();
+  Wave                   wave;
+  if (!pack_findWave(load->data.filepath, &wave)) wave = LoadWave(load->data.filepath);
+  if (wave.data != nullptr) {
+    for (int i = 0; i < load->pitchCount; i++) {
+      float pitch = load->data.pitch * load->pitches[i];
+      if (pitch == 1.0f && load->pitchCount == 1) {
+        decode->waves[i] = wave;
+        break;
+      }
+      // Resampling to fewer frames and playing at the original rate raises the pitch
+      Wave pitched = WaveCopy(wave);
+      if (pitch != 1.0f && pitched.data != nullptr) {
+        WaveFormat(&pitched, (int) (wave.sampleRate / pitch), wave.sampleSize, wave.channels);
+        pitched.sampleRate = wave.sampleRate;
+      }
+      decode->waves[i] = pitched;
+    }
+    if (decode->waves[0].data != wave.data) asset_unloadWave(wave);
+  }
+  decode->seconds = startup_getTime() - start;
+}
+
+static void unloadWaves(asset_Decode* decode) {
+  for (int i = 0; i < decode->load->pitchCount; i++) {
+    if (decode->waves[i].data != nullptr) asset_unloadWave(decode->waves[i]);
+    decode->waves[i] = (Wave) {};
+  }
+}
+
+#if defined(DECODE_THREAD)
+// Works through every file in turn, stopping early if loading is abandoned
+static void* decodeThread([[maybe_unused]] void* arg) {
+  for (int i = 0; i < g_decoder.count; i++) {
+    pthread_mutex_lock(&g_decoder.mutex);
+    bool isQuitting = g_decoder.isQuitting;
+    pthread_mutex_unlock(&g_decoder.mutex);
+    if (isQuitting) break;
+
+    decodeFile(&g_decoder.decodes[i]);
+
+    pthread_mutex_lock(&g_decoder.mutex);
+    g_decoder.decodedCount = i + 1;
+    pthread_cond_broadcast(&g_decoder.cond);
+    pthread_mutex_unlock(&g_decoder.mutex);
+  }
+  return nullptr;
+}
+#endif
+
+// --- Decode functions ---
+
+// The loads are the caller's and must outlive the decoding. Without the thread each file decodes as it is taken.
+void asset_startDecoding(const asset_SoundLoad* loads, int count) {
+  assert(loads != nullptr);
+  assert(count > 0 && count <= SOUND_FILE_COUNT);
+  assert(g_decoder.count == 0);
+
+  for (int i = 0; i < count; i++) g_decoder.decodes[i] = (asset_Decode) { .load = &loads[i] };
+  g_decoder.count        = count;
+  g_decoder.decodedCount = 0;
+#if defined(DECODE_THREAD)
+  g_decoder.isRunning = pthread_create(&g_decoder.thread, nullptr, decodeThread, nullptr) == 0;
+  if (!g_decoder.isRunning) LOG_WARN(game_log, "Failed to start sound decoding thread, decoding on demand");
+#endif
+}
+
+// False while the thread is still working through the files, taking the waves would then wait
+bool asset_isDecoded(void) {
+#if defined(DECODE_THREAD)
+  if (g_decoder.isRunning) {
+    pthread_mutex_lock(&g_decoder.mutex);
+    bool isDecoded = g_decoder.decodedCount == g_decoder.count;
+    pthread_mutex_unlock(&g_decoder.mutex);
+    return isDecoded;
+  }
+#endif
+  return true;
+}
+
+// The waves become the caller's, one per pitch of the load. False if the file failed to decode, leaving them unset.
+bool asset_takeWaves(int load, Wave* waves) {
+  assert(load >= 0 && load < g_decoder.count);
+  assert(waves != nullptr);
+
+  asset_Decode* decode = &g_decoder.decodes[load];
+  assert(!decode->isTaken);
+  const char* name = GetFileName(decode->load->data.filepath);
+#if defined(DECODE_THREAD)
+  if (g_decoder.isRunning) {
+    pthread_mutex_lock(&g_decoder.mutex);
+    while (g_decoder.decodedCount <= load) pthread_cond_wait(&g_decoder.cond, &g_decoder.mutex);
+    pthread_mutex_unlock(&g_decoder.mutex);
+    // Decoded in the background, so this time overlaps the other stages
+    startup_add(decode->seconds, "Sound %s decode (background)", name);
+  } else
+#endif
+  {
+    decodeFile(decode);
+    startup_add(decode->seconds, "Sound %s decode", name);
+  }
+
+  decode->isTaken = true;
+  for (int i = 0; i < decode->load->pitchCount; i++) {
+    if (decode->waves[i].data == nullptr) {
+      unloadWaves(decode);
+      return false;
+    }
+  }
+  for (int i = 0; i < decode->load->pitchCount; i++) {
+    waves[i]         = decode->waves[i];
+    decode->waves[i] = (Wave) {};
+  }
+  return true;
+}
+
+// Waits for the thread and frees whatever was decoded but never taken, so is safe part way through loading
+void asset_stopDecoding(void) {
+#if defined(DECODE_THREAD)
+  if (g_decoder.isRunning) {
+    pthread_mutex_lock(&g_decoder.mutex);
+    g_decoder.isQuitting = true;
+    pthread_mutex_unlock(&g_decoder.mutex);
+    pthread_join(g_decoder.thread, nullptr);
+    g_decoder.isRunning  = false;
+    g_decoder.isQuitting = false;
+  }
+#endif
+  for (int i = 0; i < g_decoder.count; i++) unloadWaves(&g_decoder.decodes[i]);
+  g_decoder.count        = 0;
+  g_decoder.decodedCount = 0;
+}
+
+// A wave straight out of the asset pack is a view into it, so only decoded ones are freed
+void asset_unloadWave(Wave wave) {
+  if (!pack_contains(wave.data)) UnloadWave(wave);
+}
@@ -7,7 +7,11 @@
 
 // --- Types ---
 
-constexpr int CREATURE_TOTAL = CREATURE_COUNT * LEVEL_COUNT;
+constexpr int CREATURE_LEVELS  = 7;  // Levels with their own creature art, later levels reuse it in turn
+constexpr int CREATURE_TOTAL   = CREATURE_COUNT * CREATURE_LEVELS;
+constexpr int MAX_SOUND_WAVES  = 32;
+constexpr int SOUND_FILE_COUNT = WAIL_SOUND_COUNT + 10;  // Each wail and the ten other effects
+constexpr int MAX_PITCHES      = CHIME_PITCH_COUNT;
 
 typedef struct asset_AnimData {
   int    row;
@@ -27,15 +31,30 @@ typedef struct asset_ActorData {
 typedef struct asset_Sound {
   const char* filepath;
   float       volume;
-  float       pitch;
+  float       pitch;   // Resampled to as it loads
+  int         voices;  // Of it that can play at once, each an alias made as it loads
 } asset_Sound;
 
+// A file's sounds, one per pitch, decoded in the background and then loaded on the main thread
+typedef struct asset_SoundLoad {
+  asset_Sound  data;
+  const float* pitches;  // Applied on top of its own
+  int          pitchCount;
+  Sound*       sounds;
+} asset_SoundLoad;
+
 typedef struct asset_Music {
   const char* filepath;
   float       volume;
   float       duckedVolume;
 } asset_Music;
 
+// Kept for offline mixing, which can't read back what the audio device was given
+typedef struct asset_SoundWave {
+  const void* buffer;  // Of the sound made from the wave
+  Wave        wave;
+} asset_SoundWave;
+
 typedef struct asset_Assets {
   engine_Texture* logo;
   engine_Texture* creatureSpriteSheet;
@@ -44,26 +63,39 @@ typedef struct asset_Assets {
   engine_Sprite*  playerLivesSprites[PLAYER_MAX_LIVES];
   engine_Sprite*  playerNextLifeSprite;
   engine_Anim*    playerAnim[PLAYER_STATE_COUNT][DIR_COUNT];
-  engine_Sprite*  creatureSprites[CREATURE_TOTAL];
-  engine_Anim*    creatureAnims[CREATURE_TOTAL][DIR_COUNT];
+  engine_Sprite*  creatureSprites[CREATURE_COUNT];  // Only the current level's creatures
+  engine_Anim*    creatureAnims[CREATURE_COUNT][DIR_COUNT];
+  int             creatureLevel;  // Level the creature visuals were made for, or -1
   engine_Texture* cursorSpriteSheet;
   engine_Sprite*  cursorSprite;
   engine_Font*    font;
   engine_Font*    fontTiny;
-  engine_Sound*   wailSounds[WAIL_SOUND_COUNT];
-  engine_Sound*   chimeSound;
-  engine_Sound*   deathSound;
-  engine_Sound*   fallingSound;
-  engine_Sound*   whispersSound;
-  engine_Sound*   pickupSound;
-  engine_Sound*   twinkleSound;
-  engine_Sound*   winSound;
-  engine_Sound*   gameOverSound;
-  engine_Sound*   lifeSound;
-  engine_Sound*   resSound;
-  engine_Music*   music;
+  Sound           wailSounds[WAIL_SOUND_COUNT];
+  Sound           chimeSounds[CHIME_PITCH_COUNT];  // One per pitch, the chime rises as coins are collected
+  Sound           deathSound;
+  Sound           fallingSound;
+  Sound           whispersSound;
+  Sound           pickupSound;
+  Sound           twinkleSound;
+  Sound           winSound;
+  Sound           gameOverSound;
+  Sound           lifeSound;
+  Sound           resSound;
+  asset_SoundLoad soundLoads[SOUND_FILE_COUNT];
+  int             soundLoadCount;
+  asset_SoundWave soundWaves[MAX_SOUND_WAVES];
+  int             soundWaveCount;
+  bool            isKeepingWaves;
 } asset_Assets;
 
+// --- Decode functions ---
+
+void asset_startDecoding(const asset_SoundLoad* loads, int count);
+bool asset_isDecoded(void);
+bool asset_takeWaves(int load, Wave* waves);
+void asset_stopDecoding(void);
+void asset_unloadWave(Wave wave);
+
 // --- Constants ---
 
 static const char FILE_LOGO[]      = ASSET_DIR "gfx/logo.png";
@@ -73,21 +105,50 @@ static const char FILE_FONT[]      = ASSET_DIR "gfx/font.png";
 static const char FILE_FONT_TINY[] = ASSET_DIR "gfx/tiny-numbers.png";
 
 static const asset_Sound WAIL_SOUNDS[] = {
-  { .filepath = ASSET_DIR "sfx/wail-down.wav", .volume = 0.2f, .pitch = 1.0f },
-  { .filepath = ASSET_DIR "sfx/wail-down.wav", .volume = 0.2f, .pitch = 0.8f },
-  {   .filepath = ASSET_DIR "sfx/wail-up.wav", .volume = 0.2f, .pitch = 1.0f },
-  {   .filepath = ASSET_DIR "sfx/wail-up.wav", .volume = 0.2f, .pitch = 1.2f }
+  { .filepath = ASSET_DIR "sfx/wail-down.wav", .volume = 0.2f, .pitch = 1.0f, .voices = 1 },
+  { .filepath = ASSET_DIR "sfx/wail-down.wav", .volume = 0.2f, .pitch = 0.8f, .voices = 1 },
+  {   .filepath = ASSET_DIR "sfx/wail-up.wav", .volume = 0.2f, .pitch = 1.0f, .voices = 1 },
+  {   .filepath = ASSET_DIR "sfx/wail-up.wav", .volume = 0.2f, .pitch = 1.2f, .voices = 1 }
+};
+static const asset_Sound CHIME_SOUND = {
+  .filepath = ASSET_DIR "sfx/chime.wav", .volume = 0.33f, .pitch = 1.0f, .voices = 2
+};
+static const asset_Sound DEATH_SOUND = {
+  .filepath = ASSET_DIR "sfx/death.wav", .volume = 1.0f, .pitch = 1.0f, .voices = 1
+};
+static const asset_Sound FALLING_SOUND = {
+  .filepath = ASSET_DIR "sfx/falling.wav", .volume = 1.0f, .pitch = 1.0f, .voices = 1
+};
+static const asset_Sound WHISPERS_SOUND = {
+  .filepath = ASSET_DIR "sfx/whispers.wav", .volume = 1.0f, .pitch = 1.0f, .voices = CREATURE_COUNT
+};
+static const asset_Sound PICKUP_SOUND = {
+  .filepath = ASSET_DIR "sfx/pickup.wav", .volume = 1.0f, .pitch = 1.0f, .voices = 2
+};
+static const asset_Sound TWINKLE_SOUND = {
+  .filepath = ASSET_DIR "sfx/twinkle.mp3", .volume = 1.0f, .pitch = 1.0f, .voices = 1
+};
+static const asset_Sound WIN_SOUND = {
+  .filepath = ASSET_DIR "sfx/win.wav", .volume = 0.67f, .pitch = 1.0f, .voices = 1
+};
+static const asset_Sound GAME_OVER_SOUND = {
+  .filepath = ASSET_DIR "sfx/game-over.wav", .volume = 1.0f, .pitch = 1.0f, .voices = 1
+};
+static const asset_Sound LIFE_SOUND = {
+  .filepath = ASSET_DIR "sfx/life.wav", .volume = 1.0f, .pitch = 1.0f, .voices = 1
+};
+static const asset_Sound RES_SOUND = {
+  .filepath = ASSET_DIR "sfx/res.wav", .volume = 1.0f, .pitch = 1.0f, .voices = 1
+};
+
+// Applied on top of the chime's own pitch
+static const float CHIME_PITCHES[CHIME_PITCH_COUNT] = {
+  0.7937f,  // -4 semitones
+  0.8409f,  // -3 semitones
+  0.8909f,  // -2 semitones
+  0.9439f,  // -1 semitone
+  1.0000f   // root
 };
-static const asset_Sound CHIME_SOUND     = { .filepath = ASSET_DIR "sfx/chime.wav", .volume = 0.33f, .pitch = 1.0f };
-static const asset_Sound DEATH_SOUND     = { .filepath = ASSET_DIR "sfx/death.wav", .volume = 1.0f, .pitch = 1.0f };
-static const asset_Sound FALLING_SOUND   = { .filepath = ASSET_DIR "sfx/falling.wav", .volume = 1.0f, .pitch = 1.0f };
-static const asset_Sound WHISPERS_SOUND  = { .filepath = ASSET_DIR "sfx/whispers.wav", .volume = 1.0f, .pitch = 1.0f };
-static const asset_Sound PICKUP_SOUND    = { .filepath = ASSET_DIR "sfx/pickup.wav", .volume = 1.0f, .pitch = 1.0f };
-static const asset_Sound TWINKLE_SOUND   = { .filepath = ASSET_DIR "sfx/twinkle.mp3", .volume = 1.0f, .pitch = 1.0f };
-static const asset_Sound WIN_SOUND       = { .filepath = ASSET_DIR "sfx/win.wav", .volume = 0.67f, .pitch = 1.0f };
-static const asset_Sound GAME_OVER_SOUND = { .filepath = ASSET_DIR "sfx/game-over.wav", .volume = 1.0f, .pitch = 1.0f };
-static const asset_Sound LIFE_SOUND      = { .filepath = ASSET_DIR "sfx/life.wav", .volume = 1.0f, .pitch = 1.0f };
-static const asset_Sound RES_SOUND       = { .filepath = ASSET_DIR "sfx/res.wav", .volume = 1.0f, .pitch = 1.0f };
 
 static const float       FADE_IN_RATE  = 1.0f / 1.0f;
 static const float       FADE_OUT_RATE = 1.0f / 0.25f;
@@ -0,0 +1,94 @@
+#include <assert.h>
+#include <log/log.h>
+#include <raylib.h>
+#include <stdlib.h>
+#include "../internal.h"
+#include "../startup/startup.h"
+#include "audio.h"
+#include "internal.h"
+
+// As the engine wraps its sounds, so the voices never touch raylib's Sound directly. Loading and unloading hold the
+// engine lock, everything else is a command for the music thread, so playing a sound never waits on the stream's
+// update. Whether an alias is still playing is worked out from when it started rather than asked of the engine.
+
+// --- Types ---
+
+struct audio_Alias {
+  Sound  sound;    // Shares the source's samples, never copies them
+  double length;   // In seconds
+  double endTime;  // Of the last play, none once stopped
+};
+
+// --- Alias functions ---
+
+audio_Alias* audio_loadAlias(Sound sound) {
+  assert(sound.stream.buffer != nullptr);
+
+  audio_Alias* alias = malloc(sizeof(audio_Alias));
+  if (alias == nullptr) {
+    LOG_ERROR(game_log, "Failed to allocate sound alias");
+    return nullptr;
+  }
+  audio_lockEngine();
+  alias->sound = LoadSoundAlias(sound);
+  audio_unlockEngine();
+  if (alias->sound.stream.buffer == nullptr) {
+    LOG_ERROR(game_log, "Failed to load sound alias");
+    free(alias);
+    return nullptr;
+  }
+  alias->length  = (double) sound.frameCount / sound.stream.sampleRate;
+  alias->endTime = 0.0;
+  return alias;
+}
+
+// Call once nothing queued refers to the alias, see audio_waitCommands()
+void audio_unloadAlias(audio_Alias** alias) {
+  assert(alias != nullptr && *alias != nullptr);
+  audio_lockEngine();
+  StopSound((*alias)->sound);
+  UnloadSoundAlias((*alias)->sound);
+  audio_unlockEngine();
+  free(*alias);
+  *alias = nullptr;
+}
+
+void audio_setAliasVolume(audio_Alias* alias, float volume) {
+  assert(alias != nullptr);
+  audio_postCommand((audio_Command) { .type = COMMAND_ALIAS_VOLUME, .alias = alias, .value = volume });
+}
+
+void audio_setAliasPan(audio_Alias* alias, float pan) {
+  assert(alias != nullptr);
+  audio_postCommand((audio_Command) { .type = COMMAND_ALIAS_PAN, .alias = alias, .value = pan });
+}
+
+void audio_playAlias(audio_Alias* alias) {
+  assert(alias != nullptr);
+  alias->endTime = startup_getTime() + alias->length;
+  audio_postCommand((audio_Command) { .type = COMMAND_PLAY_ALIAS, .alias = alias });
+}
+
+void audio_stopAlias(audio_Alias* alias) {
+  assert(alias != nullptr);
+  alias->endTime = 0.0;
+  audio_postCommand((audio_Command) { .type = COMMAND_STOP_ALIAS, .alias = alias });
+}
+
+bool audio_isAliasPlaying(const audio_Alias* alias) {
+  assert(alias != nullptr);
+  return startup_getTime() < alias->endTime;
+}
+
+// On whichever thread runs the commands, holding the engine lock
+void audio_runAliasCommand(audio_Command command) {
+  assert(command.alias != nullptr);
+  Sound sound = command.alias->sound;
+  switch (command.type) {
+    case COMMAND_PLAY_ALIAS  : PlaySound(sound); break;
+    case COMMAND_STOP_ALIAS  : StopSound(sound); break;
+    case COMMAND_ALIAS_VOLUME: SetSoundVolume(sound, command.value); break;
+    case COMMAND_ALIAS_PAN   : SetSoundPan(sound, command.value); break;
+    default                  : assert(false); break;
+  }
+}
@@ -4,85 +4,192 @@
 #include "../asset/asset.h"
 #include "../internal.h"
 #include "../maze/maze.h"
+#include "../metrics/metrics.h"
 #include "../options/options.h"
-#include "engine/engine.h"
+#include "internal.h"
 
 // --- Constants ---
 
-constexpr int    COIN_PITCH_COUNT = 5;
-static const int COIN_THRESHOLD   = 20;
+static const int COIN_THRESHOLD = 20;
+constexpr int    MAX_WHISPERS   = CREATURE_COUNT * 2;  // Room for a stopped slot waiting on the next flush
 
 // --- Types ---
 
+typedef enum audio_EventType {
+  EVENT_CHIME,
+  EVENT_DEATH,
+  EVENT_FALLING,
+  EVENT_WAIL,
+  EVENT_PICKUP,
+  EVENT_TWINKLE,
+  EVENT_WIN,
+  EVENT_GAME_OVER,
+  EVENT_LIFE,
+  EVENT_RES,
+  EVENT_COUNT
+} audio_EventType;
+
+// Events of a type are coalesced within a frame, the first one's position is used
+typedef struct audio_Event {
+  bool    isPending;
+  Vector2 pos;
+} audio_Event;
+
+typedef enum audio_WhisperState {
+  WHISPER_FREE,
+  WHISPER_STARTING,
+  WHISPER_PLAYING,
+  WHISPER_STOPPING
+} audio_WhisperState;
+
+typedef struct audio_Whisper {
+  audio_WhisperState state;
+  Vector2            pos;
+  int                voice;
+} audio_Whisper;
+
 typedef struct audio_State {
-  const float coinPitches[COIN_PITCH_COUNT];
-  int         coinPitchIndex;
-  int         coinsCollected;
+  audio_Event   events[EVENT_COUNT];
+  audio_Whisper whispers[MAX_WHISPERS];
+  int           coinPitchIndex;
+  int           coinsCollected;
+  unsigned      wailSeed;  // Not the game's random numbers, so replays don't depend on whether audio is enabled
 
   bool audioEnabled;
 } audio_State;
 
 // --- Global state ---
 
-static audio_State g_state = {
-  .coinPitches = {
-      0.7937f,  // -4 semitones
-      0.8409f,  // -3 semitones
-      0.8909f,  // -2 semitones
-      0.9439f,  // -1 semitone
-      1.0000f   // root
-  },
-  .coinPitchIndex = 0,
-  .coinsCollected = 0,
-  .audioEnabled = true
-};
+static audio_State g_state = { .coinPitchIndex = 0, .coinsCollected = 0, .wailSeed = 1, .audioEnabled = true };
 
 // --- Helper functions ---
 
 static inline float getPan(Vector2 pos) { return 1.0f - pos.x / (maze_getCols() * TILE_SIZE); }
 
-// --- Audio functions ---
-
-void audio_onVolumeChange(void) {
-  float masterVolume = options_getMasterVolume();
-  float musicVolume  = options_getMusicVolume();
-  float sfxVolume    = options_getSfxVolume();
+static void post(audio_EventType type, Vector2 pos) {
+  if (!g_state.audioEnabled || g_state.events[type].isPending) return;
+  g_state.events[type] = (audio_Event) { .isPending = true, .pos = pos };
+}
 
-  engine_setMasterVolume(masterVolume);
+// Xorshift
+static int getWail(void) {
+  g_state.wailSeed ^= g_state.wailSeed << 13;
+  g_state.wailSeed ^= g_state.wailSeed >> 17;
+  g_state.wailSeed ^= g_state.wailSeed << 5;
+  return g_state.wailSeed % WAIL_SOUND_COUNT;
+}
 
-  engine_setMusicVolume(asset_getMusic(), musicVolume);
+static void playEvent(audio_EventType type, Vector2 pos) {
+  Sound          sound;
+  float          volume;
+  audio_Priority priority = PRIORITY_NORMAL;
+  switch (type) {
+    case EVENT_CHIME:
+      sound    = asset_getChimeSound(g_state.coinPitchIndex);
+      volume   = asset_getChimeVolume();
+      priority = PRIORITY_LOW;
+      break;
+    case EVENT_DEATH:
+      sound    = asset_getDeathSound();
+      volume   = asset_getDeathVolume();
+      priority = PRIORITY_HIGH;
+      break;
+    case EVENT_FALLING:
+      sound  = asset_getFallingSound();
+      volume = asset_getFallingVolume();
+      break;
+    case EVENT_WAIL: {
+      int id   = getWail();
+      sound    = asset_getWailSound(id);
+      volume   = asset_getWailVolume(id);
+      priority = PRIORITY_LOW;
+      break;
+    }
+    case EVENT_PICKUP:
+      sound    = asset_getPickupSound();
+      volume   = asset_getPickupVolume();
+      priority = PRIORITY_LOW;
+      break;
+    case EVENT_TWINKLE:
+      sound  = asset_getTwinkleSound();
+      volume = asset_getTwinkleVolume();
+      break;
+    case EVENT_WIN:
+      sound    = asset_getWinSound();
+      volume   = asset_getWinVolume();
+      priority = PRIORITY_HIGH;
+      break;
+    case EVENT_GAME_OVER:
+      sound    = asset_getGameOverSound();
+      volume   = asset_getGameOverVolume();
+      priority = PRIORITY_HIGH;
+      break;
+    case EVENT_LIFE:
+      sound  = asset_getLifeSound();
+      volume = asset_getLifeVolume();
+      break;
+    case EVENT_RES:
+      sound  = asset_getResSound();
+      volume = asset_getResVolume();
+      break;
+    default: assert(false); return;
+  }
+  audio_playVoice(sound, volume, getPan(pos), priority, false);
+}
 
-  for (int i = 0; i < WAIL_SOUND_COUNT; i++) {
-    engine_setSoundVolume(asset_getWailSound(i), asset_getWailVolume(i) * sfxVolume);
+static void updateWhisper(audio_Whisper* whisper) {
+  switch (whisper->state) {
+    case WHISPER_FREE: break;
+    case WHISPER_STARTING:
+      whisper->voice = audio_playVoice(
+          asset_getWhispersSound(), asset_getWhispersVolume(), getPan(whisper->pos), PRIORITY_NORMAL, true
+      );
+      whisper->state = WHISPER_PLAYING;
+      break;
+    case WHISPER_PLAYING: audio_loopVoice(whisper->voice); break;
+    case WHISPER_STOPPING:
+      audio_stopVoice(whisper->voice);
+      *whisper = (audio_Whisper) { .state = WHISPER_FREE, .voice = -1 };
+      break;
   }
-  engine_setSoundVolume(asset_getChimeSound(), asset_getChimeVolume() * sfxVolume);
-  engine_setSoundVolume(asset_getDeathSound(), asset_getDeathVolume() * sfxVolume);
-  engine_setSoundVolume(asset_getFallingSound(), asset_getFallingVolume() * sfxVolume);
-  engine_setSoundVolume(asset_getWhispersSound(), asset_getWhispersVolume() * sfxVolume);
-  engine_setSoundVolume(asset_getPickupSound(), asset_getPickupVolume() * sfxVolume);
-  engine_setSoundVolume(asset_getTwinkleSound(), asset_getTwinkleVolume() * sfxVolume);
-  engine_setSoundVolume(asset_getWinSound(), asset_getWinVolume() * sfxVolume);
-  engine_setSoundVolume(asset_getGameOverSound(), asset_getGameOverVolume() * sfxVolume);
-  engine_setSoundVolume(asset_getLifeSound(), asset_getLifeVolume() * sfxVolume);
-  engine_setSoundVolume(asset_getResSound(), asset_getResVolume() * sfxVolume);
 }
 
-void audio_startMusic(void) { engine_playMusic(asset_getMusic()); }
+// --- Audio functions ---
+
+// Batch runs disable audio, so gameplay's calls into this module cost next to nothing
+void audio_setEnabled(bool isEnabled) { g_state.audioEnabled = isEnabled; }
+
+// The title menu's sliders work before the sounds have loaded, so each setter skips what isn't loaded yet. Sounds take
+// their volume from the options as they start playing.
+void audio_onVolumeChange(void) {
+  audio_postCommand((audio_Command) { .type = COMMAND_MASTER_VOLUME, .value = options_getMasterVolume() });
+  audio_setMusicVolume(options_getMusicVolume());
+  audio_setVoiceVolumes(options_getSfxVolume());
+}
+
+// Plays what the frame's updates asked for, call once a frame after updating
+void audio_flushEvents(void) {
+  if (!g_state.audioEnabled) return;
 
-void audio_stopMusic(void) { engine_stopMusic(asset_getMusic()); }
+  for (int i = 0; i < EVENT_COUNT; i++) {
+    if (!g_state.events[i].isPending) continue;
+    playEvent(i, g_state.events[i].pos);
+    g_state.events[i].isPending = false;
+  }
+  for (int i = 0; i < MAX_WHISPERS; i++) updateWhisper(&g_state.whispers[i]);
+  audio_duckMusic(audio_isEffectPlaying());
+  metrics_set(METRICS_ACTIVE_VOICES, audio_countVoices());
+}
 
+// The chime rises in pitch the more coins are collected
 void audio_playChime(Vector2 pos) {
   if (!g_state.audioEnabled) return;
 
   if (++g_state.coinsCollected >= COIN_THRESHOLD) {
-    g_state.coinPitchIndex = MIN(g_state.coinPitchIndex + 1, COIN_PITCH_COUNT);
+    g_state.coinPitchIndex = MIN(g_state.coinPitchIndex + 1, CHIME_PITCH_COUNT - 1);
     g_state.coinsCollected = 0;
   }
-
-  engine_Sound* sound = asset_getChimeSound();
-  engine_setSoundPitch(sound, g_state.coinPitches[g_state.coinPitchIndex]);
-  engine_setSoundPan(sound, getPan(pos));
-  engine_playSound(sound);
+  post(EVENT_CHIME, pos);
 }
 
 void audio_resetChimePitch(void) {
@@ -90,87 +197,43 @@ void audio_resetChimePitch(void) {
   g_state.coinsCollected = 0;
 }
 
-void audio_playDeath(Vector2 pos) {
-  if (!g_state.audioEnabled) return;
-  engine_Sound* sound = asset_getDeathSound();
-  engine_setSoundPan(sound, getPan(pos));
-  engine_playSound(sound);
-}
+void audio_playDeath(Vector2 pos) { post(EVENT_DEATH, pos); }
 
-void audio_playFalling(Vector2 pos) {
-  if (!g_state.audioEnabled) return;
-  engine_Sound* sound = asset_getFallingSound();
-  engine_setSoundPan(sound, getPan(pos));
-  engine_playSound(sound);
-}
+void audio_playFalling(Vector2 pos) { post(EVENT_FALLING, pos); }
 
-void audio_playWail(Vector2 pos) {
-  if (!g_state.audioEnabled) return;
-  engine_Sound* sound = asset_getWailSound(GetRandomValue(0, WAIL_SOUND_COUNT - 1));
-  engine_setSoundPan(sound, getPan(pos));
-  engine_playSound(sound);
-}
+void audio_playWail(Vector2 pos) { post(EVENT_WAIL, pos); }
 
+// Loops until stopped, each flush restarts it when it ends, returns -1 if there are too many
 int audio_playWhispers(Vector2 pos) {
   if (!g_state.audioEnabled) return -1;
-  engine_Sound* sound = asset_getWhispersSound();
-  engine_setSoundPan(sound, getPan(pos));
-  return engine_playSound(sound);
-}
 
-void audio_updateWhispers(int id) {
-  if (!g_state.audioEnabled) return;
-  assert(id >= 0 && id < MAX_SOUNDS);
-  engine_Sound* sound = asset_getWhispersSound();
-  engine_updateSound(sound, id);
+  for (int i = 0; i < MAX_WHISPERS; i++) {
+    if (g_state.whispers[i].state == WHISPER_FREE) {
+      g_state.whispers[i] = (audio_Whisper) { .state = WHISPER_STARTING, .pos = pos, .voice = -1 };
+      return i;
+    }
+  }
+  return -1;
 }
 
 void audio_stopWhispers(int* id) {
   if (!g_state.audioEnabled) return;
-  assert(id != nullptr && *id >= 0 && *id < MAX_SOUNDS);
-  engine_Sound* sound = asset_getWhispersSound();
-  engine_stopSound(sound, *id);
-  *id = -1;
-}
+  assert(id != nullptr && *id >= 0 && *id < MAX_WHISPERS);
 
-void audio_playPickup(Vector2 pos) {
-  if (!g_state.audioEnabled) return;
-  engine_Sound* sound = asset_getPickupSound();
-  engine_setSoundPan(sound, getPan(pos));
-  engine_playSound(sound);
+  audio_Whisper* whisper = &g_state.whispers[*id];
+  // Never started, so there is nothing to stop
+  whisper->state = whisper->state == WHISPER_STARTING ? WHISPER_FREE : WHISPER_STOPPING;
+  *id            = -1;
 }
 
-void audio_playTwinkle(Vector2 pos) {
-  if (!g_state.audioEnabled) return;
-  engine_Sound* sound = asset_getTwinkleSound();
-  engine_setSoundPan(sound, getPan(pos));
-  engine_playSound(sound);
-}
+void audio_playPickup(Vector2 pos) { post(EVENT_PICKUP, pos); }
 
-void audio_playWin(Vector2 pos) {
-  if (!g_state.audioEnabled) return;
-  engine_Sound* sound = asset_getWinSound();
-  engine_setSoundPan(sound, getPan(pos));
-  engine_playSound(sound);
-}
+void audio_playTwinkle(Vector2 pos) { post(EVENT_TWINKLE, pos); }
 
-void audio_playGameOver(Vector2 pos) {
-  if (!g_state.audioEnabled) return;
-  engine_Sound* sound = asset_getGameOverSound();
-  engine_setSoundPan(sound, getPan(pos));
-  engine_playSound(sound);
-}
+void audio_playWin(Vector2 pos) { post(EVENT_WIN, pos); }
 
-void audio_playLife(Vector2 pos) {
-  if (!g_state.audioEnabled) return;
-  engine_Sound* sound = asset_getLifeSound();
-  engine_setSoundPan(sound, getPan(pos));
-  engine_playSound(sound);
-}
+void audio_playGameOver(Vector2 pos) { post(EVENT_GAME_OVER, pos); }
 
-void audio_playRes(Vector2 pos) {
-  if (!g_state.audioEnabled) return;
-  engine_Sound* sound = asset_getResSound();
-  engine_setSoundPan(sound, getPan(pos));
-  engine_playSound(sound);
-}
+void audio_playLife(Vector2 pos) { post(EVENT_LIFE, pos); }
+
+void audio_playRes(Vector2 pos) { post(EVENT_RES, pos); }
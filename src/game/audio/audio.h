@@ -5,16 +5,25 @@
 
 // --- Audio functions ---
 
+void audio_setEnabled(bool isEnabled);
 void audio_onVolumeChange(void);
+void audio_flushEvents(void);
 void audio_startMusic(void);
 void audio_stopMusic(void);
+void audio_updateMusic(void);
+void audio_lockEngine(void);
+void audio_unlockEngine(void);
+bool audio_bindVoices(Sound sound, int count);
+void audio_releaseVoices(void);
+bool audio_openMix(const char* file);
+void audio_mixFrame(double frameTime);
+bool audio_closeMix(void);
 void audio_playChime(Vector2 pos);
 void audio_resetChimePitch(void);
 void audio_playDeath(Vector2 pos);
 void audio_playFalling(Vector2 pos);
 void audio_playWail(Vector2 pos);
 int  audio_playWhispers(Vector2 pos);
-void audio_updateWhispers(int id);
 void audio_stopWhispers(int* id);
 void audio_playPickup(Vector2 pos);
 void audio_playTwinkle(Vector2 pos);
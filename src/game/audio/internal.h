@@ -0,0 +1,67 @@
+/*
+ * internal.h: Internal to audio units, don't include in other units.
+ */
+
+#pragma once
+// Clang format Language: C
+
+#include <raylib.h>
+
+// --- Types ---
+
+typedef enum audio_Priority { PRIORITY_LOW, PRIORITY_NORMAL, PRIORITY_HIGH } audio_Priority;
+
+typedef struct audio_Alias audio_Alias;
+
+// What the game thread asks of the engine's audio while the music thread runs, run in order on the music thread
+typedef enum audio_CommandType {
+  COMMAND_PLAY_MUSIC,
+  COMMAND_STOP_MUSIC,
+  COMMAND_MUSIC_VOLUME,
+  COMMAND_DUCK_MUSIC,
+  COMMAND_MASTER_VOLUME,
+  COMMAND_PLAY_ALIAS,
+  COMMAND_STOP_ALIAS,
+  COMMAND_ALIAS_VOLUME,
+  COMMAND_ALIAS_PAN,
+  COMMAND_QUIT
+} audio_CommandType;
+
+typedef struct audio_Command {
+  audio_CommandType type;
+  audio_Alias*      alias;
+  float             value;
+} audio_Command;
+
+// --- Alias functions ---
+
+audio_Alias* audio_loadAlias(Sound sound);
+void         audio_unloadAlias(audio_Alias** alias);
+void         audio_setAliasVolume(audio_Alias* alias, float volume);
+void         audio_setAliasPan(audio_Alias* alias, float pan);
+void         audio_playAlias(audio_Alias* alias);
+void         audio_stopAlias(audio_Alias* alias);
+bool         audio_isAliasPlaying(const audio_Alias* alias);
+void         audio_runAliasCommand(audio_Command command);
+
+// --- Music functions ---
+
+void audio_postCommand(audio_Command command);
+void audio_waitCommands(void);
+void audio_setMusicVolume(float volume);
+void audio_duckMusic(bool isDucked);
+
+// --- Voice functions ---
+
+int  audio_playVoice(Sound sound, float volume, float pan, audio_Priority priority, bool isLooping);
+void audio_loopVoice(int handle);
+void audio_stopVoice(int handle);
+void audio_setVoiceVolumes(float sfxVolume);
+int  audio_countVoices(void);
+bool audio_isEffectPlaying(void);
+
+// --- Mix functions ---
+
+bool audio_isMixing(void);
+int  audio_mixPlay(Sound sound, float volume, float pitch, float pan, audio_Priority priority, bool isLooping);
+void audio_mixStop(int handle);
@@ -0,0 +1,315 @@
+#include <assert.h>
+#include <log/log.h>
+#include <raylib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "../asset/asset.h"
+#include "../internal.h"
+#include "../options/options.h"
+#include "audio.h"
+#include "internal.h"
+
+// --- Constants ---
+
+constexpr int MIX_RATE        = 48000;
+constexpr int MIX_CHANNELS    = 2;
+constexpr int MIX_VOICE_COUNT = 16;  // As many as the device plays at once
+constexpr int MAX_SAMPLES     = 32;
+constexpr int CHUNK_FRAMES    = 1024;
+constexpr int GENERATION_SPAN = 1 << 20;
+constexpr int WAV_HEADER_SIZE = 44;
+
+// --- Types ---
+
+typedef struct audio_MixSamples {
+  const void* source;  // Buffer of the sound the samples came from
+  Wave        wave;    // Always MIX_RATE, 16 bit stereo
+} audio_MixSamples;
+
+typedef struct audio_MixVoice {
+  const Wave*    wave;
+  double         position;  // In frames, between two while pitched
+  double         step;      // Frames per frame mixed, the pitch
+  float          left;
+  float          right;
+  int            generation;
+  unsigned       order;
+  audio_Priority priority;
+  bool           isLooping;
+} audio_MixVoice;
+
+// --- Global state ---
+
+static struct {
+  FILE*            file;
+  bool             hasFailed;
+  double           time;
+  uint64_t         frameCount;
+  audio_MixSamples samples[MAX_SAMPLES];
+  int              sampleCount;
+  audio_MixVoice   voices[MIX_VOICE_COUNT];
+  unsigned         nextOrder;
+  Wave             music;
+  unsigned         musicPosition;
+  float            musicGain;
+  float            musicVolume;
+  float            musicDuckedVolume;
+  float            fadeInStep;  // Per full chunk
+  float            fadeOutStep;
+} g_mix;
+
+// --- Helper functions ---
+
+// raylib's pan law, where a pan of 1 is hard left
+static inline float getPanLevel(float x) { return 0.5f * x * (3.0f - x * x); }
+
+static inline void putU16(unsigned char* bytes, uint16_t value) {
+  bytes[0] = value & 0xFF;
+  bytes[1] = value >> 8;
+}
+
+static inline void putU32(unsigned char* bytes, uint32_t value) {
+  putU16(bytes, value & 0xFFFF);
+  putU16(bytes + 2, value >> 16);
+}
+
+static inline int16_t toSample(float value) {
+  value = CLAMP(value, -1.0f, 1.0f);
+  return (int16_t) (value * 32767.0f);
+}
+
+// 16 bit PCM stereo, the sizes are patched in once the length is known
+static bool writeHeader(uint32_t dataSize) {
+  unsigned char header[WAV_HEADER_SIZE];
+  memcpy(header, "RIFF", 4);
+  putU32(header + 4, WAV_HEADER_SIZE - 8 + dataSize);
+  memcpy(header + 8, "WAVEfmt ", 8);
+  putU32(header + 16, 16);
+  putU16(header + 20, 1);
+  putU16(header + 22, MIX_CHANNELS);
+  putU32(header + 24, MIX_RATE);
+  putU32(header + 28, MIX_RATE * MIX_CHANNELS * sizeof(int16_t));
+  putU16(header + 32, MIX_CHANNELS * sizeof(int16_t));
+  putU16(header + 34, 16);
+  memcpy(header + 36, "data", 4);
+  putU32(header + 40, dataSize);
+  return fseek(g_mix.file, 0, SEEK_SET) == 0 && fwrite(header, sizeof(header), 1, g_mix.file) == 1;
+}
+
+static bool convertWave(Wave* wave) {
+  if (wave->data == nullptr || wave->frameCount == 0) return false;
+  WaveFormat(wave, MIX_RATE, 16, MIX_CHANNELS);
+  return wave->data != nullptr && wave->frameCount > 0;
+}
+
+// Each sound is converted to the mix format the first time it plays
+static const Wave* getSamples(Sound sound) {
+  for (int i = 0; i < g_mix.sampleCount; i++) {
+    if (g_mix.samples[i].source == sound.stream.buffer) return &g_mix.samples[i].wave;
+  }
+
+  const Wave* wave = asset_getSoundWave(sound);
+  if (wave == nullptr || g_mix.sampleCount == MAX_SAMPLES) {
+    LOG_WARN(game_log, "No samples to mix for a sound");
+    return nullptr;
+  }
+  Wave copy = WaveCopy(*wave);
+  if (!convertWave(&copy)) {
+    UnloadWave(copy);
+    LOG_WARN(game_log, "Failed to convert a sound for mixing");
+    return nullptr;
+  }
+
+  audio_MixSamples* samples = &g_mix.samples[g_mix.sampleCount++];
+  *samples                  = (audio_MixSamples) { .source = sound.stream.buffer, .wave = copy };
+  return &samples->wave;
+}
+
+// A free voice, or else the oldest of the lowest priority playing, looping voices are never stolen
+static int findVoice(audio_Priority priority) {
+  int victim = -1;
+  for (int i = 0; i < MIX_VOICE_COUNT; i++) {
+    const audio_MixVoice* voice = &g_mix.voices[i];
+    if (voice->wave == nullptr) return i;
+    if (voice->isLooping || voice->priority > priority) continue;
+
+    const audio_MixVoice* best = victim == -1 ? nullptr : &g_mix.voices[victim];
+    if (best == nullptr || voice->priority < best->priority ||
+        (voice->priority == best->priority && (int) (voice->order - best->order) < 0)) {
+      victim = i;
+    }
+  }
+  return victim;
+}
+
+// Returns false once a voice has played to its end. A pitched voice steps through its samples faster or slower,
+// interpolating between frames as the device's resampler does.
+static bool mixVoice(audio_MixVoice* voice, float* mix, int frames) {
+  const int16_t* data       = voice->wave->data;
+  unsigned       frameCount = voice->wave->frameCount;
+  for (int i = 0; i < frames; i++) {
+    if (voice->position >= frameCount) {
+      if (!voice->isLooping) return false;
+      voice->position -= frameCount;
+    }
+    unsigned       index  = (unsigned) voice->position;
+    unsigned       next   = index + 1 < frameCount ? index + 1 : voice->isLooping ? 0 : index;
+    float          t      = (float) (voice->position - index);
+    const int16_t* frame  = &data[index * MIX_CHANNELS];
+    const int16_t* after  = &data[next * MIX_CHANNELS];
+    mix[i * 2]           += (frame[0] + (after[0] - frame[0]) * t) / 32768.0f * voice->left;
+    mix[i * 2 + 1]       += (frame[1] + (after[1] - frame[1]) * t) / 32768.0f * voice->right;
+    voice->position      += voice->step;
+  }
+  return true;
+}
+
+// Fades like the engine's ducking, down while any one-shot effect plays and back up once none are
+static void mixMusic(float* mix, int frames, bool isDucked) {
+  if (g_mix.music.data == nullptr) return;
+
+  // Scaled to the frames mixed, so the fade takes as long however the frame times fall
+  float target = isDucked ? g_mix.musicDuckedVolume : g_mix.musicVolume;
+  float step   = (isDucked ? g_mix.fadeOutStep : g_mix.fadeInStep) * frames / CHUNK_FRAMES;
+  if (g_mix.musicGain > target) {
+    g_mix.musicGain = MAX(g_mix.musicGain - step, target);
+  } else {
+    g_mix.musicGain = MIN(g_mix.musicGain + step, target);
+  }
+
+  float          level = g_mix.musicGain * options_getMusicVolume() * getPanLevel(0.5f);
+  const int16_t* data  = g_mix.music.data;
+  for (int i = 0; i < frames; i++) {
+    if (g_mix.musicPosition == g_mix.music.frameCount) g_mix.musicPosition = 0;
+    const int16_t* frame  = &data[g_mix.musicPosition++ * MIX_CHANNELS];
+    mix[i * 2]           += frame[0] / 32768.0f * level;
+    mix[i * 2 + 1]       += frame[1] / 32768.0f * level;
+  }
+}
+
+static void mixChunk(int frames) {
+  assert(frames > 0 && frames <= CHUNK_FRAMES);
+
+  float mix[CHUNK_FRAMES * MIX_CHANNELS] = {};
+  bool  isDucked                         = false;
+  for (int i = 0; i < MIX_VOICE_COUNT; i++) {
+    audio_MixVoice* voice = &g_mix.voices[i];
+    if (voice->wave == nullptr) continue;
+    isDucked |= !voice->isLooping;  // A loop like the whispers plays for as long as its creature is near
+    if (!mixVoice(voice, mix, frames)) voice->wave = nullptr;
+  }
+  mixMusic(mix, frames, isDucked);
+
+  unsigned char bytes[CHUNK_FRAMES * MIX_CHANNELS * sizeof(int16_t)];
+  float         master = options_getMasterVolume();
+  for (int i = 0; i < frames * MIX_CHANNELS; i++) putU16(&bytes[i * 2], (uint16_t) toSample(mix[i] * master));
+  if (fwrite(bytes, frames * MIX_CHANNELS * sizeof(int16_t), 1, g_mix.file) != 1 && !g_mix.hasFailed) {
+    LOG_ERROR(game_log, "Failed to write mixed audio");
+    g_mix.hasFailed = true;
+  }
+}
+
+static void loadMusic(void) {
+  const char* file = asset_getMusicFile();
+  g_mix.music      = LoadWave(file);
+  if (!convertWave(&g_mix.music)) {
+    LOG_WARN(game_log, "Failed to load music %s for mixing, mixing without it", file);
+    UnloadWave(g_mix.music);
+    g_mix.music = (Wave) {};
+    return;
+  }
+
+  float fadeInRate, fadeOutRate;
+  asset_getMusicDucking(&g_mix.musicVolume, &g_mix.musicDuckedVolume, &fadeInRate, &fadeOutRate);
+  float range       = g_mix.musicVolume - g_mix.musicDuckedVolume;
+  g_mix.musicGain   = g_mix.musicVolume;
+  g_mix.fadeInStep  = range * fadeInRate * CHUNK_FRAMES / MIX_RATE;
+  g_mix.fadeOutStep = range * fadeOutRate * CHUNK_FRAMES / MIX_RATE;
+}
+
+// --- Mix functions ---
+
+// Call after game_load() and before the sounds load, so their samples are kept to mix from
+bool audio_openMix(const char* file) {
+  assert(file != nullptr);
+  assert(g_mix.file == nullptr);
+
+  g_mix.file = fopen(file, "wb");
+  if (g_mix.file == nullptr) {
+    LOG_ERROR(game_log, "Failed to open %s for writing", file);
+    return false;
+  }
+  if (!writeHeader(0)) {
+    LOG_ERROR(game_log, "Failed to write %s", file);
+    fclose(g_mix.file);
+    g_mix.file = nullptr;
+    return false;
+  }
+
+  asset_keepSoundWaves();
+  loadMusic();
+  LOG_INFO(game_log, "Mixing audio to %s", file);
+  return true;
+}
+
+bool audio_isMixing(void) { return g_mix.file != nullptr; }
+
+// Mixes up to the end of the frame, however long it took to simulate
+void audio_mixFrame(double frameTime) {
+  assert(frameTime >= 0.0);
+  if (g_mix.file == nullptr) return;
+
+  g_mix.time      += frameTime;
+  uint64_t target  = (uint64_t) (g_mix.time * MIX_RATE);
+  while (g_mix.frameCount < target) {
+    uint64_t remaining = target - g_mix.frameCount;
+    int      frames    = remaining < CHUNK_FRAMES ? (int) remaining : CHUNK_FRAMES;
+    mixChunk(frames);
+    g_mix.frameCount += frames;
+  }
+}
+
+// Returns a handle, or -1 if every voice is busy with something more important
+int audio_mixPlay(Sound sound, float volume, float pitch, float pan, audio_Priority priority, bool isLooping) {
+  const Wave* wave = getSamples(sound);
+  if (wave == nullptr) return -1;
+  int slot = findVoice(priority);
+  if (slot == -1) return -1;
+
+  audio_MixVoice* voice = &g_mix.voices[slot];
+  float           level = volume * options_getSfxVolume();
+  *voice                = (audio_MixVoice) {
+                   .wave       = wave,
+                   .step       = pitch,
+                   .left       = level * getPanLevel(pan),
+                   .right      = level * getPanLevel(1.0f - pan),
+                   .generation = (voice->generation + 1) % GENERATION_SPAN,
+                   .order      = g_mix.nextOrder++,
+                   .priority   = priority,
+                   .isLooping  = isLooping
+  };
+  return voice->generation * MIX_VOICE_COUNT + slot;
+}
+
+void audio_mixStop(int handle) {
+  if (handle < 0) return;
+  audio_MixVoice* voice = &g_mix.voices[handle % MIX_VOICE_COUNT];
+  if (voice->generation == handle / MIX_VOICE_COUNT) voice->wave = nullptr;
+}
+
+// Writes the final sizes into the header, returns false if any of the audio failed to write
+bool audio_closeMix(void) {
+  if (g_mix.file == nullptr) return true;
+
+  uint64_t dataSize = g_mix.frameCount * MIX_CHANNELS * sizeof(int16_t);
+  bool     isOk     = !g_mix.hasFailed && dataSize <= UINT32_MAX - WAV_HEADER_SIZE && writeHeader((uint32_t) dataSize);
+  if (fclose(g_mix.file) != 0) isOk = false;
+  if (!isOk) LOG_ERROR(game_log, "Failed to write mixed audio");
+  LOG_INFO(game_log, "Mixed %.2f seconds of audio", (double) g_mix.frameCount / MIX_RATE);
+
+  for (int i = 0; i < g_mix.sampleCount; i++) UnloadWave(g_mix.samples[i].wave);
+  UnloadWave(g_mix.music);
+  g_mix = (typeof(g_mix)) {};
+  return isOk;
+}
@@ -0,0 +1,289 @@
+#include <assert.h>
+#include <engine/engine.h>
+#include <external/dr_mp3.h>
+#include <log/log.h>
+#include <raylib.h>
+#include <stdint.h>
+#include "../asset/asset.h"
+#include "../internal.h"
+#include "../options/options.h"
+#include "../ring/ring.h"
+#include "audio.h"
+#include "internal.h"
+
+#if !defined(__EMSCRIPTEN__)
+#define MUSIC_THREAD
+#include <pthread.h>
+#include <time.h>
+#endif
+
+// The music is decoded here with raylib's own MP3 decoder rather than streamed by the engine, so the decoding happens
+// outside the engine lock and only handing a decoded chunk to the stream holds it.
+
+// --- Constants ---
+
+constexpr int       QUEUE_SIZE      = 256;   // Power of two, room for many frames of voice calls
+constexpr int       CHUNK_FRAMES    = 2048;  // Decoded at a time, each fills one of the stream's two buffers
+constexpr int       MAX_CHANNELS    = 2;
+static const double UPDATE_INTERVAL = 0.005;
+static const double WAIT_INTERVAL   = 0.001;
+
+// --- Global state ---
+
+// The queue's producer is the game thread, its consumer the music thread. The decoder, stream and gain belong to
+// whichever runs the commands, the music thread while it runs and the game thread otherwise.
+static struct {
+  audio_Command commands[QUEUE_SIZE];
+  ring_Ring     queue;
+  drmp3         decoder;
+  AudioStream   stream;
+  int16_t       chunk[CHUNK_FRAMES * MAX_CHANNELS];
+  bool          isOpen;
+  bool          isChunkReady;
+  bool          isDucked;
+  bool          isDuckPosted;  // The game thread's record of what it last asked for
+  float         volume;        // The music volume option
+  float         gain;          // Fading between the full and ducked volumes
+  float         fullVolume;
+  float         duckedVolume;
+  float         fadeInStep;  // Per frame
+  float         fadeOutStep;
+#if defined(MUSIC_THREAD)
+  pthread_t       thread;
+  bool            isRunning;
+  pthread_mutex_t engineLock;  // Held by whichever thread is calling into the engine's audio
+#endif
+} g_music = {
+#if defined(MUSIC_THREAD)
+  .engineLock = PTHREAD_MUTEX_INITIALIZER
+#endif
+};
+
+// --- Helper functions ---
+
+static bool openMusic(void) {
+  const char* file = asset_getMusicFile();
+  if (!drmp3_init_file(&g_music.decoder, file, nullptr)) {
+    LOG_ERROR(game_log, "Failed to open music %s", file);
+    return false;
+  }
+  if (g_music.decoder.channels > MAX_CHANNELS) {
+    LOG_ERROR(game_log, "Music %s has %u channels", file, g_music.decoder.channels);
+    drmp3_uninit(&g_music.decoder);
+    return false;
+  }
+
+  // Sized so each chunk fills a buffer, the engine's sounds keep the default
+  audio_lockEngine();
+  SetAudioStreamBufferSizeDefault(CHUNK_FRAMES);
+  g_music.stream = LoadAudioStream(g_music.decoder.sampleRate, 16, g_music.decoder.channels);
+  SetAudioStreamBufferSizeDefault(0);
+  audio_unlockEngine();
+  if (g_music.stream.buffer == nullptr) {
+    LOG_ERROR(game_log, "Failed to load music stream for %s", file);
+    drmp3_uninit(&g_music.decoder);
+    return false;
+  }
+
+  float fadeInRate, fadeOutRate;
+  asset_getMusicDucking(&g_music.fullVolume, &g_music.duckedVolume, &fadeInRate, &fadeOutRate);
+  float range          = g_music.fullVolume - g_music.duckedVolume;
+  g_music.gain         = g_music.fullVolume;
+  g_music.fadeInStep   = range * fadeInRate / g_music.decoder.sampleRate;
+  g_music.fadeOutStep  = range * fadeOutRate / g_music.decoder.sampleRate;
+  g_music.isChunkReady = false;
+  g_music.isOpen       = true;
+  return true;
+}
+
+static void closeMusic(void) {
+  if (!g_music.isOpen) return;
+  audio_lockEngine();
+  StopAudioStream(g_music.stream);
+  UnloadAudioStream(g_music.stream);
+  audio_unlockEngine();
+  drmp3_uninit(&g_music.decoder);
+  g_music.isOpen = false;
+}
+
+// The slow part of an update, so it never holds the engine lock. Loops back to the start at the end.
+static void decodeChunk(void) {
+  unsigned channels = g_music.decoder.channels;
+  uint64_t frames   = 0;
+  bool     isLooped = false;
+  while (frames < CHUNK_FRAMES) {
+    int16_t* data = &g_music.chunk[frames * channels];
+    uint64_t read = drmp3_read_pcm_frames_s16(&g_music.decoder, CHUNK_FRAMES - frames, data);
+    if (read > 0) {
+      frames   += read;
+      isLooped  = false;
+      continue;
+    }
+    if (isLooped || !drmp3_seek_to_pcm_frame(&g_music.decoder, 0)) break;
+    isLooped = true;
+  }
+
+  // Fades like the engine's ducking, a frame at a time so the steps aren't heard
+  float target = g_music.isDucked ? g_music.duckedVolume : g_music.fullVolume;
+  float step   = g_music.isDucked ? g_music.fadeOutStep : g_music.fadeInStep;
+  for (unsigned i = 0; i < CHUNK_FRAMES; i++) {
+    if (g_music.gain > target) {
+      g_music.gain = MAX(g_music.gain - step, target);
+    } else {
+      g_music.gain = MIN(g_music.gain + step, target);
+    }
+    float level = g_music.gain * g_music.volume;
+    for (unsigned c = 0; c < channels; c++) {
+      int16_t* sample = &g_music.chunk[i * channels + c];
+      *sample         = i < frames ? (int16_t) (*sample * level) : 0;
+    }
+  }
+  g_music.isChunkReady = true;
+}
+
+// Call holding the engine lock, true if the chunk was taken so there's room for another
+static bool updateStream(void) {
+  if (!g_music.isOpen || !g_music.isChunkReady || !IsAudioStreamProcessed(g_music.stream)) return false;
+  UpdateAudioStream(g_music.stream, g_music.chunk, CHUNK_FRAMES);
+  g_music.isChunkReady = false;
+  return true;
+}
+
+// Returns false when told to quit. Call holding the engine lock.
+static bool runCommand(audio_Command command) {
+  switch (command.type) {
+    case COMMAND_PLAY_MUSIC:
+      if (g_music.isOpen) PlayAudioStream(g_music.stream);
+      break;
+    case COMMAND_STOP_MUSIC:
+      if (g_music.isOpen) StopAudioStream(g_music.stream);
+      break;
+    case COMMAND_MUSIC_VOLUME : g_music.volume = command.value; break;
+    case COMMAND_DUCK_MUSIC   : g_music.isDucked = command.value != 0.0f; break;
+    case COMMAND_MASTER_VOLUME: engine_setMasterVolume(command.value); break;
+    case COMMAND_QUIT         : return false;
+    default                   : audio_runAliasCommand(command); break;
+  }
+  return true;
+}
+
+#if defined(MUSIC_THREAD)
+static bool runCommands(void) {
+  unsigned count     = ring_getCount(&g_music.queue);
+  bool     isRunning = true;
+  for (unsigned i = 0; i < count; i++) isRunning &= runCommand(*(const audio_Command*) ring_get(&g_music.queue, i));
+  ring_release(&g_music.queue, count);
+  return isRunning;
+}
+
+// Keeps the stream topped up and the ducking fading however long the game's frames take. Only the commands and handing
+// over a decoded chunk hold the lock the game thread takes to load and unload sounds.
+static void* musicThread([[maybe_unused]] void* arg) {
+  static const struct timespec INTERVAL = { .tv_nsec = (long) (UPDATE_INTERVAL * 1e9) };
+
+  bool isRunning = true;
+  while (isRunning) {
+    if (g_music.isOpen && !g_music.isChunkReady) decodeChunk();
+    audio_lockEngine();
+    isRunning       = runCommands();
+    bool isUpdated = isRunning && updateStream();
+    audio_unlockEngine();
+    // Straight on to the next chunk while the stream has room, both its buffers fill as it starts
+    if (!isUpdated) nanosleep(&INTERVAL, nullptr);
+  }
+  return nullptr;
+}
+#endif
+
+// --- Music functions ---
+
+// Around any other call into the engine's or raylib's audio that can happen while the music thread runs
+void audio_lockEngine(void) {
+#if defined(MUSIC_THREAD)
+  pthread_mutex_lock(&g_music.engineLock);
+#endif
+}
+
+void audio_unlockEngine(void) {
+#if defined(MUSIC_THREAD)
+  pthread_mutex_unlock(&g_music.engineLock);
+#endif
+}
+
+// Queued for the music thread while it runs, so the game thread never waits on the engine, and otherwise run now
+void audio_postCommand(audio_Command command) {
+#if defined(MUSIC_THREAD)
+  if (g_music.isRunning) {
+    audio_Command* slot = ring_claim(&g_music.queue);
+    if (slot == nullptr) {
+      LOG_WARN(game_log, "Audio command queue full, dropping command");
+      return;
+    }
+    *slot = command;
+    ring_publish(&g_music.queue);
+    return;
+  }
+#endif
+  audio_lockEngine();
+  runCommand(command);
+  audio_unlockEngine();
+}
+
+// Until the music thread has run everything queued, so nothing it has yet to run refers to what's about to be unloaded
+void audio_waitCommands(void) {
+#if defined(MUSIC_THREAD)
+  static const struct timespec INTERVAL = { .tv_nsec = (long) (WAIT_INTERVAL * 1e9) };
+  while (g_music.isRunning && ring_getCount(&g_music.queue) > 0) nanosleep(&INTERVAL, nullptr);
+#endif
+}
+
+// The music belongs to the music thread from here until audio_stopMusic(), everything else goes through commands
+void audio_startMusic(void) {
+  assert(!g_music.isOpen);
+  g_music.volume       = options_getMusicVolume();
+  g_music.isDucked     = false;
+  g_music.isDuckPosted = false;
+  if (!openMusic()) return;
+  audio_postCommand((audio_Command) { .type = COMMAND_PLAY_MUSIC });
+
+#if defined(MUSIC_THREAD)
+  ring_init(&g_music.queue, g_music.commands, sizeof(audio_Command), QUEUE_SIZE);
+  g_music.isRunning = pthread_create(&g_music.thread, nullptr, musicThread, nullptr) == 0;
+  if (!g_music.isRunning) LOG_WARN(game_log, "Failed to start music thread, streaming from the game loop");
+#endif
+}
+
+// Waits for the music thread to run what's queued and quit, so the music can then be closed
+void audio_stopMusic(void) {
+#if defined(MUSIC_THREAD)
+  if (g_music.isRunning) {
+    audio_postCommand((audio_Command) { .type = COMMAND_QUIT });
+    pthread_join(g_music.thread, nullptr);
+    g_music.isRunning = false;
+  }
+#endif
+  closeMusic();
+}
+
+// Streams the music from the game loop where there is no music thread
+void audio_updateMusic(void) {
+#if defined(MUSIC_THREAD)
+  if (g_music.isRunning) return;
+#endif
+  if (!g_music.isOpen) return;
+
+  do {
+    if (!g_music.isChunkReady) decodeChunk();
+  } while (updateStream());
+}
+
+void audio_setMusicVolume(float volume) {
+  audio_postCommand((audio_Command) { .type = COMMAND_MUSIC_VOLUME, .value = volume });
+}
+
+// Asks for the fade only when it changes, rather than every frame
+void audio_duckMusic(bool isDucked) {
+  if (isDucked == g_music.isDuckPosted) return;
+  g_music.isDuckPosted = isDucked;
+  audio_postCommand((audio_Command) { .type = COMMAND_DUCK_MUSIC, .value = isDucked });
+}
@@ -0,0 +1,184 @@
+#include <assert.h>
+#include <raylib.h>
+#include "../asset/asset.h"
+#include "../internal.h"
+#include "../options/options.h"
+#include "audio.h"
+#include "internal.h"
+
+// --- Constants ---
+
+constexpr int VOICE_COUNT     = 16;  // Played at once, however many effects there are
+constexpr int GENERATION_SPAN = 1 << 20;
+
+// --- Types ---
+
+// Bound to one sound as it loads, so the alias only ever plays those samples, at the pitch they were resampled to
+typedef struct audio_Voice {
+  audio_Alias*   alias;
+  const void*    source;  // Buffer of the sound the alias was made from
+  int            generation;
+  unsigned       order;  // When it started, for stealing the oldest
+  audio_Priority priority;
+  float          volume;
+  bool           isLooping;
+} audio_Voice;
+
+// --- Global state ---
+
+static struct {
+  audio_Voice voices[SOUND_VOICE_COUNT];
+  int         voiceCount;
+  unsigned    nextOrder;
+} g_voices;
+
+// --- Helper functions ---
+
+static inline bool isBusy(const audio_Voice* voice) { return voice->isLooping || audio_isAliasPlaying(voice->alias); }
+
+static inline bool isOlder(const audio_Voice* voice, const audio_Voice* other) {
+  return (int) (voice->order - other->order) < 0;
+}
+
+// Old handles to a stopped voice no longer match
+static void stopVoice(audio_Voice* voice) {
+  audio_stopAlias(voice->alias);
+  voice->isLooping  = false;
+  voice->generation = (voice->generation + 1) % GENERATION_SPAN;
+}
+
+// A free voice of the sound's, or else the oldest of them that isn't looping
+static int findVoice(const void* source, bool* isFree) {
+  int found = -1;
+  for (int i = 0; i < g_voices.voiceCount; i++) {
+    const audio_Voice* voice = &g_voices.voices[i];
+    if (voice->source != source) continue;
+    if (!isBusy(voice)) {
+      *isFree = true;
+      return i;
+    }
+    if (!voice->isLooping && (found == -1 || isOlder(voice, &g_voices.voices[found]))) found = i;
+  }
+  *isFree = false;
+  return found;
+}
+
+// With as many playing as the device plays at once, stops the oldest of the lowest priority. False if they are all
+// more important or looping.
+static bool makeRoom(audio_Priority priority) {
+  int busyCount = 0;
+  int victim    = -1;
+  for (int i = 0; i < g_voices.voiceCount; i++) {
+    const audio_Voice* voice = &g_voices.voices[i];
+    if (!isBusy(voice)) continue;
+    busyCount++;
+    if (voice->isLooping || voice->priority > priority) continue;
+
+    const audio_Voice* best = victim == -1 ? nullptr : &g_voices.voices[victim];
+    if (best == nullptr || voice->priority < best->priority ||
+        (voice->priority == best->priority && isOlder(voice, best))) {
+      victim = i;
+    }
+  }
+  if (busyCount < VOICE_COUNT) return true;
+  if (victim == -1) return false;
+  stopVoice(&g_voices.voices[victim]);
+  return true;
+}
+
+static audio_Voice* getVoice(int handle) {
+  if (handle < 0) return nullptr;
+  audio_Voice* voice = &g_voices.voices[handle % SOUND_VOICE_COUNT];
+  return voice->generation == handle / SOUND_VOICE_COUNT ? voice : nullptr;
+}
+
+// --- Voice functions ---
+
+// Made as the sound loads and kept until it unloads, so playing never makes or frees an alias
+bool audio_bindVoices(Sound sound, int count) {
+  assert(sound.stream.buffer != nullptr);
+  assert(g_voices.voiceCount + count <= SOUND_VOICE_COUNT);
+
+  for (int i = 0; i < count; i++) {
+    audio_Alias* alias = audio_loadAlias(sound);
+    if (alias == nullptr) return false;
+    audio_Voice* voice = &g_voices.voices[g_voices.voiceCount++];
+    *voice = (audio_Voice) { .alias = alias, .source = sound.stream.buffer, .generation = voice->generation };
+  }
+  return true;
+}
+
+// Returns a handle for looping voices, or -1 if every voice is busy with something more important
+int audio_playVoice(Sound sound, float volume, float pan, audio_Priority priority, bool isLooping) {
+  assert(sound.stream.buffer != nullptr);
+  // Resampled to its pitch as it loaded, so the mixer plays it at its own rate
+  if (audio_isMixing()) return audio_mixPlay(sound, volume, 1.0f, pan, priority, isLooping);
+
+  bool isFree;
+  int  slot = findVoice(sound.stream.buffer, &isFree);
+  if (slot == -1 || (isFree && !makeRoom(priority))) return -1;
+
+  // Playing restarts one taken from its sound, and old handles to it no longer match
+  audio_Voice* voice = &g_voices.voices[slot];
+  voice->generation  = (voice->generation + 1) % GENERATION_SPAN;
+  voice->order      = g_voices.nextOrder++;
+  voice->priority   = priority;
+  voice->volume     = volume;
+  voice->isLooping  = isLooping;
+
+  audio_setAliasVolume(voice->alias, volume * options_getSfxVolume());
+  audio_setAliasPan(voice->alias, pan);
+  audio_playAlias(voice->alias);
+  return voice->generation * SOUND_VOICE_COUNT + slot;
+}
+
+// Restarts a looping voice that has reached its end, the mixer loops its own
+void audio_loopVoice(int handle) {
+  if (audio_isMixing()) return;
+  audio_Voice* voice = getVoice(handle);
+  if (voice != nullptr && voice->isLooping && !audio_isAliasPlaying(voice->alias)) audio_playAlias(voice->alias);
+}
+
+void audio_stopVoice(int handle) {
+  if (audio_isMixing()) {
+    audio_mixStop(handle);
+    return;
+  }
+  audio_Voice* voice = getVoice(handle);
+  if (voice != nullptr) stopVoice(voice);
+}
+
+void audio_setVoiceVolumes(float sfxVolume) {
+  for (int i = 0; i < g_voices.voiceCount; i++) {
+    audio_Voice* voice = &g_voices.voices[i];
+    audio_setAliasVolume(voice->alias, voice->volume * sfxVolume);
+  }
+}
+
+int audio_countVoices(void) {
+  int count = 0;
+  for (int i = 0; i < g_voices.voiceCount; i++) {
+    if (isBusy(&g_voices.voices[i])) count++;
+  }
+  return count;
+}
+
+// A loop like the whispers plays for as long as its creature is near, so only the one-shot effects duck the music
+bool audio_isEffectPlaying(void) {
+  for (int i = 0; i < g_voices.voiceCount; i++) {
+    const audio_Voice* voice = &g_voices.voices[i];
+    if (!voice->isLooping && audio_isAliasPlaying(voice->alias)) return true;
+  }
+  return false;
+}
+
+// Voices play the effects' samples, so have to go before the effects are unloaded
+void audio_releaseVoices(void) {
+  audio_waitCommands();
+  for (int i = 0; i < g_voices.voiceCount; i++) {
+    audio_Voice* voice = &g_voices.voices[i];
+    audio_unloadAlias(&voice->alias);
+    *voice = (audio_Voice) { .generation = voice->generation };
+  }
+  g_voices.voiceCount = 0;
+}
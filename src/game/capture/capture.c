@@ -0,0 +1,298 @@
+#include "capture.h"
+
+#if !defined(__EMSCRIPTEN__)
+
+#include <assert.h>
+#include <log/log.h>
+#include <pthread.h>
+#include <raylib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../internal.h"
+
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+// --- Constants ---
+
+constexpr int    MAX_WORKERS      = 16;
+constexpr int    SLOTS_PER_WORKER = 2;  // Lets the next frame be rasterised while every worker is busy
+constexpr int    MAX_SLOTS        = MAX_WORKERS * SLOTS_PER_WORKER;
+constexpr size_t PATH_LENGTH      = 256;
+
+static const char Y4M_EXTENSION[] = ".y4m";
+static const char FRAME_HEADER[]  = "FRAME\n";
+
+// --- Types ---
+
+typedef enum capture_SlotState { SLOT_FREE, SLOT_QUEUED, SLOT_BUSY, SLOT_ENCODED } capture_SlotState;
+
+typedef struct capture_Slot {
+  capture_SlotState state;
+  int               frame;
+  Color*            pixels;
+  unsigned char*    yuv;  // Y4M only, planar 4:2:0
+} capture_Slot;
+
+// --- Global state ---
+
+// Frames move through the slot ring in order, so the Y4M stream can be written as each next frame is encoded
+static struct {
+  pthread_t       workers[MAX_WORKERS];
+  int             workerCount;
+  pthread_mutex_t mutex;
+  pthread_cond_t  cond;
+  capture_Slot    slots[MAX_SLOTS];
+  int             slotCount;
+  int             nextFrame;  // Next frame to be pushed
+  int             nextJob;    // Next frame for a worker to pick up
+  int             nextWrite;  // Next frame to be finished
+  bool            isWriting;
+  bool            isQuitting;
+  bool            hasFailed;
+  FILE*           stream;  // Y4M only, otherwise frames go to a directory of PNGs
+  char            path[PATH_LENGTH];
+  int             width;
+  int             height;
+} g_capture = { .mutex = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER };
+
+// --- Helper functions ---
+
+static int getWorkerCount(void) {
+#if defined(_WIN32)
+  const char* processors = getenv("NUMBER_OF_PROCESSORS");
+  int         cores      = processors != nullptr ? atoi(processors) : 1;
+#else
+  int cores = (int) sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+  // The main thread is busy simulating and rasterising
+  return CLAMP(cores - 1, 1, MAX_WORKERS);
+}
+
+static inline unsigned char clampByte(int value) { return value < 0 ? 0 : value > 255 ? 255 : value; }
+
+// Full range BT.601 to match the C420jpeg tag, chroma is the average of each 2x2 block
+static void encodeYUV(const Color* pixels, unsigned char* yuv) {
+  int            width  = g_capture.width;
+  int            height = g_capture.height;
+  unsigned char* yPlane = yuv;
+  unsigned char* uPlane = yPlane + width * height;
+  unsigned char* vPlane = uPlane + (width / 2) * (height / 2);
+
+  for (int i = 0; i < width * height; i++) {
+    Color c   = pixels[i];
+    yPlane[i] = clampByte((77 * c.r + 150 * c.g + 29 * c.b + 128) >> 8);
+  }
+
+  for (int y = 0; y < height / 2; y++) {
+    for (int x = 0; x < width / 2; x++) {
+      const Color* row0 = &pixels[(2 * y) * width + 2 * x];
+      const Color* row1 = row0 + width;
+      int          r    = (row0[0].r + row0[1].r + row1[0].r + row1[1].r + 2) / 4;
+      int          g    = (row0[0].g + row0[1].g + row1[0].g + row1[1].g + 2) / 4;
+      int          b    = (row0[0].b + row0[1].b + row1[0].b + row1[1].b + 2) / 4;
+      int          i    = y * (width / 2) + x;
+      uPlane[i]         = clampByte((-43 * r - 85 * g + 128 * b + 32896) >> 8);
+      vPlane[i]         = clampByte((128 * r - 107 * g - 21 * b + 32896) >> 8);
+    }
+  }
+}
+
+static bool writePNG(const capture_Slot* slot) {
+  char file[PATH_LENGTH * 2];
+  snprintf(file, sizeof(file), "%s/frame%06d.png", g_capture.path, slot->frame);
+  Image image = {
+    .data    = slot->pixels,
+    .width   = g_capture.width,
+    .height  = g_capture.height,
+    .mipmaps = 1,
+    .format  = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8
+  };
+  return ExportImage(image, file);
+}
+
+static bool writeY4M(const capture_Slot* slot) {
+  size_t size = (size_t) g_capture.width * g_capture.height * 3 / 2;
+  return fwrite(FRAME_HEADER, sizeof(FRAME_HEADER) - 1, 1, g_capture.stream) == 1 &&
+         fwrite(slot->yuv, size, 1, g_capture.stream) == 1;
+}
+
+// Called with the mutex held, whichever worker finishes the next frame in order writes out every frame ready behind it
+static void writeEncoded(void) {
+  if (g_capture.isWriting) return;
+  g_capture.isWriting = true;
+
+  while (true) {
+    capture_Slot* slot = &g_capture.slots[g_capture.nextWrite % g_capture.slotCount];
+    if (slot->state != SLOT_ENCODED || slot->frame != g_capture.nextWrite) break;
+
+    pthread_mutex_unlock(&g_capture.mutex);
+    bool isWritten = writeY4M(slot);
+    pthread_mutex_lock(&g_capture.mutex);
+
+    if (!isWritten && !g_capture.hasFailed) {
+      LOG_ERROR(game_log, "Failed to write frame %d to %s", slot->frame, g_capture.path);
+      g_capture.hasFailed = true;
+    }
+    slot->state = SLOT_FREE;
+    g_capture.nextWrite++;
+    pthread_cond_broadcast(&g_capture.cond);
+  }
+
+  g_capture.isWriting = false;
+}
+
+static void* workerThread([[maybe_unused]] void* arg) {
+  pthread_mutex_lock(&g_capture.mutex);
+  while (true) {
+    capture_Slot* slot = &g_capture.slots[g_capture.nextJob % g_capture.slotCount];
+    if (slot->state == SLOT_QUEUED && slot->frame == g_capture.nextJob) {
+      slot->state = SLOT_BUSY;
+      g_capture.nextJob++;
+      pthread_mutex_unlock(&g_capture.mutex);
+
+      if (g_capture.stream != nullptr) {
+        encodeYUV(slot->pixels, slot->yuv);
+        pthread_mutex_lock(&g_capture.mutex);
+        slot->state = SLOT_ENCODED;
+        writeEncoded();
+      } else {
+        bool isWritten = writePNG(slot);
+        pthread_mutex_lock(&g_capture.mutex);
+        if (!isWritten && !g_capture.hasFailed) {
+          LOG_ERROR(game_log, "Failed to write frame %d to %s", slot->frame, g_capture.path);
+          g_capture.hasFailed = true;
+        }
+        // PNGs are separate files, so they can finish in any order
+        slot->state = SLOT_FREE;
+        g_capture.nextWrite++;
+        pthread_cond_broadcast(&g_capture.cond);
+      }
+      continue;
+    }
+
+    if (g_capture.isQuitting) break;
+    pthread_cond_wait(&g_capture.cond, &g_capture.mutex);
+  }
+  pthread_mutex_unlock(&g_capture.mutex);
+  return nullptr;
+}
+
+static bool openOutput(const char* path, int fps) {
+  strncpy(g_capture.path, path, PATH_LENGTH - 1);
+
+  if (!IsFileExtension(path, Y4M_EXTENSION)) {
+    if (!DirectoryExists(path) && MakeDirectory(path) != 0) {
+      LOG_ERROR(game_log, "Failed to create capture directory %s", path);
+      return false;
+    }
+    return true;
+  }
+
+  g_capture.stream = fopen(path, "wb");
+  if (g_capture.stream == nullptr) {
+    LOG_ERROR(game_log, "Failed to open %s for writing", path);
+    return false;
+  }
+  fprintf(g_capture.stream, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", g_capture.width, g_capture.height, fps);
+  return true;
+}
+
+static void freeSlots(void) {
+  for (int i = 0; i < MAX_SLOTS; i++) {
+    free(g_capture.slots[i].pixels);
+    free(g_capture.slots[i].yuv);
+    g_capture.slots[i] = (capture_Slot) {};
+  }
+}
+
+// --- Capture functions ---
+
+// A path ending in .y4m writes a video stream, anything else is a directory to fill with numbered PNGs
+bool capture_open(const char* path, int width, int height, int fps) {
+  assert(path != nullptr);
+  assert(g_capture.workerCount == 0);
+  assert(width > 0 && height > 0 && width % 2 == 0 && height % 2 == 0);
+
+  int workerCount      = getWorkerCount();
+  g_capture.width      = width;
+  g_capture.height     = height;
+  g_capture.slotCount  = workerCount * SLOTS_PER_WORKER;
+  g_capture.nextFrame  = 0;
+  g_capture.nextJob    = 0;
+  g_capture.nextWrite  = 0;
+  g_capture.isQuitting = false;
+  g_capture.hasFailed  = false;
+  GAME_TRY(openOutput(path, fps));
+
+  for (int i = 0; i < g_capture.slotCount; i++) {
+    capture_Slot* slot = &g_capture.slots[i];
+    slot->pixels       = malloc((size_t) width * height * sizeof(Color));
+    if (g_capture.stream != nullptr) slot->yuv = malloc((size_t) width * height * 3 / 2);
+    if (slot->pixels == nullptr || (g_capture.stream != nullptr && slot->yuv == nullptr)) {
+      LOG_ERROR(game_log, "Failed to allocate capture buffers");
+      capture_close();
+      return false;
+    }
+  }
+
+  for (int i = 0; i < workerCount; i++) {
+    if (pthread_create(&g_capture.workers[i], nullptr, workerThread, nullptr) != 0) {
+      LOG_ERROR(game_log, "Failed to start capture worker");
+      capture_close();
+      return false;
+    }
+    g_capture.workerCount++;
+  }
+
+  LOG_INFO(game_log, "Capturing to %s with %d workers", path, workerCount);
+  return true;
+}
+
+// Copies the frame, so the caller can rasterise the next one while this is encoded
+bool capture_pushFrame(const Color* pixels) {
+  assert(pixels != nullptr);
+  assert(g_capture.workerCount > 0);
+
+  pthread_mutex_lock(&g_capture.mutex);
+  capture_Slot* slot = &g_capture.slots[g_capture.nextFrame % g_capture.slotCount];
+  while (slot->state != SLOT_FREE) pthread_cond_wait(&g_capture.cond, &g_capture.mutex);
+  bool hasFailed = g_capture.hasFailed;
+  pthread_mutex_unlock(&g_capture.mutex);
+  if (hasFailed) return false;
+
+  memcpy(slot->pixels, pixels, (size_t) g_capture.width * g_capture.height * sizeof(Color));
+
+  pthread_mutex_lock(&g_capture.mutex);
+  slot->state = SLOT_QUEUED;
+  slot->frame = g_capture.nextFrame++;
+  pthread_cond_broadcast(&g_capture.cond);
+  pthread_mutex_unlock(&g_capture.mutex);
+  return true;
+}
+
+int capture_getFrameCount(void) { return g_capture.nextFrame; }
+
+// Waits for every pushed frame to be written
+void capture_close(void) {
+  pthread_mutex_lock(&g_capture.mutex);
+  if (g_capture.workerCount > 0) {
+    while (g_capture.nextWrite < g_capture.nextFrame) pthread_cond_wait(&g_capture.cond, &g_capture.mutex);
+  }
+  g_capture.isQuitting = true;
+  pthread_cond_broadcast(&g_capture.cond);
+  pthread_mutex_unlock(&g_capture.mutex);
+
+  for (int i = 0; i < g_capture.workerCount; i++) pthread_join(g_capture.workers[i], nullptr);
+  g_capture.workerCount = 0;
+
+  if (g_capture.stream != nullptr) {
+    fclose(g_capture.stream);
+    g_capture.stream = nullptr;
+  }
+  freeSlots();
+}
+
+#endif
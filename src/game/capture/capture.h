@@ -0,0 +1,11 @@
+// clang-format Language: C
+#pragma once
+
+#include <raylib.h>
+
+// --- Capture functions ---
+
+bool capture_open(const char* path, int width, int height, int fps);
+bool capture_pushFrame(const Color* pixels);
+int  capture_getFrameCount(void);
+void capture_close(void);
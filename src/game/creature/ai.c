@@ -7,6 +7,7 @@
 #include "../internal.h"
 #include "../maze/maze.h"
 #include "../player/player.h"
+#include "../trace/trace.h"
 #include "creature.h"
 #include "internal.h"
 #include "log/log.h"
@@ -99,8 +100,7 @@ static game_Dir greedyDirSelect(creature_Creature* creature, game_Dir dirs[], in
       bestDirs[bestDirCount++] = dirs[i];
       minDist                  = dist;
     }
-    LOG_TRACE(
-        game_log,
+    TRACE(
         "Creature %d: direction = %s, dist = %d, bestDirCount = %d",
         creature->id,
         DIR_STRINGS[dirs[i]],
@@ -111,7 +111,7 @@ static game_Dir greedyDirSelect(creature_Creature* creature, game_Dir dirs[], in
 
   assert(bestDirCount > 0);
   if (bestDirCount == 1) {
-    LOG_TRACE(game_log, "Creature %d going: %s (best choice)", creature->id, DIR_STRINGS[bestDirs[0]]);
+    TRACE("Creature %d going: %s (best choice)", creature->id, DIR_STRINGS[bestDirs[0]]);
     return bestDirs[0];
   } else {
     // Keep Arcade Mode deterministic
@@ -121,7 +121,7 @@ static game_Dir greedyDirSelect(creature_Creature* creature, game_Dir dirs[], in
     } else {
       dir = randomSelect(bestDirs, bestDirCount);
     }
-    LOG_TRACE(game_log, "Creature %d going: %s (%d choices)", creature->id, DIR_STRINGS[dir], bestDirCount);
+    TRACE("Creature %d going: %s (%d choices)", creature->id, DIR_STRINGS[dir], bestDirCount);
     return dir;
   }
 }
@@ -185,7 +185,7 @@ creatureUpdateCommon(creature_Creature* creature, double frameTime, float slop,
 
       if (count > 1 || currentDir != newDir) {
         actor_setDir(actor, newDir);
-        LOG_TRACE(game_log, "Creature %u chose new direction: %s", creature->id, DIR_STRINGS[newDir]);
+        TRACE("Creature %u chose new direction: %s", creature->id, DIR_STRINGS[newDir]);
         creature->decisionCooldown = DECISION_COOLDOWN;
       }
     }
@@ -238,12 +238,12 @@ void creature_penToStart(creature_Creature* creature, double frameTime, float sl
   float   startY = creature->mazeStart.y;
   Vector2 pos    = actor_getPos(actor);
   if (fabsf(pos.y - startY) > slop) {
-    LOG_TRACE(game_log, "Moving to line up wth exit");
+    TRACE("Moving to line up wth exit");
     dir = pos.y < startY ? DIR_DOWN : DIR_UP;
     actor_setDir(actor, dir);
     actor_moveNoCheck(actor, dir, frameTime);
   } else {
-    LOG_TRACE(game_log, "Moving to start tile");
+    TRACE("Moving to start tile");
     float startX = creature->mazeStart.x;
     dir          = pos.x < startX ? DIR_RIGHT : DIR_LEFT;
     actor_setDir(actor, dir);
@@ -272,12 +272,12 @@ void creature_startToPen(creature_Creature* creature, double frameTime, float sl
   float   startY = MAZE_CENTRE.y;
   Vector2 pos    = actor_getPos(actor);
   if (fabsf(pos.y - startY) > slop) {
-    LOG_TRACE(game_log, "Moving to line up wth exit");
+    TRACE("Moving to line up wth exit");
     dir = pos.y < startY ? DIR_DOWN : DIR_UP;
     actor_setDir(actor, dir);
     actor_moveNoCheck(actor, dir, frameTime);
   } else {
-    LOG_TRACE(game_log, "Moving to original tile");
+    TRACE("Moving to original tile");
     float startX = getStartPos(creature->id).x;
     dir          = pos.x < startX ? DIR_RIGHT : DIR_LEFT;
     actor_setDir(actor, dir);
@@ -7,6 +7,7 @@
 #include "../internal.h"
 #include "../maze/maze.h"
 #include "../player/player.h"
+#include "../telemetry/telemetry.h"
 #include "internal.h"
 #include "log/log.h"
 
@@ -68,9 +69,28 @@ static const char* getStateString(void (*update)(struct creature_Creature*, doub
   return "";
 }
 
+static telemetry_State getStateID(void (*update)(struct creature_Creature*, double, float)) {
+  assert(update != nullptr);
+
+  if (update == creature_pen) return TELEMETRY_STATE_PEN;
+  if (update == creature_penToStart) return TELEMETRY_STATE_PEN_TO_START;
+  if (update == creature_startToPen) return TELEMETRY_STATE_START_TO_PEN;
+  if (update == creature_frightened) return TELEMETRY_STATE_FRIGHTENED;
+  if (update == creature_dead) return TELEMETRY_STATE_DEAD;
+  if (update == creature_chase) return TELEMETRY_STATE_CHASE;
+  assert(update == creature_scatter);
+  return TELEMETRY_STATE_SCATTER;
+}
+
 static void transitionToState(void (*newState)(creature_Creature*, double, float)) {
   assert(newState != nullptr);
 
+  TELEMETRY_EVENT(
+      TELEMETRY_CREATURE_STATE,
+      getStateID(newState),
+      g_state.update != nullptr ? getStateID(g_state.update) : TELEMETRY_NO_STATE,
+      TELEMETRY_NOWHERE
+  );
   if (g_state.update != creature_frightened) g_state.lastUpdate = g_state.update;
   g_state.update = newState;
   for (int i = 0; i < CREATURE_COUNT; i++) {
@@ -96,10 +116,11 @@ static float getStateTimer(int stateNum) {
   float maxTimer = STATE_TIMERS_MAX[difficulty][stateNum];
 
   // Get current level-based interpolation factor
-  // Level 1 → t = 0.0, Level LEVEL_COUNT → t = 1.0
-  int level = game_getLevel();
-  assert(level >= 0 && level < LEVEL_COUNT);
-  float t = (float) level / (LEVEL_COUNT - 1);  // normalised [0,1]
+  // Level 1 → t = 0.0, last level → t = 1.0
+  int level      = game_getLevel();
+  int levelCount = maze_getLevelCount();
+  assert(level >= 0 && level < levelCount);
+  float t = levelCount > 1 ? (float) level / (levelCount - 1) : 0.0f;  // normalised [0,1]
 
   return minTimer + t * (maxTimer - minTimer);
 }
@@ -251,6 +272,12 @@ static void creatureDied(creature_Creature* creature) {
   creature->teleportTimer = 0.0f;
   creatureSetNearestStartTile(creature);
   player_killedCreature(creature->id);
+  TELEMETRY_EVENT(
+      TELEMETRY_CREATURE_KILLED,
+      creature->id,
+      0,
+      maze_getTile(Vector2AddValue(actor_getPos(creature->actor), ACTOR_SIZE / 2.0f))
+  );
   creature->whisperId = audio_playWhispers(actor_getPos(creature->actor));
 }
 
@@ -300,7 +327,7 @@ void creature_update(double frameTime, float slop) {
   assert(frameTime >= 0.0f);
   assert(slop >= MIN_SLOP && slop <= MAX_SLOP);
 
-  bool             playerDead  = false;
+  int              killerID    = -1;
   game_PlayerState playerState = player_getState();
 
   for (int i = 0; i < CREATURE_COUNT; i++) {
@@ -310,8 +337,8 @@ void creature_update(double frameTime, float slop) {
       if (actor_isColliding(player_getActor(), g_state.creatures[i].actor)) {
         if (playerState == PLAYER_SWORD) {
           creatureDied(&g_state.creatures[i]);
-        } else {
-          playerDead = true;
+        } else if (killerID == -1) {
+          killerID = i;
         }
       }
     }
@@ -322,15 +349,13 @@ void creature_update(double frameTime, float slop) {
       creatureCheckTeleport(&g_state.creatures[i]);
       creatureUpdateTeleportSlow(&g_state.creatures[i], frameTime);
     }
-
-    if (g_state.creatures[i].whisperId != -1) {
-      audio_updateWhispers(g_state.creatures[i].whisperId);
-    }
   }
 
   if (!player_hasSword()) updateState(frameTime);
 
-  if (playerDead && playerState != PLAYER_DEAD && playerState != PLAYER_FALLING) player_dead();
+  if (killerID != -1 && playerState != PLAYER_DEAD && playerState != PLAYER_FALLING) {
+    player_dead(TELEMETRY_DEATH_CREATURE, killerID);
+  }
 }
 
 Vector2 creature_getPos(int id) {
@@ -434,10 +459,11 @@ float creature_getSpeed(creature_Creature* creature) {
   }
 
   // Get current level-based interpolation factor
-  // Level 1 → t = 0.0, Level LEVEL_COUNT → t = 1.0
-  int level = game_getLevel();
-  assert(level >= 0 && level < LEVEL_COUNT);
-  float t = (float) level / (LEVEL_COUNT - 1);  // normalised [0,1]
+  // Level 1 → t = 0.0, last level → t = 1.0
+  int level      = game_getLevel();
+  int levelCount = maze_getLevelCount();
+  assert(level >= 0 && level < levelCount);
+  float t = levelCount > 1 ? (float) level / (levelCount - 1) : 0.0f;  // normalised [0,1]
 
   float speedMultiplier = minMult + t * (maxMult - minMult);
   return player_getMaxSpeed() * speedMultiplier;
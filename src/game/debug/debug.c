@@ -9,6 +9,7 @@
 #include "../internal.h"
 #include "../maze/maze.h"
 #include "../player/player.h"
+#include "../render/render.h"
 
 // --- Types ---
 
@@ -61,7 +62,7 @@ static void drawActorArrow(game_Actor* actor) {
     default: assert(false); return;
   }
 
-  engine_drawArrow(start, end, ACTOR_SIZE, WHITE);
+  render_arrow(start, end, ACTOR_SIZE, WHITE);
 }
 
 // --- Debug functions ---
@@ -70,11 +71,13 @@ void debug_reset(void) { g_debug = (Debug) {}; }
 
 void debug_drawOverlay(void) {
   if (g_debug.isPlayerImmune) {
-    DrawText("Player immune", OVERLAY_IMMUNE_POS.x, OVERLAY_IMMUNE_POS.y, OVERLAY_LARGE_TEXT_SIZE, RED);
+    render_screenText("Player immune", OVERLAY_IMMUNE_POS.x, OVERLAY_IMMUNE_POS.y, OVERLAY_LARGE_TEXT_SIZE, RED);
   }
 
   if (g_debug.isFPSOverlayEnabled) {
-    DrawFPS(OVERLAY_FPS_POS.x, OVERLAY_FPS_POS.y);
+    render_screenText(
+        TextFormat("%2i FPS", GetFPS()), OVERLAY_FPS_POS.x, OVERLAY_FPS_POS.y, OVERLAY_LARGE_TEXT_SIZE, LIME
+    );
   }
 
   if (g_debug.isMazeOverlayEnabled) {
@@ -84,7 +87,7 @@ void debug_drawOverlay(void) {
   if (g_debug.isPlayerOverlayEnabled) {
     actor_overlay(player_getActor(), OVERLAY_COLOUR_PLAYER);
     actor_canMoveOverlay(player_getActor());
-    engine_drawFloat(actor_getSpeed(player_getActor()), POS_ADJUST(player_getPos()), OVERLAY_NUMBER_SIZE, WHITE);
+    render_debugFloat(actor_getSpeed(player_getActor()), POS_ADJUST(player_getPos()), OVERLAY_NUMBER_SIZE, WHITE);
   }
 
   if (g_debug.isCreatureOverlayEnabled) {
@@ -97,20 +100,20 @@ void debug_drawOverlay(void) {
       float   cooldown = creature_getDecisionCooldown(i);
       Color   colour   = cooldown == 0.0f ? WHITE : RED;
       Vector2 pos      = POS_ADJUST(actor_getPos(actor));
-      engine_drawFloat(cooldown, pos, OVERLAY_NUMBER_SIZE, colour);
+      render_debugFloat(cooldown, pos, OVERLAY_NUMBER_SIZE, colour);
 
       const char* string = creature_getStateString(i);
       float       scale  = engine_getScale();
-      engine_drawText(
+      render_debugText(
           string, (Vector2) { pos.x, pos.y + ACTOR_SIZE - OVERLAY_TEXT_SIZE / scale }, OVERLAY_TEXT_SIZE, WHITE
       );
 
       pos.y += 4;
-      engine_drawFloat(actor_getSpeed(actor), pos, OVERLAY_NUMBER_SIZE, WHITE);
+      render_debugFloat(actor_getSpeed(actor), pos, OVERLAY_NUMBER_SIZE, WHITE);
 
-      engine_drawInt(creature_getGlobaStateNum() - 1, OVERLAY_STATE_NUM, OVERLAY_NUMBER_SIZE, WHITE);
-      engine_drawText(creature_getGlobalStateString(), OVERLAY_STATE_STRING, OVERLAY_LARGE_TEXT_SIZE, WHITE);
-      engine_drawFloat(creature_getGlobalTimer(), OVERLAY_STATE_TIMER, OVERLAY_NUMBER_SIZE, WHITE);
+      render_debugInt(creature_getGlobaStateNum() - 1, OVERLAY_STATE_NUM, OVERLAY_NUMBER_SIZE, WHITE);
+      render_debugText(creature_getGlobalStateString(), OVERLAY_STATE_STRING, OVERLAY_LARGE_TEXT_SIZE, WHITE);
+      render_debugFloat(creature_getGlobalTimer(), OVERLAY_STATE_TIMER, OVERLAY_NUMBER_SIZE, WHITE);
 
       Vector2 start        = POS_ADJUST(actor_getPos(actor));
       start                = Vector2AddValue(start, TILE_SIZE / 2.0f);
@@ -118,7 +121,7 @@ void debug_drawOverlay(void) {
       if (targetTile.col >= 0 && targetTile.row >= 0) {
         Vector2 end = POS_ADJUST(maze_getPos(targetTile));
         end         = Vector2AddValue(end, TILE_SIZE / 2.0f);
-        engine_drawLine(start, end, BLACK);
+        render_line(start, end, BLACK);
       }
     }
   }
@@ -6,11 +6,15 @@
 #include <stdarg.h>
 #include "../asset/asset.h"
 #include "../creature/creature.h"
+#include "../input/input.h"
 #include "../internal.h"
+#include "../maze/maze.h"
 #include "../options/options.h"
 #include "../player/player.h"
+#include "../render/render.h"
 #include "../scores/scores.h"
 #include "game/game.h"
+#include "internal.h"
 
 // --- Constants ---
 
@@ -29,6 +33,10 @@ static const Rectangle GAME_WON_BG_RECTANGLE = { 130, 90, 220, 90 };
 static const Color     GAME_WON_BG_COLOUR    = { 64, 64, 64, 200 };
 static const Color     GAME_WON_BG_BORDER    = { 255, 255, 255, 200 };
 
+static const Rectangle LOADING_BAR_RECTANGLE = { 140, 256, 200, 6 };
+static const Color     LOADING_BAR_COLOUR    = { 245, 245, 245, 200 };
+static const Color     LOADING_BAR_BORDER    = { 255, 255, 255, 200 };
+
 constexpr Color        RECORD_COLOUR          = { 253, 255, 0, 255 };
 constexpr Color        SHADOW_COLOUR          = { 32, 32, 32, 255 };
 static draw_Text       SWORD_TIMER            = { "%d", 0, 0, TEXT_COLOUR, FONT_TINY };
@@ -42,12 +50,14 @@ static const draw_Text LEVEL_TIME_TEXT        = { "This level's time:  %s", 153,
 static const draw_Text LEVEL_SCORE_TEXT       = { "This level's score: %d", 153, 130, TEXT_COLOUR, FONT_NORMAL };
 static const draw_Text TIME_RECORD_TEXT       = { "New record time!", 153, 150, RECORD_COLOUR, FONT_NORMAL };
 static const draw_Text SCORE_RECORD_TEXT      = { "New record score!", 153, 160, RECORD_COLOUR, FONT_NORMAL };
+static const draw_Text LEVEL_BEATEN_TEXT      = { "Faster than %d%% of runs", 153, 140, TEXT_COLOUR, FONT_NORMAL };
 static const draw_Text GAME_OVER_TEXT         = { "Game over!", 210, 100, TEXT_COLOUR, FONT_NORMAL };
 static const draw_Text GAME_WON_TEXT          = { "Game won!", 140, 100, TEXT_COLOUR, FONT_NORMAL };
 static const draw_Text TOTAL_RUN_TIME_TEXT    = { "This run's total time:  %s", 140, 120, TEXT_COLOUR, FONT_NORMAL };
 static const draw_Text TOTal_RUN_SCORE_TEXT   = { "This run's total score: %d", 140, 130, TEXT_COLOUR, FONT_NORMAL };
 static const draw_Text TOTAL_RUN_TIME_RECORD  = { "New record total time!", 140, 150, RECORD_COLOUR, FONT_NORMAL };
 static const draw_Text TOTAl_RUN_SCORE_RECORD = { "New record total score!", 140, 160, RECORD_COLOUR, FONT_NORMAL };
+static const draw_Text TOTAL_RUN_BEATEN_TEXT  = { "Faster than %d%% of full runs", 140, 140, TEXT_COLOUR, FONT_NORMAL };
 static const draw_Text SPACE_TEXT             = { "Press space", 206, 188, TEXT_COLOUR, FONT_NORMAL };
 static const draw_Text PLAYER_READY_TEXT[DIFFICULTY_COUNT] = {
   {        "Get ready!", 210, 100, TEXT_COLOUR, FONT_NORMAL },
@@ -60,16 +70,25 @@ static const draw_Text DIFFICULTY_TEXT[DIFFICULTY_COUNT] = {
   { "Arcade Mode", 206, 252, TEXT_COLOUR, FONT_NORMAL }
 };
 
+// --- Global state ---
+
+static int g_maxScale;  // Latched on the main thread, monitor queries aren't safe from the simulation thread
+
 // --- Helper functions ---
 
+// Window changes are applied by the main thread from the saved options
+static void applyScale(void) { engine_setScale(options_getScreenScale()); }
+
+static void applyMode(void) { engine_setWindowMode(options_getWindowMode(), options_getScreenScale()); }
+
 static void setScale(int scale) {
   options_setScreenSacle(scale);
-  engine_setScale(scale);
+  game_runOnMainThread(applyScale);
 }
 
 static void setMode(engine_WindowMode mode) {
   options_setWindowMode(mode);
-  engine_setWindowMode(mode, options_getScreenScale());
+  game_runOnMainThread(applyMode);
 }
 
 // --- Draw functions ---
@@ -78,8 +97,9 @@ void draw_text(draw_Text text, ...) {
   engine_Font* font = text.fontSize == FONT_TINY ? asset_getFontTiny() : asset_getFont();
   va_list      args;
   va_start(args, text);
-  engine_fontPrintfV(font, text.xPos, text.yPos, text.colour, text.format, args);
+  text_Layout layout = text_format(font, text.format, args);
   va_end(args);
+  render_glyphs(font, layout.glyphs, layout.glyphCount, text.xPos, text.yPos, text.colour);
 }
 
 int draw_getTextOffset(int number) {
@@ -93,26 +113,28 @@ void draw_shadowText(draw_Text text, ...) {
   engine_Font* font = text.fontSize == FONT_TINY ? asset_getFontTiny() : asset_getFont();
   va_list      args;
   va_start(args, text);
-  engine_fontPrintfV(font, text.xPos + 1, text.yPos + 1, SHADOW_COLOUR, text.format, args);
-  engine_fontPrintfV(font, text.xPos, text.yPos, text.colour, text.format, args);
+  text_Layout layout = text_format(font, text.format, args);
   va_end(args);
+  // Both passes share the one layout
+  render_glyphs(font, layout.glyphs, layout.glyphCount, text.xPos + 1, text.yPos + 1, SHADOW_COLOUR);
+  render_glyphs(font, layout.glyphs, layout.glyphCount, text.xPos, text.yPos, text.colour);
 }
 
 void draw_resetPlayer(void) {
   game_PlayerState state = player_getState();
   Vector2          pos   = POS_ADJUST(player_getPos());
   game_Dir         dir   = player_getDir();
-  engine_resetAnim(asset_getPlayerAnim(state, dir));
-  engine_spriteSetPos(asset_getPlayerSprite(state), pos);
+  render_resetAnim(asset_getPlayerAnim(state, dir));
+  render_spriteSetPos(asset_getPlayerSprite(state), pos);
 }
 
 void draw_resetCreatures(void) {
   for (int i = 0; i < CREATURE_COUNT; i++) {
-    Vector2  pos        = Vector2Add(POS_ADJUST(creature_getPos(i)), asset_getCreatureOffset(i));
-    game_Dir dir        = creature_getDir(i);
     int      creatureID = i + game_getLevel() * CREATURE_COUNT;
-    engine_resetAnim(asset_getCreatureAnim(creatureID, dir));
-    engine_spriteSetPos(asset_getCreateSprite(creatureID), pos);
+    Vector2  pos        = Vector2Add(POS_ADJUST(creature_getPos(i)), asset_getCreatureOffset(creatureID));
+    game_Dir dir        = creature_getDir(i);
+    render_resetAnim(asset_getCreatureAnim(creatureID, dir));
+    render_spriteSetPos(asset_getCreateSprite(creatureID), pos);
   }
 }
 
@@ -133,15 +155,15 @@ void draw_updatePlayer(double frameTime, [[maybe_unused]] float slop) {
       );
     if (prevDir != DIR_NONE && dir != prevDir)
       LOG_TRACE(game_log, "Player direction changed from %s to %s", DIR_STRINGS[prevDir], DIR_STRINGS[dir]);
-    engine_resetAnim(asset_getPlayerAnim(state, dir));
+    render_resetAnim(asset_getPlayerAnim(state, dir));
     prevState = state;
     prevDir   = dir;
   }
 
-  engine_spriteSetPos(asset_getPlayerSprite(state), pos);
+  render_spriteSetPos(asset_getPlayerSprite(state), pos);
 
   if (player_isMoving() || state == PLAYER_SWORD || state == PLAYER_DEAD || state == PLAYER_FALLING) {
-    engine_updateAnim(asset_getPlayerAnim(state, dir), frameTime);
+    render_updateAnim(asset_getPlayerAnim(state, dir), frameTime);
   }
 }
 
@@ -155,13 +177,13 @@ void draw_updateCreatures(double frameTime, [[maybe_unused]] float slop) {
     int             creatureID              = i + game_getLevel() * CREATURE_COUNT;
 
     if (dir != prevDir[i]) {
-      engine_resetAnim(asset_getCreatureAnim(creatureID, dir));
+      render_resetAnim(asset_getCreatureAnim(creatureID, dir));
       prevDir[i] = dir;
     }
 
     Vector2 pos = Vector2Add(POS_ADJUST(creature_getPos(i)), asset_getCreatureOffset(creatureID));
-    engine_spriteSetPos(asset_getCreateSprite(creatureID), pos);
-    engine_updateAnim(asset_getCreatureAnim(creatureID, dir), frameTime);
+    render_spriteSetPos(asset_getCreateSprite(creatureID), pos);
+    render_updateAnim(asset_getCreatureAnim(creatureID, dir), frameTime);
   }
 }
 
@@ -171,7 +193,7 @@ void draw_player(void) {
   bool flash = false;
   if (swordTimer > 0.0f && swordTimer < 1.0f) flash = ((int) (swordTimer * 10) % 2) == 0;
   Color colour = flash ? BLACK : WHITE;
-  engine_drawSprite(asset_getPlayerSpriteSheet(), asset_getPlayerSprite(player_getState()), colour);
+  render_sprite(asset_getPlayerSpriteSheet(), asset_getPlayerSprite(player_getState()), colour);
 
   int lives = player_getLives() - 1;
   for (int i = 0; i < lives; i++) {
@@ -182,7 +204,7 @@ void draw_player(void) {
       text.yPos      = pos.y + NEW_LIFE_OFFSETY;
       draw_shadowText(text);
     } else {
-      engine_drawSprite(asset_getPlayerSpriteSheet(), asset_getPlayerLivesSprite(i), WHITE);
+      render_sprite(asset_getPlayerSpriteSheet(), asset_getPlayerLivesSprite(i), WHITE);
     }
   }
 
@@ -199,7 +221,7 @@ void draw_creatures(void) {
   for (int i = 0; i < CREATURE_COUNT; i++) {
     Color colour     = creature_isFrightened(i) ? BLUE : creature_isDead(i) ? CREATURE_DEAD_COLOUR : WHITE;
     int   creatureID = i + game_getLevel() * CREATURE_COUNT;
-    engine_drawSprite(asset_getCreatureSpriteSheet(), asset_getCreateSprite(creatureID), colour);
+    render_sprite(asset_getCreatureSpriteSheet(), asset_getCreateSprite(creatureID), colour);
 
     int score = creature_getScore(i);
     if (score > 0.0f) {
@@ -215,23 +237,24 @@ void draw_cursor(void) {
   engine_Sprite* sprite = asset_getCursorSprite();
   // Hack as we want the sprite scaled but the position is also scaled
   int     scale = engine_getScale();
-  Vector2 pos   = Vector2Scale(engine_getMousePosition(), 1.0f / scale);
-  engine_spriteSetPos(sprite, pos);
-  engine_drawSprite(asset_getCursorSpriteSheet(), sprite, WHITE);
+  Vector2 pos   = Vector2Scale(input_getMousePosition(), 1.0f / scale);
+  render_spriteSetPos(sprite, pos);
+  render_setLayer(LAYER_CURSOR);
+  render_sprite(asset_getCursorSpriteSheet(), sprite, WHITE);
 }
 
 void draw_interface(void) {
   draw_text(SCORE_TEXT, player_getScore());
-  draw_text(LEVEL_TEXT, game_getLevel() + 1, LEVEL_COUNT);
+  draw_text(LEVEL_TEXT, game_getLevel() + 1, maze_getLevelCount());
   draw_text(DIFFICULTY_TEXT[game_getDifficulty()]);
 }
 
 void draw_nextLife(void) {
-  engine_drawSprite(asset_getPlayerSpriteSheet(), asset_getPlayerNextLifeSprite(), WHITE);
+  render_sprite(asset_getPlayerSpriteSheet(), asset_getPlayerNextLifeSprite(), WHITE);
   draw_text(EXTRA_LIFE_TEXT, player_getNextExtraLifeScore());
 }
 
-void draw_title(void) { engine_drawBackground(asset_getLogo()); }
+void draw_title(void) { render_background(asset_getLogo()); }
 
 void draw_ready(void) {
   draw_shadowText(PLAYER_READY_TEXT[game_getDifficulty()]);
@@ -239,14 +262,15 @@ void draw_ready(void) {
 }
 
 void draw_levelClear(void) {
-  engine_drawRectangle(LEVEL_CLEAR_BG_RECTANGLE, LEVEL_CLEAR_BG_COLOUR);
-  engine_drawRectangleOutline(LEVEL_CLEAR_BG_RECTANGLE, LEVEL_CLEAR_BG_BORDER);
+  render_rectangle(LEVEL_CLEAR_BG_RECTANGLE, LEVEL_CLEAR_BG_COLOUR);
+  render_rectangleOutline(LEVEL_CLEAR_BG_RECTANGLE, LEVEL_CLEAR_BG_BORDER);
 
   draw_shadowText(LEVEL_CLEAR_TEXT);
 
   player_levelData data = player_getLevelData();
   draw_shadowText(LEVEL_TIME_TEXT, scores_printTime(data.time));
   draw_shadowText(LEVEL_SCORE_TEXT, data.score);
+  if (data.clearResult.timeBeaten >= 0) draw_shadowText(LEVEL_BEATEN_TEXT, data.clearResult.timeBeaten);
 
   if (data.clearResult.isTimeRecord) draw_shadowText(TIME_RECORD_TEXT);
   if (data.clearResult.isScoreRecord) draw_shadowText(SCORE_RECORD_TEXT);
@@ -259,38 +283,53 @@ void draw_gameOver(void) {
   draw_shadowText(SPACE_TEXT);
 }
 
+// Only rectangles, as it is drawn before the fonts have loaded
+void draw_loading(float progress) {
+  Rectangle bar = LOADING_BAR_RECTANGLE;
+  render_rectangleOutline(bar, LOADING_BAR_BORDER);
+  bar.x      += 1.0f;
+  bar.y      += 1.0f;
+  bar.width   = (bar.width - 2.0f) * Clamp(progress, 0.0f, 1.0f);
+  bar.height -= 2.0f;
+  render_rectangle(bar, LOADING_BAR_COLOUR);
+}
+
 void draw_gameWon(void) {
-  engine_drawRectangle(GAME_WON_BG_RECTANGLE, GAME_WON_BG_COLOUR);
-  engine_drawRectangleOutline(GAME_WON_BG_RECTANGLE, GAME_WON_BG_BORDER);
+  render_rectangle(GAME_WON_BG_RECTANGLE, GAME_WON_BG_COLOUR);
+  render_rectangleOutline(GAME_WON_BG_RECTANGLE, GAME_WON_BG_BORDER);
 
   draw_shadowText(GAME_WON_TEXT);
 
   player_levelData data = player_getFullRunData();
   draw_shadowText(TOTAL_RUN_TIME_TEXT, scores_printTime(data.time));
   draw_shadowText(TOTal_RUN_SCORE_TEXT, data.score);
+  if (data.clearResult.timeBeaten >= 0) draw_shadowText(TOTAL_RUN_BEATEN_TEXT, data.clearResult.timeBeaten);
 
   if (data.clearResult.isTimeRecord) draw_shadowText(TOTAL_RUN_TIME_RECORD);
   if (data.clearResult.isScoreRecord) draw_shadowText(TOTAl_RUN_SCORE_RECORD);
 }
 
+void draw_latchDisplay(void) { g_maxScale = engine_getMaxScale(); }
+
 int draw_getMaxScale(void) {
-  int scale = engine_getMaxScale();
+  assert(g_maxScale > 0);
+  int scale = g_maxScale;
   if (options_getWindowMode() == MODE_WINDOWED) scale--;
   return MIN(scale, MAX_SCALE);
 }
 
 void draw_fullscreenBorderless(void) {
-  if (options_getWindowMode() == MODE_WINDOWED) options_setScreenSacle(engine_getMaxScale());
+  if (options_getWindowMode() == MODE_WINDOWED) options_setScreenSacle(g_maxScale);
   setMode(MODE_BORDERLESS);
 }
 
 void draw_fullscreenOn(void) {
-  if (options_getWindowMode() == MODE_WINDOWED) options_setScreenSacle(engine_getMaxScale());
+  if (options_getWindowMode() == MODE_WINDOWED) options_setScreenSacle(g_maxScale);
   setMode(MODE_FULLSCREEN);
 }
 
 void draw_fullscreenOff(void) {
-  int windowedMaxScale = engine_getMaxScale() - 1;
+  int windowedMaxScale = g_maxScale - 1;
   if (options_getScreenScale() > windowedMaxScale) options_setScreenSacle(windowedMaxScale);
   setMode(MODE_WINDOWED);
 }
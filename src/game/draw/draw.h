@@ -40,6 +40,8 @@ void draw_ready(void);
 void draw_levelClear(void);
 void draw_gameOver(void);
 void draw_gameWon(void);
+void draw_loading(float progress);
+void draw_latchDisplay(void);
 int  draw_getMaxScale(void);
 void draw_fullscreenBorderless(void);
 void draw_fullscreenOn(void);
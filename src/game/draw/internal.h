@@ -0,0 +1,28 @@
+/*
+ * internal.h: Internal to draw units, don't include in other units.
+ */
+
+#pragma once
+// Clang format Language: C
+
+#include <engine/engine.h>
+#include <stdarg.h>
+#include "../render/render.h"
+
+// --- Constants ---
+
+constexpr int TEXT_CACHE_SIZE     = 64;
+constexpr int TEXT_CACHE_MAX_ARGS = 8;
+constexpr int TEXT_CACHE_LENGTH   = 128;
+
+// --- Types ---
+
+// Formatted text laid out in the font it was formatted for, valid until the next call
+typedef struct text_Layout {
+  const render_Glyph* glyphs;
+  int                 glyphCount;
+} text_Layout;
+
+// --- Text cache functions ---
+
+text_Layout text_format(const engine_Font* font, const char* format, va_list args);
@@ -0,0 +1,205 @@
+#include <assert.h>
+#include <engine/engine.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "../internal.h"
+#include "../render/render.h"
+#include "internal.h"
+
+// --- Types ---
+
+// The printf length modifiers, which decide the type each argument is read as
+typedef enum text_Length {
+  LENGTH_NONE,
+  LENGTH_LONG,
+  LENGTH_LONG_LONG,
+  LENGTH_INTMAX,
+  LENGTH_SIZE,
+  LENGTH_PTRDIFF,
+  LENGTH_LONG_DOUBLE
+} text_Length;
+
+typedef struct text_Entry {
+  const engine_Font* font;
+  const char*        format;
+  uint64_t           args[TEXT_CACHE_MAX_ARGS];
+  int                argCount;
+  unsigned           lastUsed;
+  char               text[TEXT_CACHE_LENGTH];
+  render_Glyph       glyphs[TEXT_CACHE_LENGTH];  // Laid out whenever the text is formatted
+  int                glyphCount;
+} text_Entry;
+
+typedef struct text_Key {
+  uint64_t args[TEXT_CACHE_MAX_ARGS];
+  int      argCount;
+  bool     isCacheable;
+} text_Key;
+
+// --- Global state ---
+
+static struct {
+  text_Entry entries[TEXT_CACHE_SIZE];
+  unsigned   tick;
+} g_state;
+
+// --- Helper functions ---
+
+// FNV-1a, strings are keyed by content as callers often reuse a static buffer
+static uint64_t hashString(const char* string) {
+  uint64_t hash = 14695981039346656037ull;
+  for (const char* c = string ? string : "(null)"; *c; c++) {
+    hash ^= (unsigned char) *c;
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+// hh and h are promoted to int
+static text_Length readLength(const char** c) {
+  switch (**c) {
+    case 'h':
+      while (**c == 'h') (*c)++;
+      return LENGTH_NONE;
+    case 'l':
+      (*c)++;
+      if (**c != 'l') return LENGTH_LONG;
+      (*c)++;
+      return LENGTH_LONG_LONG;
+    case 'j': (*c)++; return LENGTH_INTMAX;
+    case 'z': (*c)++; return LENGTH_SIZE;
+    case 't': (*c)++; return LENGTH_PTRDIFF;
+    case 'L': (*c)++; return LENGTH_LONG_DOUBLE;
+    default : return LENGTH_NONE;
+  }
+}
+
+static uint64_t readInteger(text_Length length, va_list* args) {
+  switch (length) {
+    case LENGTH_LONG: return (uint64_t) va_arg(*args, long);
+    case LENGTH_LONG_LONG: return (uint64_t) va_arg(*args, long long);
+    case LENGTH_INTMAX: return (uint64_t) va_arg(*args, intmax_t);
+    case LENGTH_SIZE: return (uint64_t) va_arg(*args, size_t);
+    case LENGTH_PTRDIFF: return (uint64_t) va_arg(*args, ptrdiff_t);
+    case LENGTH_NONE:
+    case LENGTH_LONG_DOUBLE: break;
+  }
+  return (uint64_t) va_arg(*args, int);
+}
+
+// Walk the printf conversions to pull out the argument values, these form the key along with the format pointer
+static text_Key buildKey(const char* format, va_list* args) {
+  text_Key key = { .isCacheable = true };
+
+  for (const char* c = format; *c; c++) {
+    if (*c != '%') continue;
+    c++;
+    if (*c == '%') continue;
+
+    while (*c && strchr("-+ #0", *c)) c++;
+    while (*c == '*' || (*c >= '0' && *c <= '9') || *c == '.') {
+      if (*c == '*') {
+        if (key.argCount == TEXT_CACHE_MAX_ARGS) return (text_Key) {};
+        key.args[key.argCount++] = (uint64_t) va_arg(*args, int);
+      }
+      c++;
+    }
+
+    text_Length length = readLength(&c);
+    if (key.argCount == TEXT_CACHE_MAX_ARGS) return (text_Key) {};
+    switch (*c) {
+      case 'd':
+      case 'i':
+      case 'u':
+      case 'o':
+      case 'x':
+      case 'X': key.args[key.argCount++] = readInteger(length, args); break;
+      // A wide character or string would need wint_t or wchar_t, which nothing draws
+      case 'c':
+        if (length != LENGTH_NONE) return (text_Key) {};
+        key.args[key.argCount++] = (uint64_t) va_arg(*args, int);
+        break;
+      case 's':
+        if (length != LENGTH_NONE) return (text_Key) {};
+        key.args[key.argCount++] = hashString(va_arg(*args, const char*));
+        break;
+      case 'f':
+      case 'F':
+      case 'e':
+      case 'E':
+      case 'g':
+      case 'G':
+      case 'a':
+      case 'A':
+        if (length == LENGTH_LONG_DOUBLE) {
+          // Split into the nearest double and what's left over, so values differing past a double's precision don't
+          // share an entry
+          if (key.argCount + 2 > TEXT_CACHE_MAX_ARGS) return (text_Key) {};
+          long double value = va_arg(*args, long double);
+          double      high  = (double) value;
+          double      low   = (double) (value - high);
+          memcpy(&key.args[key.argCount++], &high, sizeof(high));
+          memcpy(&key.args[key.argCount++], &low, sizeof(low));
+        } else {
+          double value = va_arg(*args, double);
+          memcpy(&key.args[key.argCount++], &value, sizeof(value));
+        }
+        break;
+      case 'p': key.args[key.argCount++] = (uint64_t) (uintptr_t) va_arg(*args, void*); break;
+      default : return (text_Key) {};
+    }
+  }
+
+  return key;
+}
+
+static bool isMatch(const text_Entry* entry, const engine_Font* font, const char* format, const text_Key* key) {
+  return entry->format == format && entry->font == font && entry->argCount == key->argCount &&
+         memcmp(entry->args, key->args, key->argCount * sizeof(key->args[0])) == 0;
+}
+
+// --- Text cache functions ---
+
+// Returns the text's glyphs, only formatting and laying it out again when the format, font or arguments change. Plain
+// strings are keyed by their format alone.
+text_Layout text_format(const engine_Font* font, const char* format, va_list args) {
+  assert(font != nullptr);
+  assert(format != nullptr);
+
+  va_list keyArgs;
+  va_copy(keyArgs, args);
+  text_Key key = buildKey(format, &keyArgs);
+  va_end(keyArgs);
+
+  g_state.tick++;
+
+  text_Entry* victim = &g_state.entries[0];
+  if (key.isCacheable) {
+    for (int i = 0; i < TEXT_CACHE_SIZE; i++) {
+      text_Entry* entry = &g_state.entries[i];
+      if (isMatch(entry, font, format, &key)) {
+        entry->lastUsed = g_state.tick;
+        return (text_Layout) { .glyphs = entry->glyphs, .glyphCount = entry->glyphCount };
+      }
+      if (entry->lastUsed < victim->lastUsed) victim = entry;
+    }
+  }
+
+  // Least recently used entry is replaced, an unusual format gets a single uncached slot
+  vsnprintf(victim->text, sizeof(victim->text), format, args);
+  victim->glyphCount = render_layoutText(font, victim->text, victim->glyphs, TEXT_CACHE_LENGTH);
+  if (key.isCacheable) {
+    victim->font     = font;
+    victim->format   = format;
+    victim->argCount = key.argCount;
+    memcpy(victim->args, key.args, sizeof(key.args));
+    victim->lastUsed = g_state.tick;
+  } else {
+    victim->format   = nullptr;
+    victim->lastUsed = 0;
+  }
+  return (text_Layout) { .glyphs = victim->glyphs, .glyphCount = victim->glyphCount };
+}
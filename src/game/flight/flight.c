@@ -0,0 +1,237 @@
+#include "flight.h"
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <log/log.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "../creature/creature.h"
+#include "../input/input.h"
+#include "../internal.h"
+#include "../player/player.h"
+
+#if !defined(__EMSCRIPTEN__)
+#define FLIGHT_SIGNALS
+#if defined(_WIN32)
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <unistd.h>
+#endif
+#endif
+
+// --- Constants ---
+
+constexpr uint32_t  FRAME_RING        = 32768;  // Frames, power of two, minutes of play at any refresh rate
+constexpr uint32_t  SNAPSHOT_RING     = 16;     // Power of two
+static const double SNAPSHOT_INTERVAL = 1.0;    // Seconds of game time
+constexpr size_t    PATH_LENGTH       = 64;
+
+#if defined(FLIGHT_SIGNALS)
+static const char DUMP_FILE[]    = "crash-%lld.mdr";  // Session
+static const char DUMP_MESSAGE[] = "Crashed, the flight recorder was dumped to ";
+static const int  SIGNALS[]      = { SIGSEGV, SIGABRT, SIGFPE, SIGILL };
+#if !defined(_WIN32)
+constexpr size_t ALT_STACK_SIZE = 64 * 1024;  // So the main thread overflowing its stack can still dump
+#endif
+#endif
+
+// --- Global state ---
+
+// Fixed in size and only ever copied into, so the signal handler can write it out as it stands
+static struct {
+  replay_Frame           frames[FRAME_RING];
+  uint32_t               frameCount;  // Since the session started
+  uint32_t               checkpointFrame;
+  bool                   hasCheckpoint;
+  replay_Checkpoint      checkpoint;
+  replay_Snapshot        snapshots[SNAPSHOT_RING];
+  uint32_t               snapshotCount;  // Since the checkpoint
+  double                 nextSnapshot;
+  const replay_Snapshot* expected;  // The crash dump's being played back, until its level ends
+  int                    expectedCount;
+  bool                   hasDiverged;
+  char                   path[PATH_LENGTH];
+  bool                   isOpen;
+} g_flight;
+
+// --- Helper functions ---
+
+// Playing back a crash dump, the world should match each of its snapshots exactly
+static void checkSnapshot(const replay_Snapshot* snapshot) {
+  if (g_flight.hasDiverged) return;
+
+  for (int i = 0; i < g_flight.expectedCount; i++) {
+    const replay_Snapshot* expected = &g_flight.expected[i];
+    if (expected->sequence != snapshot->sequence) continue;
+
+    if (memcmp(expected, snapshot, sizeof(*snapshot)) != 0) {
+      g_flight.hasDiverged = true;
+      double time          = snapshot->gameTime - g_flight.checkpoint.gameTime;
+      LOG_WARN(game_log, "Replay diverged from the crash dump %.2f seconds into the level", time);
+    } else if (i == g_flight.expectedCount - 1) {
+      LOG_INFO(game_log, "Replay matches the crash dump up to its last snapshot");
+    }
+    return;
+  }
+}
+
+#if defined(FLIGHT_SIGNALS)
+// Everything from here to the handler has to be async-signal-safe
+#if defined(_WIN32)
+static int openDump(void) {
+  return _open(g_flight.path, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+}
+
+static bool writeAll(int fd, const void* data, size_t size) { return _write(fd, data, (unsigned) size) == (int) size; }
+
+static void closeDump(int fd) { _close(fd); }
+#else
+static int openDump(void) { return open(g_flight.path, O_WRONLY | O_CREAT | O_TRUNC, 0644); }
+
+static bool writeAll(int fd, const void* data, size_t size) {
+  const char* bytes = data;
+  while (size > 0) {
+    ssize_t written = write(fd, bytes, size);
+    if (written == -1 && errno == EINTR) continue;
+    if (written <= 0) return false;
+    bytes += written;
+    size  -= written;
+  }
+  return true;
+}
+
+static void closeDump(int fd) { close(fd); }
+#endif
+
+// The count entries before the next to be written, oldest first
+static bool writeRing(int fd, const void* ring, size_t size, uint32_t capacity, uint32_t first, uint32_t count) {
+  uint32_t start = first & (capacity - 1);
+  uint32_t head  = count < capacity - start ? count : capacity - start;
+  return writeAll(fd, (const char*) ring + start * size, head * size) && writeAll(fd, ring, (count - head) * size);
+}
+
+// A replay from the checkpoint, or only the snapshots when the frames since it have been overwritten
+static void writeDump(int fd) {
+  uint32_t frames     = g_flight.frameCount - g_flight.checkpointFrame;
+  bool     isComplete = g_flight.hasCheckpoint && frames <= FRAME_RING;
+  uint32_t snapshots  = MIN(g_flight.snapshotCount, SNAPSHOT_RING);
+
+  replay_Header header = {
+    .version    = REPLAY_VERSION,
+    .seed       = g_flight.checkpoint.seed,
+    .frameCount = isComplete ? frames : 0,
+    .flags      = isComplete ? REPLAY_CHECKPOINT : REPLAY_INCOMPLETE
+  };
+  memcpy(header.magic, REPLAY_MAGIC, sizeof(header.magic));
+
+  bool isOk = writeAll(fd, &header, sizeof(header));
+  if (isOk && isComplete) {
+    isOk = writeAll(fd, &g_flight.checkpoint, sizeof(g_flight.checkpoint)) &&
+           writeRing(fd, g_flight.frames, sizeof(replay_Frame), FRAME_RING, g_flight.checkpointFrame, frames);
+  }
+  if (isOk) isOk = writeAll(fd, &snapshots, sizeof(snapshots));
+  if (isOk) {
+    writeRing(
+        fd, g_flight.snapshots, sizeof(replay_Snapshot), SNAPSHOT_RING, g_flight.snapshotCount - snapshots, snapshots
+    );
+  }
+}
+
+static void crashHandler(int sig) {
+  int fd = openDump();
+  if (fd != -1) {
+    writeDump(fd);
+    closeDump(fd);
+    writeAll(2, DUMP_MESSAGE, sizeof(DUMP_MESSAGE) - 1);
+    writeAll(2, g_flight.path, strlen(g_flight.path));
+    writeAll(2, "\n", 1);
+  }
+
+  // Then crash as if the recorder was never there, so the signal still cores and reports as before
+  signal(sig, SIG_DFL);
+  raise(sig);
+}
+
+// Other threads have no alternate stack, a stack overflow on one of them isn't dumped
+static void installHandlers(void) {
+#if defined(_WIN32)
+  for (size_t i = 0; i < COUNT(SIGNALS); i++) signal(SIGNALS[i], crashHandler);
+#else
+  static char altStack[ALT_STACK_SIZE];
+  stack_t     stack = { .ss_sp = altStack, .ss_size = sizeof(altStack) };
+  if (sigaltstack(&stack, nullptr) != 0) LOG_WARN(game_log, "Failed to set the flight recorder's signal stack");
+
+  struct sigaction action = { .sa_handler = crashHandler, .sa_flags = SA_ONSTACK | SA_RESETHAND };
+  sigemptyset(&action.sa_mask);
+  for (size_t i = 0; i < COUNT(SIGNALS); i++) sigaction(SIGNALS[i], &action, nullptr);
+#endif
+}
+#endif
+
+// --- Flight recorder functions ---
+
+// Always on, it dumps whatever it has recorded if the game crashes or an assert fails
+void flight_open(void) {
+  assert(!g_flight.isOpen);
+#if defined(FLIGHT_SIGNALS)
+  snprintf(g_flight.path, sizeof(g_flight.path), DUMP_FILE, (long long) time(nullptr));
+  installHandlers();
+  g_flight.isOpen = true;
+#endif
+}
+
+// Call with every frame's input latched, whether live or replayed
+void flight_recordFrame(double delta) {
+  replay_Frame frame                                     = { .delta = delta, .input = input_getFrame() };
+  g_flight.frames[g_flight.frameCount & (FRAME_RING - 1)] = frame;
+  g_flight.frameCount++;
+}
+
+// Call on the main thread as a level starts, the frames and snapshots before it are no longer needed
+void flight_checkpoint(const replay_Checkpoint* checkpoint) {
+  assert(checkpoint != nullptr);
+  g_flight.checkpoint      = *checkpoint;
+  g_flight.hasCheckpoint   = true;
+  g_flight.checkpointFrame = g_flight.frameCount;
+  g_flight.snapshotCount   = 0;
+  g_flight.nextSnapshot    = checkpoint->gameTime + SNAPSHOT_INTERVAL;
+  g_flight.expected        = nullptr;
+  g_flight.expectedCount   = 0;
+}
+
+// After restoring a crash dump's checkpoint, to report if playing it back stops reproducing it
+void flight_checkReplay(void) {
+  g_flight.expected    = replay_getSnapshots(&g_flight.expectedCount);
+  g_flight.hasDiverged = false;
+}
+
+// Call at the end of each update, it snapshots the world every second of game time
+void flight_update(void) {
+  if (!g_flight.hasCheckpoint || game_getTime() < g_flight.nextSnapshot) return;
+  g_flight.nextSnapshot += SNAPSHOT_INTERVAL;
+
+  replay_Snapshot snapshot = {
+    .sequence       = g_flight.snapshotCount,
+    .state          = g_game.state,
+    .gameTime       = game_getTime(),
+    .lives          = player_getLives(),
+    .score          = player_getScore(),
+    .coinsCollected = player_getCoinsCollected(),
+    .playerState    = player_getState(),
+    .player         = player_getPos()
+  };
+  for (int i = 0; i < CREATURE_COUNT; i++) snapshot.creatures[i] = creature_getPos(i);
+  g_flight.snapshots[g_flight.snapshotCount++ & (SNAPSHOT_RING - 1)] = snapshot;
+  checkSnapshot(&snapshot);
+}
+
+void flight_close(void) {
+#if defined(FLIGHT_SIGNALS)
+  if (!g_flight.isOpen) return;
+  for (size_t i = 0; i < COUNT(SIGNALS); i++) signal(SIGNALS[i], SIG_DFL);
+  g_flight.isOpen = false;
+#endif
+}
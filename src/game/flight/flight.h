@@ -0,0 +1,13 @@
+// clang-format Language: C
+#pragma once
+
+#include "../replay/replay.h"
+
+// --- Flight recorder functions ---
+
+void flight_open(void);
+void flight_recordFrame(double delta);
+void flight_checkpoint(const replay_Checkpoint* checkpoint);
+void flight_checkReplay(void);
+void flight_update(void);
+void flight_close(void);
@@ -10,13 +10,25 @@
 #include "creature/creature.h"
 #include "debug/debug.h"
 #include "draw/draw.h"
+#include "flight/flight.h"
 #include "input/input.h"
 #include "internal.h"
+#include "loader/loader.h"
 #include "maze/maze.h"
 #include "menu/menu.h"
+#include "metrics/metrics.h"
 #include "options/options.h"
+#include "pack/pack.h"
 #include "player/player.h"
+#include "render/render.h"
+#include "replay/replay.h"
+#include "save/save.h"
 #include "scores/scores.h"
+#include "soak/soak.h"
+#include "splits/splits.h"
+#include "startup/startup.h"
+#include "telemetry/telemetry.h"
+#include "trace/trace.h"
 
 // --- Constants ---
 
@@ -44,8 +56,13 @@ const float MIN_SLOP        = 0.05f;
 const float MAX_SLOP        = 2.5f;
 const float OVERLAP_EPSILON = 2e-5f;
 
-static const char  SCREENSHOT_FILE[]                    = "screenshot.png";
-static const char* DIFFICULTY_STRINGS[DIFFICULTY_COUNT] = { "Easy", "Normal", "Arcade Mode" };
+static const char   SCREENSHOT_FILE[]                    = "screenshot.png";
+static const char   PACK_FILE[]                          = ASSET_DIR "asset.pack";
+constexpr int       MAX_MAIN_THREAD_TASKS                = 8;
+static const double IDLE_REDRAW_INTERVAL                 = 1.0;  // Keeps the window fresh if the compositor loses it
+static const double LOAD_BUDGET                          = 1.0 / 120.0;  // Loading time per frame, keeps menus responsive
+constexpr int       SEED_PART_MAX                        = 0x7fff;  // Within RAND_MAX if raylib falls back to rand()
+static const char*  DIFFICULTY_STRINGS[DIFFICULTY_COUNT] = { "Easy", "Normal", "Arcade Mode" };
 
 // --- Global state ---
 
@@ -60,11 +77,38 @@ Game     g_game = {
   .startLevel      = 0
 };
 
+// Window and screen work requested by the simulation, run by the main thread between frames
+static struct {
+  game_Task tasks[MAX_MAIN_THREAD_TASKS];
+  int       count;
+} g_mainThreadTasks;
+
+// Static screens are only redrawn when something on them could have changed
+static struct {
+  bool           isRedrawRequested;
+  bool           hasInput;
+  game_GameState drawnState;
+  double         lastDrawTime;
+} g_redraw;
+
+// Time as seen by the simulation, so replays reproduce it exactly
+static double g_gameTime;
+
+// Levels load on the main thread between frames, so starting one always waits for the next game_loadStep(). Replays
+// then see the same frame order whichever thread the simulation runs on.
+static struct {
+  double startTime;
+  bool   isStartPending;
+  bool   isNextLevelPending;
+} g_loading;
+
 // --- Helper functions ---
 
-static inline void updateMusic(double frameTime) {
+static void takeScreenshot(void) { TakeScreenshot(SCREENSHOT_FILE); }
+
+static inline void updateMusic(void) {
   switch (g_game.state) {
-    case GAME_BOOT: assert(false); break;
+    case GAME_BOOT: break;
 
     case GAME_TITLE:
     case GAME_MENU:
@@ -74,13 +118,13 @@ static inline void updateMusic(double frameTime) {
     case GAME_PAUSE:
     case GAME_OVER:
     case GAME_LEVELCLEAR:
-    case GAME_WON: engine_updateMusic(asset_getMusic(), frameTime); break;
+    case GAME_WON: audio_updateMusic(); break;
   }
 }
 
 static void escapePressed(void) {
   switch (g_game.state) {
-    case GAME_BOOT: assert(false); break;
+    case GAME_BOOT: break;
 
     case GAME_TITLE:
     case GAME_MENU: menu_back(); break;
@@ -97,7 +141,7 @@ static void escapePressed(void) {
 
 static void spacePressed(void) {
   switch (g_game.state) {
-    case GAME_BOOT: assert(false); break;
+    case GAME_BOOT: break;
 
     case GAME_TITLE:
     case GAME_MENU: break;
@@ -119,10 +163,7 @@ static void spacePressed(void) {
       player_onResume();
       break;
 
-    case GAME_LEVELCLEAR:
-      g_game.state = GAME_START;
-      game_nextLevel();
-      break;
+    case GAME_LEVELCLEAR: game_nextLevel(); break;
 
     case GAME_OVER:
     case GAME_WON: menu_open(MENU_CONTEXT_TITLE); break;
@@ -132,16 +173,21 @@ static void spacePressed(void) {
 static void checkKeys(void) {
   if (input_isKeyPressed(INPUT_SPACE)) spacePressed();
   if (input_isKeyPressed(INPUT_ESCAPE)) escapePressed();
-  if (input_isKeyPressed(INPUT_S)) TakeScreenshot(SCREENSHOT_FILE);
+  if (input_isKeyPressed(INPUT_S)) game_runOnMainThread(takeScreenshot);
 }
 
 static void drawGame(void) {
+  render_setLayer(LAYER_MAZE);
   maze_draw();
+  render_setLayer(LAYER_ACTORS);
   draw_player();
   draw_nextLife();
   draw_creatures();
+  render_setLayer(LAYER_INTERFACE);
   draw_interface();
+  splits_draw();
 #ifndef NDEBUG
+  render_setLayer(LAYER_DEBUG);
   debug_drawOverlay();
 #endif
 }
@@ -149,7 +195,7 @@ static void drawGame(void) {
 static void updateGame(double frameTime) {
   float slop = BASE_SLOP * (frameTime / BASE_DT);
   slop       = fminf(fmaxf(slop, MIN_SLOP), MAX_SLOP);
-  LOG_TRACE(game_log, "Slop: %f", slop);
+  TRACE("Slop: %f", slop);
 
   player_update(frameTime, slop);
   creature_update(frameTime, slop);
@@ -158,7 +204,73 @@ static void updateGame(double frameTime) {
   maze_update(frameTime);
 }
 
+// Each level starts from a fresh seed, so the flight recorder can replay it from here without the levels before it
+static void checkpointLevel(void) {
+  static replay_Checkpoint checkpoint;
+
+  unsigned seed = (unsigned) GetRandomValue(0, SEED_PART_MAX) << 15 | (unsigned) GetRandomValue(0, SEED_PART_MAX);
+  SetRandomSeed(seed);
+  checkpoint = (replay_Checkpoint) {
+    .seed        = seed,
+    .difficulty  = g_game.difficulty,
+    .level       = g_game.level,
+    .startLevel  = g_game.startLevel,
+    .gameTime    = g_gameTime,
+    .accumulator = g_accumulator
+  };
+  player_getCarry(&checkpoint.player);
+  flight_checkpoint(&checkpoint);
+}
+
+// Loads the maze if it isn't resident, creature visuals only exist for the level being played. The one on screen stays
+// resident until the new one replaces it.
+static bool loadLevel(int level) {
+  if (maze_loadLevel(level, g_game.level) && asset_loadCreatures(level)) return true;
+
+  LOG_FATAL(game_log, "Failed to load level %d", level + 1);
+  engine_requestClose();
+  return false;
+}
+
+static bool startGame(void) {
+  if (g_game.startLevel > player_getProgress(g_game.startDifficulty)) return true;
+
+  GAME_TRY(loadLevel(g_game.startLevel));
+
+  LOG_INFO(game_log, "Starting new game, difficulty: %s", DIFFICULTY_STRINGS[g_game.startDifficulty]);
+  g_game.difficulty = g_game.startDifficulty;
+  g_game.level      = g_game.startLevel;
+  g_game.state      = GAME_START;
+  player_totalReset();
+  creature_reset();
+  maze_reset(g_game.level);
+  draw_resetCreatures();
+  draw_resetPlayer();
+  debug_reset();
+  checkpointLevel();
+  TELEMETRY_EVENT(TELEMETRY_RUN_START, 0, 0, TELEMETRY_NOWHERE);
+  metrics_add(METRICS_RUNS_STARTED, 1);
+  return true;
+}
+
+static bool startNextLevel(void) {
+  GAME_TRY(loadLevel(g_game.level + 1));
+
+  g_game.level += 1;
+  g_game.state  = GAME_START;
+  player_reset();
+  creature_reset();
+  maze_reset(g_game.level);
+  draw_resetPlayer();
+  draw_resetCreatures();
+  checkpointLevel();
+  TELEMETRY_EVENT(TELEMETRY_LEVEL_START, 0, 0, TELEMETRY_NOWHERE);
+  return true;
+}
+
 static void gameWon(void) {
+  TELEMETRY_EVENT(TELEMETRY_GAME_WON, 0, 0, TELEMETRY_NOWHERE);
+  metrics_add(METRICS_RUNS_WON, 1);
   if (g_game.startLevel == 0) {
     g_game.state = GAME_WON;
   } else {
@@ -168,10 +280,11 @@ static void gameWon(void) {
 
 // --- Game functions ---
 
+// Starts loading, the rest happens a stage at a time in game_loadStep() while the loading screen is drawn
 bool game_load(void) {
   assert(g_game.state == GAME_BOOT);
 
-  double start = engine_getTime();
+  g_loading.startTime = engine_getTime();
 
   if (game_log != nullptr) {
     LOG_ERROR(game_log, "Game already loaded");
@@ -183,45 +296,128 @@ bool game_load(void) {
     return false;
   }
 
+  int timer = startup_begin("Audio init");
   engine_initAudio(options_getMasterVolume());
-  GAME_TRY(maze_init());
-  GAME_TRY(asset_load());  // Requires maze_init() for the tileset
-  GAME_TRY(asset_initPlayer());
-  GAME_TRY(asset_initCreatures());
-  GAME_TRY(asset_initCursor());
-  scores_load();
-  LOG_INFO(game_log, "Game loading took %f seconds", engine_getTime() - start);
-
-  audio_startMusic();
-  menu_open(MENU_CONTEXT_TITLE);
+  startup_end(timer);
+  timer = startup_begin("Asset pack open");
+  pack_open(PACK_FILE);
+  startup_end(timer);
+  loader_start();
+  draw_latchDisplay();
   return true;
 }
 
-void game_start(void) {
-  if (g_game.startLevel > player_getProgress(g_game.startDifficulty)) return;
+// Call each frame on the main thread, as loading uploads textures, the title menu opens as soon as it can. Once loaded
+// it starts levels and converts the prefetched one.
+bool game_loadStep(void) {
+  if (!loader_isDone()) {
+    loader_Status status = loader_step(LOAD_BUDGET);
+    if (status == LOADER_FAILED) {
+      LOG_FATAL(game_log, "Failed to load game");
+      engine_requestClose();
+      return false;
+    }
+    game_requestRedraw();
+
+    if (g_game.state == GAME_BOOT && loader_isTitleReady()) {
+      LOG_INFO(game_log, "Title screen ready after %f seconds", engine_getTime() - g_loading.startTime);
+      audio_startMusic();
+      menu_open(MENU_CONTEXT_TITLE);
+    }
+
+    if (status != LOADER_DONE) return true;
+    LOG_INFO(game_log, "Game loading took %f seconds", engine_getTime() - g_loading.startTime);
+    startup_finish();
+    startup_report();
+  }
 
-  LOG_INFO(game_log, "Starting new game, difficulty: %s", DIFFICULTY_STRINGS[g_game.startDifficulty]);
-  g_game.difficulty = g_game.startDifficulty;
-  g_game.level      = g_game.startLevel;
-  g_game.state      = GAME_START;
+  if (g_loading.isStartPending) {
+    g_loading.isStartPending = false;
+    GAME_TRY(startGame());
+  } else if (g_loading.isNextLevelPending) {
+    g_loading.isNextLevelPending = false;
+    GAME_TRY(startNextLevel());
+  }
+  maze_updateStreaming(g_game.level);
+  return true;
+}
+
+bool game_isLoaded(void) { return loader_isDone(); }
+
+// A crash dump plays back from its checkpoint, the start of the level it crashed in, rather than from boot
+bool game_restoreReplay(void) {
+  // Its level parses in the background while the save store is swapped
+  const replay_Checkpoint* checkpoint = replay_getCheckpoint();
+  if (checkpoint != nullptr) {
+    if (checkpoint->difficulty < 0 || checkpoint->difficulty >= DIFFICULTY_COUNT || checkpoint->level < 0 ||
+        checkpoint->level >= maze_getLevelCount() || checkpoint->startLevel < 0 ||
+        checkpoint->startLevel > checkpoint->level) {
+      LOG_ERROR(game_log, "Replay checkpoint isn't for a level in this game");
+      return false;
+    }
+    maze_requestLevel(checkpoint->level);
+  }
+
+  // Everything read from the save store is read again from the recording's copy
+  size_t      saveSize = 0;
+  const void* save     = replay_getSave(&saveSize);
+  if (save != nullptr) {
+    if (!save_useImage(save, saveSize)) {
+      LOG_ERROR(game_log, "Replay's save store is corrupt");
+      return false;
+    }
+    options_load();
+    audio_onVolumeChange();
+    scores_load();
+    GAME_TRY(player_loadProgress());
+  }
+
+  if (checkpoint == nullptr) return true;
+  assert(loader_isDone());
+  GAME_TRY(loadLevel(checkpoint->level));
+
+  g_game.difficulty      = checkpoint->difficulty;
+  g_game.startDifficulty = checkpoint->difficulty;
+  g_game.level           = checkpoint->level;
+  g_game.startLevel      = checkpoint->startLevel;
+  g_game.state           = GAME_START;
+  g_gameTime             = checkpoint->gameTime;
+  g_accumulator          = checkpoint->accumulator;
   player_totalReset();
+  player_setCarry(&checkpoint->player);
   creature_reset();
   maze_reset(g_game.level);
   draw_resetCreatures();
   draw_resetPlayer();
   debug_reset();
+  SetRandomSeed(checkpoint->seed);
+  flight_checkpoint(checkpoint);
+  flight_checkReplay();
+  return true;
 }
 
-void game_input(void) { input_update(); }
+// Chosen before everything has loaded, the game starts once it has
+void game_start(void) { g_loading.isStartPending = true; }
+
+void game_input(void) {
+  g_redraw.hasInput = replay_isPlaying() ? replay_applyFrame() : soak_isRunning() ? soak_applyInput() : input_update();
+  draw_latchDisplay();
+}
+
+void game_runMainThreadTasks(void) {
+  for (int i = 0; i < g_mainThreadTasks.count; i++) g_mainThreadTasks.tasks[i]();
+  g_mainThreadTasks.count = 0;
+}
 
 void game_update(double frameTime) {
+  g_gameTime += frameTime;
   checkKeys();
   switch (g_game.state) {
-    case GAME_BOOT: assert(false); break;
+    case GAME_BOOT: break;
 
     case GAME_TITLE:
     case GAME_MENU:
-      updateMusic(frameTime);
+      updateMusic();
       menu_update();
       break;
 
@@ -230,34 +426,54 @@ void game_update(double frameTime) {
     case GAME_PAUSE:
     case GAME_LEVELCLEAR:
     case GAME_OVER:
-    case GAME_WON: updateMusic(frameTime); break;
+    case GAME_WON: updateMusic(); break;
 
     case GAME_RUN:
       checkFPSKeys();
       updateGame(frameTime);
-      updateMusic(frameTime);
+      updateMusic();
       break;
   }
+  flight_update();
   input_flush();
 }
 
+// Fills the frame's render command list and submits it to the render backend
 void game_draw(void) {
+  g_redraw.isRedrawRequested = false;
+  g_redraw.drawnState        = g_game.state;
+  g_redraw.lastDrawTime      = engine_getTime();
+
+  render_begin();
+
   switch (g_game.state) {
-    case GAME_BOOT: assert(false); break;
+    case GAME_BOOT:
+      render_setLayer(LAYER_PANEL);
+      draw_loading(loader_getProgress());
+      break;
 
     case GAME_TITLE:
+      render_setLayer(LAYER_BACKGROUND);
       draw_title();
+      render_setLayer(LAYER_MENU);
       menu_draw();
+      // The rest of the levels keep loading behind the title
+      if (!loader_isDone()) {
+        render_setLayer(LAYER_PANEL);
+        draw_loading(loader_getProgress());
+      }
       break;
 
     case GAME_MENU:
       drawGame();
+      render_setLayer(LAYER_MENU);
       menu_draw();
       break;
 
     case GAME_START:
     case GAME_DEAD:
       drawGame();
+      render_setLayer(LAYER_PANEL);
       draw_ready();
       break;
 
@@ -266,29 +482,55 @@ void game_draw(void) {
 
     case GAME_LEVELCLEAR:
       drawGame();
+      render_setLayer(LAYER_PANEL);
       draw_levelClear();
       break;
 
     case GAME_OVER:
       drawGame();
+      render_setLayer(LAYER_PANEL);
       draw_gameOver();
       break;
 
     case GAME_WON:
       drawGame();
+      render_setLayer(LAYER_PANEL);
       draw_gameWon();
       break;
   }
+
+  render_submit();
+}
+
+// True when the last frame drawn is still what would be drawn, so the main loop can skip drawing and wait
+bool game_isIdle(void) {
+  switch (g_game.state) {
+    case GAME_BOOT:
+    case GAME_RUN : return false;
+
+    case GAME_TITLE:
+    case GAME_MENU:
+    case GAME_START:
+    case GAME_DEAD:
+    case GAME_PAUSE:
+    case GAME_LEVELCLEAR:
+    case GAME_OVER:
+    case GAME_WON: break;
+  }
+
+  if (!loader_isDone() || g_loading.isStartPending || g_loading.isNextLevelPending) return false;
+  if (g_redraw.isRedrawRequested || g_redraw.hasInput || g_redraw.drawnState != g_game.state) return false;
+  return engine_getTime() - g_redraw.lastDrawTime < IDLE_REDRAW_INTERVAL;
 }
 
 void game_unload(void) {
-  audio_stopMusic();
+  if (loader_isTitleReady()) audio_stopMusic();
   engine_shutdownAudio();
-  asset_shutdownCursor();
-  asset_shutdownCreatures();
-  asset_shutdownPlayer();
-  maze_shutdown();
-  asset_unload();
+  loader_unload();
+  pack_close();
+  // Opened before the game by main(), flushed here while there is still a log to report a failed write
+  save_close();
+  render_checkLeaks();
   log_destroy(&game_log);
 }
 
@@ -298,23 +540,20 @@ void game_setNormal(void) { g_game.startDifficulty = DIFFICULTY_NORMAL; }
 
 void game_setArcade(void) { g_game.startDifficulty = DIFFICULTY_ARCADE; }
 
-void game_setLevel1(void) { g_game.startLevel = 0; }
-
-void game_setLevel2(void) { g_game.startLevel = 1; }
-
-void game_setLevel3(void) { g_game.startLevel = 2; }
-
-void game_setLevel4(void) { g_game.startLevel = 3; }
-
-void game_setLevel5(void) { g_game.startLevel = 4; }
-
-void game_setLevel6(void) { g_game.startLevel = 5; }
-
-void game_setLevel7(void) { g_game.startLevel = 6; }
+// The level parses in the background while the menu is up
+void game_setStartLevel(int level) {
+  assert(level >= 0 && level < maze_getLevelCount());
+  g_game.startLevel = level;
+  maze_requestLevel(level);
+}
 
 game_Difficulty game_getDifficulty(void) { return g_game.difficulty; }
 
-void game_over(void) { g_game.state = GAME_OVER; }
+void game_over(void) {
+  TELEMETRY_EVENT(TELEMETRY_GAME_OVER, 0, 0, TELEMETRY_NOWHERE);
+  metrics_add(METRICS_RUNS_LOST, 1);
+  g_game.state = GAME_OVER;
+}
 
 int game_getLevel(void) { return g_game.level; }
 
@@ -322,22 +561,19 @@ game_Difficulty game_getStartDifficulty(void) { return g_game.startDifficulty; }
 
 int game_getStartLevel(void) { return g_game.startLevel; }
 
+// The next level parses in the background while the level clear screen is up
 void game_levelClear(void) {
+  TELEMETRY_EVENT(TELEMETRY_LEVEL_CLEAR, 0, 0, TELEMETRY_NOWHERE);
   scores_save();
   g_game.state = GAME_LEVELCLEAR;
+  maze_prefetchLevel(g_game.level + 1);
 }
 
 void game_nextLevel(void) {
-  if (g_game.level == LEVEL_COUNT - 1) {
+  if (g_game.level == maze_getLevelCount() - 1) {
     gameWon();
   } else {
-    g_game.level += 1;
-    g_game.state  = GAME_START;
-    player_reset();
-    creature_reset();
-    maze_reset(g_game.level);
-    draw_resetPlayer();
-    draw_resetCreatures();
+    g_loading.isNextLevelPending = true;
   }
 }
 
@@ -346,3 +582,23 @@ void game_playerDead(void) {
   player_restart();
   creature_reset();
 }
+
+// Anything touching the window or GPU has to happen on the main thread, so queue it when the simulation is threaded
+void game_runOnMainThread(game_Task task) {
+  assert(task != nullptr);
+  game_requestRedraw();
+#if defined(GAME_PIPELINED)
+  for (int i = 0; i < g_mainThreadTasks.count; i++) {
+    if (g_mainThreadTasks.tasks[i] == task) return;
+  }
+  assert(g_mainThreadTasks.count < MAX_MAIN_THREAD_TASKS);
+  g_mainThreadTasks.tasks[g_mainThreadTasks.count++] = task;
+#else
+  task();
+#endif
+}
+
+// Anything animating on a static screen calls this each frame it changes
+void game_requestRedraw(void) { g_redraw.isRedrawRequested = true; }
+
+double game_getTime(void) { return g_gameTime; }
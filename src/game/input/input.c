@@ -1,4 +1,5 @@
 #include "input.h"
+#include <assert.h>
 #include <raylib.h>
 #include "engine/engine.h"
 
@@ -11,25 +12,42 @@ static const int KEYS[INPUT_KEY_COUNT] = {
 
 static const int MOUSE_BUTTONS[INPUT_BUTTON_COUNT] = { MOUSE_BUTTON_LEFT };
 
+static_assert(INPUT_KEY_COUNT <= 32, "Keys must fit in an input_Frame bitmask");
+
 // --- Global state ---
 
 static struct {
-  bool isKeyPressed[INPUT_KEY_COUNT];
-  bool isKeyPressedRepeat[INPUT_KEY_COUNT];
-  bool isMouseButtonPressed[INPUT_BUTTON_COUNT];
+  bool    isKeyPressed[INPUT_KEY_COUNT];
+  bool    isKeyPressedRepeat[INPUT_KEY_COUNT];
+  bool    isMouseButtonPressed[INPUT_BUTTON_COUNT];
+  bool    isKeyDown[INPUT_KEY_COUNT];
+  Vector2 mousePos;
 } g_input = {};
 
 // --- Input functions ---
 
-void input_update(void) {
+// Latches the engine's input state on the main thread, the simulation only ever reads the latched copy
+// Returns true if anything was pressed, held or moved
+bool input_update(void) {
+  bool hasActivity = false;
+
   for (int i = 0; i < INPUT_KEY_COUNT; i++) {
     if (engine_isKeyPressed(KEYS[i])) g_input.isKeyPressed[i] = true;
     if (engine_isKeyPressedRepeat(KEYS[i])) g_input.isKeyPressedRepeat[i] = true;
+    g_input.isKeyDown[i]  = engine_isKeyDown(KEYS[i]);
+    hasActivity          |= g_input.isKeyPressed[i] || g_input.isKeyDown[i];
   }
 
+  Vector2 mousePos  = engine_getMousePosition();
+  hasActivity      |= mousePos.x != g_input.mousePos.x || mousePos.y != g_input.mousePos.y;
+  g_input.mousePos  = mousePos;
+
   for (int i = 0; i < INPUT_BUTTON_COUNT; i++) {
     if (engine_isMouseButtonPressed(MOUSE_BUTTONS[i])) g_input.isMouseButtonPressed[i] = true;
+    hasActivity |= g_input.isMouseButtonPressed[i];
   }
+
+  return hasActivity;
 }
 
 void input_flush(void) {
@@ -47,8 +65,63 @@ bool input_isKeyPressed(input_Key key) { return g_input.isKeyPressed[key]; }
 
 bool input_isKeyPressedRepeat(input_Key key) { return g_input.isKeyPressedRepeat[key]; }
 
+bool input_isKeyDown(input_Key key) { return g_input.isKeyDown[key]; }
+
 bool input_isMouseButtonPressed(input_MouseButton button) { return g_input.isMouseButtonPressed[button]; }
 
 bool input_isMouseButtonClick(input_MouseButton button, Rectangle rectangle) {
-  return input_isMouseButtonPressed(button) && engine_isMouseHover(rectangle);
+  return input_isMouseButtonPressed(button) && input_isMouseHover(rectangle);
+}
+
+Vector2 input_getMousePosition(void) { return g_input.mousePos; }
+
+// The mouse position is in window pixels, rectangles are in canvas pixels
+bool input_isMouseHover(Rectangle rectangle) {
+  float scale = engine_getScale();
+  return CheckCollisionPointRec(
+      g_input.mousePos,
+      (Rectangle) { rectangle.x * scale, rectangle.y * scale, rectangle.width * scale, rectangle.height * scale }
+  );
+}
+
+// --- Replay functions ---
+
+input_Frame input_getFrame(void) {
+  float       scale = engine_getScale();
+  input_Frame frame = {
+    .mousePos = { g_input.mousePos.x / scale, g_input.mousePos.y / scale }
+  };
+
+  for (int i = 0; i < INPUT_KEY_COUNT; i++) {
+    if (g_input.isKeyPressed[i]) frame.isKeyPressed |= 1u << i;
+    if (g_input.isKeyPressedRepeat[i]) frame.isKeyPressedRepeat |= 1u << i;
+    if (g_input.isKeyDown[i]) frame.isKeyDown |= 1u << i;
+  }
+  for (int i = 0; i < INPUT_BUTTON_COUNT; i++) {
+    if (g_input.isMouseButtonPressed[i]) frame.isMouseButtonPressed |= 1u << i;
+  }
+  return frame;
+}
+
+// Replaces the latched state in place of input_update(), so returns activity the same way
+bool input_setFrame(const input_Frame* frame) {
+  assert(frame != nullptr);
+
+  float   scale    = engine_getScale();
+  Vector2 mousePos = { frame->mousePos.x * scale, frame->mousePos.y * scale };
+  bool    hasActivity =
+      frame->isKeyPressed || frame->isKeyDown || frame->isMouseButtonPressed || mousePos.x != g_input.mousePos.x ||
+      mousePos.y != g_input.mousePos.y;
+
+  for (int i = 0; i < INPUT_KEY_COUNT; i++) {
+    g_input.isKeyPressed[i]       = frame->isKeyPressed & (1u << i);
+    g_input.isKeyPressedRepeat[i] = frame->isKeyPressedRepeat & (1u << i);
+    g_input.isKeyDown[i]          = frame->isKeyDown & (1u << i);
+  }
+  for (int i = 0; i < INPUT_BUTTON_COUNT; i++) {
+    g_input.isMouseButtonPressed[i] = frame->isMouseButtonPressed & (1u << i);
+  }
+  g_input.mousePos = mousePos;
+
+  return hasActivity;
 }
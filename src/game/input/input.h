@@ -4,6 +4,8 @@
 // --- Types ---
 
 #include <raylib.h>
+#include <stdint.h>
+
 typedef enum input_Key {
   INPUT_ESCAPE,
   INPUT_SPACE,
@@ -27,11 +29,28 @@ typedef enum input_Key {
 
 typedef enum input_MouseButton { INPUT_LEFT_BUTTON, INPUT_BUTTON_COUNT } input_MouseButton;
 
+// One frame of latched input as bitmasks indexed by input_Key, the mouse is in canvas pixels
+typedef struct input_Frame {
+  uint32_t isKeyPressed;
+  uint32_t isKeyPressedRepeat;
+  uint32_t isKeyDown;
+  uint32_t isMouseButtonPressed;
+  Vector2  mousePos;
+} input_Frame;
+
 // --- Input functions ---
 
-void input_update(void);
-void input_flush(void);
-bool input_isKeyPressed(input_Key key);
-bool input_isKeyPressedRepeat(input_Key key);
-bool input_isMouseButtonPressed(input_MouseButton button);
-bool input_isMouseButtonClick(input_MouseButton button, Rectangle rectangle);
+bool    input_update(void);
+void    input_flush(void);
+bool    input_isKeyPressed(input_Key key);
+bool    input_isKeyPressedRepeat(input_Key key);
+bool    input_isKeyDown(input_Key key);
+bool    input_isMouseButtonPressed(input_MouseButton button);
+bool    input_isMouseButtonClick(input_MouseButton button, Rectangle rectangle);
+Vector2 input_getMousePosition(void);
+bool    input_isMouseHover(Rectangle rectangle);
+
+// --- Replay functions ---
+
+input_Frame input_getFrame(void);
+bool        input_setFrame(const input_Frame* frame);
@@ -8,6 +8,7 @@
 #include <raymath.h>
 #include <stddef.h>
 #include <string.h>
+#include "render/render.h"
 
 #ifndef ASSET_DIR
 #define ASSET_DIR "./asset/"
@@ -75,6 +76,8 @@ typedef struct {
 
 typedef struct game_Actor game_Actor;
 
+typedef void (*game_Task)(void);
+
 // --- Constants ---
 
 constexpr int ACTOR_SIZE       = 16;
@@ -95,7 +98,7 @@ extern const char* DIR_STRINGS[];
 
 constexpr int WAIL_SOUND_COUNT = 4;
 constexpr int MAX_KEY_TYPES    = 2;
-constexpr int LEVEL_COUNT      = 7;
+constexpr int MAX_LEVELS       = 256;  // Capacity of the level catalog, the levels themselves are found at startup
 constexpr int MUSIC_TRACKS     = 7;
 
 // --- Global state ---
@@ -120,7 +123,7 @@ static inline float game_getAABBOverlapY(game_AABB a, game_AABB b) {
 static inline void game_drawAABBOverlay(game_AABB aabb, Color colour) {
   Vector2 min = POS_ADJUST(aabb.min);
   Vector2 max = POS_ADJUST(aabb.max);
-  engine_drawRectangleOutline((Rectangle) { min.x, min.y, max.x - min.x, max.y - min.y }, colour);
+  render_rectangleOutline((Rectangle) { min.x, min.y, max.x - min.x, max.y - min.y }, colour);
 }
 
 static inline game_Dir game_getOppositeDir(game_Dir dir) { return (dir + 2) % DIR_COUNT; }
@@ -130,13 +133,7 @@ static inline game_Dir game_getOppositeDir(game_Dir dir) { return (dir + 2) % DI
 void            game_setEasy(void);
 void            game_setNormal(void);
 void            game_setArcade(void);
-void            game_setLevel1(void);
-void            game_setLevel2(void);
-void            game_setLevel3(void);
-void            game_setLevel4(void);
-void            game_setLevel5(void);
-void            game_setLevel6(void);
-void            game_setLevel7(void);
+void            game_setStartLevel(int level);
 void            game_start(void);
 void            game_over(void);
 int             game_getLevel(void);
@@ -145,3 +142,6 @@ int             game_getStartLevel(void);
 void            game_levelClear(void);
 void            game_nextLevel(void);
 void            game_playerDead(void);
+void            game_runOnMainThread(game_Task task);
+void            game_requestRedraw(void);
+double          game_getTime(void);
@@ -0,0 +1,319 @@
+#include "leaderboard.h"
+#include <assert.h>
+#include <log/log.h>
+#include "../internal.h"
+
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+#define LEADERBOARD_NET
+#include <errno.h>
+#include <fcntl.h>
+#include <leaderboard/protocol.h>
+#include <net/address.h>
+#include <netdb.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include "../replay/replay.h"
+
+#if !defined(MSG_NOSIGNAL)
+#define MSG_NOSIGNAL 0  // SO_NOSIGPIPE is set on the socket instead
+#endif
+#endif
+
+#if defined(LEADERBOARD_NET)
+
+// --- Constants ---
+
+constexpr int MAX_QUEUE      = 256;   // Runs waiting to be sent, new ones are dropped past this
+constexpr int MAX_BATCH      = 64;
+constexpr int RETRY_INTERVAL = 5;     // Seconds to wait after failing to reach the leaderboard
+constexpr int TIMEOUT        = 2000;  // Milliseconds to connect, send or hear back
+
+// --- Types ---
+
+typedef struct leaderboard_Entry {
+  runs_Record record;
+  bool        hasReplay;
+} leaderboard_Entry;
+
+// --- Global state ---
+
+// Runs are queued on the game's thread and sent from the leaderboard's, so a slow network never holds up a frame
+static struct {
+  pthread_t         thread;
+  pthread_mutex_t   mutex;
+  pthread_cond_t    cond;
+  leaderboard_Entry queue[MAX_QUEUE];
+  int               first;
+  int               count;
+  int               dropped;
+  bool              isRunning;
+  bool              isQuitting;
+  int               fd;  // Only touched by the leaderboard thread
+  bool              isWarned;
+  net_Address       address;
+  const char*       replayFile;
+} g_leaderboard = { .mutex = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER, .fd = -1 };
+
+// --- Helper functions ---
+
+static bool connectSocket(int fd, const struct addrinfo* item) {
+  int flags = fcntl(fd, F_GETFL);
+  fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+  bool isConnected = connect(fd, item->ai_addr, item->ai_addrlen) == 0;
+  if (!isConnected && errno == EINPROGRESS) {
+    struct pollfd ready  = { .fd = fd, .events = POLLOUT };
+    int           error  = 0;
+    socklen_t     length = sizeof(error);
+    if (poll(&ready, 1, TIMEOUT) == 1 && getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) == 0) {
+      isConnected = error == 0;
+    }
+  }
+  fcntl(fd, F_SETFL, flags);
+  if (!isConnected) return false;
+
+  struct timeval timeout = { .tv_sec = TIMEOUT / 1000, .tv_usec = TIMEOUT % 1000 * 1000 };
+  if (setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)) != 0) return false;
+  if (setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) != 0) return false;
+#if defined(SO_NOSIGPIPE)
+  int isSet = 1;
+  if (setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &isSet, sizeof(isSet)) != 0) return false;
+#endif
+  return true;
+}
+
+static int openSocket(void) {
+  struct addrinfo  hints = { .ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM };
+  struct addrinfo* info;
+  if (getaddrinfo(g_leaderboard.address.host, g_leaderboard.address.port, &hints, &info) != 0) return -1;
+
+  int fd = -1;
+  for (struct addrinfo* item = info; fd == -1 && item != nullptr; item = item->ai_next) {
+    fd = socket(item->ai_family, item->ai_socktype, item->ai_protocol);
+    if (fd != -1 && !connectSocket(fd, item)) {
+      close(fd);
+      fd = -1;
+    }
+  }
+  freeaddrinfo(info);
+  return fd;
+}
+
+static bool sendAll(int fd, const void* data, size_t size) {
+  const unsigned char* bytes = data;
+  while (size > 0) {
+    ssize_t sent = send(fd, bytes, size, MSG_NOSIGNAL);
+    if (sent < 0 && errno == EINTR) continue;
+    if (sent <= 0) return false;
+    bytes += sent;
+    size  -= sent;
+  }
+  return true;
+}
+
+static bool receiveAll(int fd, void* data, size_t size) {
+  unsigned char* bytes = data;
+  while (size > 0) {
+    ssize_t received = recv(fd, bytes, size, 0);
+    if (received < 0 && errno == EINTR) continue;
+    if (received <= 0) return false;
+    bytes += received;
+    size  -= received;
+  }
+  return true;
+}
+
+// The replay so far, which covers the run just finished
+static unsigned char* readReplay(uint32_t* size) {
+  *size        = 0;
+  FILE* stream = fopen(g_leaderboard.replayFile, "rb");
+  if (stream == nullptr) return nullptr;
+
+  fseek(stream, 0, SEEK_END);
+  long length = ftell(stream);
+  fseek(stream, 0, SEEK_SET);
+  unsigned char* replay = length > 0 && length < LEADERBOARD_MAX_MESSAGE / 2 ? malloc(length) : nullptr;
+  if (replay != nullptr && fread(replay, length, 1, stream) == 1) {
+    *size = length;
+  } else {
+    free(replay);
+    replay = nullptr;
+  }
+  fclose(stream);
+  return replay;
+}
+
+static bool sendBatch(const leaderboard_Entry batch[], int count) {
+  if (g_leaderboard.fd == -1) g_leaderboard.fd = openSocket();
+  if (g_leaderboard.fd == -1) return false;
+
+  // The file covers every run before it too, so it is only sent with the latest
+  int replayRun = -1;
+  for (int i = 0; i < count; i++) {
+    if (batch[i].hasReplay) replayRun = i;
+  }
+  uint32_t       replaySize = 0;
+  unsigned char* replay     = replayRun >= 0 ? readReplay(&replaySize) : nullptr;
+  uint32_t       size       = sizeof(uint32_t) + count * sizeof(leaderboard_Run) + replaySize;
+  unsigned char* message    = malloc(sizeof(leaderboard_Header) + size);
+  if (message == nullptr) {
+    free(replay);
+    return false;
+  }
+
+  leaderboard_Header header = { .version = LEADERBOARD_VERSION, .type = LEADERBOARD_SUBMIT, .size = size };
+  memcpy(header.magic, LEADERBOARD_MAGIC, sizeof(header.magic));
+  memcpy(message, &header, sizeof(header));
+  uint32_t runCount = count;
+  memcpy(message + sizeof(header), &runCount, sizeof(runCount));
+  size_t offset = sizeof(header) + sizeof(runCount);
+  for (int i = 0; i < count; i++) {
+    leaderboard_Run run = { .record = batch[i].record, .replaySize = i == replayRun ? replaySize : 0 };
+    memcpy(message + offset, &run, sizeof(run));
+    if (run.replaySize > 0) memcpy(message + offset + sizeof(run), replay, run.replaySize);
+    offset += sizeof(run) + run.replaySize;
+  }
+  free(replay);
+
+  bool isSent = sendAll(g_leaderboard.fd, message, offset);
+  free(message);
+
+  leaderboard_Header reply;
+  leaderboard_Ack    ack;
+  isSent = isSent && receiveAll(g_leaderboard.fd, &reply, sizeof(reply)) && leaderboard_isValidHeader(&reply) &&
+           reply.type == LEADERBOARD_ACK && reply.size == sizeof(ack) &&
+           receiveAll(g_leaderboard.fd, &ack, sizeof(ack));
+  if (!isSent) {
+    close(g_leaderboard.fd);
+    g_leaderboard.fd = -1;
+    return false;
+  }
+
+  LOG_DEBUG(game_log, "Sent %d runs to the leaderboard, %u accepted", count, ack.accepted);
+  return true;
+}
+
+static void waitToRetry(void) {
+  struct timespec until;
+  clock_gettime(CLOCK_REALTIME, &until);
+  until.tv_sec += RETRY_INTERVAL;
+  while (!g_leaderboard.isQuitting) {
+    if (pthread_cond_timedwait(&g_leaderboard.cond, &g_leaderboard.mutex, &until) == ETIMEDOUT) break;
+  }
+}
+
+// Sends the front of the queue, only taking it off once the leaderboard has acknowledged it
+static void* sendThread([[maybe_unused]] void* arg) {
+  leaderboard_Entry batch[MAX_BATCH];
+  pthread_mutex_lock(&g_leaderboard.mutex);
+  while (true) {
+    while (g_leaderboard.count == 0 && !g_leaderboard.isQuitting) {
+      pthread_cond_wait(&g_leaderboard.cond, &g_leaderboard.mutex);
+    }
+    if (g_leaderboard.count == 0) break;
+
+    int count = MIN(g_leaderboard.count, MAX_BATCH);
+    for (int i = 0; i < count; i++) batch[i] = g_leaderboard.queue[(g_leaderboard.first + i) % MAX_QUEUE];
+    pthread_mutex_unlock(&g_leaderboard.mutex);
+    bool isSent = sendBatch(batch, count);
+    pthread_mutex_lock(&g_leaderboard.mutex);
+
+    if (isSent) {
+      g_leaderboard.first     = (g_leaderboard.first + count) % MAX_QUEUE;
+      g_leaderboard.count    -= count;
+      g_leaderboard.isWarned  = false;
+      continue;
+    }
+    if (!g_leaderboard.isWarned) {
+      const net_Address* address = &g_leaderboard.address;
+      LOG_WARN(game_log, "Unable to reach leaderboard %s:%s, will retry", address->host, address->port);
+      g_leaderboard.isWarned = true;
+    }
+    // Closing gets one try
+    if (g_leaderboard.isQuitting) break;
+    waitToRetry();
+  }
+  pthread_mutex_unlock(&g_leaderboard.mutex);
+
+  if (g_leaderboard.fd != -1) close(g_leaderboard.fd);
+  g_leaderboard.fd = -1;
+  return nullptr;
+}
+
+#endif
+
+// --- Leaderboard functions ---
+
+// Runs recorded into a replay file are sent with it when they complete the game, so they can be checked
+bool leaderboard_open([[maybe_unused]] const char* address, [[maybe_unused]] const char* replayFile) {
+  assert(address != nullptr);
+#if defined(LEADERBOARD_NET)
+  assert(!g_leaderboard.isRunning);
+
+  if (!net_parseAddress(address, &g_leaderboard.address)) {
+    LOG_ERROR(game_log, "Not a leaderboard address: %s", address);
+    return false;
+  }
+  g_leaderboard.replayFile = replayFile;
+  g_leaderboard.isQuitting = false;
+  if (pthread_create(&g_leaderboard.thread, nullptr, sendThread, nullptr) != 0) {
+    LOG_ERROR(game_log, "Failed to start the leaderboard thread");
+    return false;
+  }
+  g_leaderboard.isRunning = true;
+  LOG_INFO(
+      game_log, "Submitting runs to the leaderboard at %s:%s", g_leaderboard.address.host, g_leaderboard.address.port
+  );
+  return true;
+#else
+  LOG_WARN(game_log, "The leaderboard isn't supported on this platform");
+  return false;
+#endif
+}
+
+// Queues the run and returns, never waiting on the network
+void leaderboard_submit([[maybe_unused]] const runs_Record* record) {
+  assert(record != nullptr);
+#if defined(LEADERBOARD_NET)
+  if (!g_leaderboard.isRunning) return;
+
+  bool hasReplay = g_leaderboard.replayFile != nullptr && record->level == RUNS_FULL_RUN;
+  if (hasReplay) replay_flush();
+
+  pthread_mutex_lock(&g_leaderboard.mutex);
+  if (g_leaderboard.count == MAX_QUEUE) {
+    g_leaderboard.dropped++;
+  } else {
+    int last                  = (g_leaderboard.first + g_leaderboard.count++) % MAX_QUEUE;
+    g_leaderboard.queue[last] = (leaderboard_Entry) { *record, hasReplay };
+    pthread_cond_broadcast(&g_leaderboard.cond);
+  }
+  pthread_mutex_unlock(&g_leaderboard.mutex);
+#endif
+}
+
+// Gives whatever is still queued one last try
+void leaderboard_close(void) {
+#if defined(LEADERBOARD_NET)
+  if (!g_leaderboard.isRunning) return;
+
+  pthread_mutex_lock(&g_leaderboard.mutex);
+  g_leaderboard.isQuitting = true;
+  pthread_cond_broadcast(&g_leaderboard.cond);
+  pthread_mutex_unlock(&g_leaderboard.mutex);
+  pthread_join(g_leaderboard.thread, nullptr);
+
+  int unsent = g_leaderboard.count + g_leaderboard.dropped;
+  if (unsent > 0) LOG_WARN(game_log, "%d runs weren't sent to the leaderboard", unsent);
+  g_leaderboard.isRunning = false;
+  g_leaderboard.first     = 0;
+  g_leaderboard.count     = 0;
+  g_leaderboard.dropped   = 0;
+  g_leaderboard.isWarned  = false;
+#endif
+}
@@ -0,0 +1,10 @@
+// clang-format Language: C
+#pragma once
+
+#include <runs/format.h>
+
+// --- Leaderboard functions ---
+
+bool leaderboard_open(const char* address, const char* replayFile);
+void leaderboard_submit(const runs_Record* record);
+void leaderboard_close(void);
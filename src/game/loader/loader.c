@@ -0,0 +1,120 @@
+#include "loader.h"
+#include <assert.h>
+#include <engine/engine.h>
+#include <log/log.h>
+#include "../asset/asset.h"
+#include "../audio/audio.h"
+#include "../internal.h"
+#include "../maze/maze.h"
+#include "../runs/runs.h"
+#include "../scores/scores.h"
+#include "../startup/startup.h"
+
+// --- Types ---
+
+// Map stages convert a level parsed in the background, the rest call their load function. Later levels are loaded as
+// play reaches them.
+typedef struct loader_Stage {
+  const char* name;
+  int         level;
+  bool (*load)(void);
+  void (*unload)(void);
+  bool (*isReady)(void);  // False while its work is still being done in the background, if any is
+  bool isTitleReady;      // The title screen can open once this stage has loaded
+} loader_Stage;
+
+// --- Helper functions ---
+
+static bool loadScores(void) {
+  int timer = startup_begin("Scores file");
+  scores_load();
+  startup_end(timer);
+  return true;
+}
+
+static void unloadSounds(void) {
+  audio_releaseVoices();
+  asset_unloadSounds();
+}
+
+// --- Constants ---
+
+// Ordered so the title screen is up as soon as possible, the rest loads behind it. The sound files decode in the
+// background from the first stage, so the last only hands them to the audio device.
+static const loader_Stage STAGES[] = {
+  {    "Decode", -1,  asset_decodeSounds, asset_stopDecodingSounds,                nullptr, false },
+  {     "Title", -1,     asset_loadTitle,        asset_unloadTitle,                nullptr, false },
+  {   "Catalog", -1,    maze_openCatalog,        maze_closeCatalog,                nullptr, false },
+  {     "Map 1",  0,             nullptr,                  nullptr,                nullptr, false },
+  {    "Cursor", -1,    asset_initCursor,     asset_shutdownCursor,                nullptr, false },
+  {    "Scores", -1,          loadScores,                  nullptr,                nullptr,  true },
+  {      "Runs", -1,           runs_open,               runs_close,                nullptr, false },
+  {   "Sprites", -1,   asset_loadSprites,      asset_unloadSprites,                nullptr, false },
+  {    "Player", -1,    asset_initPlayer,     asset_shutdownPlayer,                nullptr, false },
+  { "Creatures", -1, asset_initCreatures,  asset_shutdownCreatures,                nullptr, false },
+  {    "Sounds", -1,    asset_loadSounds,             unloadSounds, asset_areSoundsDecoded, false },
+};
+constexpr int STAGE_COUNT = COUNT(STAGES);
+
+// --- Global state ---
+
+static struct {
+  int  loadedCount;
+  bool isTitleReady;
+  bool hasFailed;
+} g_loader;
+
+// --- Loader functions ---
+
+void loader_start(void) {
+  assert(g_loader.loadedCount == 0);
+  g_loader = (typeof(g_loader)) {};
+}
+
+// Loads stages on the main thread, as they upload to the GPU and audio device, until the time budget is spent or a map
+// is still parsing or the sounds decoding
+loader_Status loader_step(double budget) {
+  if (g_loader.hasFailed) return LOADER_FAILED;
+
+  double start = engine_getTime();
+  while (g_loader.loadedCount < STAGE_COUNT) {
+    const loader_Stage* stage = &STAGES[g_loader.loadedCount];
+    if (stage->level >= 0 && !maze_isLevelParsed(stage->level)) return LOADER_BUSY;
+    if (stage->isReady != nullptr && !stage->isReady()) return LOADER_BUSY;
+
+    int  timer    = startup_begin("Stage %s", stage->name);
+    bool isLoaded = stage->level >= 0 ? maze_loadLevel(stage->level, -1) : stage->load();
+    startup_end(timer);
+    if (!isLoaded) {
+      LOG_FATAL(game_log, "Failed to load %s", stage->name);
+      g_loader.hasFailed = true;
+      return LOADER_FAILED;
+    }
+
+    g_loader.isTitleReady |= stage->isTitleReady;
+    g_loader.loadedCount++;
+    if (engine_getTime() - start >= budget) break;
+  }
+
+  if (g_loader.loadedCount < STAGE_COUNT) return LOADER_BUSY;
+  return LOADER_DONE;
+}
+
+bool loader_isTitleReady(void) { return g_loader.isTitleReady; }
+
+bool loader_isDone(void) { return g_loader.loadedCount == STAGE_COUNT; }
+
+float loader_getProgress(void) { return (float) g_loader.loadedCount / STAGE_COUNT; }
+
+// Unloads whatever has loaded, in reverse, so is safe if loading failed or the game closed part way through
+void loader_unload(void) {
+  for (int i = g_loader.loadedCount - 1; i >= 0; i--) {
+    const loader_Stage* stage = &STAGES[i];
+    if (stage->level >= 0) {
+      maze_unloadLevel(stage->level);
+    } else if (stage->unload != nullptr) {
+      stage->unload();
+    }
+  }
+  g_loader = (typeof(g_loader)) {};
+}
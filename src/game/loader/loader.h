@@ -0,0 +1,15 @@
+// clang-format Language: C
+#pragma once
+
+// --- Types ---
+
+typedef enum loader_Status { LOADER_BUSY, LOADER_DONE, LOADER_FAILED } loader_Status;
+
+// --- Loader functions ---
+
+void          loader_start(void);
+loader_Status loader_step(double budget);
+bool          loader_isTitleReady(void);
+bool          loader_isDone(void);
+float         loader_getProgress(void);
+void          loader_unload(void);
@@ -63,9 +63,11 @@ typedef struct maze_Maze {
   int keyIDs[MAX_KEY_TYPES];
   bool hasKeySpawned[MAX_KEY_TYPES];
   engine_Texture *tileset;
-  maze_Tile *tiles;
+  maze_Tile *tiles;  // Only while the level is resident
+  size_t residentSize;
+  unsigned lastUsed;
 } maze_Maze;
 
 // --- Global state ---
 
-extern maze_Maze g_maze[LEVEL_COUNT];
+extern maze_Maze g_maze[MAX_LEVELS];
@@ -1,10 +1,17 @@
 #include <assert.h>
 #include <cute_headers/cute_tiled.h>
+#if !defined(__EMSCRIPTEN__)
+#define MAZE_PARSE_THREAD
+#include <pthread.h>
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include "../internal.h"
 #include "../maze/maze.h"
+#include "../metrics/metrics.h"
+#include "../pack/pack.h"
+#include "../startup/startup.h"
 #include "internal.h"
 #include "log/log.h"
 
@@ -20,6 +27,10 @@ typedef struct {
   int           animCount;
 } MapTile;
 
+#if defined(MAZE_PARSE_THREAD)
+typedef enum maze_ParseState { PARSE_NONE, PARSE_QUEUED, PARSE_DONE } maze_ParseState;
+#endif
+
 // --- Constants ---
 
 constexpr size_t   BUFFER_SIZE         = 1024;
@@ -27,6 +38,38 @@ static const float ANIM_FRAME_TIME     = 0.1f;
 static const int   TILE_PROPERTY_COUNT = 8;
 static const int   TELEPORT_TYPES      = 3;
 static const int   MAP_PROPERTY_COUNT  = 1;
+constexpr int      MAX_TILESETS        = 8;
+constexpr size_t   RESIDENT_BUDGET     = 2 * 1024 * 1024;  // About eight of the shipped levels
+constexpr size_t   SPRITE_COST         = 256;              // Rough size of an engine sprite or anim and its tracking
+
+// --- Global state ---
+
+// Levels are found at startup and loaded as play reaches them, the least recently played are evicted to stay in budget
+static struct {
+  int             levelCount;
+  engine_Texture* tilesets[MAX_TILESETS];  // Shared between levels and kept until the catalog closes
+  char            tilesetFiles[MAX_TILESETS][BUFFER_SIZE];
+  int             tilesetCount;
+  size_t          residentSize;
+  unsigned        useCount;
+  int             prefetchLevel;
+} g_catalog = { .prefetchLevel = -1 };
+
+#if defined(MAZE_PARSE_THREAD)
+static struct {
+  pthread_t         thread;
+  pthread_mutex_t   mutex;
+  pthread_cond_t    cond;
+  cute_tiled_map_t* maps[MAX_LEVELS];
+  double            parseTimes[MAX_LEVELS];
+  maze_ParseState   states[MAX_LEVELS];
+  int               queue[MAX_LEVELS];  // Levels waiting to be parsed, in the order asked for
+  int               queueHead;
+  int               queueTail;
+  bool              isRunning;
+  bool              isQuitting;
+} g_parser = { .mutex = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER };
+#endif
 
 // --- Helper functions ---
 
@@ -201,12 +244,12 @@ static bool createMaze(cute_tiled_map_t* map, MapTile tileData[], int level) {
         int animCount  = tileData[tileId].animCount;
 
         type   = tileData[tileId].type;
-        sprite = engine_createSpriteFromSheet(pos, size, tilesetRow, tilesetCol, inset);
+        sprite = render_createSpriteFromSheet(pos, size, tilesetRow, tilesetCol, inset);
         aabb   = (game_AABB) { .min = min, .max = max };
 
         if (animCount > 0) {
           LOG_TRACE(game_log, "New animation: layer: %d, tile %d, %d, frame count: %d", layerNum, row, col, animCount);
-          anim = engine_createAnim(
+          anim = render_createAnim(
               sprite,
               tilesetRow,
               tilesetCol,
@@ -362,10 +405,12 @@ static bool convertMap(cute_tiled_map_t* map, int level) {
   return true;
 }
 
+// Every layer has its own sprites and anims
 static void destroyMaze(int level) {
   if (g_maze[level].tiles != nullptr) {
-    for (int i = 0; i < g_maze[level].count; i++) {
-      if (g_maze[level].tiles[i].sprite != nullptr) engine_destroySprite(&g_maze[level].tiles[i].sprite);
+    for (int i = 0; i < g_maze[level].count * g_maze[level].layerCount; i++) {
+      if (g_maze[level].tiles[i].anim != nullptr) render_destroyAnim(&g_maze[level].tiles[i].anim);
+      if (g_maze[level].tiles[i].sprite != nullptr) render_destroySprite(&g_maze[level].tiles[i].sprite);
     }
 
     free(g_maze[level].tiles);
@@ -390,14 +435,27 @@ static bool loadMazetileset(cute_tiled_map_t* map, int level) {
   }
 
   strncat(buffer, map->tilesets->image.ptr, filenameLen);
-  GAME_TRY(g_maze[level].tileset = engine_textureLoad(buffer));
+  for (int i = 0; i < g_catalog.tilesetCount; i++) {
+    if (strcmp(g_catalog.tilesetFiles[i], buffer) == 0) {
+      g_maze[level].tileset = g_catalog.tilesets[i];
+      return true;
+    }
+  }
 
+  if (g_catalog.tilesetCount == MAX_TILESETS) {
+    LOG_FATAL(game_log, "Too many map tilesets");
+    return false;
+  }
+  GAME_TRY(g_maze[level].tileset = render_textureLoad(buffer));
+  g_catalog.tilesets[g_catalog.tilesetCount] = g_maze[level].tileset;
+  strcpy(g_catalog.tilesetFiles[g_catalog.tilesetCount], buffer);
+  g_catalog.tilesetCount++;
   return true;
 }
 
-static void unloadMazetileset(int level) {
-  assert(g_maze[level].tileset != nullptr);
-  engine_textureUnload(&g_maze[level].tileset);
+static void unloadTilesets(void) {
+  for (int i = 0; i < g_catalog.tilesetCount; i++) render_textureUnload(&g_catalog.tilesets[i]);
+  g_catalog.tilesetCount = 0;
 }
 
 void countCoins(int level) {
@@ -434,61 +492,290 @@ void findChest(int level) {
   }
 }
 
-// --- Maze functions ---
+static bool isResident(int level) { return g_maze[level].tiles != nullptr; }
 
-bool maze_init(void) {
-  bool success = false;
-  int  level   = -1;
-  // File names start at 1 but array starts at 0
-  for (int fileNum = 1; fileNum <= LEVEL_COUNT; fileNum++) {
-    level = fileNum - 1;
-    cute_tiled_map_t* map;
-
-    LOG_INFO(game_log, "--- Map %d ---", fileNum);
-
-    char format[] = ASSET_DIR "map/maze%02d.tmj";
-    int  size     = snprintf(nullptr, 0, format, fileNum);
-    char file[size + 1];
-    snprintf(file, sizeof file, format, fileNum);
-
-    GAME_TRY(map = cute_tiled_load_map_from_file(file, nullptr));
-    LOG_INFO(game_log, "Map loaded: %s (%d x %d)", file, map->width, map->height);
-
-    success = convertMap(map, level);
-    if (!success) {
-      LOG_FATAL(game_log, "Failed to convert map");
-      cute_tiled_free_map(map);
-      break;
+// Tiles for every layer, plus what the engine holds for each sprite and anim
+static size_t getResidentSize(int level) {
+  size_t size = 0;
+  for (int i = 0; i < g_maze[level].count * g_maze[level].layerCount; i++) {
+    size += sizeof(maze_Tile);
+    if (g_maze[level].tiles[i].sprite != nullptr) size += SPRITE_COST;
+    if (g_maze[level].tiles[i].anim != nullptr) size += SPRITE_COST;
+  }
+  return size;
+}
+
+// Least recently played first, never the level just loaded or the one being played
+static void evictLevels(int loadedLevel, int playingLevel) {
+  while (g_catalog.residentSize > RESIDENT_BUDGET) {
+    int oldest = -1;
+    for (int level = 0; level < g_catalog.levelCount; level++) {
+      if (!isResident(level) || level == loadedLevel || level == playingLevel) continue;
+      if (oldest == -1 || g_maze[level].lastUsed < g_maze[oldest].lastUsed) oldest = level;
     }
+    if (oldest == -1) break;
+
+    LOG_INFO(game_log, "Evicting map %d", oldest + 1);
+    maze_unloadLevel(oldest);
+  }
+}
 
-    success = loadMazetileset(map, level);
-    if (!success) {
-      LOG_FATAL(game_log, "Failed to load map tileset");
-      cute_tiled_free_map(map);
-      break;
+static void getMapName(int fileNum, char* name, size_t size) { snprintf(name, size, "map/maze%02d.tmj", fileNum); }
+
+static bool mapExists(int fileNum) {
+  char name[BUFFER_SIZE];
+  getMapName(fileNum, name, sizeof name);
+
+  size_t size = 0;
+  if (pack_find(name, &size) != nullptr) return true;
+
+  char file[BUFFER_SIZE];
+  snprintf(file, sizeof file, ASSET_DIR "%s", name);
+  return FileExists(file);
+}
+
+// Maps come from the asset pack when there is one, the JSON is parsed straight out of it
+static cute_tiled_map_t* loadMap(int fileNum) {
+  char name[BUFFER_SIZE];
+  getMapName(fileNum, name, sizeof name);
+
+  size_t      size = 0;
+  const void* data = pack_find(name, &size);
+  if (data != nullptr) {
+    LOG_INFO(game_log, "Map found in pack: %s", name);
+    return cute_tiled_load_map_from_memory(data, (int) size, nullptr);
+  }
+
+  char file[BUFFER_SIZE];
+  snprintf(file, sizeof file, ASSET_DIR "%s", name);
+  cute_tiled_map_t* map = cute_tiled_load_map_from_file(file, nullptr);
+  if (map != nullptr) LOG_INFO(game_log, "Map loaded: %s", file);
+  return map;
+}
+
+// --- Map parsing ---
+
+#if defined(MAZE_PARSE_THREAD)
+// Parses maps as they are asked for, so the main thread only has to convert each one once it is ready
+static void* parseThread([[maybe_unused]] void* arg) {
+  pthread_mutex_lock(&g_parser.mutex);
+  while (!g_parser.isQuitting) {
+    if (g_parser.queueHead == g_parser.queueTail) {
+      pthread_cond_wait(&g_parser.cond, &g_parser.mutex);
+      continue;
     }
+    int level = g_parser.queue[g_parser.queueHead++ % MAX_LEVELS];
+    pthread_mutex_unlock(&g_parser.mutex);
+
+    // File names start at 1 but array starts at 0
+    double            start = startup_getTime();
+    cute_tiled_map_t* map   = loadMap(level + 1);
+    double            time  = startup_getTime() - start;
+
+    pthread_mutex_lock(&g_parser.mutex);
+    g_parser.maps[level]       = map;
+    g_parser.parseTimes[level] = time;
+    g_parser.states[level]     = PARSE_DONE;
+    pthread_cond_broadcast(&g_parser.cond);
+  }
+  pthread_mutex_unlock(&g_parser.mutex);
+  return nullptr;
+}
 
-    cute_tiled_free_map(map);
-    countCoins(level);
-    findChest(level);
-    maze_reset(level);
+static void stopParser(void) {
+  if (!g_parser.isRunning) return;
+
+  pthread_mutex_lock(&g_parser.mutex);
+  g_parser.isQuitting = true;
+  pthread_cond_broadcast(&g_parser.cond);
+  pthread_mutex_unlock(&g_parser.mutex);
+  pthread_join(g_parser.thread, nullptr);
+
+  // Frees any maps that were never loaded, e.g. a prefetch the player never reached
+  for (int level = 0; level < MAX_LEVELS; level++) {
+    if (g_parser.maps[level] != nullptr) cute_tiled_free_map(g_parser.maps[level]);
+    g_parser.maps[level]   = nullptr;
+    g_parser.states[level] = PARSE_NONE;
   }
+  g_parser.queueHead  = 0;
+  g_parser.queueTail  = 0;
+  g_parser.isRunning  = false;
+  g_parser.isQuitting = false;
+}
+#endif
+
+// Without the parse thread the map is parsed when it is loaded instead
+static void requestParse([[maybe_unused]] int level) {
+#if defined(MAZE_PARSE_THREAD)
+  if (!g_parser.isRunning) return;
+
+  pthread_mutex_lock(&g_parser.mutex);
+  if (g_parser.states[level] == PARSE_NONE) {
+    g_parser.states[level]                            = PARSE_QUEUED;
+    g_parser.queue[g_parser.queueTail++ % MAX_LEVELS] = level;
+    pthread_cond_broadcast(&g_parser.cond);
+  }
+  pthread_mutex_unlock(&g_parser.mutex);
+#endif
+}
 
-  if (!success) {
-    for (int i = 0; i <= level; i++) {
-      destroyMaze(i);
+static cute_tiled_map_t* takeMap(int level) {
+#if defined(MAZE_PARSE_THREAD)
+  if (g_parser.isRunning) {
+    pthread_mutex_lock(&g_parser.mutex);
+    if (g_parser.states[level] != PARSE_NONE) {
+      while (g_parser.states[level] != PARSE_DONE) pthread_cond_wait(&g_parser.cond, &g_parser.mutex);
+      cute_tiled_map_t* map  = g_parser.maps[level];
+      g_parser.maps[level]   = nullptr;
+      g_parser.states[level] = PARSE_NONE;
+      double time            = g_parser.parseTimes[level];
+      pthread_mutex_unlock(&g_parser.mutex);
+
+      // Parsed in the background, so this time overlaps the other stages
+      startup_add(time, "Map %d parse (background)", level + 1);
+      return map;
     }
+    pthread_mutex_unlock(&g_parser.mutex);
+  }
+#endif
+  int               timer = startup_begin("Map %d parse", level + 1);
+  cute_tiled_map_t* map   = loadMap(level + 1);
+  startup_end(timer);
+  return map;
+}
+
+// --- Maze functions ---
+
+// Levels are the numbered maps in the pack or the asset directory, up to the first one missing. Starts the parse thread
+// where there are threads and has it parse the first level.
+bool maze_openCatalog(void) {
+  assert(g_catalog.levelCount == 0);
+
+  while (g_catalog.levelCount < MAX_LEVELS && mapExists(g_catalog.levelCount + 1)) g_catalog.levelCount++;
+  if (g_catalog.levelCount == 0) {
+    LOG_FATAL(game_log, "No maps found");
     return false;
   }
+  LOG_INFO(game_log, "Level catalog: %d level%s", g_catalog.levelCount, g_catalog.levelCount == 1 ? "" : "s");
+
+#if defined(MAZE_PARSE_THREAD)
+  assert(!g_parser.isRunning);
+  g_parser.isRunning = pthread_create(&g_parser.thread, nullptr, parseThread, nullptr) == 0;
+  if (!g_parser.isRunning) LOG_WARN(game_log, "Failed to start map parsing thread, parsing on demand");
+#endif
+  requestParse(0);
+  return true;
+}
 
-  LOG_INFO(game_log, "--- Maps loaded ---");
+// Unloads every resident level, so is safe if loading failed or the game closed part way through
+void maze_closeCatalog(void) {
+#if defined(MAZE_PARSE_THREAD)
+  stopParser();
+#endif
+  for (int level = 0; level < g_catalog.levelCount; level++) maze_unloadLevel(level);
+  unloadTilesets();
+  g_catalog = (typeof(g_catalog)) { .prefetchLevel = -1 };
+}
 
+int maze_getLevelCount(void) { return g_catalog.levelCount; }
+
+// False while the parse thread is still working on the level, loading it would then wait
+bool maze_isLevelParsed(int level) {
+  assert(level >= 0 && level < g_catalog.levelCount);
+#if defined(MAZE_PARSE_THREAD)
+  if (g_parser.isRunning) {
+    pthread_mutex_lock(&g_parser.mutex);
+    bool isParsed = g_parser.states[level] != PARSE_QUEUED;
+    pthread_mutex_unlock(&g_parser.mutex);
+    return isParsed;
+  }
+#endif
   return true;
 }
 
-void maze_shutdown(void) {
-  for (int i = 0; i < LEVEL_COUNT; i++) {
-    unloadMazetileset(i);
-    destroyMaze(i);
+// Converts the parsed map and uploads its tileset, so has to run on the main thread. A resident level is only marked as
+// used. The level being played, -1 if there is none, is never evicted to make room.
+bool maze_loadLevel(int level, int playingLevel) {
+  assert(level >= 0 && level < g_catalog.levelCount);
+  if (isResident(level)) {
+    g_maze[level].lastUsed = ++g_catalog.useCount;
+    return true;
+  }
+  LOG_INFO(game_log, "--- Map %d ---", level + 1);
+
+  cute_tiled_map_t* map = takeMap(level);
+  if (map == nullptr) {
+    LOG_FATAL(game_log, "Failed to load map %d", level + 1);
+    return false;
+  }
+  LOG_INFO(game_log, "Map size: %d x %d", map->width, map->height);
+
+  int  timer     = startup_begin("Map %d convert", level + 1);
+  bool isSuccess = convertMap(map, level);
+  startup_end(timer);
+  if (!isSuccess) {
+    LOG_FATAL(game_log, "Failed to convert map");
+    cute_tiled_free_map(map);
+    destroyMaze(level);
+    return false;
+  }
+
+  timer     = startup_begin("Map %d tileset", level + 1);
+  isSuccess = loadMazetileset(map, level);
+  startup_end(timer);
+  if (!isSuccess) {
+    LOG_FATAL(game_log, "Failed to load map tileset");
+    cute_tiled_free_map(map);
+    destroyMaze(level);
+    return false;
   }
+  cute_tiled_free_map(map);
+
+  countCoins(level);
+  findChest(level);
+  maze_reset(level);
+
+  g_maze[level].residentSize  = getResidentSize(level);
+  g_maze[level].lastUsed      = ++g_catalog.useCount;
+  g_catalog.residentSize     += g_maze[level].residentSize;
+  metrics_add(METRICS_LEVELS_LOADED, 1);
+  metrics_add(METRICS_LEVELS_RESIDENT, 1);
+  evictLevels(level, playingLevel);
+  metrics_set(METRICS_MEMORY_MAZE, g_catalog.residentSize);
+  return true;
+}
+
+// The tileset is shared, so stays loaded for other levels
+void maze_unloadLevel(int level) {
+  assert(level >= 0 && level < MAX_LEVELS);
+  if (!isResident(level)) return;
+
+  g_catalog.residentSize -= g_maze[level].residentSize;
+  metrics_add(METRICS_LEVELS_RESIDENT, -1);
+  metrics_set(METRICS_MEMORY_MAZE, g_catalog.residentSize);
+  destroyMaze(level);
+  g_maze[level].tileset = nullptr;
+}
+
+// Has the level parsed in the background, so loading it later doesn't wait on the parse
+void maze_requestLevel(int level) {
+  assert(level >= 0 && level < g_catalog.levelCount);
+  if (!isResident(level)) requestParse(level);
+}
+
+// Has the level parsed in the background, maze_updateStreaming() then converts it between frames
+void maze_prefetchLevel(int level) {
+  if (level < 0 || level >= g_catalog.levelCount || isResident(level)) return;
+
+  g_catalog.prefetchLevel = level;
+  requestParse(level);
+}
+
+// Call each frame on the main thread, once the prefetched level has parsed it is converted so is ready to play
+void maze_updateStreaming(int playingLevel) {
+  int level = g_catalog.prefetchLevel;
+  if (level == -1 || !maze_isLevelParsed(level)) return;
+
+  g_catalog.prefetchLevel = -1;
+  if (!maze_loadLevel(level, playingLevel)) LOG_WARN(game_log, "Failed to prefetch map %d", level + 1);
 }
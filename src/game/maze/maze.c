@@ -4,11 +4,12 @@
 #include <log/log.h>
 #include <raylib.h>
 #include <stdlib.h>
-#include "../asset/asset.h"
 #include "../audio/audio.h"
 #include "../draw/draw.h"
 #include "../internal.h"
 #include "../player/player.h"
+#include "../render/render.h"
+#include "../telemetry/telemetry.h"
 #include "internal.h"
 
 // --- Constants ---
@@ -18,6 +19,7 @@ const Vector2 MAZE_ORIGIN         = { 8.0f, 8.0f };  // Screen offset to the act
 const float   CHEST_DESPAWN_TIMER = 10.0f;
 const float   CHEST_SCORE_TIMER   = 2.0f;
 const Vector2 CHEST_SCORE_OFFSET  = { 5.0f, 4.0f };
+const draw_Text CHEST_SCORE_TEXT  = { "%d", 0, 0, WHITE, FONT_TINY };
 
 // --- Global state ---
 
@@ -33,6 +35,16 @@ static maze_Tile* getTileAt(Vector2 pos, int layer, int level) {
 
 // --- Helper functions ---
 
+static Vector2 getChestPos(int level) {
+  int idx = g_maze[level].chestID;
+  int row = idx % g_maze[level].count / g_maze[level].cols;
+  int col = idx % g_maze[level].count % g_maze[level].cols;
+  assert(idx >= 0 && idx < g_maze[level].count * g_maze[level].layerCount);
+  assert(row >= 0 && row < g_maze[level].rows);
+  assert(col >= 0 && col < g_maze[level].cols);
+  return (Vector2) { col * g_maze[level].tileWidth, row * g_maze[level].tileHeight };
+}
+
 // Chest appears at regular intervals of player collecting coins
 static void checkChestSpawn(int level) {
   if (g_maze[level].chestID == -1) return;
@@ -44,6 +56,7 @@ static void checkChestSpawn(int level) {
         g_maze[level].tiles[g_maze[level].chestID].isChestCollected = false;
         g_maze[level].chestDespawnTimer                             = CHEST_DESPAWN_TIMER;
         LOG_INFO(game_log, "Chest spawned at %d coins", player_getCoinsCollected());
+        TELEMETRY_EVENT(TELEMETRY_CHEST_SPAWN, i, 0, maze_getTile(getChestPos(level)));
       }
     }
   }
@@ -84,16 +97,6 @@ static void updateChestScoreTimer(double frameTime, int level) {
   g_maze[level].chestScoreTimer = fmaxf(g_maze[level].chestScoreTimer - frameTime, 0.0f);
 }
 
-static Vector2 getChestPos(int level) {
-  int idx = g_maze[level].chestID;
-  int row = idx % g_maze[level].count / g_maze[level].cols;
-  int col = idx % g_maze[level].count % g_maze[level].cols;
-  assert(idx >= 0 && idx < g_maze[level].count * g_maze[level].layerCount);
-  assert(row >= 0 && row < g_maze[level].rows);
-  assert(col >= 0 && col < g_maze[level].cols);
-  return (Vector2) { col * g_maze[level].tileWidth, row * g_maze[level].tileHeight };
-}
-
 // --- Maze functions ---
 
 game_AABB maze_getAABB(Vector2 pos) {
@@ -225,7 +228,7 @@ void maze_draw(void) {
              g_maze[level].tiles[idx].type != TILE_DOOR)) {
           engine_Sprite* sprite = g_maze[level].tiles[idx].sprite;
           assert(sprite != nullptr);
-          engine_drawSprite(g_maze[level].tileset, sprite, WHITE);
+          render_sprite(g_maze[level].tileset, sprite, WHITE);
         }
       }
     }
@@ -233,14 +236,10 @@ void maze_draw(void) {
 
   if (g_maze[level].chestScoreTimer > 0.0f) {
     Vector2 pos = Vector2Add(POS_ADJUST(getChestPos(level)), CHEST_SCORE_OFFSET);
-    engine_fontPrintf(
-        asset_getFontTiny(),
-        pos.x + draw_getTextOffset(g_maze[level].chestScore),
-        pos.y,
-        WHITE,
-        "%d",
-        g_maze[level].chestScore
-    );
+    draw_Text text = CHEST_SCORE_TEXT;
+    text.xPos      = pos.x + draw_getTextOffset(g_maze[level].chestScore);
+    text.yPos      = pos.y;
+    draw_text(text, g_maze[level].chestScore);
   }
 }
 
@@ -259,7 +258,7 @@ void maze_update(double frameTime) {
           continue;
         engine_Anim* anim = g_maze[level].tiles[idx].anim;
         if (anim != nullptr) {
-          engine_updateAnim(anim, frameTime);
+          render_updateAnim(anim, frameTime);
         }
       }
     }
@@ -323,7 +322,7 @@ void maze_reset(int level) {
       g_maze[level].tiles[idx].isKeyCollected   = true;  // Spawned later
       g_maze[level].tiles[idx].isDoorOpen       = false;
       g_maze[level].tiles[idx].hasTrapTriggered = false;
-      if (g_maze[level].tiles[idx].anim != nullptr) engine_resetAnim(g_maze[level].tiles[idx].anim);
+      if (g_maze[level].tiles[idx].anim != nullptr) render_resetAnim(g_maze[level].tiles[idx].anim);
     }
   }
 }
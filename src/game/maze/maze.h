@@ -7,8 +7,15 @@
 
 // --- Maze functions ---
 
-[[nodiscard]] bool maze_init(void);
-void               maze_shutdown(void);
+bool               maze_openCatalog(void);
+void               maze_closeCatalog(void);
+int                maze_getLevelCount(void);
+bool               maze_isLevelParsed(int level);
+[[nodiscard]] bool maze_loadLevel(int level, int playingLevel);
+void               maze_unloadLevel(int level);
+void               maze_requestLevel(int level);
+void               maze_prefetchLevel(int level);
+void               maze_updateStreaming(int playingLevel);
 game_AABB          maze_getAABB(Vector2 pos);
 bool               maze_isWall(Vector2 pos, bool isPlayer);
 bool               maze_isTeleport(Vector2 pos, Vector2* dest);
@@ -8,8 +8,10 @@
 #include "../draw/draw.h"
 #include "../input/input.h"
 #include "../internal.h"
+#include "../maze/maze.h"
 #include "../options/options.h"
 #include "../player/player.h"
+#include "../render/render.h"
 #include "../scores/scores.h"
 
 // --- Types ---
@@ -71,6 +73,7 @@ typedef struct menu_State {
   Vector2          lastMousePos;
   int              activeDropdown;
   int              dropdownSelection;
+  int              firstLevel;  // Level on the second row of the start level dropdown
 } menu_State;
 
 // --- Function prototypes ---
@@ -81,6 +84,13 @@ static void fullscreenBorderless(void);
 #endif
 static void fullscreenOn(void);
 static void fullscreenOff(void);
+static void selectLevel1(void);
+static void selectLevel2(void);
+static void selectLevel3(void);
+static void selectLevel4(void);
+static void selectLevel5(void);
+static void selectLevel6(void);
+static void selectLevel7(void);
 
 // --- Constants ---
 
@@ -102,6 +112,12 @@ static const Vector2 SLIDER_SIZE   = { 12 * TEXT_WIDTH, 7 };
 static const Color   SLIDER_COLOUR = { 239, 177, 0, 200 };
 static const float   VOLUME_SHIFT  = 0.1f;
 
+constexpr int LEVEL_ROWS        = 7;
+constexpr int LEVEL_TEXT_LENGTH = 16;
+
+// Filled in when the menu opens, from the level catalog and the player's progress
+static char g_levelText[LEVEL_ROWS][LEVEL_TEXT_LENGTH];
+
 // clang-format off
 static menu_Button MAIN_BUTTONS[] = {
   { { 165, 145, 60, 10 },      "Start Game",     MENU_GAME,             nullptr,   MENU_CONTEXT_BOTH, MENU_BUTTON_NORMAL, nullptr, 0, 0, nullptr, nullptr, 0, 0 },
@@ -144,13 +160,13 @@ static menu_Button GAME_DIFFICULTY[] = {
 };
 // [Level     : Level 1 ↓]
 static menu_Button GAME_LEVEL[] = {
-  { { 165, 70, 24, 10 },   "Level 1", MENU_NONE, game_setLevel1, MENU_CONTEXT_BOTH, MENU_BUTTON_NORMAL, nullptr, 0, 0, nullptr, nullptr, 0, 0 },
-  { { 165, 70, 24, 10 },   "Level 2", MENU_NONE, game_setLevel2, MENU_CONTEXT_BOTH, MENU_BUTTON_NORMAL, nullptr, 0, 0, nullptr, nullptr, 0, 0 },
-  { { 165, 70, 24, 10 },   "Level 3", MENU_NONE, game_setLevel3, MENU_CONTEXT_BOTH, MENU_BUTTON_NORMAL, nullptr, 0, 0, nullptr, nullptr, 0, 0 },
-  { { 165, 70, 24, 10 },   "Level 4", MENU_NONE, game_setLevel4, MENU_CONTEXT_BOTH, MENU_BUTTON_NORMAL, nullptr, 0, 0, nullptr, nullptr, 0, 0 },
-  { { 165, 70, 24, 10 },   "Level 5", MENU_NONE, game_setLevel5, MENU_CONTEXT_BOTH, MENU_BUTTON_NORMAL, nullptr, 0, 0, nullptr, nullptr, 0, 0 },
-  { { 165, 70, 24, 10 },   "Level 6", MENU_NONE, game_setLevel6, MENU_CONTEXT_BOTH, MENU_BUTTON_NORMAL, nullptr, 0, 0, nullptr, nullptr, 0, 0 },
-  { { 165, 70, 24, 10 },   "Level 7", MENU_NONE, game_setLevel7, MENU_CONTEXT_BOTH, MENU_BUTTON_NORMAL, nullptr, 0, 0, nullptr, nullptr, 0, 0 },
+  { { 165, 70, 24, 10 }, g_levelText[0], MENU_NONE, selectLevel1, MENU_CONTEXT_BOTH, MENU_BUTTON_NORMAL, nullptr, 0, 0, nullptr, nullptr, 0, 0 },
+  { { 165, 70, 24, 10 }, g_levelText[1], MENU_NONE, selectLevel2, MENU_CONTEXT_BOTH, MENU_BUTTON_NORMAL, nullptr, 0, 0, nullptr, nullptr, 0, 0 },
+  { { 165, 70, 24, 10 }, g_levelText[2], MENU_NONE, selectLevel3, MENU_CONTEXT_BOTH, MENU_BUTTON_NORMAL, nullptr, 0, 0, nullptr, nullptr, 0, 0 },
+  { { 165, 70, 24, 10 }, g_levelText[3], MENU_NONE, selectLevel4, MENU_CONTEXT_BOTH, MENU_BUTTON_NORMAL, nullptr, 0, 0, nullptr, nullptr, 0, 0 },
+  { { 165, 70, 24, 10 }, g_levelText[4], MENU_NONE, selectLevel5, MENU_CONTEXT_BOTH, MENU_BUTTON_NORMAL, nullptr, 0, 0, nullptr, nullptr, 0, 0 },
+  { { 165, 70, 24, 10 }, g_levelText[5], MENU_NONE, selectLevel6, MENU_CONTEXT_BOTH, MENU_BUTTON_NORMAL, nullptr, 0, 0, nullptr, nullptr, 0, 0 },
+  { { 165, 70, 24, 10 }, g_levelText[6], MENU_NONE, selectLevel7, MENU_CONTEXT_BOTH, MENU_BUTTON_NORMAL, nullptr, 0, 0, nullptr, nullptr, 0, 0 },
 };
 static menu_Button GAME_BUTTONS[] = {
   {  { 165, 145,  60, 10 }, "Start Game", MENU_NONE, game_start, MENU_CONTEXT_BOTH,   MENU_BUTTON_NORMAL,         nullptr,                      0, 0, nullptr, nullptr, 0, 0 },
@@ -190,6 +206,7 @@ static menu_Button OPTIONS_BUTTONS[] = {
 };
 static const int WINDOW_MODE_DROPDOWN = 5;
 static const int SCREEN_SCALE_DROPDOWN = 6;
+static const int START_LEVEL_DROPDOWN = 2;
 
 static menu_Button CREDITS_BUTTONS[] = {
   { { 165, 215, 24, 10 }, "Back", MENU_MAIN, nullptr, MENU_CONTEXT_BOTH, MENU_BUTTON_NORMAL, nullptr, 0, 0, nullptr, nullptr, 0, 0 }
@@ -259,6 +276,17 @@ static Rectangle getDropdownRectangle(const menu_Button* button) {
   float height = button->bounds.height * (button->dropdownItemCount + 2);
   return (Rectangle) { button->bounds.x, button->bounds.y - height - 1, button->bounds.width, height };
 }
+
+static Rectangle getDropdownItemRectangle(const menu_Button* button, int item) {
+  Rectangle dropdownRect = getDropdownRectangle(button);
+  return (Rectangle) {
+    dropdownRect.x, dropdownRect.y + (item + 1) * button->bounds.height, dropdownRect.width, button->bounds.height
+  };
+}
+
+static Vector2 getCentre(Rectangle rectangle) {
+  return (Vector2) { rectangle.x + rectangle.width / 2.0f, rectangle.y + rectangle.height / 2.0f };
+}
 static void activateDropdownButton(const menu_Button* button, int buttonID) {
   g_state.dropdownSelection = button->selectedItem;
   if (g_state.activeDropdown != buttonID) {
@@ -283,9 +311,7 @@ static void handleDropdownInput(const menu_Screen* screen) {
 
   for (int i = 0; i < button->dropdownItemCount; i++) {
     const menu_Button* item     = &button->dropdownItems[i];
-    Rectangle          itemRect = {
-      dropdownRect.x, dropdownRect.y + (i + 1) * button->bounds.height, dropdownRect.width, button->bounds.height
-    };
+    Rectangle          itemRect = getDropdownItemRectangle(button, i);
     if (g_state.activatedButton == i || input_isMouseButtonClick(INPUT_LEFT_BUTTON, itemRect)) {
       if (item->action != nullptr) {
         item->action();
@@ -303,19 +329,17 @@ static void drawDropdown(const menu_Button* button, int index) {
     Rectangle dropdownRect = getDropdownRectangle(button);
 
     // Draw dropdown background
-    engine_drawRectangle(dropdownRect, BG_DROP_DOWN_COLOUR);
-    engine_drawRectangleOutline(dropdownRect, BG_BORDER);
+    render_rectangle(dropdownRect, BG_DROP_DOWN_COLOUR);
+    render_rectangleOutline(dropdownRect, BG_BORDER);
 
     // Draw dropdown items
     for (int j = 0; j < button->dropdownItemCount; j++) {
       const menu_Button* item = &button->dropdownItems[j];
       if (isButtonActive(item)) {
-        Rectangle itemRect = {
-          dropdownRect.x, dropdownRect.y + (j + 1) * button->bounds.height, dropdownRect.width, button->bounds.height
-        };
+        Rectangle itemRect = getDropdownItemRectangle(button, j);
 
         bool isSelected    = !g_state.isMouseActive && g_state.dropdownSelection == j;
-        bool isItemHovered = g_state.isMouseActive && engine_isMouseHover(itemRect);
+        bool isItemHovered = g_state.isMouseActive && input_isMouseHover(itemRect);
 
         draw_Text itemText = {
           .xPos     = itemRect.x + TEXT_WIDTH,
@@ -359,7 +383,7 @@ static void activateSliderButton(const menu_Button* button) {
   Rectangle slider            = getSliderRectangle(button);
   int       sliderXScaled     = slider.x * scale;
   int       sliderWidthScaled = slider.width * scale;
-  float     mouseX            = engine_getMousePosition().x;
+  float     mouseX            = input_getMousePosition().x;
   float     newValue          = (mouseX - (float) sliderXScaled) / (float) sliderWidthScaled;
   button->sliderSet(CLAMP(newValue, button->sliderMin, button->sliderMax));
 
@@ -414,13 +438,13 @@ static void drawSliderButton(const menu_Button* button, bool isSelected, bool is
   drawButtonText(button, button->text, colour);
 
   colour = isHovered ? TEXT_ACTIVE : BG_BORDER;
-  engine_drawRectangleOutline(getSliderOutline(button), colour);
+  render_rectangleOutline(getSliderOutline(button), colour);
 
   float sliderValue = button->sliderGet();
   if (sliderValue > 0.0f) {
     Rectangle slider  = getSliderRectangle(button);
     slider.width     *= sliderValue;  // TODO: use sliderMin/sliderMax
-    engine_drawRectangle(slider, SLIDER_COLOUR);
+    render_rectangle(slider, SLIDER_COLOUR);
   }
 }
 
@@ -429,8 +453,8 @@ static void drawTextButton(const menu_Button* button) { drawButtonText(button, b
 static void drawMenuScreen(const menu_Screen* screen) {
   assert(screen != nullptr);
 
-  engine_drawRectangle(screen->background, screen->backgroundColour);
-  engine_drawRectangleOutline(screen->background, screen->borderColour);
+  render_rectangle(screen->background, screen->backgroundColour);
+  render_rectangleOutline(screen->background, screen->borderColour);
 
   // Draw regular buttons
   for (int i = 0; i < screen->buttonCount; i++) {
@@ -438,7 +462,7 @@ static void drawMenuScreen(const menu_Screen* screen) {
     assert(button != nullptr);
     if (isButtonActive(button)) {
       bool isSelected = !g_state.isMouseActive && g_state.selectedButton[g_state.currentScreen] == i;
-      bool isHovered  = g_state.activeDropdown == -1 && g_state.isMouseActive && engine_isMouseHover(button->bounds);
+      bool isHovered  = g_state.activeDropdown == -1 && g_state.isMouseActive && input_isMouseHover(button->bounds);
 
       switch (button->type) {
         case MENU_BUTTON_NORMAL: drawNormalButton(button, isSelected, isHovered); break;
@@ -527,13 +551,51 @@ static void checkKeys(const menu_Screen* screen) {
 }
 
 static void checkMouse(void) {
-  Vector2 pos = engine_getMousePosition();
+  Vector2 pos = input_getMousePosition();
   if (Vector2Distance(g_state.lastMousePos, pos) >= MOUSE_ACTIVE_DISTANCE) {
     g_state.isMouseActive = true;
     g_state.lastMousePos  = pos;
   }
 }
 
+static int getRowLevel(int row) { return row == 0 ? 0 : g_state.firstLevel + row - 1; }
+
+static void selectLevel(int row) { game_setStartLevel(getRowLevel(row)); }
+
+static void selectLevel1(void) { selectLevel(0); }
+
+static void selectLevel2(void) { selectLevel(1); }
+
+static void selectLevel3(void) { selectLevel(2); }
+
+static void selectLevel4(void) { selectLevel(3); }
+
+static void selectLevel5(void) { selectLevel(4); }
+
+static void selectLevel6(void) { selectLevel(5); }
+
+static void selectLevel7(void) { selectLevel(6); }
+
+// Too many levels to list, so offer the first level and the latest ones unlocked. Matches the full list when there are
+// no more levels than rows.
+static void setLevelRows(void) {
+  int levelCount = maze_getLevelCount();
+  int rows       = MIN(levelCount, LEVEL_ROWS);
+  int lastLevel  = player_getProgress(game_getStartDifficulty());
+  if (lastLevel > levelCount - 1) lastLevel = levelCount - 1;
+  g_state.firstLevel = MAX(lastLevel - (rows - 2), 1);
+
+  int selected = 0;
+  for (int row = 0; row < rows; row++) {
+    snprintf(g_levelText[row], LEVEL_TEXT_LENGTH, "Level %d", getRowLevel(row) + 1);
+    if (getRowLevel(row) == game_getStartLevel()) selected = row;
+  }
+  if (selected == 0) game_setStartLevel(0);
+
+  GAME_BUTTONS[START_LEVEL_DROPDOWN].dropdownItemCount = rows;
+  GAME_BUTTONS[START_LEVEL_DROPDOWN].selectedItem      = selected;
+}
+
 static void setSelectedDropdowns(void) {
 #if defined(__EMSCRIPTEN__)
   OPTIONS_BUTTONS[WINDOW_MODE_DROPDOWN].selectedItem = options_getWindowMode() - 1;
@@ -546,6 +608,8 @@ static void setSelectedDropdowns(void) {
   OPTIONS_BUTTONS[SCREEN_SCALE_DROPDOWN].dropdownItems     = &SCALE_LEVEL[dropdownIndex];
   OPTIONS_BUTTONS[SCREEN_SCALE_DROPDOWN].dropdownItemCount = maxScale;
   OPTIONS_BUTTONS[SCREEN_SCALE_DROPDOWN].selectedItem      = maxScale - options_getScreenScale();
+
+  setLevelRows();
 }
 
 #if !defined(__EMSCRIPTEN__)
@@ -586,7 +650,7 @@ void menu_open(menu_Context context) {
 
   g_state.currentScreen     = MENU_MAIN;
   g_state.context           = context;
-  g_state.lastMousePos      = engine_getMousePosition();
+  g_state.lastMousePos      = input_getMousePosition();
   g_state.activeDropdown    = -1;
   const menu_Screen* screen = &SCREENS[g_state.currentScreen];
   resetButtonState(screen);
@@ -617,6 +681,30 @@ void menu_draw(void) {
   if (g_state.isMouseActive) draw_cursor();
 }
 
+// What a player could click, the items of an open dropdown or else the screen's buttons, for the soak bot to find
+int menu_getTargets(menu_Target targets[], int maxTargets) {
+  assert(targets != nullptr);
+
+  const menu_Screen* screen = &SCREENS[g_state.currentScreen];
+  int                count  = 0;
+  if (g_state.activeDropdown != -1) {
+    const menu_Button* button = &screen->buttons[g_state.activeDropdown];
+    for (int i = 0; i < button->dropdownItemCount && count < maxTargets; i++) {
+      if (!isButtonActive(&button->dropdownItems[i])) continue;
+      Rectangle itemRect = getDropdownItemRectangle(button, i);
+      targets[count++]   = (menu_Target) { button->dropdownItems[i].text, getCentre(itemRect) };
+    }
+    return count;
+  }
+
+  for (int i = 0; i < screen->buttonCount && count < maxTargets; i++) {
+    const menu_Button* button = &screen->buttons[i];
+    if (!isButtonActive(button) || button->type == MENU_BUTTON_TEXT) continue;
+    targets[count++] = (menu_Target) { button->text, getCentre(button->bounds) };
+  }
+  return count;
+}
+
 void menu_back(void) {
   switch (g_state.currentScreen) {
     case MENU_MAIN:
@@ -1,10 +1,18 @@
 // clang-format Language: C
 #pragma once
 
+#include <raylib.h>
+
 // --- Types ---
 
 typedef enum menu_Context { MENU_CONTEXT_TITLE, MENU_CONTEXT_INGAME, MENU_CONTEXT_BOTH } menu_Context;
 
+// A button or dropdown item as it is labelled on screen, the centre is in canvas pixels
+typedef struct menu_Target {
+  const char* text;
+  Vector2     centre;
+} menu_Target;
+
 // --- Menu functions ---
 
 void menu_open(menu_Context context);
@@ -12,3 +20,4 @@ void menu_close(void);
 void menu_update(void);
 void menu_draw(void);
 void menu_back(void);
+int  menu_getTargets(menu_Target targets[], int maxTargets);
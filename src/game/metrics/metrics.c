@@ -0,0 +1,321 @@
+#include "metrics.h"
+#include <assert.h>
+#include <log/log.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include "../internal.h"
+
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+#define METRICS_SERVER
+#include <errno.h>
+#include <net/address.h>
+#include <netdb.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#if !defined(MSG_NOSIGNAL)
+#define MSG_NOSIGNAL 0  // SO_NOSIGPIPE is set on the socket instead
+#endif
+#endif
+
+// --- Constants ---
+
+constexpr int BUCKET_COUNT = 10;
+
+// Upper bounds in seconds, finest around 60 fps
+static const double FRAME_BUCKETS[BUCKET_COUNT] = {
+  0.004, 0.008, 0.0125, 0.0167, 0.02, 0.025, 0.0334, 0.05, 0.1, 0.25
+};
+
+#if defined(METRICS_SERVER)
+constexpr int    POLL_INTERVAL   = 100;   // Milliseconds between checks for closing
+constexpr int    TIMEOUT         = 1000;  // Milliseconds to read a request or send a response
+constexpr int    BACKLOG         = 4;
+constexpr size_t REQUEST_LENGTH  = 1024;
+constexpr size_t RESPONSE_LENGTH = 16384;
+
+static const char OK_HEADER[] = "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+                                "Content-Length: %zu\r\nConnection: close\r\n\r\n";
+static const char NOT_FOUND[] = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+#endif
+
+// --- Types ---
+
+typedef struct metrics_Info {
+  const char* name;
+  const char* type;
+  const char* help;
+  const char* labels;  // Metrics sharing a name follow each other, told apart by their labels
+  double      scale;   // From the stored value to the served one
+} metrics_Info;
+
+#if defined(METRICS_SERVER)
+typedef struct metrics_Buffer {
+  char   data[RESPONSE_LENGTH];
+  size_t length;
+} metrics_Buffer;
+#endif
+
+// --- Global state ---
+
+static const metrics_Info METRICS[METRICS_COUNT] = {
+  [METRICS_UPDATE_TIME]     = { "mythic_update_seconds_total", "counter", "Time spent updating the game", "", 1e-9 },
+  [METRICS_DRAW_TIME]       = { "mythic_draw_seconds_total", "counter", "Time spent drawing the game", "", 1e-9 },
+  [METRICS_DRAW_CALLS]      = { "mythic_draw_calls", "gauge", "Render commands in the last frame drawn", "", 1.0 },
+  [METRICS_ACTIVE_VOICES]   = { "mythic_active_voices", "gauge", "Sound effects playing", "", 1.0 },
+  [METRICS_SAVE_QUEUE]      = { "mythic_save_queue", "gauge", "Save writes waiting to reach the file", "", 1.0 },
+  [METRICS_LEVELS_LOADED]   = { "mythic_levels_loaded_total", "counter", "Levels loaded, reloads included", "", 1.0 },
+  [METRICS_LEVELS_RESIDENT] = { "mythic_levels_resident", "gauge", "Levels loaded and not yet evicted", "", 1.0 },
+  [METRICS_RUNS_STARTED]    = { "mythic_runs_started_total", "counter", "Games started", "", 1.0 },
+  [METRICS_RUNS_WON]        = { "mythic_runs_completed_total", "counter", "Games ended", "{outcome=\"won\"}", 1.0 },
+  [METRICS_RUNS_LOST]       = { "mythic_runs_completed_total", "counter", "Games ended", "{outcome=\"lost\"}", 1.0 },
+  [METRICS_MEMORY_PACK]     = { "mythic_memory_bytes", "gauge", "Memory held", "{subsystem=\"pack\"}", 1.0 },
+  [METRICS_MEMORY_MAZE]     = { "mythic_memory_bytes", "gauge", "Memory held", "{subsystem=\"maze\"}", 1.0 },
+  [METRICS_MEMORY_SOUNDS]   = { "mythic_memory_bytes", "gauge", "Memory held", "{subsystem=\"sounds\"}", 1.0 },
+  [METRICS_MEMORY_SAVE]     = { "mythic_memory_bytes", "gauge", "Memory held", "{subsystem=\"save\"}", 1.0 },
+  [METRICS_SPRITES]         = { "mythic_engine_objects", "gauge", "Engine objects alive", "{kind=\"sprite\"}", 1.0 },
+  [METRICS_ANIMS]           = { "mythic_engine_objects", "gauge", "Engine objects alive", "{kind=\"anim\"}", 1.0 },
+  [METRICS_TEXTURES]        = { "mythic_engine_objects", "gauge", "Engine objects alive", "{kind=\"texture\"}", 1.0 },
+  [METRICS_FONTS]           = { "mythic_engine_objects", "gauge", "Engine objects alive", "{kind=\"font\"}", 1.0 }
+};
+
+// Written from any thread, the server only reads them, so a scrape never holds up a frame
+static struct {
+  atomic_llong values[METRICS_COUNT];
+  atomic_llong frames[BUCKET_COUNT + 1];  // Per bucket, the last is anything slower
+  atomic_llong frameTime;                 // Nanoseconds
+#if defined(METRICS_SERVER)
+  pthread_t      thread;
+  atomic_bool    isQuitting;
+  bool           isRunning;
+  int            listener;
+  const char*    socketFile;  // Removed on closing
+  metrics_Buffer response;    // Owned by the server thread
+#endif
+} g_metrics;
+
+// --- Helper functions ---
+
+static inline long long toNanos(double seconds) { return (long long) (seconds * 1e9); }
+
+#if defined(METRICS_SERVER)
+[[gnu::format(printf, 2, 3)]] static void append(metrics_Buffer* buffer, const char* format, ...) {
+  size_t  remaining = sizeof(buffer->data) - buffer->length;
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(buffer->data + buffer->length, remaining, format, args);
+  va_end(args);
+  if (length > 0) buffer->length += (size_t) length < remaining ? (size_t) length : remaining - 1;
+}
+
+// A scrape can land part way through a frame, so the histogram's count and sum may be a frame apart
+static void formatMetrics(metrics_Buffer* buffer) {
+  buffer->length = 0;
+  append(buffer, "# HELP mythic_frame_seconds Time between frames\n# TYPE mythic_frame_seconds histogram\n");
+  long long count = 0;
+  for (int i = 0; i <= BUCKET_COUNT; i++) {
+    count += atomic_load_explicit(&g_metrics.frames[i], memory_order_relaxed);
+    if (i < BUCKET_COUNT) {
+      append(buffer, "mythic_frame_seconds_bucket{le=\"%g\"} %lld\n", FRAME_BUCKETS[i], count);
+    } else {
+      append(buffer, "mythic_frame_seconds_bucket{le=\"+Inf\"} %lld\n", count);
+    }
+  }
+  double sum = atomic_load_explicit(&g_metrics.frameTime, memory_order_relaxed) * 1e-9;
+  append(buffer, "mythic_frame_seconds_sum %.9g\nmythic_frame_seconds_count %lld\n", sum, count);
+
+  for (int i = 0; i < METRICS_COUNT; i++) {
+    const metrics_Info* info = &METRICS[i];
+    if (i == 0 || strcmp(info->name, METRICS[i - 1].name) != 0) {
+      append(buffer, "# HELP %s %s\n# TYPE %s %s\n", info->name, info->help, info->name, info->type);
+    }
+    long long value = atomic_load_explicit(&g_metrics.values[i], memory_order_relaxed);
+    if (info->scale == 1.0) {
+      append(buffer, "%s%s %lld\n", info->name, info->labels, value);
+    } else {
+      append(buffer, "%s%s %.9g\n", info->name, info->labels, value * info->scale);
+    }
+  }
+}
+
+static bool sendAll(int fd, const void* data, size_t size) {
+  const unsigned char* bytes = data;
+  while (size > 0) {
+    ssize_t sent = send(fd, bytes, size, MSG_NOSIGNAL);
+    if (sent < 0 && errno == EINTR) continue;
+    if (sent <= 0) return false;
+    bytes += sent;
+    size  -= sent;
+  }
+  return true;
+}
+
+// Reads up to the end of the request's headers, the body of anything but a GET is ignored
+static bool receiveRequest(int fd, char* request, size_t size) {
+  size_t length = 0;
+  while (length + 1 < size) {
+    ssize_t received = recv(fd, request + length, size - length - 1, 0);
+    if (received < 0 && errno == EINTR) continue;
+    if (received <= 0) return false;
+    length          += received;
+    request[length]  = '\0';
+    if (strstr(request, "\r\n\r\n") != nullptr || strstr(request, "\n\n") != nullptr) return true;
+  }
+  return true;
+}
+
+static void serveClient(int fd) {
+  struct timeval timeout = { .tv_sec = TIMEOUT / 1000, .tv_usec = TIMEOUT % 1000 * 1000 };
+  if (setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)) != 0) return;
+  if (setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) != 0) return;
+#if defined(SO_NOSIGPIPE)
+  int isSet = 1;
+  if (setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &isSet, sizeof(isSet)) != 0) return;
+#endif
+
+  char request[REQUEST_LENGTH];
+  if (!receiveRequest(fd, request, sizeof(request))) return;
+  if (strncmp(request, "GET /metrics ", 13) != 0 && strncmp(request, "GET / ", 6) != 0) {
+    sendAll(fd, NOT_FOUND, sizeof(NOT_FOUND) - 1);
+    return;
+  }
+
+  metrics_Buffer* response = &g_metrics.response;
+  formatMetrics(response);
+  char header[sizeof(OK_HEADER) + 16];
+  int  headerLength = snprintf(header, sizeof(header), OK_HEADER, response->length);
+  if (sendAll(fd, header, headerLength)) sendAll(fd, response->data, response->length);
+}
+
+// One scrape at a time, a client that stalls is dropped after the timeout
+static void* serveThread([[maybe_unused]] void* arg) {
+  struct pollfd ready = { .fd = g_metrics.listener, .events = POLLIN };
+  while (!atomic_load_explicit(&g_metrics.isQuitting, memory_order_acquire)) {
+    if (poll(&ready, 1, POLL_INTERVAL) != 1) continue;
+    int fd = accept(g_metrics.listener, nullptr, nullptr);
+    if (fd == -1) continue;
+    serveClient(fd);
+    close(fd);
+  }
+  return nullptr;
+}
+
+// A socket left behind by a game that didn't close is replaced, anything else at the path is left alone
+static int listenUnix(const char* path) {
+  struct sockaddr_un address = { .sun_family = AF_UNIX };
+  if (strlen(path) >= sizeof(address.sun_path)) return -1;
+  memcpy(address.sun_path, path, strlen(path) + 1);
+
+  struct stat info;
+  if (lstat(path, &info) == 0 && S_ISSOCK(info.st_mode)) unlink(path);
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd == -1) return -1;
+  if (bind(fd, (const struct sockaddr*) &address, sizeof(address)) != 0 || listen(fd, BACKLOG) != 0) {
+    close(fd);
+    return -1;
+  }
+  g_metrics.socketFile = path;
+  return fd;
+}
+
+static void closeListener(void) {
+  close(g_metrics.listener);
+  if (g_metrics.socketFile != nullptr) unlink(g_metrics.socketFile);
+  g_metrics.socketFile = nullptr;
+}
+
+// Only this machine can scrape unless a host is given
+static int listenTcp(const char* text) {
+  net_Address address;
+  if (!net_parseAddress(text, &address)) return -1;
+
+  struct addrinfo  hints = { .ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM, .ai_flags = AI_PASSIVE };
+  struct addrinfo* info;
+  if (getaddrinfo(address.host, address.port, &hints, &info) != 0) return -1;
+
+  int fd = -1;
+  for (struct addrinfo* item = info; fd == -1 && item != nullptr; item = item->ai_next) {
+    fd = socket(item->ai_family, item->ai_socktype, item->ai_protocol);
+    if (fd == -1) continue;
+
+    int reuse = 1;
+    if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) != 0 ||
+        bind(fd, item->ai_addr, item->ai_addrlen) != 0 || listen(fd, BACKLOG) != 0) {
+      close(fd);
+      fd = -1;
+    }
+  }
+  freeaddrinfo(info);
+  return fd;
+}
+#endif
+
+// --- Metrics functions ---
+
+// Serves the metrics at "[HOST:]PORT", or a Unix socket given as a path, on its own thread
+bool metrics_open([[maybe_unused]] const char* address) {
+  assert(address != nullptr);
+#if defined(METRICS_SERVER)
+  assert(!g_metrics.isRunning);
+
+  g_metrics.listener = strchr(address, '/') != nullptr ? listenUnix(address) : listenTcp(address);
+  if (g_metrics.listener == -1) {
+    LOG_ERROR(game_log, "Unable to serve metrics on %s", address);
+    return false;
+  }
+  atomic_store(&g_metrics.isQuitting, false);
+  g_metrics.isRunning = pthread_create(&g_metrics.thread, nullptr, serveThread, nullptr) == 0;
+  if (!g_metrics.isRunning) {
+    LOG_ERROR(game_log, "Failed to start the metrics thread");
+    closeListener();
+    return false;
+  }
+  LOG_INFO(game_log, "Serving metrics on %s", address);
+  return true;
+#else
+  LOG_WARN(game_log, "The metrics endpoint isn't supported on this platform");
+  return false;
+#endif
+}
+
+void metrics_add(metrics_Metric metric, long long amount) {
+  assert(metric >= 0 && metric < METRICS_COUNT);
+  atomic_fetch_add_explicit(&g_metrics.values[metric], amount, memory_order_relaxed);
+}
+
+void metrics_set(metrics_Metric metric, long long value) {
+  assert(metric >= 0 && metric < METRICS_COUNT);
+  atomic_store_explicit(&g_metrics.values[metric], value, memory_order_relaxed);
+}
+
+long long metrics_get(metrics_Metric metric) {
+  assert(metric >= 0 && metric < METRICS_COUNT);
+  return atomic_load_explicit(&g_metrics.values[metric], memory_order_relaxed);
+}
+
+void metrics_addTime(metrics_Metric metric, double seconds) { metrics_add(metric, toNanos(seconds)); }
+
+void metrics_recordFrame(double frameTime) {
+  int bucket = 0;
+  while (bucket < BUCKET_COUNT && frameTime > FRAME_BUCKETS[bucket]) bucket++;
+  atomic_fetch_add_explicit(&g_metrics.frames[bucket], 1, memory_order_relaxed);
+  atomic_fetch_add_explicit(&g_metrics.frameTime, toNanos(frameTime), memory_order_relaxed);
+}
+
+// The counters carry on, so the endpoint can be opened again
+void metrics_close(void) {
+#if defined(METRICS_SERVER)
+  if (!g_metrics.isRunning) return;
+
+  atomic_store_explicit(&g_metrics.isQuitting, true, memory_order_release);
+  pthread_join(g_metrics.thread, nullptr);
+  g_metrics.isRunning = false;
+  closeListener();
+#endif
+}
@@ -0,0 +1,39 @@
+// clang-format Language: C
+#pragma once
+
+// Runtime counters and gauges, kept up to date with relaxed atomics wherever they change. --metrics serves them in the
+// Prometheus text format from its own thread, which only ever reads them.
+
+// --- Types ---
+
+typedef enum metrics_Metric {
+  METRICS_UPDATE_TIME,  // Nanoseconds, served as seconds
+  METRICS_DRAW_TIME,
+  METRICS_DRAW_CALLS,     // Render commands in the last frame submitted
+  METRICS_ACTIVE_VOICES,  // Effects playing
+  METRICS_SAVE_QUEUE,     // Save writes waiting on the write thread
+  METRICS_LEVELS_LOADED,
+  METRICS_LEVELS_RESIDENT,
+  METRICS_RUNS_STARTED,
+  METRICS_RUNS_WON,
+  METRICS_RUNS_LOST,
+  METRICS_MEMORY_PACK,  // Bytes
+  METRICS_MEMORY_MAZE,
+  METRICS_MEMORY_SOUNDS,
+  METRICS_MEMORY_SAVE,
+  METRICS_SPRITES,  // Engine objects alive
+  METRICS_ANIMS,
+  METRICS_TEXTURES,
+  METRICS_FONTS,
+  METRICS_COUNT
+} metrics_Metric;
+
+// --- Metrics functions ---
+
+bool      metrics_open(const char* address);
+void      metrics_add(metrics_Metric metric, long long amount);
+void      metrics_set(metrics_Metric metric, long long value);
+long long metrics_get(metrics_Metric metric);
+void      metrics_addTime(metrics_Metric metric, double seconds);
+void      metrics_recordFrame(double frameTime);
+void      metrics_close(void);
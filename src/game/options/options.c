@@ -4,6 +4,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "../save/save.h"
+#include "../startup/startup.h"
 
 // --- Constants ---
 
@@ -15,18 +17,14 @@ static const engine_WindowMode DEFAULT_WINDOW_MODE = MODE_BORDERLESS;
 
 static const int   DEFAULT_SCREEN_SCALE = -1;
 static const float DEFAULT_VOLUME       = 1.0f;
-static const char  OPTIONS_FILE[]       = "options.txt";
+static const char  OPTIONS_FILE[]       = "options.txt";  // Read once to migrate to the save store
+static const int   OPTIONS_VERSION      = 1;              // Of the saved layout, bump it with a migration
 
 #define MASTER_VOLUME "masterVolume"
 #define MUSIC_VOLUME "musicVolume"
 #define SFX_VOLUME "sfxVolume"
 #define WINDOW_MODE "windowMode"
 #define SCREEN_SCALE "screenScale"
-static const char FORMAT_MASTER_VOLUME[] = MASTER_VOLUME "=%.2f\n";
-static const char FORMAT_MUSIC_VOLUME[]  = MUSIC_VOLUME "=%.2f\n";
-static const char FORMAT_SFX_VOLUME[]    = SFX_VOLUME "=%.2f\n";
-static const char FORMAT_WINDOW_MODE[]   = WINDOW_MODE "=%d\n";
-static const char FORMAT_SCREEN_SCALE[]  = SCREEN_SCALE "=%d\n";
 
 constexpr int LINE_LENGTH    = 64;
 constexpr int SETTING_LENGTH = 16;
@@ -57,9 +55,9 @@ static void setDefaults(void) {
   g_options.screenScale  = DEFAULT_SCREEN_SCALE;
 }
 
-static void loadOptionsFile(const char* fileName) {
+static bool loadOptionsFile(const char* fileName) {
   FILE* file = fopen(fileName, "r");
-  if (!file) return;
+  if (!file) return false;
 
   char line[LINE_LENGTH];
   while (fgets(line, sizeof(line), file)) {
@@ -90,29 +88,22 @@ static void loadOptionsFile(const char* fileName) {
   }
 
   fclose(file);
-}
-
-static void saveOptionsFile(const char* fileName) {
-  FILE* file = fopen(fileName, "w");
-  if (!file) return;
-
-  fprintf(file, FORMAT_MASTER_VOLUME, g_options.masterVolume);
-  fprintf(file, FORMAT_MUSIC_VOLUME, g_options.musicVolume);
-  fprintf(file, FORMAT_SFX_VOLUME, g_options.sfxVolume);
-  fprintf(file, FORMAT_WINDOW_MODE, (int) g_options.windowMode);
-  fprintf(file, FORMAT_SCREEN_SCALE, g_options.screenScale);
-
-  fclose(file);
+  return true;
 }
 
 // --- Options functions ---
 
 void options_load(void) {
+  int timer = startup_begin("Options file");
   setDefaults();
-  loadOptionsFile(OPTIONS_FILE);
+  if (save_read(SAVE_OPTIONS, OPTIONS_VERSION, &g_options, sizeof(g_options), nullptr) == SAVE_MISSING &&
+      loadOptionsFile(OPTIONS_FILE)) {
+    options_save();
+  }
+  startup_end(timer);
 }
 
-void options_save(void) { saveOptionsFile(OPTIONS_FILE); }
+void options_save(void) { save_write(SAVE_OPTIONS, OPTIONS_VERSION, &g_options, sizeof(g_options)); }
 
 // --- Volume options ---
 
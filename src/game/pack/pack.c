@@ -0,0 +1,256 @@
+#include "pack.h"
+#include <assert.h>
+#include <log/log.h>
+#include <pack/format.h>
+#include <raylib.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../internal.h"
+#include "../metrics/metrics.h"
+
+#if defined(GAME_EMBED_ASSETS)
+// Generated by the pack tool at build time
+extern const unsigned char pack_embeddedData[];
+extern const size_t        pack_embeddedSize;
+#elif !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+#define PACK_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// --- Types ---
+
+typedef struct pack_Key {
+  const char* name;
+  pack_Type   type;
+} pack_Key;
+
+// --- Global state ---
+
+static struct {
+  const unsigned char* data;
+  size_t               size;
+  const pack_Entry*    entries;
+  int                  entryCount;
+} g_pack;
+
+// --- Helper functions ---
+
+static bool mapFile([[maybe_unused]] const char* file) {
+#if defined(GAME_EMBED_ASSETS)
+  // Already in memory, paged in as it is read
+  g_pack.data = pack_embeddedData;
+  g_pack.size = pack_embeddedSize;
+#elif defined(PACK_MMAP)
+  int fd = open(file, O_RDONLY);
+  if (fd == -1) return false;
+
+  struct stat info;
+  if (fstat(fd, &info) == -1 || info.st_size == 0) {
+    close(fd);
+    return false;
+  }
+  void* data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) return false;
+
+  g_pack.data = data;
+  g_pack.size = info.st_size;
+#else
+  if (!FileExists(file)) return false;
+
+  int size    = 0;
+  g_pack.data = LoadFileData(file, &size);
+  if (g_pack.data == nullptr) return false;
+  g_pack.size = size;
+#endif
+  return true;
+}
+
+static void unmapFile(void) {
+#if defined(PACK_MMAP)
+  munmap((void*) g_pack.data, g_pack.size);
+#elif !defined(GAME_EMBED_ASSETS)
+  UnloadFileData((unsigned char*) g_pack.data);
+#endif
+}
+
+static int compareEntry(const void* key, const void* entry) {
+  const pack_Key*   packKey   = key;
+  const pack_Entry* packEntry = entry;
+  int               order     = strcmp(packKey->name, packEntry->name);
+  return order != 0 ? order : (int) packKey->type - (int) packEntry->type;
+}
+
+// Decoded entries have to hold as many samples or pixels as their header says
+static bool isEntryValid(const pack_Entry* entry) {
+  const unsigned char* data = g_pack.data + entry->offset;
+  switch (entry->type) {
+    case PACK_FILE:
+      return true;
+    case PACK_WAVE: {
+      if (entry->size < sizeof(pack_Wave)) return false;
+      const pack_Wave* wave = (const pack_Wave*) data;
+      return (uint64_t) wave->frameCount * wave->channels * (wave->sampleSize / 8) == entry->size - sizeof(pack_Wave);
+    }
+    case PACK_IMAGE: {
+      if (entry->size < sizeof(pack_Image)) return false;
+      const pack_Image* image = (const pack_Image*) data;
+      return (uint64_t) image->width * image->height * 4 == entry->size - sizeof(pack_Image);
+    }
+    default:
+      return false;
+  }
+}
+
+// The index is binary searched, so has to be in order as well as in bounds
+static bool isValid(void) {
+  if (g_pack.size < sizeof(pack_Header)) return false;
+
+  const pack_Header* header = (const pack_Header*) g_pack.data;
+  if (memcmp(header->magic, PACK_MAGIC, sizeof(header->magic)) != 0 || header->version != PACK_VERSION) return false;
+  if (sizeof(pack_Header) + (size_t) header->entryCount * sizeof(pack_Entry) > g_pack.size) return false;
+
+  const pack_Entry* entries = (const pack_Entry*) (g_pack.data + sizeof(pack_Header));
+  for (uint32_t i = 0; i < header->entryCount; i++) {
+    if ((size_t) entries[i].offset + entries[i].size > g_pack.size) return false;
+    if (entries[i].name[PACK_NAME_LENGTH - 1] != '\0' || !isEntryValid(&entries[i])) return false;
+    if (i > 0 && compareEntry(&(pack_Key) { entries[i - 1].name, entries[i - 1].type }, &entries[i]) >= 0) {
+      return false;
+    }
+  }
+
+  g_pack.entries    = entries;
+  g_pack.entryCount = header->entryCount;
+  return true;
+}
+
+// A path into the asset directory is taken as the name it's packed under
+static const pack_Entry* findEntry(const char* name, pack_Type type) {
+  if (g_pack.entries == nullptr) return nullptr;
+  if (strncmp(name, ASSET_DIR, strlen(ASSET_DIR)) == 0) name += strlen(ASSET_DIR);
+
+  pack_Key key = { .name = name, .type = type };
+  return bsearch(&key, g_pack.entries, g_pack.entryCount, sizeof(pack_Entry), compareEntry);
+}
+
+// raylib loads the engine's images through this, so its file based loaders read from the pack. raylib frees what it's
+// given, so this is the one place entries are copied, decoded sounds and images are used in place instead.
+static unsigned char* loadFileData(const char* fileName, int* dataSize) {
+  assert(fileName != nullptr);
+  assert(dataSize != nullptr);
+
+  size_t      size = 0;
+  const void* data = pack_find(fileName, &size);
+  if (data == nullptr) {
+    // Not packed, so let raylib read it from disk
+    SetLoadFileDataCallback(nullptr);
+    unsigned char* fileData = LoadFileData(fileName, dataSize);
+    SetLoadFileDataCallback(loadFileData);
+    return fileData;
+  }
+
+  unsigned char* copy = MemAlloc(size);
+  if (copy == nullptr) {
+    *dataSize = 0;
+    return nullptr;
+  }
+  memcpy(copy, data, size);
+  *dataSize = (int) size;
+  return copy;
+}
+
+// --- Pack functions ---
+
+// A missing pack isn't an error, assets are then read from the asset directory as loose files. Builds with the pack
+// embedded ignore the file.
+bool pack_open(const char* file) {
+  assert(file != nullptr);
+  assert(g_pack.data == nullptr);
+#if defined(GAME_EMBED_ASSETS)
+  file = "embedded in the executable";
+#endif
+
+  if (!mapFile(file)) {
+    LOG_INFO(game_log, "No asset pack at %s, loading loose files", file);
+    return false;
+  }
+  if (!isValid()) {
+    LOG_WARN(game_log, "Invalid asset pack %s, loading loose files", file);
+    pack_close();
+    return false;
+  }
+
+  SetLoadFileDataCallback(loadFileData);
+  metrics_set(METRICS_MEMORY_PACK, g_pack.size);
+  LOG_INFO(game_log, "Asset pack %s: %d entries, %zu bytes", file, g_pack.entryCount, g_pack.size);
+  return true;
+}
+
+// Returns the file's bytes in place, valid until pack_close()
+const void* pack_find(const char* name, size_t* size) {
+  assert(name != nullptr);
+  assert(size != nullptr);
+
+  const pack_Entry* entry = findEntry(name, PACK_FILE);
+  if (entry == nullptr) return nullptr;
+
+  *size = entry->size;
+  return g_pack.data + entry->offset;
+}
+
+// The sound file's samples in place, valid until pack_close(). The wave is the pack's and read only, so it's copied
+// rather than formatted and never unloaded.
+bool pack_findWave(const char* name, Wave* wave) {
+  assert(name != nullptr);
+  assert(wave != nullptr);
+
+  const pack_Entry* entry = findEntry(name, PACK_WAVE);
+  if (entry == nullptr) return false;
+
+  const pack_Wave* header = (const pack_Wave*) (g_pack.data + entry->offset);
+  *wave                   = (Wave) {
+    .frameCount = header->frameCount,
+    .sampleRate = header->sampleRate,
+    .sampleSize = header->sampleSize,
+    .channels   = header->channels,
+    .data       = (void*) (header + 1)
+  };
+  return true;
+}
+
+// The image file's pixels in place, as pack_findWave()
+bool pack_findImage(const char* name, Image* image) {
+  assert(name != nullptr);
+  assert(image != nullptr);
+
+  const pack_Entry* entry = findEntry(name, PACK_IMAGE);
+  if (entry == nullptr) return false;
+
+  const pack_Image* header = (const pack_Image*) (g_pack.data + entry->offset);
+  *image                   = (Image) {
+    .data    = (void*) (header + 1),
+    .width   = (int) header->width,
+    .height  = (int) header->height,
+    .mipmaps = 1,
+    .format  = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8
+  };
+  return true;
+}
+
+// Whether the data is a view into the pack, so mustn't be freed
+bool pack_contains(const void* data) {
+  const unsigned char* bytes = data;
+  return g_pack.data != nullptr && bytes >= g_pack.data && bytes < g_pack.data + g_pack.size;
+}
+
+void pack_close(void) {
+  if (g_pack.data == nullptr) return;
+
+  SetLoadFileDataCallback(nullptr);
+  unmapFile();
+  g_pack = (typeof(g_pack)) {};
+  metrics_set(METRICS_MEMORY_PACK, 0);
+}
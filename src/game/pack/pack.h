@@ -0,0 +1,14 @@
+// clang-format Language: C
+#pragma once
+
+#include <raylib.h>
+#include <stddef.h>
+
+// --- Pack functions ---
+
+bool        pack_open(const char* file);
+const void* pack_find(const char* name, size_t* size);
+bool        pack_findWave(const char* name, Wave* wave);
+bool        pack_findImage(const char* name, Image* image);
+bool        pack_contains(const void* data);
+void        pack_close(void);
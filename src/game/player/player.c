@@ -13,7 +13,11 @@
 #include "../draw/draw.h"
 #include "../input/input.h"
 #include "../maze/maze.h"
+#include "../save/save.h"
 #include "../scores/scores.h"
+#include "../soak/soak.h"
+#include "../splits/splits.h"
+#include "../startup/startup.h"
 #include "game/game.h"
 #include "log/log.h"
 
@@ -42,8 +46,9 @@ typedef struct Player {
   float            coinSlowTimer;
   float            swordSlowTimer;
   int              lastScoreBonusLife;
+  game_Tile        tile;  // For telemetry, reset on every restart
   Progress         progress;
-  player_levelData levelData[LEVEL_COUNT];
+  player_levelData levelData[MAX_LEVELS];
   player_levelData fullRun;
 } Player;
 
@@ -52,7 +57,7 @@ typedef struct Player {
 static const Vector2     PLAYER_START_POS                    = { 14 * TILE_SIZE, 10 * TILE_SIZE };
 static const float       PLAYER_MAX_SPEED[DIFFICULTY_COUNT]  = { 88.0f, 80.0f, 80.0f };
 static const game_Dir    PLAYER_START_DIR                    = DIR_LEFT;
-static const KeyboardKey PLAYER_KEYS[]                       = { KEY_UP, KEY_RIGHT, KEY_DOWN, KEY_LEFT };
+static const input_Key   PLAYER_KEYS[]                       = { INPUT_UP, INPUT_RIGHT, INPUT_DOWN, INPUT_LEFT };
 static const int         SCORE_COIN                          = 10;
 static const int         SCORE_SWORD                         = 50;
 static const float       PLAYER_DEAD_TIMER                   = 2.0f;
@@ -66,6 +71,7 @@ static const float       SWORD_MAX_TIMER[DIFFICULTY_COUNT]   = { 14.0f, 10.0f, 6
 static const float       SWORD_MIN_TIMER[DIFFICULTY_COUNT]   = { 8.4f, 6.0f, 3.6f };     // 60%
 static const int         SCORE_EXTRA_LIFE[DIFFICULTY_COUNT]  = { 3000, 5000, 10000 };
 static const int         SCORE_CHEST                         = 100;
+static const int         PROGRESS_VERSION                    = 1;  // Of the saved layout, bump it with a migration
 static const draw_Text   LOCKED_TEXT = { "             (locked)", 168, 185, TEXT_RED, FONT_NORMAL };
 
 // --- Global state ---
@@ -110,7 +116,10 @@ static void chestPickup(void) {
   audio_playPickup(player_getPos());
 }
 
-static void keyPickup(void) { audio_playPickup(player_getPos()); }
+static void keyPickup(void) {
+  audio_playPickup(player_getPos());
+  splits_split(SPLITS_KEY);
+}
 
 static float getSwordTimer(void) {
   float t                    = fminf(fmaxf((game_getLevel() - 1) / (MAX_LEVEL - 1.0f), 0.0f), 1.0f);
@@ -128,6 +137,7 @@ static void swordPickup(void) {
   g_player.scoreMultiplier = 1;
   actor_setSpeed(g_player.actor, PLAYER_SLOW_SPEED[game_getDifficulty()]);
   audio_resetChimePitch();
+  splits_split(SPLITS_SWORD);
 }
 
 static void coinSlowUpdate(double frameTime) {
@@ -169,7 +179,7 @@ static void swordUpdate(double frameTime) {
 
 static void updateProgress(game_Difficulty difficulty, int levelCompleted) {
   assert(difficulty >= 0 && difficulty < DIFFICULTY_COUNT);
-  assert(levelCompleted >= 0 && levelCompleted < LEVEL_COUNT);
+  assert(levelCompleted >= 0 && levelCompleted < maze_getLevelCount());
 
   int* target = nullptr;
   switch (difficulty) {
@@ -182,18 +192,15 @@ static void updateProgress(game_Difficulty difficulty, int levelCompleted) {
 }
 
 static void saveProgress(void) {
-  FILE* file = fopen("progress.txt", "w");
-  if (!file) return;
-
-  fprintf(file, "easy=%d\n", g_player.progress.easy);
-  fprintf(file, "normal=%d\n", g_player.progress.normal);
-  fprintf(file, "arcade=%d\n", g_player.progress.arcade);
-
-  fclose(file);
+  save_write(SAVE_PROGRESS, PROGRESS_VERSION, &g_player.progress, sizeof(g_player.progress));
 }
 
-bool loadProgress(void) {
+// The old text file is only read when the save store has no progress, and is then migrated to it
+bool player_loadProgress(void) {
   g_player.progress = (Progress) {};
+  save_Status status =
+      save_read(SAVE_PROGRESS, PROGRESS_VERSION, &g_player.progress, sizeof(g_player.progress), nullptr);
+  if (status != SAVE_MISSING) return true;
 
   FILE* file = fopen("progress.txt", "r");
   if (!file) return true;
@@ -213,11 +220,13 @@ bool loadProgress(void) {
   }
 
   fclose(file);
+  saveProgress();
   return true;
 }
 
 static void levelClear(void) {
-  g_player.time += engine_getTime() - g_player.previousTime;
+  g_player.time += game_getTime() - g_player.previousTime;
+  splits_split(SPLITS_CLEAR);
 
   int level      = game_getLevel();
   int difficulty = game_getDifficulty();
@@ -239,11 +248,11 @@ static void levelClear(void) {
       g_player.levelData[level].time, g_player.levelData[level].score, g_player.levelData[level].lives
   );
 
-  if (level == LEVEL_COUNT - 1 && game_getStartLevel() == 0) {
+  if (level == maze_getLevelCount() - 1 && game_getStartLevel() == 0) {
     g_player.fullRun.time  = 0.0;
     g_player.fullRun.score = 0;
     g_player.fullRun.lives = 0;
-    for (int i = 0; i < LEVEL_COUNT; i++) {
+    for (int i = 0; i < maze_getLevelCount(); i++) {
       if (game_getDifficulty() == DIFFICULTY_ARCADE) {
         g_player.fullRun.time += g_player.levelData[i].frameCount * FRAME_TIME;
       } else {
@@ -258,8 +267,9 @@ static void levelClear(void) {
   }
 
   audio_playWin(player_getPos());
+  // The bot unlocks levels for the rest of its soak, but never for the player
   updateProgress(difficulty, level);
-  saveProgress();
+  if (!soak_isRunning()) saveProgress();
 }
 
 static void checkPickups(void) {
@@ -269,29 +279,45 @@ static void checkPickups(void) {
   if (maze_isCoin(pos)) {
     maze_pickupCoin(pos);
     coinPickup();
+    TELEMETRY_EVENT(TELEMETRY_PICKUP, TELEMETRY_PICKUP_COIN, 0, maze_getTile(pos));
   } else if (maze_isSword(pos)) {
     maze_pickupSword(pos);
     swordPickup();
     creature_swordPickup();
+    TELEMETRY_EVENT(TELEMETRY_PICKUP, TELEMETRY_PICKUP_SWORD, 0, maze_getTile(pos));
   } else if (maze_isChest(pos)) {
     maze_pickupChest(pos, getChestScore());
     chestPickup();
+    TELEMETRY_EVENT(TELEMETRY_PICKUP, TELEMETRY_PICKUP_CHEST, 0, maze_getTile(pos));
   } else if (maze_isKey(pos)) {
     maze_pickupKey(pos);
     keyPickup();
+    TELEMETRY_EVENT(TELEMETRY_PICKUP, TELEMETRY_PICKUP_KEY, 0, maze_getTile(pos));
   }
 }
 
-static void deadCommon(void) {
+static void updateTile(void) {
+  game_Tile tile = maze_getTile(Vector2AddValue(actor_getPos(g_player.actor), ACTOR_SIZE / 2.0f));
+  if (tile.col == g_player.tile.col && tile.row == g_player.tile.row) return;
+
+  g_player.tile = tile;
+  telemetry_record(TELEMETRY_TILE, 0, 0, tile);
+}
+
+static void deadCommon(telemetry_Death cause, int creatureID) {
   g_player.lives     -= 1;
   g_player.deadTimer  = PLAYER_DEAD_TIMER;
   audio_resetChimePitch();
+  TELEMETRY_EVENT(
+      TELEMETRY_DEATH, cause, creatureID, maze_getTile(Vector2AddValue(actor_getPos(g_player.actor), ACTOR_SIZE / 2.0f))
+  );
 }
 
 static void fallToDeath(void) {
   if (debug_isPlayerImmune()) return;
 
-  deadCommon();
+  player_onPause();
+  deadCommon(TELEMETRY_DEATH_FALL, -1);
   g_player.state = PLAYER_FALLING;
   audio_playFalling(player_getPos());
 }
@@ -312,7 +338,7 @@ static bool checkTraps(void) {
     return true;
   } else if (maze_isTrap(pos)) {
     maze_trapTriggered(pos);
-    player_dead();
+    player_dead(TELEMETRY_DEATH_TRAP, -1);
     return true;
   }
   return false;
@@ -342,7 +368,10 @@ bool player_init(void) {
       PLAYER_MAX_SPEED[game_getDifficulty()],
       true
   );
-  GAME_TRY(loadProgress());
+  int  timer      = startup_begin("Progress file");
+  bool isProgress = player_loadProgress();
+  startup_end(timer);
+  GAME_TRY(isProgress);
   return g_player.actor != nullptr;
 }
 
@@ -353,11 +382,12 @@ void player_shutdown(void) {
 }
 
 void player_ready(void) {
-  g_player.previousTime     = engine_getTime();
+  g_player.previousTime     = game_getTime();
   g_player.time             = 0.0;
   int level                 = game_getLevel();
   g_player.levelData[level] = (player_levelData) {};
   g_accumulator             = 0.0;
+  splits_startLevel();
 }
 
 void player_update(double frameTime, float slop) {
@@ -365,7 +395,10 @@ void player_update(double frameTime, float slop) {
   assert(frameTime >= 0.0f);
   assert(slop >= 0.0f);
 
+  // Split as the level is timed, Arcade Mode by the frame and otherwise only while the player is alive
+  bool isDead = g_player.state == PLAYER_DEAD || g_player.state == PLAYER_FALLING;
   if (game_getDifficulty() == DIFFICULTY_ARCADE) g_player.levelData[game_getLevel()].frameCount++;
+  if (game_getDifficulty() == DIFFICULTY_ARCADE || !isDead) splits_tick(frameTime);
 
 #ifndef NDEBUG
   if (input_isKeyPressed(INPUT_F)) debug_toggleFPSOverlay();
@@ -396,7 +429,7 @@ void player_update(double frameTime, float slop) {
 
   game_Dir dir = DIR_NONE;
   for (int i = 0; i < DIR_COUNT; i++) {
-    if (engine_isKeyDown(PLAYER_KEYS[i]) && actor_canMove(g_player.actor, (game_Dir) i, slop)) {
+    if (input_isKeyDown(PLAYER_KEYS[i]) && actor_canMove(g_player.actor, (game_Dir) i, slop)) {
       dir = (game_Dir) i;
       break;
     }
@@ -405,6 +438,7 @@ void player_update(double frameTime, float slop) {
   if (dir == DIR_NONE) dir = actor_getDir(g_player.actor);
 
   actor_move(g_player.actor, dir, frameTime);
+  if (telemetry_isOn()) updateTile();
 
   if (checkTraps()) return;  // Dead!
   checkPickups();
@@ -431,6 +465,7 @@ void player_restart(void) {
   actor_setSpeed(g_player.actor, PLAYER_MAX_SPEED[game_getDifficulty()]);
   actor_startMoving(g_player.actor);
   audio_resetChimePitch();
+  g_player.tile = TELEMETRY_NOWHERE;
 }
 
 // Next level
@@ -450,9 +485,9 @@ void player_totalReset() {
   g_player.lastScoreBonusLife = 0;
 }
 
-void player_onPause(void) { g_player.time += engine_getTime() - g_player.previousTime; }
+void player_onPause(void) { g_player.time += game_getTime() - g_player.previousTime; }
 
-void player_onResume(void) { g_player.previousTime = engine_getTime(); }
+void player_onResume(void) { g_player.previousTime = game_getTime(); }
 
 game_Tile player_tileAhead(int tileNum) {
   assert(tileNum > 0);
@@ -566,11 +601,12 @@ bool player_hasSword(void) {
   return g_player.swordTimer > 0.0f;
 }
 
-void player_dead(void) {
+// The creature's ID is -1 unless one caught the player
+void player_dead(telemetry_Death cause, int creatureID) {
   if (debug_isPlayerImmune()) return;
   player_onPause();
 
-  deadCommon();
+  deadCommon(cause, creatureID);
   g_player.state = PLAYER_DEAD;
   audio_playDeath(player_getPos());
 }
@@ -583,3 +619,27 @@ void player_killedCreature(int creatureID) {
   g_player.scoreMultiplier *= 2;
   creature_setScore(creatureID, score);
 }
+
+// Filled in rather than returned, it holds every level's results
+void player_getCarry(player_Carry* carry) {
+  assert(carry != nullptr);
+  carry->lives              = g_player.lives;
+  carry->previousLives      = g_player.previousLives;
+  carry->score              = g_player.score;
+  carry->previousScore      = g_player.previousScore;
+  carry->lastScoreBonusLife = g_player.lastScoreBonusLife;
+  carry->fullRun            = g_player.fullRun;
+  memcpy(carry->levelData, g_player.levelData, sizeof(carry->levelData));
+}
+
+// Call after player_totalReset() to start a level part way through a run
+void player_setCarry(const player_Carry* carry) {
+  assert(carry != nullptr);
+  g_player.lives              = carry->lives;
+  g_player.previousLives      = carry->previousLives;
+  g_player.score              = carry->score;
+  g_player.previousScore      = carry->previousScore;
+  g_player.lastScoreBonusLife = carry->lastScoreBonusLife;
+  g_player.fullRun            = carry->fullRun;
+  memcpy(g_player.levelData, carry->levelData, sizeof(g_player.levelData));
+}
@@ -4,6 +4,7 @@
 #include <raylib.h>
 #include "../internal.h"
 #include "../scores/scores.h"
+#include "../telemetry/telemetry.h"
 #include "game/game.h"
 
 typedef struct player_levelData {
@@ -14,6 +15,17 @@ typedef struct player_levelData {
   scores_Result clearResult;
 } player_levelData;
 
+// What a level inherits from the ones before it, everything else is reset as it starts
+typedef struct player_Carry {
+  int              lives;
+  int              previousLives;
+  int              score;
+  int              previousScore;
+  int              lastScoreBonusLife;
+  player_levelData levelData[MAX_LEVELS];
+  player_levelData fullRun;
+} player_Carry;
+
 // --- Player functions ---
 
 bool             player_init(void);
@@ -39,9 +51,12 @@ float            player_getSwordTimer(void);
 int              player_getCoinsCollected(void);
 int              player_getNextExtraLifeScore(void);
 int              player_getProgress(game_Difficulty difficulty);
+bool             player_loadProgress(void);
 float            player_getNewLifeTimer(void);
 void             player_drawContinue(void);
 bool             player_isMoving(void);
 bool             player_hasSword(void);
-void             player_dead(void);
+void             player_dead(telemetry_Death cause, int creatureID);
 void             player_killedCreature(int creatureID);
+void             player_getCarry(player_Carry* carry);
+void             player_setCarry(const player_Carry* carry);
@@ -0,0 +1,37 @@
+/*
+ * internal.h: Internal to render units, don't include in other units.
+ */
+
+#pragma once
+// Clang format Language: C
+
+#include <engine/engine.h>
+#include <raylib.h>
+
+// --- Types ---
+
+// What the engine keeps hidden inside its sprites and fonts, mirrored so other backends can draw them. Text is drawn a
+// glyph at a time by every backend, the engine's from a texture of the font's sheet made once there's a window.
+typedef struct render_SpriteInfo {
+  Rectangle source;
+  Vector2   pos;
+  Vector2   offset;
+} render_SpriteInfo;
+
+typedef struct render_FontInfo {
+  const char* file;
+  int         glyphWidth;
+  int         glyphHeight;
+  int         firstChar;
+  int         lastChar;
+  int         xSpacing;
+  int         ySpacing;
+  int         columns;  // Glyphs to a row of the sheet
+  Texture2D   texture;
+} render_FontInfo;
+
+// --- Tracking functions ---
+
+const char* render_getTextureFile(const engine_Texture* texture);
+bool        render_getSpriteInfo(const engine_Sprite* sprite, render_SpriteInfo* info);
+bool        render_getFontInfo(const engine_Font* font, render_FontInfo* info);
@@ -0,0 +1,251 @@
+#include "render.h"
+#include <assert.h>
+#include <engine/engine.h>
+#include <log/log.h>
+#include <raylib.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../internal.h"
+#include "../metrics/metrics.h"
+#include "internal.h"
+
+// --- Constants ---
+
+constexpr int    MAX_COMMANDS = 4096;  // A full maze with all its layers is ~1,500 sprites
+constexpr size_t TEXT_ARENA   = 16384;
+constexpr int    LAYER_SHIFT  = 24;
+constexpr int    SEQUENCE_MAX = 1 << LAYER_SHIFT;
+
+// --- Engine backend ---
+
+// Scaled as the engine scales its own drawing, from the font sheet's texture
+static void drawGlyph(const engine_Font* font, Rectangle source, Vector2 pos, Color colour) {
+  render_FontInfo info;
+  if (!render_getFontInfo(font, &info) || info.texture.id == 0) return;
+
+  float     scale = engine_getScale();
+  Rectangle dest  = { pos.x * scale, pos.y * scale, source.width * scale, source.height * scale };
+  DrawTexturePro(info.texture, source, dest, (Vector2) {}, 0.0f, colour);
+}
+
+static void engineExecute(const render_Command* command) {
+  assert(command != nullptr);
+
+  switch (command->type) {
+    case RENDER_BACKGROUND: engine_drawBackground(command->background); break;
+    case RENDER_SPRITE    : engine_drawSprite(command->sprite.texture, command->sprite.sprite, command->colour); break;
+    case RENDER_GLYPH:
+      drawGlyph(command->glyph.font, command->glyph.source, command->glyph.pos, command->colour);
+      break;
+    case RENDER_RECTANGLE        : engine_drawRectangle(command->rectangle, command->colour); break;
+    case RENDER_RECTANGLE_OUTLINE: engine_drawRectangleOutline(command->rectangle, command->colour); break;
+    case RENDER_LINE             : engine_drawLine(command->line.start, command->line.end, command->colour); break;
+    case RENDER_ARROW:
+      engine_drawArrow(command->line.start, command->line.end, command->line.size, command->colour);
+      break;
+    case RENDER_DEBUG_TEXT:
+      engine_drawText(command->debug.string, command->debug.pos, command->debug.size, command->colour);
+      break;
+    case RENDER_DEBUG_FLOAT:
+      engine_drawFloat(command->debug.floatValue, command->debug.pos, command->debug.size, command->colour);
+      break;
+    case RENDER_DEBUG_INT:
+      engine_drawInt(command->debug.intValue, command->debug.pos, command->debug.size, command->colour);
+      break;
+    case RENDER_SCREEN_TEXT:
+      DrawText(
+          command->debug.string, command->debug.pos.x, command->debug.pos.y, command->debug.size, command->colour
+      );
+      break;
+    default: assert(false); break;
+  }
+}
+
+static const render_Backend ENGINE_BACKEND = { .beginFrame = nullptr, .execute = engineExecute, .endFrame = nullptr };
+
+// --- Global state ---
+
+static struct {
+  render_Command        commands[MAX_COMMANDS];
+  int                   commandCount;
+  char                  text[TEXT_ARENA];
+  size_t                textUsed;
+  render_Layer          layer;
+  unsigned              sequence;
+  bool                  hasOverflowed;
+  const render_Backend* backend;
+} g_state = { .backend = &ENGINE_BACKEND };
+
+// --- Helper functions ---
+
+static render_Command* pushCommand(render_CommandType type, Color colour) {
+  if (g_state.commandCount == MAX_COMMANDS || g_state.sequence == SEQUENCE_MAX) {
+    if (!g_state.hasOverflowed) LOG_ERROR(game_log, "Render command list full, dropping commands");
+    g_state.hasOverflowed = true;
+    return nullptr;
+  }
+
+  unsigned        sortKey = ((unsigned) g_state.layer << LAYER_SHIFT) | g_state.sequence++;
+  render_Command* command = &g_state.commands[g_state.commandCount++];
+  *command                = (render_Command) { .type = type, .sortKey = sortKey, .colour = colour };
+  return command;
+}
+
+// Strings are copied as callers often format into a buffer that is reused before the frame is submitted
+static const char* copyString(const char* string) {
+  assert(string != nullptr);
+
+  size_t length = strlen(string) + 1;
+  if (g_state.textUsed + length > TEXT_ARENA) {
+    if (!g_state.hasOverflowed) LOG_ERROR(game_log, "Render text arena full, dropping text");
+    g_state.hasOverflowed = true;
+    return nullptr;
+  }
+
+  char* copy = &g_state.text[g_state.textUsed];
+  memcpy(copy, string, length);
+  g_state.textUsed += length;
+  return copy;
+}
+
+static int compareCommands(const void* a, const void* b) {
+  unsigned keyA = ((const render_Command*) a)->sortKey;
+  unsigned keyB = ((const render_Command*) b)->sortKey;
+  return (keyA > keyB) - (keyA < keyB);
+}
+
+static bool isSorted(void) {
+  for (int i = 1; i < g_state.commandCount; i++) {
+    if (g_state.commands[i - 1].sortKey > g_state.commands[i].sortKey) return false;
+  }
+  return true;
+}
+
+static void pushDebug(render_CommandType type, const char* string, Vector2 pos, int size, Color colour) {
+  const char* copy = copyString(string);
+  if (copy == nullptr) return;
+
+  render_Command* command = pushCommand(type, colour);
+  if (command == nullptr) return;
+  command->debug.string = copy;
+  command->debug.pos    = pos;
+  command->debug.size   = size;
+}
+
+// --- Render functions ---
+
+void render_begin(void) {
+  g_state.commandCount  = 0;
+  g_state.textUsed      = 0;
+  g_state.sequence      = 0;
+  g_state.layer         = LAYER_BACKGROUND;
+  g_state.hasOverflowed = false;
+}
+
+void render_setLayer(render_Layer layer) {
+  assert(layer >= 0 && layer < LAYER_COUNT);
+  g_state.layer = layer;
+}
+
+void render_background(engine_Texture* texture) {
+  assert(texture != nullptr);
+
+  render_Command* command = pushCommand(RENDER_BACKGROUND, WHITE);
+  if (command != nullptr) command->background = texture;
+}
+
+void render_sprite(engine_Texture* texture, engine_Sprite* sprite, Color colour) {
+  assert(texture != nullptr);
+  assert(sprite != nullptr);
+
+  render_Command* command = pushCommand(RENDER_SPRITE, colour);
+  if (command == nullptr) return;
+  command->sprite.texture = texture;
+  command->sprite.sprite  = sprite;
+}
+
+// Each glyph of text laid out by render_layoutText() is a command of its own, so drawing text never lays it out again
+void render_glyphs(const engine_Font* font, const render_Glyph* glyphs, int count, int xPos, int yPos, Color colour) {
+  assert(font != nullptr);
+  assert(glyphs != nullptr || count == 0);
+
+  for (int i = 0; i < count; i++) {
+    render_Command* command = pushCommand(RENDER_GLYPH, colour);
+    if (command == nullptr) return;
+    command->glyph.font   = font;
+    command->glyph.source = glyphs[i].source;
+    command->glyph.pos    = (Vector2) { xPos + glyphs[i].offset.x, yPos + glyphs[i].offset.y };
+  }
+}
+
+void render_rectangle(Rectangle rectangle, Color colour) {
+  render_Command* command = pushCommand(RENDER_RECTANGLE, colour);
+  if (command != nullptr) command->rectangle = rectangle;
+}
+
+void render_rectangleOutline(Rectangle rectangle, Color colour) {
+  render_Command* command = pushCommand(RENDER_RECTANGLE_OUTLINE, colour);
+  if (command != nullptr) command->rectangle = rectangle;
+}
+
+void render_line(Vector2 start, Vector2 end, Color colour) {
+  render_Command* command = pushCommand(RENDER_LINE, colour);
+  if (command == nullptr) return;
+  command->line.start = start;
+  command->line.end   = end;
+}
+
+void render_arrow(Vector2 start, Vector2 end, int size, Color colour) {
+  render_Command* command = pushCommand(RENDER_ARROW, colour);
+  if (command == nullptr) return;
+  command->line.start = start;
+  command->line.end   = end;
+  command->line.size  = size;
+}
+
+void render_debugText(const char* string, Vector2 pos, int size, Color colour) {
+  pushDebug(RENDER_DEBUG_TEXT, string, pos, size, colour);
+}
+
+void render_debugFloat(float value, Vector2 pos, int size, Color colour) {
+  render_Command* command = pushCommand(RENDER_DEBUG_FLOAT, colour);
+  if (command == nullptr) return;
+  command->debug.floatValue = value;
+  command->debug.pos        = pos;
+  command->debug.size       = size;
+}
+
+void render_debugInt(int value, Vector2 pos, int size, Color colour) {
+  render_Command* command = pushCommand(RENDER_DEBUG_INT, colour);
+  if (command == nullptr) return;
+  command->debug.intValue = value;
+  command->debug.pos      = pos;
+  command->debug.size     = size;
+}
+
+void render_screenText(const char* string, int xPos, int yPos, int size, Color colour) {
+  pushDebug(RENDER_SCREEN_TEXT, string, (Vector2) { xPos, yPos }, size, colour);
+}
+
+// Sorts the frame's commands and hands them to the backend, the list stays readable until the next render_begin()
+void render_submit(void) {
+  // Layers are mostly pushed in order, so skip the sort when there is nothing to do
+  if (!isSorted()) qsort(g_state.commands, g_state.commandCount, sizeof(g_state.commands[0]), compareCommands);
+
+  const render_Backend* backend = g_state.backend;
+  if (backend->beginFrame != nullptr) backend->beginFrame();
+  for (int i = 0; i < g_state.commandCount; i++) backend->execute(&g_state.commands[i]);
+  if (backend->endFrame != nullptr) backend->endFrame();
+  metrics_set(METRICS_DRAW_CALLS, g_state.commandCount);
+}
+
+void render_setBackend(const render_Backend* backend) {
+  assert(backend == nullptr || backend->execute != nullptr);
+  g_state.backend = backend != nullptr ? backend : &ENGINE_BACKEND;
+}
+
+const render_Command* render_getCommands(int* count) {
+  assert(count != nullptr);
+  *count = g_state.commandCount;
+  return g_state.commands;
+}
@@ -0,0 +1,131 @@
+// clang-format Language: C
+#pragma once
+
+#include <engine/engine.h>
+#include <raylib.h>
+
+// --- Types ---
+
+// Commands are sorted by layer, then by the order they were pushed within that layer
+typedef enum render_Layer {
+  LAYER_BACKGROUND,
+  LAYER_MAZE,
+  LAYER_ACTORS,
+  LAYER_INTERFACE,
+  LAYER_PANEL,
+  LAYER_MENU,
+  LAYER_CURSOR,
+  LAYER_DEBUG,
+  LAYER_COUNT
+} render_Layer;
+
+typedef enum render_CommandType {
+  RENDER_BACKGROUND,
+  RENDER_SPRITE,
+  RENDER_GLYPH,
+  RENDER_RECTANGLE,
+  RENDER_RECTANGLE_OUTLINE,
+  RENDER_LINE,
+  RENDER_ARROW,
+  RENDER_DEBUG_TEXT,
+  RENDER_DEBUG_FLOAT,
+  RENDER_DEBUG_INT,
+  RENDER_SCREEN_TEXT,
+  RENDER_COMMAND_COUNT
+} render_CommandType;
+
+typedef struct render_Command {
+  render_CommandType type;
+  unsigned           sortKey;
+  Color              colour;
+  union {
+    struct {
+      engine_Texture* texture;
+      engine_Sprite*  sprite;
+    } sprite;
+    struct {
+      const engine_Font* font;
+      Rectangle          source;  // In the font's sheet
+      Vector2            pos;
+    } glyph;
+    struct {
+      Vector2     pos;
+      int         size;
+      const char* string;
+      float       floatValue;
+      int         intValue;
+    } debug;
+    struct {
+      Vector2 start;
+      Vector2 end;
+      int     size;
+    } line;
+    engine_Texture* background;
+    Rectangle       rectangle;
+  };
+} render_Command;
+
+// A character of laid out text, where it comes from in the font's sheet and where it goes from where the text is drawn
+typedef struct render_Glyph {
+  Rectangle source;
+  Vector2   offset;
+} render_Glyph;
+
+// A backend consumes the sorted command list, the default one calls straight into the engine
+typedef struct render_Backend {
+  void (*beginFrame)(void);
+  void (*execute)(const render_Command* command);
+  void (*endFrame)(void);
+} render_Backend;
+
+// --- Render functions ---
+
+void                  render_begin(void);
+void                  render_setLayer(render_Layer layer);
+void                  render_background(engine_Texture* texture);
+void                  render_sprite(engine_Texture* texture, engine_Sprite* sprite, Color colour);
+void                  render_rectangle(Rectangle rectangle, Color colour);
+void                  render_rectangleOutline(Rectangle rectangle, Color colour);
+void                  render_line(Vector2 start, Vector2 end, Color colour);
+void                  render_arrow(Vector2 start, Vector2 end, int size, Color colour);
+void                  render_debugText(const char* string, Vector2 pos, int size, Color colour);
+void                  render_debugFloat(float value, Vector2 pos, int size, Color colour);
+void                  render_debugInt(int value, Vector2 pos, int size, Color colour);
+void                  render_screenText(const char* string, int xPos, int yPos, int size, Color colour);
+void                  render_submit(void);
+void                  render_setBackend(const render_Backend* backend);
+const render_Command* render_getCommands(int* count);
+
+void render_glyphs(const engine_Font* font, const render_Glyph* glyphs, int count, int xPos, int yPos, Color colour);
+
+// --- Resource functions ---
+
+// Wrap the engine calls so other backends can see the sprite geometry the engine keeps to itself. The engine doesn't
+// expose it, so it's mirrored from the arguments, with the animation frame worked out from the time played.
+void            render_setTracking(bool isTracking);
+engine_Texture* render_textureLoad(const char* file);
+void            render_textureUnload(engine_Texture** texture);
+void            render_fontUnload(engine_Font** font);
+int             render_layoutText(const engine_Font* font, const char* string, render_Glyph* glyphs, int maxGlyphs);
+engine_Sprite*  render_createSprite(Vector2 pos, Vector2 size, Vector2 offset);
+engine_Sprite*  render_createSpriteFromSheet(Vector2 pos, Vector2 size, int row, int col, Vector2 inset);
+void            render_destroySprite(engine_Sprite** sprite);
+void            render_spriteSetPos(engine_Sprite* sprite, Vector2 pos);
+void            render_destroyAnim(engine_Anim** anim);
+void            render_resetAnim(engine_Anim* anim);
+void            render_updateAnim(engine_Anim* anim, double frameTime);
+void            render_checkLeaks(void);
+
+engine_Font* render_fontLoad(
+    const char* file, int glyphWidth, int glyphHeight, int firstChar, int lastChar, int xSpacing, int ySpacing
+);
+engine_Anim* render_createAnim(
+    engine_Sprite* sprite, int row, int startCol, int frameCount, double frameTime, Vector2 inset, bool loop
+);
+
+// --- Software renderer functions ---
+
+bool                  render_softInit(int width, int height);
+void                  render_softShutdown(void);
+const render_Backend* render_getSoftBackend(void);
+const Color*          render_getSoftPixels(void);
@@ -0,0 +1,246 @@
+#include <assert.h>
+#include <log/log.h>
+#include <math.h>
+#include <raylib.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../internal.h"
+#include "../pack/pack.h"
+#include "internal.h"
+#include "render.h"
+
+// --- Constants ---
+
+constexpr int    MAX_IMAGES  = 16;
+constexpr size_t FILE_LENGTH = 256;
+
+// --- Types ---
+
+typedef struct soft_Image {
+  char  file[FILE_LENGTH];
+  Image image;  // Always R8G8B8A8
+} soft_Image;
+
+// --- Global state ---
+
+static struct {
+  Color*     pixels;
+  int        width;
+  int        height;
+  soft_Image images[MAX_IMAGES];
+  int        imageCount;
+} g_state;
+
+// --- Helper functions ---
+
+// Images are decoded once, the engine's copies live on the GPU where we can't read them. The asset pack has them
+// decoded already, so those are used in place.
+static const Image* getImage(const char* file) {
+  if (file == nullptr) return nullptr;
+
+  for (int i = 0; i < g_state.imageCount; i++) {
+    if (strcmp(g_state.images[i].file, file) == 0) return &g_state.images[i].image;
+  }
+
+  if (g_state.imageCount == MAX_IMAGES) {
+    LOG_ERROR(game_log, "Too many images for the software renderer");
+    return nullptr;
+  }
+  Image image;
+  if (!pack_findImage(file, &image)) image = LoadImage(file);
+  if (image.data == nullptr) {
+    LOG_ERROR(game_log, "Failed to load image %s", file);
+    return nullptr;
+  }
+  ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);  // Packed images already are, so aren't touched
+
+  soft_Image* entry = &g_state.images[g_state.imageCount++];
+  strncpy(entry->file, file, FILE_LENGTH - 1);
+  entry->image = image;
+  return &entry->image;
+}
+
+static inline unsigned char blendChannel(int src, int dst, int alpha) {
+  return (unsigned char) ((src * alpha + dst * (255 - alpha) + 127) / 255);
+}
+
+static inline void blendPixel(int x, int y, Color colour) {
+  if (x < 0 || y < 0 || x >= g_state.width || y >= g_state.height || colour.a == 0) return;
+
+  Color* dst = &g_state.pixels[y * g_state.width + x];
+  if (colour.a == 255) {
+    *dst = colour;
+    return;
+  }
+  dst->r = blendChannel(colour.r, dst->r, colour.a);
+  dst->g = blendChannel(colour.g, dst->g, colour.a);
+  dst->b = blendChannel(colour.b, dst->b, colour.a);
+  dst->a = 255;
+}
+
+static inline int toPixel(float value) { return (int) floorf(value + 0.5f); }
+
+// Copy part of an image to the canvas, multiplying by the tint the way the GPU would
+static void blit(const Image* image, int srcX, int srcY, int width, int height, int dstX, int dstY, Color tint) {
+  assert(image != nullptr);
+
+  // Clip against both the source image and the canvas
+  if (srcX < 0) width += srcX, dstX -= srcX, srcX = 0;
+  if (srcY < 0) height += srcY, dstY -= srcY, srcY = 0;
+  if (dstX < 0) width += dstX, srcX -= dstX, dstX = 0;
+  if (dstY < 0) height += dstY, srcY -= dstY, dstY = 0;
+  width  = MIN(width, MIN(image->width - srcX, g_state.width - dstX));
+  height = MIN(height, MIN(image->height - srcY, g_state.height - dstY));
+  if (width <= 0 || height <= 0) return;
+
+  const Color* src     = image->data;
+  bool         isWhite = tint.r == 255 && tint.g == 255 && tint.b == 255 && tint.a == 255;
+  for (int y = 0; y < height; y++) {
+    const Color* srcRow = &src[(srcY + y) * image->width + srcX];
+    for (int x = 0; x < width; x++) {
+      Color colour = srcRow[x];
+      if (colour.a == 0) continue;
+      if (!isWhite) {
+        colour.r = colour.r * tint.r / 255;
+        colour.g = colour.g * tint.g / 255;
+        colour.b = colour.b * tint.b / 255;
+        colour.a = colour.a * tint.a / 255;
+      }
+      blendPixel(dstX + x, dstY + y, colour);
+    }
+  }
+}
+
+static void fillRectangle(Rectangle rectangle, Color colour) {
+  int x0 = MAX(toPixel(rectangle.x), 0);
+  int y0 = MAX(toPixel(rectangle.y), 0);
+  int x1 = MIN(toPixel(rectangle.x + rectangle.width), g_state.width);
+  int y1 = MIN(toPixel(rectangle.y + rectangle.height), g_state.height);
+  for (int y = y0; y < y1; y++) {
+    for (int x = x0; x < x1; x++) blendPixel(x, y, colour);
+  }
+}
+
+static void outlineRectangle(Rectangle rectangle, Color colour) {
+  float x = rectangle.x, y = rectangle.y, w = rectangle.width, h = rectangle.height;
+  fillRectangle((Rectangle) { x, y, w, 1.0f }, colour);
+  fillRectangle((Rectangle) { x, y + h - 1.0f, w, 1.0f }, colour);
+  fillRectangle((Rectangle) { x, y + 1.0f, 1.0f, h - 2.0f }, colour);
+  fillRectangle((Rectangle) { x + w - 1.0f, y + 1.0f, 1.0f, h - 2.0f }, colour);
+}
+
+// Bresenham
+static void drawLine(Vector2 start, Vector2 end, Color colour) {
+  int x0 = toPixel(start.x), y0 = toPixel(start.y);
+  int x1 = toPixel(end.x), y1 = toPixel(end.y);
+  int dx = abs(x1 - x0), dy = -abs(y1 - y0);
+  int sx = x0 < x1 ? 1 : -1, sy = y0 < y1 ? 1 : -1;
+  int error = dx + dy;
+
+  while (true) {
+    blendPixel(x0, y0, colour);
+    if (x0 == x1 && y0 == y1) break;
+    int error2 = 2 * error;
+    if (error2 >= dy) error += dy, x0 += sx;
+    if (error2 <= dx) error += dx, y0 += sy;
+  }
+}
+
+static void drawSprite(const engine_Texture* texture, const engine_Sprite* sprite, Color colour) {
+  render_SpriteInfo info;
+  if (!render_getSpriteInfo(sprite, &info)) return;
+  const Image* image = getImage(render_getTextureFile(texture));
+  if (image == nullptr) return;
+
+  blit(
+      image,
+      toPixel(info.source.x),
+      toPixel(info.source.y),
+      toPixel(info.source.width),
+      toPixel(info.source.height),
+      toPixel(info.pos.x + info.offset.x),
+      toPixel(info.pos.y + info.offset.y),
+      colour
+  );
+}
+
+static void drawBackground(const engine_Texture* texture) {
+  const Image* image = getImage(render_getTextureFile(texture));
+  if (image != nullptr) blit(image, 0, 0, image->width, image->height, 0, 0, WHITE);
+}
+
+static void drawGlyph(const engine_Font* font, Rectangle source, Vector2 pos, Color colour) {
+  render_FontInfo info;
+  if (!render_getFontInfo(font, &info)) return;
+  const Image* image = getImage(info.file);
+  if (image == nullptr) return;
+
+  blit(
+      image,
+      toPixel(source.x),
+      toPixel(source.y),
+      toPixel(source.width),
+      toPixel(source.height),
+      toPixel(pos.x),
+      toPixel(pos.y),
+      colour
+  );
+}
+
+static void softBeginFrame(void) {
+  assert(g_state.pixels != nullptr);
+  for (int i = 0; i < g_state.width * g_state.height; i++) g_state.pixels[i] = BLACK;
+}
+
+// Debug overlays are drawn in window pixels with raylib's default font, leave them to the engine backend
+static void softExecute(const render_Command* command) {
+  assert(command != nullptr);
+
+  switch (command->type) {
+    case RENDER_BACKGROUND       : drawBackground(command->background); break;
+    case RENDER_SPRITE           : drawSprite(command->sprite.texture, command->sprite.sprite, command->colour); break;
+    case RENDER_RECTANGLE        : fillRectangle(command->rectangle, command->colour); break;
+    case RENDER_RECTANGLE_OUTLINE: outlineRectangle(command->rectangle, command->colour); break;
+    case RENDER_LINE:
+    case RENDER_ARROW            : drawLine(command->line.start, command->line.end, command->colour); break;
+    case RENDER_GLYPH:
+      drawGlyph(command->glyph.font, command->glyph.source, command->glyph.pos, command->colour);
+      break;
+    case RENDER_DEBUG_TEXT:
+    case RENDER_DEBUG_FLOAT:
+    case RENDER_DEBUG_INT:
+    case RENDER_SCREEN_TEXT: break;
+    default                : assert(false); break;
+  }
+}
+
+static const render_Backend SOFT_BACKEND = { .beginFrame = softBeginFrame, .execute = softExecute, .endFrame = nullptr };
+
+// --- Software renderer functions ---
+
+// Rasterises the command list into an RGBA buffer on the CPU, for capturing frames without a GPU
+bool render_softInit(int width, int height) {
+  assert(g_state.pixels == nullptr);
+  assert(width > 0 && height > 0);
+
+  g_state.pixels = calloc((size_t) width * height, sizeof(g_state.pixels[0]));
+  if (g_state.pixels == nullptr) {
+    LOG_ERROR(game_log, "Failed to allocate software framebuffer");
+    return false;
+  }
+  g_state.width  = width;
+  g_state.height = height;
+  return true;
+}
+
+void render_softShutdown(void) {
+  for (int i = 0; i < g_state.imageCount; i++) {
+    if (!pack_contains(g_state.images[i].image.data)) UnloadImage(g_state.images[i].image);
+  }
+  free(g_state.pixels);
+  g_state = (typeof(g_state)) {};
+}
+
+const render_Backend* render_getSoftBackend(void) { return &SOFT_BACKEND; }
+
+const Color* render_getSoftPixels(void) { return g_state.pixels; }
@@ -0,0 +1,471 @@
+#include <assert.h>
+#include <engine/engine.h>
+#include <log/log.h>
+#include <raylib.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../internal.h"
+#include "../metrics/metrics.h"
+#include "../pack/pack.h"
+#include "internal.h"
+#include "render.h"
+
+// --- Constants ---
+
+constexpr int    MAX_TEXTURES = 16;
+constexpr int    MAX_FONTS    = 4;
+constexpr int    MIN_SLOTS    = 256;
+constexpr size_t FILE_LENGTH  = 256;
+
+// --- Types ---
+
+typedef struct render_Texture {
+  const engine_Texture* texture;
+  char                  file[FILE_LENGTH];
+} render_Texture;
+
+typedef struct render_Font {
+  const engine_Font* font;
+  char               file[FILE_LENGTH];
+  render_FontInfo    info;
+} render_Font;
+
+typedef struct render_Anim render_Anim;
+
+// Records are allocated one at a time so they stay put as the tables grow, letting sprites and anims point at each
+// other
+typedef struct render_Sprite {
+  render_SpriteInfo  info;
+  Vector2            size;
+  const render_Anim* anim;       // The last one played, it sets the source
+  int                animCount;  // Anims still pointing here
+} render_Sprite;
+
+struct render_Anim {
+  render_Sprite* sprite;
+  int            row;
+  int            startCol;
+  int            frameCount;
+  double         frameTime;
+  Vector2        inset;
+  bool           loop;
+  double         time;
+};
+
+// Open addressing on the engine's pointer, allocated on the first insert and doubled whenever it's half full
+typedef struct render_Table {
+  const void** keys;
+  void**       values;
+  int          slotCount;
+  int          usedCount;  // Including tombstones
+} render_Table;
+
+// --- Global state ---
+
+static struct {
+  bool           isTracking;
+  render_Texture textures[MAX_TEXTURES];
+  render_Font    fonts[MAX_FONTS];
+  render_Table   sprites;
+  render_Table   anims;
+} g_state;
+
+static const char TOMBSTONE;
+
+// --- Helper functions ---
+
+// Returns the slot holding key, or else the slot to insert it at
+static int findSlot(const render_Table* table, const void* key) {
+  assert(key != nullptr);
+  assert(table->slotCount > 0);
+
+  size_t hash = ((uintptr_t) key >> 4) * 0x9E3779B97F4A7C15ull;
+  int    free = -1;
+  for (int i = 0;; i++) {
+    int slot = (hash + i) & (table->slotCount - 1);
+    if (table->keys[slot] == key) return slot;
+    if (table->keys[slot] == &TOMBSTONE && free == -1) free = slot;
+    if (table->keys[slot] == nullptr) return free != -1 ? free : slot;
+  }
+}
+
+static void* findValue(const render_Table* table, const void* key) {
+  if (table->slotCount == 0) return nullptr;
+  int slot = findSlot(table, key);
+  return table->keys[slot] == key ? table->values[slot] : nullptr;
+}
+
+// Rehashing drops the tombstones, so a table that churns without growing is rebuilt at the same size
+static bool growTable(render_Table* table) {
+  int liveCount = 0;
+  for (int i = 0; i < table->slotCount; i++) {
+    if (table->keys[i] != nullptr && table->keys[i] != &TOMBSTONE) liveCount++;
+  }
+  int slotCount = MIN_SLOTS;
+  while (slotCount < 4 * liveCount) slotCount *= 2;
+
+  render_Table grown = { .keys = calloc(slotCount, sizeof(void*)), .values = malloc(slotCount * sizeof(void*)) };
+  if (grown.keys == nullptr || grown.values == nullptr) {
+    free(grown.keys);
+    free(grown.values);
+    return false;
+  }
+  grown.slotCount = slotCount;
+  for (int i = 0; i < table->slotCount; i++) {
+    if (table->keys[i] == nullptr || table->keys[i] == &TOMBSTONE) continue;
+    int slot           = findSlot(&grown, table->keys[i]);
+    grown.keys[slot]   = table->keys[i];
+    grown.values[slot] = table->values[i];
+    grown.usedCount++;
+  }
+  free(table->keys);
+  free(table->values);
+  *table = grown;
+  return true;
+}
+
+static bool insertValue(render_Table* table, const void* key, void* value) {
+  if (2 * (table->usedCount + 1) > table->slotCount && !growTable(table)) return false;
+
+  int slot = findSlot(table, key);
+  if (table->keys[slot] == nullptr) table->usedCount++;
+  table->keys[slot]   = key;
+  table->values[slot] = value;
+  return true;
+}
+
+static void* removeValue(render_Table* table, const void* key) {
+  if (table->slotCount == 0) return nullptr;
+  int slot = findSlot(table, key);
+  if (table->keys[slot] != key) return nullptr;
+  table->keys[slot] = &TOMBSTONE;
+  return table->values[slot];
+}
+
+static void freeTable(render_Table* table) {
+  for (int i = 0; i < table->slotCount; i++) {
+    if (table->keys[i] != nullptr && table->keys[i] != &TOMBSTONE) free(table->values[i]);
+  }
+  free(table->keys);
+  free(table->values);
+  *table = (render_Table) {};
+}
+
+static void trackSprite(const engine_Sprite* sprite, render_Sprite data) {
+  render_Sprite* record = malloc(sizeof(render_Sprite));
+  if (record == nullptr || !insertValue(&g_state.sprites, sprite, record)) {
+    LOG_ERROR(game_log, "Failed to allocate tracking for a sprite");
+    free(record);
+    return;
+  }
+  *record = data;
+}
+
+// Sheets are a grid of cells, each the sprite size plus an inset border on every side
+static Rectangle getCell(Vector2 size, int row, int col, Vector2 inset) {
+  return (Rectangle) {
+    col * (size.x + 2.0f * inset.x) + inset.x, row * (size.y + 2.0f * inset.y) + inset.y, size.x, size.y
+  };
+}
+
+// Worked out when a backend asks rather than every update, most frames are never drawn by another backend
+static Rectangle getAnimFrame(const render_Anim* anim) {
+  int frame = (int) (anim->time / anim->frameTime);
+  frame     = anim->loop ? frame % anim->frameCount : MIN(frame, anim->frameCount - 1);
+  return getCell(anim->sprite->size, anim->row, anim->startCol + frame, anim->inset);
+}
+
+static void playAnim(render_Anim* anim) {
+  if (anim->sprite != nullptr) anim->sprite->anim = anim;
+}
+
+// The font's entry, or the first free one when given nullptr
+static render_Font* findFont(const engine_Font* font) {
+  for (int i = 0; i < MAX_FONTS; i++) {
+    if (g_state.fonts[i].font == font) return &g_state.fonts[i];
+  }
+  return nullptr;
+}
+
+// --- Resource functions ---
+
+engine_Texture* render_textureLoad(const char* file) {
+  assert(file != nullptr);
+
+  engine_Texture* texture = engine_textureLoad(file);
+  if (texture == nullptr) return nullptr;
+  metrics_add(METRICS_TEXTURES, 1);
+  if (!g_state.isTracking) return texture;
+
+  for (int i = 0; i < MAX_TEXTURES; i++) {
+    if (g_state.textures[i].texture == nullptr) {
+      g_state.textures[i].texture = texture;
+      strncpy(g_state.textures[i].file, file, FILE_LENGTH - 1);
+      return texture;
+    }
+  }
+  LOG_ERROR(game_log, "Too many textures to track");
+  return texture;
+}
+
+void render_textureUnload(engine_Texture** texture) {
+  assert(texture != nullptr);
+
+  for (int i = 0; i < MAX_TEXTURES; i++) {
+    if (g_state.textures[i].texture == *texture) g_state.textures[i] = (render_Texture) {};
+  }
+  if (*texture != nullptr) metrics_add(METRICS_TEXTURES, -1);
+  engine_textureUnload(texture);
+}
+
+engine_Font* render_fontLoad(
+    const char* file, int glyphWidth, int glyphHeight, int firstChar, int lastChar, int xSpacing, int ySpacing
+) {
+  assert(file != nullptr);
+
+  engine_Font* font = engine_fontLoad(file, glyphWidth, glyphHeight, firstChar, lastChar, xSpacing, ySpacing);
+  if (font == nullptr) return nullptr;
+  metrics_add(METRICS_FONTS, 1);
+
+  render_Font* entry = findFont(nullptr);
+  Image        image = {};
+  if (entry != nullptr && !pack_findImage(file, &image)) image = LoadImage(file);
+  if (image.data == nullptr) {
+    LOG_ERROR(game_log, entry != nullptr ? "Failed to load font sheet %s" : "Too many fonts to lay out %s", file);
+    render_fontUnload(&font);
+    return nullptr;
+  }
+
+  entry->font = font;
+  strncpy(entry->file, file, FILE_LENGTH - 1);
+  entry->info = (render_FontInfo) {
+    .file        = entry->file,
+    .glyphWidth  = glyphWidth,
+    .glyphHeight = glyphHeight,
+    .firstChar   = firstChar,
+    .lastChar    = lastChar,
+    .xSpacing    = xSpacing,
+    .ySpacing    = ySpacing,
+    .columns     = image.width / glyphWidth,
+    .texture     = IsWindowReady() ? LoadTextureFromImage(image) : (Texture2D) {}
+  };
+  if (!pack_contains(image.data)) UnloadImage(image);
+  return font;
+}
+
+void render_fontUnload(engine_Font** font) {
+  assert(font != nullptr);
+
+  render_Font* entry = *font != nullptr ? findFont(*font) : nullptr;
+  if (entry != nullptr) {
+    if (entry->info.texture.id != 0) UnloadTexture(entry->info.texture);
+    *entry = (render_Font) {};
+  }
+  if (*font != nullptr) metrics_add(METRICS_FONTS, -1);
+  engine_fontUnload(font);
+}
+
+engine_Sprite* render_createSprite(Vector2 pos, Vector2 size, Vector2 offset) {
+  engine_Sprite* sprite = engine_createSprite(pos, size, offset);
+  if (sprite == nullptr) return nullptr;
+  metrics_add(METRICS_SPRITES, 1);
+  if (!g_state.isTracking) return sprite;
+
+  trackSprite(
+      sprite,
+      (render_Sprite) {
+        .info = { .source = { 0.0f, 0.0f, size.x, size.y }, .pos = pos, .offset = offset },
+        .size = size
+  }
+  );
+  return sprite;
+}
+
+engine_Sprite* render_createSpriteFromSheet(Vector2 pos, Vector2 size, int row, int col, Vector2 inset) {
+  engine_Sprite* sprite = engine_createSpriteFromSheet(pos, size, row, col, inset);
+  if (sprite == nullptr) return nullptr;
+  metrics_add(METRICS_SPRITES, 1);
+  if (!g_state.isTracking) return sprite;
+
+  trackSprite(sprite, (render_Sprite) { .info = { .source = getCell(size, row, col, inset), .pos = pos }, .size = size });
+  return sprite;
+}
+
+void render_destroySprite(engine_Sprite** sprite) {
+  assert(sprite != nullptr && *sprite != nullptr);
+
+  render_Sprite* data = removeValue(&g_state.sprites, *sprite);
+  // Anims ought to go first, any left behind are cut loose
+  for (int i = 0; data != nullptr && data->animCount > 0 && i < g_state.anims.slotCount; i++) {
+    const void* key = g_state.anims.keys[i];
+    if (key == nullptr || key == &TOMBSTONE) continue;
+    render_Anim* anim = g_state.anims.values[i];
+    if (anim->sprite == data) {
+      anim->sprite = nullptr;
+      data->animCount--;
+    }
+  }
+  free(data);
+  metrics_add(METRICS_SPRITES, -1);
+  engine_destroySprite(sprite);
+}
+
+void render_spriteSetPos(engine_Sprite* sprite, Vector2 pos) {
+  if (g_state.isTracking) {
+    render_Sprite* data = findValue(&g_state.sprites, sprite);
+    if (data != nullptr) data->info.pos = pos;
+  }
+  engine_spriteSetPos(sprite, pos);
+}
+
+engine_Anim* render_createAnim(
+    engine_Sprite* sprite, int row, int startCol, int frameCount, double frameTime, Vector2 inset, bool loop
+) {
+  engine_Anim* anim = engine_createAnim(sprite, row, startCol, frameCount, frameTime, inset, loop);
+  if (anim == nullptr) return nullptr;
+  metrics_add(METRICS_ANIMS, 1);
+  if (!g_state.isTracking) return anim;
+
+  render_Sprite* spriteData = findValue(&g_state.sprites, sprite);
+  render_Anim*   data       = malloc(sizeof(render_Anim));
+  if (spriteData == nullptr || data == nullptr || !insertValue(&g_state.anims, anim, data)) {
+    LOG_ERROR(game_log, "Failed to track an animation");
+    free(data);
+    return anim;
+  }
+  *data = (render_Anim) {
+    .sprite     = spriteData,
+    .row        = row,
+    .startCol   = startCol,
+    .frameCount = frameCount,
+    .frameTime  = frameTime,
+    .inset      = inset,
+    .loop       = loop
+  };
+  spriteData->animCount++;
+  playAnim(data);
+  return anim;
+}
+
+void render_destroyAnim(engine_Anim** anim) {
+  assert(anim != nullptr && *anim != nullptr);
+
+  render_Anim* data = removeValue(&g_state.anims, *anim);
+  if (data != nullptr && data->sprite != nullptr) {
+    data->sprite->animCount--;
+    if (data->sprite->anim == data) data->sprite->anim = nullptr;
+  }
+  free(data);
+  metrics_add(METRICS_ANIMS, -1);
+  engine_destroyAnim(anim);
+}
+
+void render_resetAnim(engine_Anim* anim) {
+  render_Anim* data = g_state.isTracking ? findValue(&g_state.anims, anim) : nullptr;
+  if (data != nullptr) {
+    data->time = 0.0;
+    playAnim(data);
+  }
+  engine_resetAnim(anim);
+}
+
+void render_updateAnim(engine_Anim* anim, double frameTime) {
+  render_Anim* data = g_state.isTracking ? findValue(&g_state.anims, anim) : nullptr;
+  if (data != nullptr) {
+    data->time += frameTime;
+    playAnim(data);
+  }
+  engine_updateAnim(anim, frameTime);
+}
+
+// Call once everything is unloaded, anything the engine still holds was never destroyed
+void render_checkLeaks(void) {
+  static const struct {
+    metrics_Metric metric;
+    const char*    kind;
+  } KINDS[] = {
+    {  METRICS_SPRITES,  "sprites" },
+    {    METRICS_ANIMS,    "anims" },
+    { METRICS_TEXTURES, "textures" },
+    {    METRICS_FONTS,    "fonts" }
+  };
+
+  for (size_t i = 0; i < COUNT(KINDS); i++) {
+    long long count = metrics_get(KINDS[i].metric);
+    if (count != 0) LOG_WARN(game_log, "Leaked %lld engine %s", count, KINDS[i].kind);
+  }
+}
+
+// --- Tracking functions ---
+
+// Only another backend needs it, so it's off unless turned on before anything loads. Turning it off again frees it all
+// but the fonts, which every backend draws text from.
+void render_setTracking(bool isTracking) {
+  if (!isTracking) {
+    freeTable(&g_state.anims);
+    freeTable(&g_state.sprites);
+    memset(g_state.textures, 0, sizeof(g_state.textures));
+  }
+  g_state.isTracking = isTracking;
+}
+
+const char* render_getTextureFile(const engine_Texture* texture) {
+  for (int i = 0; i < MAX_TEXTURES; i++) {
+    if (g_state.textures[i].texture == texture) return g_state.textures[i].file;
+  }
+  return nullptr;
+}
+
+bool render_getSpriteInfo(const engine_Sprite* sprite, render_SpriteInfo* info) {
+  assert(info != nullptr);
+
+  const render_Sprite* data = findValue(&g_state.sprites, sprite);
+  if (data == nullptr) return false;
+  *info = data->info;
+  if (data->anim != nullptr) info->source = getAnimFrame(data->anim);
+  return true;
+}
+
+// Kept whether or not tracking is on, the engine backend draws text from it too
+bool render_getFontInfo(const engine_Font* font, render_FontInfo* info) {
+  assert(info != nullptr);
+
+  const render_Font* entry = font != nullptr ? findFont(font) : nullptr;
+  if (entry == nullptr) return false;
+  *info = entry->info;
+  return true;
+}
+
+// Fonts are a grid of fixed size glyphs in character order, a character the font doesn't have leaves a gap. Returns
+// how many glyphs were laid out.
+int render_layoutText(const engine_Font* font, const char* string, render_Glyph* glyphs, int maxGlyphs) {
+  assert(string != nullptr);
+  assert(glyphs != nullptr);
+
+  render_FontInfo info;
+  if (!render_getFontInfo(font, &info)) return 0;
+
+  int count = 0;
+  int x     = 0;
+  int y     = 0;
+  for (const unsigned char* c = (const unsigned char*) string; *c && count < maxGlyphs; c++) {
+    if (*c == '\n') {
+      x  = 0;
+      y += info.glyphHeight + info.ySpacing;
+      continue;
+    }
+    if (*c >= info.firstChar && *c <= info.lastChar) {
+      int glyph       = *c - info.firstChar;
+      glyphs[count++] = (render_Glyph) {
+        .source = {
+          glyph % info.columns * info.glyphWidth, glyph / info.columns * info.glyphHeight, info.glyphWidth,
+          info.glyphHeight
+        },
+        .offset = { x, y }
+      };
+    }
+    x += info.glyphWidth + info.xSpacing;
+  }
+  return count;
+}
@@ -0,0 +1,229 @@
+#include "replay.h"
+#include <assert.h>
+#include <log/log.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../input/input.h"
+#include "../internal.h"
+#include "../save/save.h"
+
+// --- Constants ---
+
+constexpr uint32_t MAX_SNAPSHOTS = 1024;  // Far more than a crash dump holds, anything larger is corrupt
+constexpr uint32_t MAX_SAVE      = 4 * 1024 * 1024;
+
+// --- Global state ---
+
+static struct {
+  FILE*             recording;
+  replay_Frame*     frames;
+  int               frameCount;
+  int               frameIndex;
+  unsigned          seed;
+  double            delta;
+  bool              hasCheckpoint;
+  replay_Checkpoint checkpoint;
+  replay_Snapshot*  snapshots;
+  int               snapshotCount;
+  void*             save;
+  uint32_t          saveSize;
+} g_replay;
+
+// --- Helper functions ---
+
+// A crash dump's frames are counted, a recording's run to the end of the file
+static int countFrames(FILE* stream, const replay_Header* header) {
+  if ((header->flags & REPLAY_CHECKPOINT) != 0) return (int) header->frameCount;
+
+  long start = ftell(stream);
+  fseek(stream, 0, SEEK_END);
+  long size = ftell(stream) - start;
+  fseek(stream, start, SEEK_SET);
+  return (int) (size / (long) sizeof(replay_Frame));
+}
+
+// Only crash dumps have them, they're checked against the world as the dump is played back
+static bool readSnapshots(FILE* stream) {
+  uint32_t count = 0;
+  if (fread(&count, sizeof(count), 1, stream) != 1 || count == 0) return true;
+  if (count > MAX_SNAPSHOTS) {
+    LOG_ERROR(game_log, "Replay has %u snapshots, it's corrupt", count);
+    return false;
+  }
+
+  g_replay.snapshots = malloc(count * sizeof(replay_Snapshot));
+  if (g_replay.snapshots == nullptr) {
+    LOG_ERROR(game_log, "Failed to allocate %u replay snapshots", count);
+    return false;
+  }
+  g_replay.snapshotCount = fread(g_replay.snapshots, sizeof(replay_Snapshot), count, stream);
+  return true;
+}
+
+// Progress, bests and options all change what's on screen, so playback uses the recording's rather than its own
+static bool writeSave(FILE* stream) {
+  size_t size  = 0;
+  void*  image = save_copyImage(&size);
+  if (image == nullptr) return false;
+
+  uint32_t saveSize = size;
+  bool     isOk     = fwrite(&saveSize, sizeof(saveSize), 1, stream) == 1 && fwrite(image, size, 1, stream) == 1;
+  free(image);
+  return isOk;
+}
+
+static bool readSave(FILE* stream) {
+  uint32_t size = 0;
+  if (fread(&size, sizeof(size), 1, stream) != 1 || size == 0 || size > MAX_SAVE) return false;
+
+  g_replay.save = malloc(size);
+  if (g_replay.save == nullptr) return false;
+  g_replay.saveSize = size;
+  return fread(g_replay.save, size, 1, stream) == 1;
+}
+
+// --- Replay functions ---
+
+// The seed is applied by the caller, everything else that varies between runs comes in through the input module or
+// the copy of the save store
+bool replay_record(const char* file, unsigned seed) {
+  assert(file != nullptr);
+  assert(g_replay.recording == nullptr && g_replay.frames == nullptr);
+
+  g_replay.recording = fopen(file, "wb");
+  if (g_replay.recording == nullptr) {
+    LOG_ERROR(game_log, "Failed to open replay %s for writing", file);
+    return false;
+  }
+
+  replay_Header header = { .version = REPLAY_VERSION, .seed = seed, .flags = REPLAY_SAVE };
+  memcpy(header.magic, REPLAY_MAGIC, sizeof(header.magic));
+  if (fwrite(&header, sizeof(header), 1, g_replay.recording) != 1 || !writeSave(g_replay.recording)) {
+    LOG_ERROR(game_log, "Failed to write replay header");
+    replay_close();
+    return false;
+  }
+  g_replay.seed = seed;
+  LOG_INFO(game_log, "Recording replay to %s", file);
+  return true;
+}
+
+// Call after game_input(), before the update consumes the latched input
+void replay_recordFrame(double delta) {
+  if (g_replay.recording == nullptr) return;
+
+  replay_Frame frame = { .delta = delta, .input = input_getFrame() };
+  if (fwrite(&frame, sizeof(frame), 1, g_replay.recording) != 1) {
+    LOG_ERROR(game_log, "Failed to write replay frame, recording stopped");
+    replay_close();
+  }
+}
+
+// So the file can be read back while still recording
+void replay_flush(void) {
+  if (g_replay.recording != nullptr) fflush(g_replay.recording);
+}
+
+bool replay_play(const char* file) {
+  assert(file != nullptr);
+  assert(g_replay.recording == nullptr && g_replay.frames == nullptr);
+
+  FILE* stream = fopen(file, "rb");
+  if (stream == nullptr) {
+    LOG_ERROR(game_log, "Failed to open replay %s", file);
+    return false;
+  }
+
+  replay_Header header;
+  if (fread(&header, sizeof(header), 1, stream) != 1 || memcmp(header.magic, REPLAY_MAGIC, sizeof(header.magic)) != 0 ||
+      header.version != REPLAY_VERSION) {
+    LOG_ERROR(game_log, "Not a version %d replay: %s", REPLAY_VERSION, file);
+    fclose(stream);
+    return false;
+  }
+  if ((header.flags & REPLAY_INCOMPLETE) != 0) {
+    LOG_ERROR(game_log, "Crash dump %s lost the start of its level, only its snapshots are left", file);
+    fclose(stream);
+    return false;
+  }
+  if ((header.flags & REPLAY_CHECKPOINT) != 0) {
+    if (fread(&g_replay.checkpoint, sizeof(g_replay.checkpoint), 1, stream) != 1) {
+      LOG_ERROR(game_log, "Failed to read the checkpoint in %s", file);
+      fclose(stream);
+      return false;
+    }
+    g_replay.hasCheckpoint = true;
+  }
+  if ((header.flags & REPLAY_SAVE) != 0 && !readSave(stream)) {
+    LOG_ERROR(game_log, "Failed to read the save store in %s", file);
+    fclose(stream);
+    replay_close();
+    return false;
+  }
+  int frameCount = countFrames(stream, &header);
+
+  g_replay.frames = malloc((size_t) (frameCount > 0 ? frameCount : 1) * sizeof(replay_Frame));
+  if (g_replay.frames == nullptr) {
+    LOG_ERROR(game_log, "Failed to allocate %d replay frames", frameCount);
+    fclose(stream);
+    replay_close();
+    return false;
+  }
+  g_replay.frameCount = fread(g_replay.frames, sizeof(replay_Frame), frameCount, stream);
+  g_replay.frameIndex = 0;
+  g_replay.seed       = header.seed;
+  bool isRead         = !g_replay.hasCheckpoint || readSnapshots(stream);
+  fclose(stream);
+  if (!isRead) {
+    replay_close();
+    return false;
+  }
+
+  LOG_INFO(game_log, "Playing replay %s, %d frames", file, g_replay.frameCount);
+  if (g_replay.hasCheckpoint) LOG_INFO(game_log, "Starting from level %d", g_replay.checkpoint.level + 1);
+  return true;
+}
+
+bool replay_isPlaying(void) { return g_replay.frames != nullptr && g_replay.frameIndex < g_replay.frameCount; }
+
+// Latches the next recorded frame in place of live input, returns true if anything was pressed, held or moved
+bool replay_applyFrame(void) {
+  assert(replay_isPlaying());
+
+  const replay_Frame* frame = &g_replay.frames[g_replay.frameIndex++];
+  g_replay.delta            = frame->delta;
+  if (g_replay.frameIndex == g_replay.frameCount) LOG_INFO(game_log, "Replay finished");
+  return input_setFrame(&frame->input);
+}
+
+double replay_getDelta(void) { return g_replay.delta; }
+
+unsigned replay_getSeed(void) { return g_replay.seed; }
+
+int replay_getFrameCount(void) { return g_replay.frameCount; }
+
+// Where the replay starts instead of boot, if anywhere
+const replay_Checkpoint* replay_getCheckpoint(void) { return g_replay.hasCheckpoint ? &g_replay.checkpoint : nullptr; }
+
+const replay_Snapshot* replay_getSnapshots(int* count) {
+  assert(count != nullptr);
+  *count = g_replay.snapshotCount;
+  return g_replay.snapshots;
+}
+
+// The save store the replay was recorded with, if it has one
+const void* replay_getSave(size_t* size) {
+  assert(size != nullptr);
+  *size = g_replay.saveSize;
+  return g_replay.save;
+}
+
+void replay_close(void) {
+  if (g_replay.recording != nullptr) fclose(g_replay.recording);
+  free(g_replay.frames);
+  free(g_replay.snapshots);
+  free(g_replay.save);
+  g_replay = (typeof(g_replay)) {};
+}
@@ -0,0 +1,77 @@
+// clang-format Language: C
+#pragma once
+
+#include <stdint.h>
+#include "../input/input.h"
+#include "../internal.h"
+#include "../player/player.h"
+
+// --- Constants ---
+
+static const char REPLAY_MAGIC[4] = { 'M', 'D', 'R', 'P' };
+constexpr int     REPLAY_VERSION  = 4;
+
+// --- Types ---
+
+typedef enum replay_Flags {
+  REPLAY_CHECKPOINT = 1 << 0,  // A replay_Checkpoint follows the header, play starts there rather than at boot
+  REPLAY_INCOMPLETE = 1 << 1,  // A crash dump whose start was overwritten, it only holds snapshots
+  REPLAY_SAVE       = 1 << 2   // The save store it was recorded with follows, its size then a copy of the file
+} replay_Flags;
+
+// Written as is, so replays only play back on machines with the same endianness
+typedef struct replay_Header {
+  char     magic[4];
+  uint32_t version;
+  uint32_t seed;
+  uint32_t frameCount;  // Only counted from a checkpoint, a recording's frames run to the end of the file
+  uint32_t flags;
+} replay_Header;
+
+typedef struct replay_Frame {
+  double      delta;
+  input_Frame input;
+} replay_Frame;
+
+// Levels start from a fresh seed, so this is all it takes to play one from its start
+typedef struct replay_Checkpoint {
+  uint32_t     seed;
+  int32_t      difficulty;
+  int32_t      level;
+  int32_t      startLevel;
+  double       gameTime;
+  double       accumulator;  // Arcade's fixed step, what the frames before left towards the next one
+  player_Carry player;
+} replay_Checkpoint;
+
+// The world as the flight recorder saw it, a crash dump's follow its frames after their count
+typedef struct replay_Snapshot {
+  uint32_t sequence;  // Since the checkpoint
+  int32_t  state;
+  double   gameTime;
+  int32_t  lives;
+  int32_t  score;
+  int32_t  coinsCollected;
+  int32_t  playerState;
+  Vector2  player;
+  Vector2  creatures[CREATURE_COUNT];
+} replay_Snapshot;
+
+static_assert(sizeof(replay_Header) == 20, "replay_Header must match the file layout");
+static_assert(sizeof(replay_Snapshot) == 40 + CREATURE_COUNT * sizeof(Vector2), "replay_Snapshot must not be padded");
+
+// --- Replay functions ---
+
+bool                     replay_record(const char* file, unsigned seed);
+void                     replay_recordFrame(double delta);
+void                     replay_flush(void);
+bool                     replay_play(const char* file);
+bool                     replay_isPlaying(void);
+bool                     replay_applyFrame(void);
+double                   replay_getDelta(void);
+unsigned                 replay_getSeed(void);
+int                      replay_getFrameCount(void);
+const replay_Checkpoint* replay_getCheckpoint(void);
+const replay_Snapshot*   replay_getSnapshots(int* count);
+const void*              replay_getSave(size_t* size);
+void                     replay_close(void);
@@ -0,0 +1,49 @@
+#include "ring.h"
+#include <assert.h>
+
+// --- Ring functions ---
+
+void ring_init(ring_Ring* ring, void* items, size_t itemSize, unsigned capacity) {
+  assert(ring != nullptr && items != nullptr);
+  assert(itemSize > 0);
+  assert(capacity > 0 && (capacity & (capacity - 1)) == 0);
+
+  ring->items    = items;
+  ring->itemSize = itemSize;
+  ring->capacity = capacity;
+  atomic_init(&ring->head, 0);
+  atomic_init(&ring->tail, 0);
+}
+
+// Producer only, the slot to fill or nullptr if the ring is full
+void* ring_claim(ring_Ring* ring) {
+  unsigned head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  unsigned tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+  if (head - tail == ring->capacity) return nullptr;
+  return ring->items + (head & (ring->capacity - 1)) * ring->itemSize;
+}
+
+// Producer only, hands the claimed slot to the consumer
+void ring_publish(ring_Ring* ring) {
+  unsigned head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+// Consumer only, the items published and not yet released
+unsigned ring_getCount(ring_Ring* ring) {
+  unsigned tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+  unsigned head = atomic_load_explicit(&ring->head, memory_order_acquire);
+  return head - tail;
+}
+
+// Consumer only, counting from the oldest item not yet released
+void* ring_get(ring_Ring* ring, unsigned index) {
+  unsigned tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+  return ring->items + ((tail + index) & (ring->capacity - 1)) * ring->itemSize;
+}
+
+// Consumer only, the oldest items go back to the producer
+void ring_release(ring_Ring* ring, unsigned count) {
+  unsigned tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+  atomic_store_explicit(&ring->tail, tail + count, memory_order_release);
+}
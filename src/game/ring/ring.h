@@ -0,0 +1,28 @@
+// clang-format Language: C
+#pragma once
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+// Single producer, single consumer queue of fixed size items, so neither side ever waits on the other. The producer
+// claims a slot, fills it and publishes it, the consumer reads what has been published and then releases it. The items
+// are the caller's, a power of two of them.
+
+// --- Types ---
+
+typedef struct ring_Ring {
+  unsigned char* items;
+  size_t         itemSize;
+  unsigned       capacity;
+  atomic_uint    head;  // Written by the producer only
+  atomic_uint    tail;  // Written by the consumer only
+} ring_Ring;
+
+// --- Ring functions ---
+
+void     ring_init(ring_Ring* ring, void* items, size_t itemSize, unsigned capacity);
+void*    ring_claim(ring_Ring* ring);
+void     ring_publish(ring_Ring* ring);
+unsigned ring_getCount(ring_Ring* ring);
+void*    ring_get(ring_Ring* ring, unsigned index);
+void     ring_release(ring_Ring* ring, unsigned count);
@@ -0,0 +1,572 @@
+#include "runs.h"
+#include <assert.h>
+#include <log/log.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../internal.h"
+
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+#define RUNS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if !defined(__EMSCRIPTEN__)
+#define RUNS_INDEX_THREAD
+#include <pthread.h>
+#include <stdatomic.h>
+#endif
+
+// --- Constants ---
+
+static const char RUNS_FILE[]       = "runs.dat";
+static const char INDEX_FILE[]      = "runs.idx";
+static const char INDEX_TEMP_FILE[] = "runs.idx.tmp";
+constexpr int     MAX_TAIL          = 4096;  // Unindexed runs a query scans before the index is rebuilt
+constexpr int     KEYS_PER_RUN      = 2 * RUNS_SORT_COUNT;  // Everyone's keys and the player's
+constexpr size_t  MIN_LOG_MAP       = 1 << 20;              // Bytes mapped for the log to grow into
+
+// --- Types ---
+
+typedef struct runs_File {
+  unsigned char* data;
+  size_t         size;
+  size_t         capacity;  // Mapped or allocated, the log grows into the rest
+  bool           isMapped;
+} runs_File;
+
+// A run's place under a key, while the index is built
+typedef struct runs_Entry {
+  runs_Key key;
+  uint32_t record;
+} runs_Entry;
+
+// A snapshot of the log and the index to merge its tail into, and the index built from them
+typedef struct runs_Build {
+  const runs_Record* records;
+  uint32_t           recordCount;
+  const runs_Key*    keys;
+  uint32_t           keyCount;
+  const uint32_t*    indexed;
+  size_t             indexedTotal;
+  uint32_t           indexedCount;
+  runs_File          index;
+} runs_Build;
+
+// --- Global state ---
+
+// The log is mapped with room to grow, and only remapped when it has doubled. Queries binary search the index and scan
+// the short tail after it, while a new index is built on its own thread.
+static struct {
+  runs_File          log;
+  runs_File          index;  // The mapped file, or the last one built
+  FILE*              stream;
+  const runs_Record* records;
+  uint32_t           recordCount;
+  const runs_Key*    keys;
+  uint32_t           keyCount;
+  const uint32_t*    indexed;             // Record numbers after the key table
+  size_t             indexedTotal;        // Of all keys
+  uint32_t           indexedCount;        // Records covered by the index, the rest are the tail
+  uint32_t           tail[2 * MAX_TAIL];  // Room for the runs added while the index is rebuilt
+  runs_Sort          tailSort;
+  runs_Build         build;
+#if defined(RUNS_INDEX_THREAD)
+  pthread_t          builder;
+  bool               isBuilding;
+  atomic_bool        isBuilt;
+#endif
+  bool               isOpen;
+} g_runs;
+
+// The log the builder's qsort comparator reads, as it can't be passed one
+static thread_local const runs_Record* t_records;
+
+// --- Helper functions ---
+
+// Maps at least reserve bytes, so the file can be appended to without remapping it
+static bool mapFile(const char* file, runs_File* map, size_t reserve) {
+#if defined(RUNS_MMAP)
+  int fd = open(file, O_RDONLY);
+  if (fd == -1) return false;
+
+  struct stat info;
+  if (fstat(fd, &info) == -1 || info.st_size == 0) {
+    close(fd);
+    return false;
+  }
+  // Shared, so runs written through the stream show up in it. Only pages the file reaches are ever read.
+  size_t capacity = MAX((size_t) info.st_size, reserve);
+  void*  data     = mmap(nullptr, capacity, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) return false;
+
+  *map = (runs_File) { data, info.st_size, capacity, true };
+#else
+  FILE* stream = fopen(file, "rb");
+  if (stream == nullptr) return false;
+
+  fseek(stream, 0, SEEK_END);
+  long size = ftell(stream);
+  fseek(stream, 0, SEEK_SET);
+  size_t         capacity = MAX((size_t) size, reserve);
+  unsigned char* data     = size > 0 ? malloc(capacity) : nullptr;
+  bool           isRead   = data != nullptr && fread(data, size, 1, stream) == 1;
+  fclose(stream);
+  if (!isRead) {
+    free(data);
+    return false;
+  }
+
+  *map = (runs_File) { data, size, capacity, false };
+#endif
+  return true;
+}
+
+static void unmapFile(runs_File* map) {
+#if defined(RUNS_MMAP)
+  if (map->isMapped) {
+    munmap(map->data, map->capacity);
+  } else {
+    free(map->data);
+  }
+#else
+  free(map->data);
+#endif
+  *map = (runs_File) {};
+}
+
+// FNV-1a of the login name, so each account on a shared machine has its own runs
+static uint32_t getPlayer(void) {
+#if defined(_WIN32)
+  const char* name = getenv("USERNAME");
+#else
+  const char* name = getenv("USER");
+#endif
+  if (name == nullptr || *name == '\0') name = "player";
+
+  uint32_t hash = 2166136261u;
+  for (; *name != '\0'; name++) hash = (hash ^ (unsigned char) *name) * 16777619u;
+  return hash == RUNS_ALL_PLAYERS ? 1 : hash;
+}
+
+static int64_t getDate(void) { return (int64_t) time(nullptr); }
+
+static runs_Key makeKey(uint32_t player, int difficulty, int level, runs_Sort sort) {
+  return (runs_Key) { .player = player, .level = level, .difficulty = difficulty, .sort = sort };
+}
+
+static int compareKeys(const runs_Key* a, const runs_Key* b) {
+  if (a->player != b->player) return a->player < b->player ? -1 : 1;
+  if (a->difficulty != b->difficulty) return a->difficulty < b->difficulty ? -1 : 1;
+  if (a->level != b->level) return a->level < b->level ? -1 : 1;
+  return (a->sort > b->sort) - (a->sort < b->sort);
+}
+
+static int compareKeyItems(const void* a, const void* b) { return compareKeys(a, b); }
+
+static int compareEntries(const void* a, const void* b) {
+  const runs_Entry* entryA = a;
+  const runs_Entry* entryB = b;
+  int               result = compareKeys(&entryA->key, &entryB->key);
+  return result != 0 ? result : runs_compareRecords(t_records, entryA->key.sort, entryA->record, entryB->record);
+}
+
+static int compareTail(const void* a, const void* b) {
+  return runs_compareRecords(g_runs.records, g_runs.tailSort, *(const uint32_t*) a, *(const uint32_t*) b);
+}
+
+static bool isMatch(const runs_Record* record, runs_Query query) {
+  return record->difficulty == query.difficulty && record->level == query.level &&
+         (query.player == RUNS_ALL_PLAYERS || record->player == query.player);
+}
+
+static bool openLog(void) {
+  g_runs.stream = fopen(RUNS_FILE, "r+b");
+  if (g_runs.stream == nullptr) {
+    runs_Header header = { .version = RUNS_VERSION, .recordSize = sizeof(runs_Record) };
+    memcpy(header.magic, RUNS_MAGIC, sizeof(header.magic));
+    g_runs.stream = fopen(RUNS_FILE, "w+b");
+    if (g_runs.stream == nullptr) return false;
+    if (fwrite(&header, sizeof(header), 1, g_runs.stream) != 1 || fflush(g_runs.stream) != 0) return false;
+  }
+  GAME_TRY(mapFile(RUNS_FILE, &g_runs.log, MIN_LOG_MAP));
+
+  const runs_Header* header = (const runs_Header*) g_runs.log.data;
+  if (g_runs.log.size < sizeof(runs_Header) || memcmp(header->magic, RUNS_MAGIC, sizeof(header->magic)) != 0 ||
+      header->version != RUNS_VERSION || header->recordSize != sizeof(runs_Record)) {
+    return false;
+  }
+
+  // A record cut short by a crash is written over by the next run
+  g_runs.records     = (const runs_Record*) (g_runs.log.data + sizeof(runs_Header));
+  g_runs.recordCount = (g_runs.log.size - sizeof(runs_Header)) / sizeof(runs_Record);
+  return true;
+}
+
+static void finishBuild(void);
+
+static bool appendRecord(const runs_Record* record) {
+  size_t offset = sizeof(runs_Header) + (size_t) g_runs.recordCount * sizeof(runs_Record);
+  size_t size   = offset + sizeof(*record);
+  if (fseek(g_runs.stream, (long) offset, SEEK_SET) != 0 || fwrite(record, sizeof(*record), 1, g_runs.stream) != 1 ||
+      fflush(g_runs.stream) != 0) {
+    return false;
+  }
+
+  // Outgrown, so doubled, once any index being built has stopped reading the old one
+  if (size > g_runs.log.capacity) {
+    finishBuild();
+#if defined(RUNS_MMAP)
+    unmapFile(&g_runs.log);
+    GAME_TRY(mapFile(RUNS_FILE, &g_runs.log, 2 * size));
+#else
+    unsigned char* data = realloc(g_runs.log.data, 2 * size);
+    if (data == nullptr) return false;
+    g_runs.log.data     = data;
+    g_runs.log.capacity = 2 * size;
+#endif
+  }
+#if !defined(RUNS_MMAP)
+  memcpy(g_runs.log.data + offset, record, sizeof(*record));
+#endif
+  g_runs.log.size = size;
+  g_runs.records  = (const runs_Record*) (g_runs.log.data + sizeof(runs_Header));
+  g_runs.recordCount++;
+  return true;
+}
+
+static void setIndex(runs_File index) {
+  const runs_IndexHeader* header = (const runs_IndexHeader*) index.data;
+  size_t                  keyEnd = sizeof(runs_IndexHeader) + (size_t) header->keyCount * sizeof(runs_Key);
+  g_runs.index                   = index;
+  g_runs.keys                    = (const runs_Key*) (index.data + sizeof(runs_IndexHeader));
+  g_runs.keyCount                = header->keyCount;
+  g_runs.indexed                 = (const uint32_t*) (index.data + keyEnd);
+  g_runs.indexedTotal            = (index.size - keyEnd) / sizeof(uint32_t);
+  g_runs.indexedCount            = header->recordCount;
+}
+
+// Checked in full, as a bad record number would read past the end of the log, and keys or runs out of order would
+// throw the binary searches off
+static bool useIndex(runs_File index) {
+  if (index.size < sizeof(runs_IndexHeader)) return false;
+
+  const runs_IndexHeader* header = (const runs_IndexHeader*) index.data;
+  if (memcmp(header->magic, RUNS_INDEX_MAGIC, sizeof(header->magic)) != 0 || header->version != RUNS_VERSION ||
+      header->recordCount > g_runs.recordCount) {
+    return false;
+  }
+  size_t keyEnd = sizeof(runs_IndexHeader) + (size_t) header->keyCount * sizeof(runs_Key);
+  if (keyEnd > index.size) return false;
+
+  const runs_Key* keys    = (const runs_Key*) (index.data + sizeof(runs_IndexHeader));
+  const uint32_t* indexed = (const uint32_t*) (index.data + keyEnd);
+  size_t          total   = (index.size - keyEnd) / sizeof(uint32_t);
+  for (uint32_t i = 0; i < header->keyCount; i++) {
+    if ((size_t) keys[i].first + keys[i].count > total) return false;
+  }
+  for (size_t i = 0; i < total; i++) {
+    if (indexed[i] >= header->recordCount) return false;
+  }
+  for (uint32_t i = 0; i < header->keyCount; i++) {
+    if (i > 0 && compareKeys(&keys[i - 1], &keys[i]) >= 0) return false;
+    for (uint32_t j = 1; j < keys[i].count; j++) {
+      const uint32_t* list = indexed + keys[i].first;
+      if (runs_compareRecords(g_runs.records, keys[i].sort, list[j - 1], list[j]) >= 0) return false;
+    }
+  }
+
+  setIndex(index);
+  return true;
+}
+
+// The index can always be rebuilt from the log, so it is replaced without syncing
+static void writeIndex(runs_File index) {
+  FILE* stream    = fopen(INDEX_TEMP_FILE, "wb");
+  bool  isWritten = stream != nullptr && fwrite(index.data, index.size, 1, stream) == 1;
+  if (stream != nullptr && fclose(stream) != 0) isWritten = false;
+#if defined(_WIN32)
+  if (isWritten) remove(INDEX_FILE);
+#endif
+  if (!isWritten || rename(INDEX_TEMP_FILE, INDEX_FILE) != 0) LOG_WARN(game_log, "Failed to write %s", INDEX_FILE);
+}
+
+// Each key's list in the old index is already in order, so only the tail is sorted and then merged in. Reads nothing
+// but the snapshot, so can run alongside play.
+static bool buildIndex(runs_Build* build) {
+  size_t      tailCount  = build->recordCount - build->indexedCount;
+  size_t      entryCount = tailCount * KEYS_PER_RUN;
+  size_t      maxKeys    = build->keyCount + entryCount;
+  size_t      total      = build->indexedTotal + entryCount;
+  runs_Entry* entries    = malloc(entryCount * sizeof(runs_Entry));
+  runs_Key*   keys       = malloc(maxKeys * sizeof(runs_Key));
+  uint32_t*   indexed    = malloc(total * sizeof(uint32_t));
+  if (entries == nullptr || keys == nullptr || indexed == nullptr) {
+    LOG_ERROR(game_log, "Failed to allocate the index for %zu runs", tailCount);
+    free(entries);
+    free(keys);
+    free(indexed);
+    return false;
+  }
+
+  size_t entry = 0;
+  for (uint32_t i = build->indexedCount; i < build->recordCount; i++) {
+    const runs_Record* record = &build->records[i];
+    for (runs_Sort sort = 0; sort < RUNS_SORT_COUNT; sort++) {
+      entries[entry++] = (runs_Entry) { makeKey(RUNS_ALL_PLAYERS, record->difficulty, record->level, sort), i };
+      entries[entry++] = (runs_Entry) { makeKey(record->player, record->difficulty, record->level, sort), i };
+    }
+  }
+  t_records = build->records;
+  qsort(entries, entryCount, sizeof(runs_Entry), compareEntries);
+
+  size_t keyCount   = 0;
+  size_t count      = 0;
+  size_t oldKey     = 0;
+  size_t firstEntry = 0;
+  while (oldKey < build->keyCount || firstEntry < entryCount) {
+    int order = oldKey == build->keyCount     ? 1
+                : firstEntry == entryCount ? -1
+                                           : compareKeys(&build->keys[oldKey], &entries[firstEntry].key);
+    runs_Key        key      = order <= 0 ? build->keys[oldKey] : entries[firstEntry].key;
+    const uint32_t* old      = order <= 0 ? build->indexed + key.first : nullptr;
+    uint32_t        oldCount = order <= 0 ? key.count : 0;
+    size_t          endEntry = firstEntry;
+    while (order >= 0 && endEntry < entryCount && compareKeys(&entries[endEntry].key, &key) == 0) endEntry++;
+
+    key.first = count;
+    for (size_t i = 0, j = firstEntry; i < oldCount || j < endEntry;) {
+      bool isOld = j == endEntry ||
+                   (i < oldCount && runs_compareRecords(build->records, key.sort, old[i], entries[j].record) < 0);
+      indexed[count++] = isOld ? old[i++] : entries[j++].record;
+    }
+    key.count        = count - key.first;
+    keys[keyCount++] = key;
+    if (order <= 0) oldKey++;
+    firstEntry = endEntry;
+  }
+  free(entries);
+
+  runs_IndexHeader header  = { .version = RUNS_VERSION, .recordCount = build->recordCount, .keyCount = keyCount };
+  size_t           keySize = keyCount * sizeof(runs_Key);
+  runs_File        index   = { .size = sizeof(header) + keySize + count * sizeof(uint32_t) };
+  index.data               = malloc(index.size);
+  index.capacity           = index.size;
+  if (index.data != nullptr) {
+    memcpy(header.magic, RUNS_INDEX_MAGIC, sizeof(header.magic));
+    memcpy(index.data, &header, sizeof(header));
+    memcpy(index.data + sizeof(header), keys, keySize);
+    memcpy(index.data + sizeof(header) + keySize, indexed, count * sizeof(uint32_t));
+  }
+  free(keys);
+  free(indexed);
+  if (index.data == nullptr) {
+    LOG_ERROR(game_log, "Failed to allocate the index for %zu runs", tailCount);
+    return false;
+  }
+
+  build->index = index;
+  return true;
+}
+
+// Queries use the one built, the file is only read at the next start
+static void useBuild(void) {
+  if (g_runs.build.index.data != nullptr) {
+    unmapFile(&g_runs.index);
+    setIndex(g_runs.build.index);
+  }
+  g_runs.build = (runs_Build) {};
+}
+
+#if defined(RUNS_INDEX_THREAD)
+static void* buildThread(void* arg) {
+  runs_Build* build = arg;
+  if (buildIndex(build)) writeIndex(build->index);
+  atomic_store(&g_runs.isBuilt, true);
+  return nullptr;
+}
+#endif
+
+// Thousands of runs to sort and merge, too many to do between frames, so they are done on their own thread
+static void startBuild(void) {
+#if defined(RUNS_INDEX_THREAD)
+  if (g_runs.isBuilding) return;
+#endif
+
+  g_runs.build = (runs_Build) {
+    .records      = g_runs.records,
+    .recordCount  = g_runs.recordCount,
+    .keys         = g_runs.keys,
+    .keyCount     = g_runs.keyCount,
+    .indexed      = g_runs.indexed,
+    .indexedTotal = g_runs.indexedTotal,
+    .indexedCount = g_runs.indexedCount
+  };
+#if defined(RUNS_INDEX_THREAD)
+  atomic_store(&g_runs.isBuilt, false);
+  g_runs.isBuilding = pthread_create(&g_runs.builder, nullptr, buildThread, &g_runs.build) == 0;
+  if (g_runs.isBuilding) return;
+#endif
+  if (buildIndex(&g_runs.build)) writeIndex(g_runs.build.index);
+  useBuild();
+}
+
+// Waits for the index being built, if there is one
+static void finishBuild(void) {
+#if defined(RUNS_INDEX_THREAD)
+  if (!g_runs.isBuilding) return;
+  pthread_join(g_runs.builder, nullptr);
+  g_runs.isBuilding = false;
+  useBuild();
+#endif
+}
+
+// Switches to a built index without waiting
+static void pollBuild(void) {
+#if defined(RUNS_INDEX_THREAD)
+  if (g_runs.isBuilding && atomic_load(&g_runs.isBuilt)) finishBuild();
+#endif
+}
+
+static const uint32_t* findKey(runs_Query query, uint32_t* count) {
+  runs_Key        key   = makeKey(query.player, query.difficulty, query.level, query.sort);
+  const runs_Key* found = nullptr;
+  if (g_runs.keyCount > 0) found = bsearch(&key, g_runs.keys, g_runs.keyCount, sizeof(runs_Key), compareKeyItems);
+
+  *count = found != nullptr ? found->count : 0;
+  return found != nullptr ? g_runs.indexed + found->first : nullptr;
+}
+
+// The tail is kept short by rebuilding the index, so this is a quick scan
+static uint32_t getTail(runs_Query query) {
+  uint32_t count = 0;
+  for (uint32_t i = g_runs.indexedCount; i < g_runs.recordCount && count < COUNT(g_runs.tail); i++) {
+    if (isMatch(&g_runs.records[i], query)) g_runs.tail[count++] = i;
+  }
+  return count;
+}
+
+// --- Runs functions ---
+
+// Not needed to play, so this never fails the load. Without a log, runs just aren't recorded.
+bool runs_open(void) {
+  assert(!g_runs.isOpen);
+
+  if (!openLog()) {
+    LOG_WARN(game_log, "Unable to open %s, runs won't be recorded", RUNS_FILE);
+    runs_close();
+    return true;
+  }
+  g_runs.isOpen = true;
+
+  // Still loading, so this one is waited for
+  runs_File index = {};
+  if (!mapFile(INDEX_FILE, &index, 0) || !useIndex(index)) unmapFile(&index);
+  if (g_runs.recordCount - g_runs.indexedCount >= MAX_TAIL) {
+    startBuild();
+    finishBuild();
+  }
+
+  LOG_INFO(game_log, "Run log %s: %u runs, %u indexed", RUNS_FILE, g_runs.recordCount, g_runs.indexedCount);
+  return true;
+}
+
+// Appended to the log straight away, the index catches up once the tail is long enough to slow queries. Returns the
+// record, logged or not, for the leaderboard.
+runs_Record runs_add(game_Difficulty difficulty, int level, double time, int score, int lives) {
+  assert(difficulty >= 0 && difficulty < DIFFICULTY_COUNT);
+  assert((level >= 0 && level < MAX_LEVELS) || level == RUNS_FULL_RUN);
+
+  runs_Record record = {
+    .date       = getDate(),
+    .time       = time,
+    .score      = score,
+    .lives      = lives,
+    .player     = getPlayer(),
+    .level      = level,
+    .difficulty = difficulty
+  };
+  if (!g_runs.isOpen) return record;
+
+  pollBuild();
+  if (!appendRecord(&record)) {
+    LOG_ERROR(game_log, "Failed to add a run to %s", RUNS_FILE);
+    runs_close();
+    return record;
+  }
+  if (g_runs.recordCount - g_runs.indexedCount >= MAX_TAIL) startBuild();
+  return record;
+}
+
+// Fills runs with up to count of the best, best first, and returns how many it found
+int runs_getTop(runs_Query query, runs_Record runs[], int count) {
+  assert(runs != nullptr);
+  assert(count >= 0);
+  if (!g_runs.isOpen) return 0;
+  pollBuild();
+
+  const runs_Record* records = g_runs.records;
+  uint32_t           indexedCount;
+  const uint32_t*    indexed   = findKey(query, &indexedCount);
+  uint32_t           tailCount = getTail(query);
+  g_runs.tailSort              = query.sort;
+  qsort(g_runs.tail, tailCount, sizeof(g_runs.tail[0]), compareTail);
+
+  int found = 0;
+  for (uint32_t i = 0, j = 0; found < count && (i < indexedCount || j < tailCount);) {
+    bool isIndexed = j == tailCount ||
+                     (i < indexedCount && runs_compareRecords(records, query.sort, indexed[i], g_runs.tail[j]) < 0);
+    runs[found++] = records[isIndexed ? indexed[i++] : g_runs.tail[j++]];
+  }
+  return found;
+}
+
+int runs_getCount(runs_Query query) {
+  if (!g_runs.isOpen) return 0;
+  pollBuild();
+
+  uint32_t count;
+  findKey(query, &count);
+  return count + getTail(query);
+}
+
+// How many runs are at least as good as the result, a binary search of the index and a scan of the tail
+int runs_getRank(runs_Query query, double time, int score) {
+  if (!g_runs.isOpen) return 0;
+  pollBuild();
+
+  uint32_t        count;
+  const uint32_t* indexed = findKey(query, &count);
+  uint32_t        low     = 0;
+  uint32_t        high    = count;
+  while (low < high) {
+    uint32_t           middle = low + (high - low) / 2;
+    const runs_Record* record = &g_runs.records[indexed[middle]];
+    if (runs_compareResults(query.sort, record->time, record->score, time, score) <= 0) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+
+  int      rank      = low;
+  uint32_t tailCount = getTail(query);
+  for (uint32_t i = 0; i < tailCount; i++) {
+    const runs_Record* record = &g_runs.records[g_runs.tail[i]];
+    if (runs_compareResults(query.sort, record->time, record->score, time, score) <= 0) rank++;
+  }
+  return rank;
+}
+
+void runs_close(void) {
+  finishBuild();
+  if (g_runs.stream != nullptr) fclose(g_runs.stream);
+  unmapFile(&g_runs.log);
+  unmapFile(&g_runs.index);
+  g_runs = (typeof(g_runs)) {};
+}
@@ -0,0 +1,24 @@
+// clang-format Language: C
+#pragma once
+
+#include <game/game.h>
+#include <runs/format.h>
+
+// --- Types ---
+
+// Level is RUNS_FULL_RUN for whole runs, player is RUNS_ALL_PLAYERS to ask about everyone
+typedef struct runs_Query {
+  game_Difficulty difficulty;
+  int             level;
+  runs_Sort       sort;
+  uint32_t        player;
+} runs_Query;
+
+// --- Runs functions ---
+
+bool        runs_open(void);
+runs_Record runs_add(game_Difficulty difficulty, int level, double time, int score, int lives);
+int         runs_getTop(runs_Query query, runs_Record runs[], int count);
+int         runs_getCount(runs_Query query);
+int         runs_getRank(runs_Query query, double time, int score);
+void        runs_close(void);
@@ -0,0 +1,446 @@
+#include "save.h"
+#include <assert.h>
+#include <limits.h>
+#include <log/log.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../internal.h"
+#include "../metrics/metrics.h"
+
+#if !defined(__EMSCRIPTEN__)
+#define SAVE_WRITE_THREAD
+#include <pthread.h>
+#endif
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+// windows.h clashes with raylib's names, so the one call needed is declared here
+constexpr unsigned long MOVEFILE_REPLACE_EXISTING = 0x1;
+constexpr unsigned long MOVEFILE_WRITE_THROUGH    = 0x8;
+__declspec(dllimport) int __stdcall MoveFileExA(const char* existing, const char* replacement, unsigned long flags);
+#endif
+
+// --- Constants ---
+
+static const char SAVE_FILE[]   = "save.dat";
+static const char TEMP_FILE[]   = "save.dat.tmp";
+static const char SAVE_MAGIC[4] = { 'M', 'D', 'S', 'V' };
+constexpr int     SAVE_VERSION  = 2;  // Version 1 had no section versions, its sections load as version 1
+constexpr size_t  MAX_SECTION   = 1024 * 1024;  // Anything bigger is a corrupt file
+
+// --- Types ---
+
+// Written as is, so saves only load on machines with the same endianness
+typedef struct save_Header {
+  char     magic[4];
+  uint32_t version;
+  uint32_t sectionCount;
+  uint32_t checksum;  // Of everything after the header
+} save_Header;
+
+typedef struct save_SectionHeader {
+  uint32_t id;
+  uint32_t size;
+  uint32_t version;  // The owning module's layout, from file version 2
+} save_SectionHeader;
+
+typedef struct save_Buffer {
+  void*    data;
+  size_t   size;
+  int      version;
+  uint32_t id;
+} save_Buffer;
+
+// A store parsed to the side, the sections this build knows and those from newer ones it doesn't
+typedef struct save_Store {
+  save_Buffer  sections[SAVE_SECTION_COUNT];
+  save_Buffer* unknown;
+  int          unknownCount;
+} save_Store;
+
+// --- Global state ---
+
+// The store lives in memory, writes update it and the file catches up behind them
+static struct {
+  save_Store store;
+#if defined(SAVE_WRITE_THREAD)
+  pthread_t       thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t  cond;
+  bool            isRunning;
+  bool            isQuitting;
+#endif
+  bool isDirty;
+  bool isDetached;  // Playing a replay from the store it was recorded with, nothing reaches the file
+  bool isNewer;     // The file is from a newer build, it's left as it is
+} g_save = {
+#if defined(SAVE_WRITE_THREAD)
+  .mutex = PTHREAD_MUTEX_INITIALIZER,
+  .cond  = PTHREAD_COND_INITIALIZER
+#endif
+};
+
+// --- Helper functions ---
+
+// FNV-1a, catches a file that was cut short or edited
+static uint32_t getChecksum(const unsigned char* data, size_t size) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < size; i++) hash = (hash ^ data[i]) * 16777619u;
+  return hash;
+}
+
+static bool copyBuffer(save_Buffer* buffer, uint32_t id, int version, const void* data, size_t size) {
+  void* copy = realloc(buffer->data, size);
+  if (copy == nullptr) return false;
+
+  memcpy(copy, data, size);
+  *buffer = (save_Buffer) { copy, size, version, id };
+  return true;
+}
+
+// Kept to be written back as they were read
+static bool addUnknown(save_Store* store, uint32_t id, int version, const void* data, size_t size) {
+  save_Buffer* unknown = realloc(store->unknown, (store->unknownCount + 1) * sizeof(save_Buffer));
+  if (unknown == nullptr) return false;
+
+  store->unknown                      = unknown;
+  store->unknown[store->unknownCount] = (save_Buffer) {};
+  if (!copyBuffer(&store->unknown[store->unknownCount], id, version, data, size)) return false;
+  store->unknownCount++;
+  return true;
+}
+
+static void freeStore(save_Store* store) {
+  for (int i = 0; i < SAVE_SECTION_COUNT; i++) free(store->sections[i].data);
+  for (int i = 0; i < store->unknownCount; i++) free(store->unknown[i].data);
+  free(store->unknown);
+  *store = (save_Store) {};
+}
+
+static bool setSection(int id, int version, const void* data, size_t size) {
+  size_t oldSize = g_save.store.sections[id].size;
+  if (!copyBuffer(&g_save.store.sections[id], id, version, data, size)) return false;
+
+  metrics_add(METRICS_MEMORY_SAVE, (long long) size - (long long) oldSize);
+  return true;
+}
+
+// Takes ownership of the store's buffers, the store is only ever replaced whole
+static void setStore(save_Store* store) {
+  freeStore(&g_save.store);
+  g_save.store   = *store;
+  long long size = 0;
+  for (int i = 0; i < SAVE_SECTION_COUNT; i++) size += store->sections[i].size;
+  for (int i = 0; i < store->unknownCount; i++) size += store->unknown[i].size;
+  metrics_set(METRICS_MEMORY_SAVE, size);
+}
+
+static void clearStore(void) {
+  freeStore(&g_save.store);
+  metrics_set(METRICS_MEMORY_SAVE, 0);
+}
+
+// The file as a whole, or a copy of it carried by a replay. Parsed to the side and only then swapped in, so a bad
+// image leaves the store as it was, as does one from a newer build.
+static save_Status readImage(const unsigned char* image, size_t size) {
+  save_Header header;
+  if (size <= sizeof(header)) return SAVE_MISSING;
+  memcpy(&header, image, sizeof(header));
+  if (memcmp(header.magic, SAVE_MAGIC, sizeof(header.magic)) != 0 || header.version < 1) return SAVE_MISSING;
+  if (header.version > SAVE_VERSION) return SAVE_NEWER;
+
+  const unsigned char* body     = image + sizeof(header);
+  size_t               bodySize = size - sizeof(header);
+  bool                 isOk     = getChecksum(body, bodySize) == header.checksum;
+
+  // Version 1 sections have no version of their own
+  size_t headerSize = header.version == 1 ? offsetof(save_SectionHeader, version) : sizeof(save_SectionHeader);
+
+  save_Store store  = {};
+  size_t     offset = 0;
+  for (uint32_t i = 0; isOk && i < header.sectionCount; i++) {
+    save_SectionHeader section = { .version = 1 };
+    isOk                       = bodySize - offset >= headerSize;
+    if (!isOk) break;
+    memcpy(&section, body + offset, headerSize);
+    offset += headerSize;
+    isOk    = section.size <= MAX_SECTION && section.size <= bodySize - offset && section.version >= 1 &&
+             section.version <= INT_MAX;
+    if (!isOk) break;
+
+    const void* data = body + offset;
+    if (section.id < SAVE_SECTION_COUNT) {
+      isOk = copyBuffer(&store.sections[section.id], section.id, section.version, data, section.size);
+    } else {
+      isOk = addUnknown(&store, section.id, section.version, data, section.size);
+    }
+    offset += section.size;
+  }
+
+  if (!isOk) {
+    freeStore(&store);
+    return SAVE_MISSING;
+  }
+  setStore(&store);
+  return SAVE_LOADED;
+}
+
+static save_Status readFile(const char* file) {
+  FILE* stream = fopen(file, "rb");
+  if (stream == nullptr) return SAVE_MISSING;
+
+  fseek(stream, 0, SEEK_END);
+  long size = ftell(stream);
+  fseek(stream, 0, SEEK_SET);
+  unsigned char* image  = size > 0 ? malloc(size) : nullptr;
+  save_Status    status = SAVE_MISSING;
+  if (image != nullptr && fread(image, size, 1, stream) == 1) status = readImage(image, size);
+  fclose(stream);
+  free(image);
+  return status;
+}
+
+static void writeSection(unsigned char* image, size_t* offset, const save_Buffer* buffer) {
+  save_SectionHeader section = { .id = buffer->id, .size = buffer->size, .version = buffer->version };
+  memcpy(image + *offset, &section, sizeof(section));
+  memcpy(image + *offset + sizeof(section), buffer->data, section.size);
+  *offset += sizeof(section) + section.size;
+}
+
+// Called with the mutex held, so the image is a consistent copy of every section. Those from newer builds follow this
+// build's, as they were read.
+static unsigned char* buildImage(size_t* size) {
+  const save_Store* store = &g_save.store;
+  *size                   = sizeof(save_Header);
+  for (int i = 0; i < SAVE_SECTION_COUNT; i++) {
+    if (store->sections[i].data != nullptr) *size += sizeof(save_SectionHeader) + store->sections[i].size;
+  }
+  for (int i = 0; i < store->unknownCount; i++) *size += sizeof(save_SectionHeader) + store->unknown[i].size;
+
+  unsigned char* image = malloc(*size);
+  if (image == nullptr) return nullptr;
+
+  save_Header header = { .version = SAVE_VERSION };
+  memcpy(header.magic, SAVE_MAGIC, sizeof(header.magic));
+  size_t offset = sizeof(header);
+  for (int i = 0; i < SAVE_SECTION_COUNT; i++) {
+    if (store->sections[i].data == nullptr) continue;
+    writeSection(image, &offset, &store->sections[i]);
+    header.sectionCount++;
+  }
+  for (int i = 0; i < store->unknownCount; i++) {
+    writeSection(image, &offset, &store->unknown[i]);
+    header.sectionCount++;
+  }
+  header.checksum = getChecksum(image + sizeof(header), *size - sizeof(header));
+  memcpy(image, &header, sizeof(header));
+  return image;
+}
+
+// Written to the side and synced before it replaces the save, so a crash part way leaves the old one whole
+static bool writeFile(const unsigned char* image, size_t size) {
+  FILE* stream = fopen(TEMP_FILE, "wb");
+  if (stream == nullptr) return false;
+
+  bool isOk = fwrite(image, size, 1, stream) == 1 && fflush(stream) == 0;
+#if defined(_WIN32)
+  isOk = isOk && _commit(_fileno(stream)) == 0;
+#else
+  isOk = isOk && fsync(fileno(stream)) == 0;
+#endif
+  if (fclose(stream) != 0 || !isOk) return false;
+
+#if defined(_WIN32)
+  // rename() won't replace a file here, this does so in one step
+  return MoveFileExA(TEMP_FILE, SAVE_FILE, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+  return rename(TEMP_FILE, SAVE_FILE) == 0;
+#endif
+}
+
+// Called with the mutex held
+static void writeStore(void) {
+  g_save.isDirty = false;
+  metrics_set(METRICS_SAVE_QUEUE, 0);
+  size_t         size  = 0;
+  unsigned char* image = buildImage(&size);
+#if defined(SAVE_WRITE_THREAD)
+  pthread_mutex_unlock(&g_save.mutex);
+#endif
+  bool isWritten = image != nullptr && writeFile(image, size);
+  free(image);
+#if defined(SAVE_WRITE_THREAD)
+  pthread_mutex_lock(&g_save.mutex);
+#endif
+  if (!isWritten) LOG_ERROR(game_log, "Failed to write %s", SAVE_FILE);
+}
+
+// Called with the mutex held
+static void queueWrite(void) {
+  if (g_save.isDetached || g_save.isNewer) return;
+
+  g_save.isDirty = true;
+  metrics_add(METRICS_SAVE_QUEUE, 1);
+#if defined(SAVE_WRITE_THREAD)
+  if (g_save.isRunning) {
+    pthread_cond_broadcast(&g_save.cond);
+    return;
+  }
+#endif
+  writeStore();
+}
+
+#if defined(SAVE_WRITE_THREAD)
+// Writes that arrive while one is in progress are coalesced into the next
+static void* writeThread([[maybe_unused]] void* arg) {
+  pthread_mutex_lock(&g_save.mutex);
+  while (true) {
+    if (g_save.isDirty) {
+      writeStore();
+      pthread_cond_broadcast(&g_save.cond);
+      continue;
+    }
+    if (g_save.isQuitting) break;
+    pthread_cond_wait(&g_save.cond, &g_save.mutex);
+  }
+  pthread_mutex_unlock(&g_save.mutex);
+  return nullptr;
+}
+#endif
+
+// --- Save functions ---
+
+// Runs before the game log exists, so a missing or unreadable save quietly leaves every section empty. Modules then
+// fall back to their old text files. A save from a newer build is never written over.
+void save_open(void) {
+  save_Status status = readFile(SAVE_FILE);
+  if (status == SAVE_MISSING) status = readFile(TEMP_FILE);
+  if (status != SAVE_LOADED) clearStore();
+  g_save.isNewer = status == SAVE_NEWER;
+
+#if defined(SAVE_WRITE_THREAD)
+  assert(!g_save.isRunning);
+  g_save.isQuitting = false;
+  g_save.isRunning  = pthread_create(&g_save.thread, nullptr, writeThread, nullptr) == 0;
+#endif
+}
+
+// One saved at an older version is handed to the migration, if there is one, and stored at the current version once
+// it succeeds. Data is left as it was unless the section is loaded, and a newer one is left for the newer build.
+save_Status save_read(save_Section section, int version, void* data, size_t size, save_Migrate migrate) {
+  assert(section >= 0 && section < SAVE_SECTION_COUNT);
+  assert(version > 0);
+  assert(data != nullptr && size > 0 && size <= MAX_SECTION);
+
+#if defined(SAVE_WRITE_THREAD)
+  pthread_mutex_lock(&g_save.mutex);
+#endif
+  const save_Buffer* buffer  = &g_save.store.sections[section];
+  bool               isRead  = false;
+  bool               isNewer = g_save.isNewer || (buffer->data != nullptr && buffer->version > version);
+  if (g_save.isNewer) {
+    LOG_WARN(game_log, "%s is from a newer build, it won't be updated", SAVE_FILE);
+  } else if (isNewer) {
+    LOG_WARN(game_log, "Save section %d is from a newer build, it won't be updated", section);
+  } else if (buffer->data != nullptr && buffer->version == version) {
+    isRead = buffer->size == size;
+    if (isRead) memcpy(data, buffer->data, size);
+  } else if (buffer->data != nullptr && buffer->version < version && migrate != nullptr) {
+    // Starts from the caller's data, so anything the old layout lacked keeps its default
+    void* migrated = malloc(size);
+    if (migrated != nullptr) {
+      memcpy(migrated, data, size);
+      isRead = migrate(buffer->version, buffer->data, buffer->size, migrated);
+    }
+    if (isRead) {
+      memcpy(data, migrated, size);
+      if (setSection(section, version, data, size)) queueWrite();
+    } else {
+      LOG_WARN(game_log, "Failed to migrate save section %d from version %d", section, buffer->version);
+    }
+    free(migrated);
+  }
+#if defined(SAVE_WRITE_THREAD)
+  pthread_mutex_unlock(&g_save.mutex);
+#endif
+  return isNewer ? SAVE_NEWER : isRead ? SAVE_LOADED : SAVE_MISSING;
+}
+
+// Copies the section and returns straight away, the file is written behind on its own thread where there is one. A
+// section from a newer build is kept as it is.
+void save_write(save_Section section, int version, const void* data, size_t size) {
+  assert(section >= 0 && section < SAVE_SECTION_COUNT);
+  assert(version > 0);
+  assert(data != nullptr && size > 0 && size <= MAX_SECTION);
+
+#if defined(SAVE_WRITE_THREAD)
+  pthread_mutex_lock(&g_save.mutex);
+#endif
+  if (g_save.store.sections[section].version <= version) {
+    if (setSection(section, version, data, size)) {
+      queueWrite();
+    } else {
+      LOG_ERROR(game_log, "Failed to allocate save section %d", section);
+    }
+  }
+#if defined(SAVE_WRITE_THREAD)
+  pthread_mutex_unlock(&g_save.mutex);
+#endif
+}
+
+// A copy of the whole store in the file's format, for a replay to carry, free it when done
+void* save_copyImage(size_t* size) {
+  assert(size != nullptr);
+
+#if defined(SAVE_WRITE_THREAD)
+  pthread_mutex_lock(&g_save.mutex);
+#endif
+  void* image = buildImage(size);
+#if defined(SAVE_WRITE_THREAD)
+  pthread_mutex_unlock(&g_save.mutex);
+#endif
+  return image;
+}
+
+// Swaps the store for a copy taken by save_copyImage(), then keeps every later write in memory so the copy never
+// replaces the player's own save
+bool save_useImage(const void* image, size_t size) {
+  assert(image != nullptr);
+
+#if defined(SAVE_WRITE_THREAD)
+  pthread_mutex_lock(&g_save.mutex);
+#endif
+  bool isRead = readImage(image, size) == SAVE_LOADED;
+  if (!isRead) clearStore();
+  g_save.isDetached = true;
+#if defined(SAVE_WRITE_THREAD)
+  pthread_mutex_unlock(&g_save.mutex);
+#endif
+  return isRead;
+}
+
+// Finishes any write still pending
+void save_close(void) {
+#if defined(SAVE_WRITE_THREAD)
+  if (g_save.isRunning) {
+    pthread_mutex_lock(&g_save.mutex);
+    g_save.isQuitting = true;
+    pthread_cond_broadcast(&g_save.cond);
+    pthread_mutex_unlock(&g_save.mutex);
+    pthread_join(g_save.thread, nullptr);
+    g_save.isRunning = false;
+  }
+#endif
+  clearStore();
+  g_save.isDirty    = false;
+  g_save.isDetached = false;
+  g_save.isNewer    = false;
+  metrics_set(METRICS_SAVE_QUEUE, 0);
+}
@@ -0,0 +1,27 @@
+// clang-format Language: C
+#pragma once
+
+#include <stddef.h>
+
+// --- Types ---
+
+// Each module owns its section and versions its layout, a section that doesn't match in size is treated as missing
+typedef enum save_Section { SAVE_OPTIONS, SAVE_PROGRESS, SAVE_SCORES, SAVE_SECTION_COUNT } save_Section;
+
+typedef enum save_Status {
+  SAVE_MISSING,  // Or a different size, or it couldn't be migrated
+  SAVE_LOADED,
+  SAVE_NEWER  // From a newer build, it's kept as it is and writes to it are dropped
+} save_Status;
+
+// Fills in the current layout from one saved at an older version, false if it can't
+typedef bool (*save_Migrate)(int version, const void* old, size_t oldSize, void* data);
+
+// --- Save functions ---
+
+void        save_open(void);
+save_Status save_read(save_Section section, int version, void* data, size_t size, save_Migrate migrate);
+void        save_write(save_Section section, int version, const void* data, size_t size);
+void*       save_copyImage(size_t* size);
+bool        save_useImage(const void* image, size_t size);
+void        save_close(void);
@@ -7,6 +7,12 @@
 #include <string.h>
 #include "../draw/draw.h"
 #include "../internal.h"
+#include "../leaderboard/leaderboard.h"
+#include "../maze/maze.h"
+#include "../replay/replay.h"
+#include "../runs/runs.h"
+#include "../save/save.h"
+#include "../soak/soak.h"
 #include "game/game.h"
 #include "log/log.h"
 
@@ -24,11 +30,18 @@ typedef struct score_Entry {
   char   type[ENTRY_LEN];
 } score_Entry;
 
+typedef struct score_Record {
+  double time;
+  int    score;
+  int    lives;
+} score_Record;
+
+// Saved as is, the level and difficulty are where the record sits
 typedef struct score_Saves {
-  score_Entry bestTimes[DIFFICULTY_COUNT][LEVEL_COUNT];
-  score_Entry bestScores[DIFFICULTY_COUNT][LEVEL_COUNT];
-  score_Entry fullRunsBestTimes[DIFFICULTY_COUNT];
-  score_Entry fullRunsBestScores[DIFFICULTY_COUNT];
+  score_Record bestTimes[DIFFICULTY_COUNT][MAX_LEVELS];
+  score_Record bestScores[DIFFICULTY_COUNT][MAX_LEVELS];
+  score_Record fullRunsBestTimes[DIFFICULTY_COUNT];
+  score_Record fullRunsBestScores[DIFFICULTY_COUNT];
 } score_Saves;
 
 typedef enum SortBy { SORTBY_TIME, SORTBY_SCORE } SortBy;
@@ -40,8 +53,9 @@ typedef struct score_State {
 
 // --- Constants ---
 
-static const char  SCORES_FILE[]                = "scores.csv";
+static const char  SCORES_FILE[]                = "scores.csv";  // Read once to migrate to the save store
 static const int   ENTRY_COUNT                  = 5;
+static const int   SCORES_VERSION               = 1;  // Of the saved layout, bump it with a migration
 static const char  TYPE_TIME[]                  = "time";
 static const char  TYPE_SCORE[]                 = "score";
 static const char  TYPE_FULL_TIME[]             = "fullTime";
@@ -52,6 +66,7 @@ static const draw_Text
 static const draw_Text FULL_RUN_TIME    = { "Full Run  %10s %6d  %5d", 138, 195, TEXT_COLOUR, FONT_NORMAL };
 static const int       LINE_HEIGHT      = 10;
 static const int       LEVEL_SCORE_YPOS = 125;
+static const int       LEVEL_SCORE_ROWS = 7;  // Room above the full run line
 
 // --- Global state ---
 
@@ -59,6 +74,13 @@ static score_State g_state      = { DIFFICULTY_EASY, SORTBY_TIME };
 static score_Saves g_saves      = {};
 static draw_Text   g_levelScore = { "Level %d   %10s %6d  %5d", 138, LEVEL_SCORE_YPOS, TEXT_COLOUR, FONT_NORMAL };
 
+// The bests the menu shows, looked up in the run log again only when the difficulty, sort or runs change
+static struct {
+  score_Record levels[MAX_LEVELS];
+  score_Record fullRun;
+  bool         isStale;
+} g_board = { .isStale = true };
+
 // --- Helper functions ---
 
 static game_Difficulty getDifficulty(const char difficulty[]) {
@@ -70,18 +92,39 @@ static game_Difficulty getDifficulty(const char difficulty[]) {
   return DIFFICULTY_NONE;
 }
 
-static void setDifficulty(game_Difficulty difficulty) { g_state.difficulty = difficulty; }
+static void setDifficulty(game_Difficulty difficulty) {
+  g_state.difficulty = difficulty;
+  g_board.isStale    = true;
+}
 
-static void setSortby(SortBy sort) { g_state.sort = sort; }
+static void setSortby(SortBy sort) {
+  g_state.sort    = sort;
+  g_board.isStale = true;
+}
 
-// --- Score functions ---
+static score_Record toRecord(score_Entry entry) { return (score_Record) { entry.time, entry.score, entry.lives }; }
 
-void scores_load(void) {
+// Against the run log, before this run is added to it. Replays are runs already logged and submitted, and soak runs are
+// the bot's, so neither are.
+static int addRun(int level, double time, int score, int lives) {
+  game_Difficulty difficulty = game_getDifficulty();
+  runs_Query      query      = { difficulty, level, RUNS_SORT_TIME, RUNS_ALL_PLAYERS };
+  int             count      = runs_getCount(query);
+  int             beaten     = count > 0 ? 100 * (count - runs_getRank(query, time, score)) / count : -1;
+  if (!replay_isPlaying() && !soak_isRunning()) {
+    runs_Record record = runs_add(difficulty, level, time, score, lives);
+    leaderboard_submit(&record);
+  }
+  g_board.isStale = true;
+  return beaten;
+}
+
+static bool loadScoresFile(void) {
   errno      = 0;
   FILE* file = fopen(SCORES_FILE, "r");
   if (file == nullptr) {
-    LOG_WARN(game_log, "Could not open file %s (%s)", SCORES_FILE, strerror(errno));
-    return;
+    LOG_INFO(game_log, "No %s to migrate (%s)", SCORES_FILE, strerror(errno));
+    return false;
   }
 
   score_Entry entry = {};
@@ -99,87 +142,77 @@ void scores_load(void) {
     );
     if (returnValue < ENTRY_COUNT) {
       LOG_ERROR(game_log, "Unable to process %s", SCORES_FILE);
-      return;
+      fclose(file);
+      return false;
     }
     entry.level--;
 
+    bool isLevelEntry = strcmp(entry.type, TYPE_TIME) == 0 || strcmp(entry.type, TYPE_SCORE) == 0;
+    if (isLevelEntry && (entry.level < 0 || entry.level >= MAX_LEVELS)) {
+      LOG_WARN(game_log, "Skipping level %d in %s", entry.level + 1, SCORES_FILE);
+      continue;
+    }
+
     if (strcmp(entry.type, TYPE_TIME) == 0) {
-      g_saves.bestTimes[getDifficulty(entry.difficulty)][entry.level] = entry;
+      g_saves.bestTimes[getDifficulty(entry.difficulty)][entry.level] = toRecord(entry);
     } else if (strcmp(entry.type, TYPE_SCORE) == 0) {
-      g_saves.bestScores[getDifficulty(entry.difficulty)][entry.level] = entry;
+      g_saves.bestScores[getDifficulty(entry.difficulty)][entry.level] = toRecord(entry);
     } else if (strcmp(entry.type, TYPE_FULL_TIME) == 0) {
-      g_saves.fullRunsBestTimes[getDifficulty(entry.difficulty)] = entry;
+      g_saves.fullRunsBestTimes[getDifficulty(entry.difficulty)] = toRecord(entry);
     } else if (strcmp(entry.type, TYPE_FULL_SCORE) == 0) {
-      g_saves.fullRunsBestScores[getDifficulty(entry.difficulty)] = entry;
+      g_saves.fullRunsBestScores[getDifficulty(entry.difficulty)] = toRecord(entry);
     } else {
       LOG_ERROR(game_log, "Syntax error in %s (%s)", SCORES_FILE, entry.type);
-      return;
+      fclose(file);
+      return false;
     }
   }
   if (errno > 0) LOG_ERROR(game_log, "%s", strerror(errno));
 
   if (fclose(file) == EOF) LOG_ERROR(game_log, "Error on closing file %s (%s)", SCORES_FILE, strerror(errno));
+  return true;
 }
 
-void scores_save(void) {
-  FILE* file = fopen(SCORES_FILE, "w");
-  if (file == nullptr) {
-    LOG_WARN(game_log, "Could not open file for writing %s (%s)", SCORES_FILE, strerror(errno));
-    return;
-  }
+// The run log's best, or the saved one where the log has none, as bests from before there was a log are only saved
+static score_Record getBest(int level, score_Record saved) {
+  runs_Sort   sort  = g_state.sort == SORTBY_TIME ? RUNS_SORT_TIME : RUNS_SORT_SCORE;
+  runs_Query  query = { g_state.difficulty, level, sort, RUNS_ALL_PLAYERS };
+  runs_Record best;
+  if (runs_getTop(query, &best, 1) == 0) return saved;
+  return (score_Record) { best.time, best.score, best.lives };
+}
 
-  for (int i = 0; i < DIFFICULTY_COUNT; i++) {
-    for (int j = 0; j < LEVEL_COUNT; j++) {
-      fprintf(
-          file,
-          "%s,%d,%.3f,%d,%d,%s\n",
-          MODE_NAMES[i],
-          g_saves.bestTimes[i][j].level = j + 1,
-          g_saves.bestTimes[i][j].time,
-          g_saves.bestTimes[i][j].score,
-          g_saves.bestTimes[i][j].lives,
-          TYPE_TIME
-      );
-      fprintf(
-          file,
-          "%s,%d,%.3f,%d,%d,%s\n",
-          MODE_NAMES[i],
-          g_saves.bestScores[i][j].level = j + 1,
-          g_saves.bestScores[i][j].time,
-          g_saves.bestScores[i][j].score,
-          g_saves.bestScores[i][j].lives,
-          TYPE_SCORE
-      );
-    }
-    fprintf(
-        file,
-        "%s,%d,%.3f,%d,%d,%s\n",
-        MODE_NAMES[i],
-        g_saves.fullRunsBestTimes[i].level = 0,
-        g_saves.fullRunsBestTimes[i].time,
-        g_saves.fullRunsBestTimes[i].score,
-        g_saves.fullRunsBestTimes[i].lives,
-        TYPE_FULL_TIME
-    );
-    fprintf(
-        file,
-        "%s,%d,%.3f,%d,%d,%s\n",
-        MODE_NAMES[i],
-        g_saves.fullRunsBestScores[i].level = 0,
-        g_saves.fullRunsBestScores[i].time,
-        g_saves.fullRunsBestScores[i].score,
-        g_saves.fullRunsBestScores[i].lives,
-        TYPE_FULL_SCORE
-    );
+static void updateBoard(void) {
+  game_Difficulty difficulty = g_state.difficulty;
+  bool            isTime     = g_state.sort == SORTBY_TIME;
+  int             rows       = MIN(maze_getLevelCount(), LEVEL_SCORE_ROWS);
+  for (int level = 0; level < rows; level++) {
+    score_Record saved    = isTime ? g_saves.bestTimes[difficulty][level] : g_saves.bestScores[difficulty][level];
+    g_board.levels[level] = getBest(level, saved);
   }
+  score_Record saved = isTime ? g_saves.fullRunsBestTimes[difficulty] : g_saves.fullRunsBestScores[difficulty];
+  g_board.fullRun    = getBest(RUNS_FULL_RUN, saved);
+  g_board.isStale    = false;
+}
 
-  if (fclose(file) == EOF) LOG_ERROR(game_log, "Error on closing file %s (%s)", SCORES_FILE, strerror(errno));
+// --- Score functions ---
+
+// The old CSV file is only read when the save store has no scores, and is then migrated to it
+void scores_load(void) {
+  g_saves         = (score_Saves) {};
+  g_board.isStale = true;
+  if (save_read(SAVE_SCORES, SCORES_VERSION, &g_saves, sizeof(g_saves), nullptr) != SAVE_MISSING) return;
+  if (loadScoresFile()) scores_save();
 }
 
+// Hands the records to the save store, which writes them behind the frame
+void scores_save(void) { save_write(SAVE_SCORES, SCORES_VERSION, &g_saves, sizeof(g_saves)); }
+
 scores_Result scores_levelClear(double time, int score, int lives) {
   int             level      = game_getLevel();
   game_Difficulty difficulty = game_getDifficulty();
-  scores_Result   result     = {};
+  scores_Result   result     = { .timeBeaten = addRun(level, time, score, lives) };
+  if (soak_isRunning()) return result;
 
   if (time < g_saves.bestTimes[difficulty][level].time || g_saves.bestTimes[difficulty][level].time == 0.0f) {
     g_saves.bestTimes[difficulty][level].time  = time;
@@ -200,7 +233,8 @@ scores_Result scores_levelClear(double time, int score, int lives) {
 
 scores_Result scores_fullRun(double time, int score, int lives) {
   game_Difficulty difficulty = game_getDifficulty();
-  scores_Result   result     = {};
+  scores_Result   result     = { .timeBeaten = addRun(RUNS_FULL_RUN, time, score, lives) };
+  if (soak_isRunning()) return result;
 
   if (time < g_saves.fullRunsBestTimes[difficulty].time || g_saves.fullRunsBestTimes[difficulty].time == 0.0f) {
     g_saves.fullRunsBestTimes[difficulty].time  = time;
@@ -229,39 +263,19 @@ const char* scores_printTime(double time) {
 }
 
 void scores_drawMenu(void) {
+  if (g_board.isStale) updateBoard();
   draw_shadowText(LEVEL_SCORE_HEADER);
 
   g_levelScore.yPos = LEVEL_SCORE_YPOS;
-  for (int level = 0; level < LEVEL_COUNT; level++) {
-    float time;
-    int   score;
-    int   lives;
-    if (g_state.sort == SORTBY_TIME) {
-      time  = g_saves.bestTimes[g_state.difficulty][level].time;
-      score = g_saves.bestTimes[g_state.difficulty][level].score;
-      lives = g_saves.bestTimes[g_state.difficulty][level].lives;
-    } else {
-      time  = g_saves.bestScores[g_state.difficulty][level].time;
-      score = g_saves.bestScores[g_state.difficulty][level].score;
-      lives = g_saves.bestScores[g_state.difficulty][level].lives;
-    }
-    if (time > 0.0) draw_shadowText(g_levelScore, level + 1, scores_printTime(time), score, lives);
+  int rows          = MIN(maze_getLevelCount(), LEVEL_SCORE_ROWS);
+  for (int level = 0; level < rows; level++) {
+    score_Record best = g_board.levels[level];
+    if (best.time > 0.0) draw_shadowText(g_levelScore, level + 1, scores_printTime(best.time), best.score, best.lives);
     g_levelScore.yPos += LINE_HEIGHT;
   }
 
-  float time;
-  int   score;
-  int   lives;
-  if (g_state.sort == SORTBY_TIME) {
-    time  = g_saves.fullRunsBestTimes[g_state.difficulty].time;
-    score = g_saves.fullRunsBestTimes[g_state.difficulty].score;
-    lives = g_saves.fullRunsBestTimes[g_state.difficulty].lives;
-  } else {
-    time  = g_saves.fullRunsBestScores[g_state.difficulty].time;
-    score = g_saves.fullRunsBestScores[g_state.difficulty].score;
-    lives = g_saves.fullRunsBestScores[g_state.difficulty].lives;
-  }
-  if (time > 0.0) draw_shadowText(FULL_RUN_TIME, scores_printTime(time), score, lives);
+  score_Record best = g_board.fullRun;
+  if (best.time > 0.0) draw_shadowText(FULL_RUN_TIME, scores_printTime(best.time), best.score, best.lives);
 }
 
 void scores_setEasy(void) { setDifficulty(DIFFICULTY_EASY); }
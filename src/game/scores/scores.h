@@ -8,6 +8,7 @@
 typedef struct scores_Result {
   bool isTimeRecord;
   bool isScoreRecord;
+  int  timeBeaten;  // Percentage of earlier runs this was faster than, -1 if it is the first
 } scores_Result;
 
 // --- Score functions ---
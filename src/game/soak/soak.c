@@ -0,0 +1,494 @@
+#include "soak.h"
+#include <assert.h>
+#include <log/log.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../input/input.h"
+#include "../internal.h"
+#include "../menu/menu.h"
+#include "../metrics/metrics.h"
+
+#if !defined(_WIN32)
+#include <dirent.h>
+#endif
+
+// --- Constants ---
+
+static const double SAMPLE_INTERVAL = 60.0;   // Seconds between samples
+constexpr int       WARM_UP         = 10;     // Samples taken while the level cache fills, before any are checked
+constexpr int       GROWTH_SAMPLES  = 10;     // Rising through this many samples in a row looks like a leak
+constexpr int       DRIFT_SAMPLES   = 3;      // Slow for this many samples in a row is drift, not a busy machine
+static const double DRIFT_RATIO     = 1.5;    // Over the baseline by both of these is slow
+static const double DRIFT_MIN       = 2.0;    // Milliseconds
+constexpr int       MAX_FRAMES      = 65536;  // Per sample, any more go uncounted in its percentiles
+static const double READY_DELAY     = 0.5;    // Game seconds before the bot dismisses a screen
+static const double END_DELAY       = 3.0;    // Game seconds on the game over and won screens
+static const double LEVEL_TIME      = 90.0;   // Game seconds before the bot gives up on a level and quits
+static const double TURN_MIN        = 0.25;   // Game seconds the bot holds a direction for
+static const double TURN_MAX        = 1.0;
+constexpr int       MAX_TARGETS     = 16;     // Buttons on one menu screen
+static const char   QUIT_BUTTON[]   = "Return to Title";
+
+static const input_Key DIR_KEYS[DIR_COUNT] = {
+  [DIR_UP] = INPUT_UP, [DIR_RIGHT] = INPUT_RIGHT, [DIR_DOWN] = INPUT_DOWN, [DIR_LEFT] = INPUT_LEFT
+};
+
+// --- Types ---
+
+// The bot's clicks from the title menu to a game, one after another
+typedef enum soak_Click {
+  CLICK_START,
+  CLICK_DIFFICULTY,
+  CLICK_DIFFICULTY_ITEM,
+  CLICK_LEVEL,
+  CLICK_LEVEL_ITEM,
+  CLICK_PLAY,
+  CLICK_DONE
+} soak_Click;
+
+// What each sample measures, the resources are checked for growth and the frame times for drift
+typedef enum soak_Series {
+  SERIES_PACK,
+  SERIES_MAZE,
+  SERIES_SOUNDS,
+  SERIES_SAVE,
+  SERIES_SPRITES,
+  SERIES_ANIMS,
+  SERIES_TEXTURES,
+  SERIES_FONTS,
+  SERIES_FILES,
+  SERIES_VOICES,  // The most playing at once since the last sample
+  SERIES_P50,     // Milliseconds, of frames in play
+  SERIES_P95,
+  SERIES_P99,
+  SERIES_COUNT
+} soak_Series;
+
+constexpr int GAUGE_COUNT    = SERIES_FILES;  // Read straight from the metrics
+constexpr int RESOURCE_COUNT = SERIES_P50;
+
+// --- Global state ---
+
+static const char* SERIES_NAMES[SERIES_COUNT] = {
+  [SERIES_PACK]     = "pack_bytes",
+  [SERIES_MAZE]     = "maze_bytes",
+  [SERIES_SOUNDS]   = "sound_bytes",
+  [SERIES_SAVE]     = "save_bytes",
+  [SERIES_SPRITES]  = "sprites",
+  [SERIES_ANIMS]    = "anims",
+  [SERIES_TEXTURES] = "textures",
+  [SERIES_FONTS]    = "fonts",
+  [SERIES_FILES]    = "open_files",
+  [SERIES_VOICES]   = "peak_voices",
+  [SERIES_P50]      = "frame_p50_ms",
+  [SERIES_P95]      = "frame_p95_ms",
+  [SERIES_P99]      = "frame_p99_ms"
+};
+
+static const metrics_Metric SERIES_METRICS[GAUGE_COUNT] = {
+  [SERIES_PACK]     = METRICS_MEMORY_PACK,
+  [SERIES_MAZE]     = METRICS_MEMORY_MAZE,
+  [SERIES_SOUNDS]   = METRICS_MEMORY_SOUNDS,
+  [SERIES_SAVE]     = METRICS_MEMORY_SAVE,
+  [SERIES_SPRITES]  = METRICS_SPRITES,
+  [SERIES_ANIMS]    = METRICS_ANIMS,
+  [SERIES_TEXTURES] = METRICS_TEXTURES,
+  [SERIES_FONTS]    = METRICS_FONTS
+};
+
+static struct {
+  bool   isRunning;
+  double duration;  // Seconds
+  double elapsed;
+  FILE*  report;
+
+  // The bot
+  uint64_t       random;
+  int            gameCount;  // Each starts on the next difficulty, then the next start level
+  game_GameState state;      // As last seen, to time how long it has been showing
+  double         stateTime;
+  bool           hasActed;  // Once per state
+  soak_Click     click;     // Next on the title menu
+  double         clickTime;
+  bool           isQuitting;
+  double         levelTime;
+  game_Dir       dir;
+  double         turnTime;
+
+  // The current sample
+  double sampleElapsed;
+  float  frames[MAX_FRAMES];
+  int    frameCount;
+  int    peakVoices;
+
+  // Those taken
+  double history[GROWTH_SAMPLES][SERIES_COUNT];
+  int    sampleCount;
+  bool   hasBaseline;
+  double baseline[SERIES_COUNT];
+  int    slowCount[SERIES_COUNT];
+  bool   isFlagged[SERIES_COUNT];
+  int    flagCount;
+} g_soak;
+
+// --- Helper functions ---
+
+// xorshift64*, kept apart from the game's generator, which a replay has to see used exactly as it was recorded
+static uint64_t nextRandom(void) {
+  g_soak.random ^= g_soak.random >> 12;
+  g_soak.random ^= g_soak.random << 25;
+  g_soak.random ^= g_soak.random >> 27;
+  return g_soak.random * 0x2545F4914F6CDD1Dull;
+}
+
+static double getRandomRange(double min, double max) { return min + (max - min) * (nextRandom() >> 11) * 0x1.0p-53; }
+
+static void click(input_Frame* frame, Vector2 pos) {
+  frame->mousePos             = pos;
+  frame->isMouseButtonPressed = 1u << INPUT_LEFT_BUTTON;
+}
+
+// Labels are padded with spaces to line up
+static const menu_Target* findTarget(const menu_Target targets[], int count, const char* text) {
+  size_t length = strlen(text);
+  for (int i = 0; i < count; i++) {
+    if (strncmp(targets[i].text, text, length) != 0) continue;
+    const char* rest = targets[i].text + length;
+    while (*rest == ' ') rest++;
+    if (*rest == '\0') return &targets[i];
+  }
+  return nullptr;
+}
+
+// Clicks through the menu as a player would, working through every difficulty at each start level it offers
+static void clickStart(input_Frame* frame) {
+  menu_Target        targets[MAX_TARGETS];
+  int                count  = menu_getTargets(targets, MAX_TARGETS);
+  const menu_Target* target = nullptr;
+  switch (g_soak.click) {
+    case CLICK_START:
+    case CLICK_PLAY: target = findTarget(targets, count, "Start Game"); break;
+    case CLICK_DIFFICULTY: target = findTarget(targets, count, "Difficulty"); break;
+    case CLICK_LEVEL: target = findTarget(targets, count, "Level"); break;
+    case CLICK_DIFFICULTY_ITEM: target = count > 0 ? &targets[g_soak.gameCount % count] : nullptr; break;
+    case CLICK_LEVEL_ITEM: target = count > 0 ? &targets[g_soak.gameCount / DIFFICULTY_COUNT % count] : nullptr; break;
+    case CLICK_DONE: return;
+  }
+
+  // Lost its place, so clicks clear of everything to close any dropdown and starts over
+  if (target == nullptr) {
+    LOG_WARN(game_log, "Soak bot lost its way on the title menu");
+    click(frame, (Vector2) { -1.0f, -1.0f });
+    g_soak.click = CLICK_START;
+    return;
+  }
+
+  click(frame, target->centre);
+  if (g_soak.click == CLICK_PLAY) g_soak.gameCount++;
+  g_soak.click++;
+}
+
+// Wanders, holding each direction for a while so the player gets down corridors rather than jittering
+static uint32_t steer(double now) {
+  if (now >= g_soak.turnTime) {
+    g_soak.dir      = nextRandom() % DIR_COUNT;
+    g_soak.turnTime = now + getRandomRange(TURN_MIN, TURN_MAX);
+  }
+  return 1u << DIR_KEYS[g_soak.dir];
+}
+
+static int countOpenFiles(void) {
+#if defined(_WIN32)
+  return -1;
+#else
+  DIR* dir = opendir("/proc/self/fd");
+  if (dir == nullptr) dir = opendir("/dev/fd");
+  if (dir == nullptr) return -1;
+
+  int count = 0;
+  for (struct dirent* entry; (entry = readdir(dir)) != nullptr;) {
+    if (entry->d_name[0] != '.') count++;
+  }
+  closedir(dir);
+  return count - 1;  // Not the directory's own
+#endif
+}
+
+static int compareFrames(const void* a, const void* b) {
+  float x = *(const float*) a;
+  float y = *(const float*) b;
+  return (x > y) - (x < y);
+}
+
+// Of the sorted frames, in milliseconds
+static double getPercentile(double percentile) {
+  int index = (int) (percentile * (g_soak.frameCount - 1) + 0.5);
+  return g_soak.frames[index] * 1000.0;
+}
+
+static void writeHeader(void) {
+  fprintf(g_soak.report, "seconds,games");
+  for (int i = 0; i < SERIES_COUNT; i++) fprintf(g_soak.report, ",%s", SERIES_NAMES[i]);
+  fputc('\n', g_soak.report);
+}
+
+// Flushed each time, so a soak that crashes still leaves its samples behind
+static void writeSample(const double values[]) {
+  if (g_soak.report == nullptr) return;
+
+  fprintf(g_soak.report, "%.0f,%d", g_soak.elapsed, g_soak.gameCount);
+  for (int i = 0; i < SERIES_COUNT; i++) {
+    if (isnan(values[i])) {
+      fputc(',', g_soak.report);
+    } else {
+      fprintf(g_soak.report, ",%.*f", i < RESOURCE_COUNT ? 0 : 3, values[i]);
+    }
+  }
+  fputc('\n', g_soak.report);
+  fflush(g_soak.report);
+}
+
+static void flag(soak_Series series) {
+  g_soak.isFlagged[series] = true;
+  g_soak.flagCount++;
+}
+
+// A leak grows through every sample, where caches level off or fall back as they evict
+static void checkGrowth(const double values[]) {
+  int oldest = g_soak.sampleCount - GROWTH_SAMPLES + 1;
+  if (oldest < WARM_UP) return;
+
+  for (int series = 0; series < RESOURCE_COUNT; series++) {
+    if (g_soak.isFlagged[series]) continue;
+
+    double first    = g_soak.history[oldest % GROWTH_SAMPLES][series];
+    double previous = first;
+    bool   isRising = true;
+    for (int i = oldest + 1; i <= g_soak.sampleCount && isRising; i++) {
+      double value = i < g_soak.sampleCount ? g_soak.history[i % GROWTH_SAMPLES][series] : values[series];
+      isRising     = value >= previous;
+      previous     = value;
+    }
+    if (isRising && previous > first) {
+      LOG_WARN(
+          game_log,
+          "Soak: %s rose through the last %d samples, from %.0f to %.0f",
+          SERIES_NAMES[series],
+          GROWTH_SAMPLES,
+          first,
+          previous
+      );
+      flag(series);
+    }
+  }
+}
+
+// Against the first sample after warming up, so the machine's own speed isn't mistaken for drift
+static void checkDrift(const double values[]) {
+  if (g_soak.sampleCount < WARM_UP || isnan(values[SERIES_P50])) return;
+  if (!g_soak.hasBaseline) {
+    memcpy(g_soak.baseline, values, sizeof(g_soak.baseline));
+    g_soak.hasBaseline = true;
+    return;
+  }
+
+  for (int series = SERIES_P50; series < SERIES_COUNT; series++) {
+    double baseline = g_soak.baseline[series];
+    bool   isSlow   = values[series] > baseline * DRIFT_RATIO && values[series] - baseline > DRIFT_MIN;
+    g_soak.slowCount[series] = isSlow ? g_soak.slowCount[series] + 1 : 0;
+    if (g_soak.isFlagged[series] || g_soak.slowCount[series] < DRIFT_SAMPLES) continue;
+
+    LOG_WARN(
+        game_log,
+        "Soak: %s drifted from %.2f to %.2f over %d samples",
+        SERIES_NAMES[series],
+        baseline,
+        values[series],
+        DRIFT_SAMPLES
+    );
+    flag(series);
+  }
+}
+
+static void takeSample(void) {
+  double values[SERIES_COUNT];
+  for (int i = 0; i < GAUGE_COUNT; i++) values[i] = (double) metrics_get(SERIES_METRICS[i]);
+  values[SERIES_FILES]  = countOpenFiles();
+  values[SERIES_VOICES] = g_soak.peakVoices;
+  if (g_soak.frameCount > 0) {
+    qsort(g_soak.frames, g_soak.frameCount, sizeof(g_soak.frames[0]), compareFrames);
+    values[SERIES_P50] = getPercentile(0.50);
+    values[SERIES_P95] = getPercentile(0.95);
+    values[SERIES_P99] = getPercentile(0.99);
+  } else {
+    values[SERIES_P50] = values[SERIES_P95] = values[SERIES_P99] = NAN;
+  }
+
+  LOG_INFO(
+      game_log,
+      "Soak sample %d, %d games: frame p95 %.2f ms, %.0f sprites, %.0f maze bytes",
+      g_soak.sampleCount + 1,
+      g_soak.gameCount,
+      values[SERIES_P95],
+      values[SERIES_SPRITES],
+      values[SERIES_MAZE]
+  );
+  writeSample(values);
+  checkGrowth(values);
+  checkDrift(values);
+
+  memcpy(g_soak.history[g_soak.sampleCount % GROWTH_SAMPLES], values, sizeof(values));
+  g_soak.sampleCount++;
+  g_soak.sampleElapsed = 0.0;
+  g_soak.frameCount    = 0;
+  g_soak.peakVoices    = 0;
+}
+
+// --- Soak functions ---
+
+// Plays for the given hours, writing each sample to the report as CSV if there is one
+bool soak_open(const char* hours, const char* reportFile) {
+  assert(hours != nullptr);
+  assert(!g_soak.isRunning);
+
+  char*  end      = nullptr;
+  double duration = strtod(hours, &end);
+  if (end == hours || *end != '\0' || !(duration > 0.0)) {
+    LOG_ERROR(game_log, "Invalid soak length %s, expected hours", hours);
+    return false;
+  }
+  if (reportFile != nullptr) {
+    g_soak.report = fopen(reportFile, "w");
+    if (g_soak.report == nullptr) {
+      LOG_ERROR(game_log, "Unable to open soak report %s", reportFile);
+      return false;
+    }
+    writeHeader();
+  }
+
+  g_soak.isRunning = true;
+  g_soak.duration  = duration * 3600.0;
+  g_soak.random    = (uint64_t) time(nullptr) * 0x9E3779B97F4A7C15ull | 1;
+  g_soak.state     = g_game.state;
+  LOG_INFO(game_log, "Soaking for %.2f hours, sampling every %.0f seconds", duration, SAMPLE_INTERVAL);
+  return true;
+}
+
+bool soak_isRunning(void) { return g_soak.isRunning; }
+
+bool soak_isFinished(void) { return g_soak.isRunning && g_soak.elapsed >= g_soak.duration; }
+
+// In place of input_update(), the bot's input as this frame's
+bool soak_applyInput(void) {
+  assert(g_soak.isRunning);
+
+  double      now   = game_getTime();
+  input_Frame frame = { .mousePos = { -1.0f, -1.0f } };  // Clear of every menu item
+
+  if (g_game.state != g_soak.state) {
+    if (g_game.state == GAME_START) g_soak.levelTime = now;
+    if (g_game.state == GAME_TITLE) {
+      g_soak.click      = CLICK_START;
+      g_soak.isQuitting = false;
+    }
+    g_soak.state     = g_game.state;
+    g_soak.stateTime = now;
+    g_soak.clickTime = now;
+    g_soak.hasActed  = false;
+  }
+  bool isReady = !g_soak.hasActed && now - g_soak.stateTime >= READY_DELAY;
+
+  switch (g_game.state) {
+    case GAME_BOOT: break;
+
+    case GAME_TITLE:
+      if (game_isLoaded() && now - g_soak.clickTime >= READY_DELAY) {
+        clickStart(&frame);
+        g_soak.clickTime = now;
+      }
+      break;
+
+    // Only opened by the bot, to quit a level it has spent too long on
+    case GAME_MENU:
+      if (isReady) {
+        menu_Target        targets[MAX_TARGETS];
+        int                count = menu_getTargets(targets, MAX_TARGETS);
+        const menu_Target* quit  = findTarget(targets, count, QUIT_BUTTON);
+        if (g_soak.isQuitting && quit != nullptr) {
+          click(&frame, quit->centre);
+        } else {
+          frame.isKeyPressed = 1u << INPUT_ESCAPE;
+        }
+        g_soak.hasActed = true;
+      }
+      break;
+
+    case GAME_START:
+    case GAME_DEAD:
+    case GAME_PAUSE:
+    case GAME_LEVELCLEAR:
+      if (isReady) {
+        frame.isKeyPressed = 1u << INPUT_SPACE;
+        g_soak.hasActed    = true;
+      }
+      break;
+
+    case GAME_RUN:
+      frame.isKeyDown = steer(now);
+      if (!g_soak.hasActed && now - g_soak.levelTime >= LEVEL_TIME) {
+        frame.isKeyPressed = 1u << INPUT_ESCAPE;
+        g_soak.isQuitting  = true;
+        g_soak.hasActed    = true;
+      }
+      break;
+
+    case GAME_OVER:
+    case GAME_WON:
+      if (!g_soak.hasActed && now - g_soak.stateTime >= END_DELAY) {
+        frame.isKeyPressed = 1u << INPUT_SPACE;
+        g_soak.hasActed    = true;
+      }
+      break;
+  }
+  return input_setFrame(&frame);
+}
+
+// With the real time between frames
+void soak_recordFrame(double frameTime) {
+  if (!g_soak.isRunning) return;
+
+  g_soak.elapsed       += frameTime;
+  g_soak.sampleElapsed += frameTime;
+  // Static screens sleep between frames, so only play is timed
+  if (g_game.state == GAME_RUN && g_soak.frameCount < MAX_FRAMES) g_soak.frames[g_soak.frameCount++] = frameTime;
+  int voices        = (int) metrics_get(METRICS_ACTIVE_VOICES);
+  g_soak.peakVoices = MAX(g_soak.peakVoices, voices);
+  if (g_soak.sampleElapsed >= SAMPLE_INTERVAL) takeSample();
+}
+
+// Returns whether it ran without anything growing or drifting
+bool soak_close(void) {
+  if (!g_soak.isRunning) return true;
+
+  g_soak.isRunning = false;
+  if (g_soak.report != nullptr && fclose(g_soak.report) != 0) LOG_ERROR(game_log, "Failed to write soak report");
+  g_soak.report = nullptr;
+
+  LOG_INFO(
+      game_log,
+      "Soaked for %.2f hours, %d games, %d samples",
+      g_soak.elapsed / 3600.0,
+      g_soak.gameCount,
+      g_soak.sampleCount
+  );
+  if (g_soak.flagCount > 0) {
+    LOG_WARN(game_log, "Soak flagged %d problems", g_soak.flagCount);
+  } else {
+    LOG_INFO(game_log, "Soak found nothing growing or drifting");
+  }
+  return g_soak.flagCount == 0;
+}
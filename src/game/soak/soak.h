@@ -0,0 +1,15 @@
+// clang-format Language: C
+#pragma once
+
+// Unattended play for hours at a time. A bot drives the game through its input frames, so a soak can be recorded and
+// replayed like any other session, while the game's memory, engine objects, open files, voices and frame times are
+// sampled, warning of any that keep growing or drifting.
+
+// --- Soak functions ---
+
+bool soak_open(const char* hours, const char* reportFile);
+bool soak_isRunning(void);
+bool soak_isFinished(void);
+bool soak_applyInput(void);
+void soak_recordFrame(double frameTime);
+bool soak_close(void);
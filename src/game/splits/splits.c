@@ -0,0 +1,309 @@
+#include "splits.h"
+#include <assert.h>
+#include <errno.h>
+#include <log/log.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "../draw/draw.h"
+#include "../internal.h"
+#include "../maze/maze.h"
+#include "../replay/replay.h"
+#include "../soak/soak.h"
+
+#if defined(_WIN32)
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+// --- Constants ---
+
+constexpr int       MAX_LEVEL_SPLITS = 16;  // The key, the swords and the last coin
+constexpr int64_t   NANOS_PER_SECOND = 1000000000;
+constexpr int64_t   NANOS_PER_MILLI  = 1000000;
+static const double DELTA_TIME       = 3.0;  // Seconds of level time a split's delta stays on screen
+constexpr size_t    PATH_LENGTH      = 1024;
+constexpr size_t    LINE_LENGTH      = 128;
+constexpr size_t    TIME_LENGTH      = 32;
+constexpr Color     AHEAD_COLOUR     = { 0, 228, 48, 255 };
+
+static const char  SPLITS_FILE[]                      = "%s/%s.splits";  // Directory and difficulty
+static const char  TEMP_FILE[]                        = "%s/%s.splits.tmp";
+static const char  SPLITS_HEADER[]                    = "# set level kind ordinal level_ns run_ns\n";
+static const char* DIFFICULTY_NAMES[DIFFICULTY_COUNT] = { "easy", "normal", "arcade" };
+static const char* KIND_NAMES[SPLITS_KIND_COUNT]      = { "key", "sword", "clear" };
+
+static const draw_Text TIME_TEXT = { "%s", 176, 0, TEXT_COLOUR, FONT_NORMAL };
+
+// --- Types ---
+
+typedef struct splits_Split {
+  splits_Kind kind;
+  int         ordinal;    // Of its kind in the level, from 1
+  int64_t     levelTime;  // Nanoseconds
+  int64_t     runTime;
+} splits_Split;
+
+typedef struct splits_Level {
+  splits_Split splits[MAX_LEVEL_SPLITS];
+  int          count;
+} splits_Level;
+
+// --- Global state ---
+
+static draw_Text g_deltaText = { "%s", 236, 0, TEXT_COLOUR, FONT_NORMAL };
+
+static struct {
+  bool            isOpen;
+  const char*     dir;
+  game_Difficulty loaded;             // Whose bests are held, DIFFICULTY_NONE until a run starts
+  splits_Level    best[MAX_LEVELS];   // Each level's fastest clear
+  splits_Level    pb[MAX_LEVELS];     // The fastest full run
+  splits_Level    current[MAX_LEVELS];
+  bool            isRunning;
+  bool            isFullRun;
+  int             level;
+  int64_t         levelTime;
+  int64_t         runTime;  // Up to the start of this level
+  int64_t         delta;    // Of the last split
+  bool            hasDelta;
+  int64_t         deltaTime;  // Level time it was split at
+} g_splits;
+
+// --- Helper functions ---
+
+static bool makeDir(const char* dir) {
+#if defined(_WIN32)
+  return _mkdir(dir) == 0 || errno == EEXIST;
+#else
+  return mkdir(dir, 0755) == 0 || errno == EEXIST;
+#endif
+}
+
+// Truncated to the millisecond as speedrun timers are, deltas are signed and drop the minutes when there are none
+static void formatTime(int64_t nanos, bool isDelta, char buffer[TIME_LENGTH]) {
+  const char* sign    = isDelta ? (nanos <= 0 ? "-" : "+") : "";
+  int64_t     millis  = (nanos < 0 ? -nanos : nanos) / NANOS_PER_MILLI;
+  int         minutes = (int) (millis / 60000);
+  int         seconds = (int) (millis / 1000 % 60);
+  int         milli   = (int) (millis % 1000);
+  if (isDelta && minutes == 0) {
+    snprintf(buffer, TIME_LENGTH, "%s%d.%03d", sign, seconds, milli);
+  } else {
+    snprintf(buffer, TIME_LENGTH, "%s%d:%02d.%03d", sign, minutes, seconds, milli);
+  }
+}
+
+static const splits_Split* findSplit(const splits_Level* level, splits_Kind kind, int ordinal) {
+  for (int i = 0; i < level->count; i++) {
+    if (level->splits[i].kind == kind && level->splits[i].ordinal == ordinal) return &level->splits[i];
+  }
+  return nullptr;
+}
+
+static int countSplits(const splits_Level* level, splits_Kind kind) {
+  int count = 0;
+  for (int i = 0; i < level->count; i++) {
+    if (level->splits[i].kind == kind) count++;
+  }
+  return count;
+}
+
+static int findKind(const char* name) {
+  for (int i = 0; i < SPLITS_KIND_COUNT; i++) {
+    if (strcmp(name, KIND_NAMES[i]) == 0) return i;
+  }
+  return -1;
+}
+
+// A missing file is no bests yet, lines that don't parse are skipped
+static void loadSplits(game_Difficulty difficulty) {
+  assert(difficulty >= 0 && difficulty < DIFFICULTY_COUNT);
+
+  memset(g_splits.best, 0, sizeof(g_splits.best));
+  memset(g_splits.pb, 0, sizeof(g_splits.pb));
+  g_splits.loaded = difficulty;
+
+  char path[PATH_LENGTH];
+  snprintf(path, sizeof(path), SPLITS_FILE, g_splits.dir, DIFFICULTY_NAMES[difficulty]);
+  FILE* stream = fopen(path, "r");
+  if (stream == nullptr) return;
+
+  char line[LINE_LENGTH];
+  while (fgets(line, sizeof(line), stream) != nullptr) {
+    char      set[8];
+    char      kindName[8];
+    int       level;
+    int       ordinal;
+    long long levelTime;
+    long long runTime;
+    if (sscanf(line, "%7s %d %7s %d %lld %lld", set, &level, kindName, &ordinal, &levelTime, &runTime) != 6) continue;
+
+    splits_Level* levels = strcmp(set, "best") == 0 ? g_splits.best : strcmp(set, "pb") == 0 ? g_splits.pb : nullptr;
+    int           kind   = findKind(kindName);
+    if (levels == nullptr || kind == -1 || level < 0 || level >= MAX_LEVELS) continue;
+    if (levels[level].count == MAX_LEVEL_SPLITS) continue;
+    levels[level].splits[levels[level].count++] = (splits_Split) { kind, ordinal, levelTime, runTime };
+  }
+  fclose(stream);
+  LOG_INFO(game_log, "Loaded splits from %s", path);
+}
+
+static void writeLevels(FILE* stream, const char* set, const splits_Level levels[]) {
+  for (int level = 0; level < MAX_LEVELS; level++) {
+    for (int i = 0; i < levels[level].count; i++) {
+      const splits_Split* split = &levels[level].splits[i];
+      fprintf(
+          stream,
+          "%s %d %s %d %lld %lld\n",
+          set,
+          level,
+          KIND_NAMES[split->kind],
+          split->ordinal,
+          (long long) split->levelTime,
+          (long long) split->runTime
+      );
+    }
+  }
+}
+
+// Replaced whole, so a failed write leaves the old bests
+static void saveSplits(void) {
+  const char* name = DIFFICULTY_NAMES[g_splits.loaded];
+  char        path[PATH_LENGTH];
+  char        temp[PATH_LENGTH];
+  snprintf(path, sizeof(path), SPLITS_FILE, g_splits.dir, name);
+  snprintf(temp, sizeof(temp), TEMP_FILE, g_splits.dir, name);
+
+  FILE* stream = fopen(temp, "w");
+  if (stream != nullptr) {
+    fputs(SPLITS_HEADER, stream);
+    writeLevels(stream, "best", g_splits.best);
+    writeLevels(stream, "pb", g_splits.pb);
+  }
+  bool isWritten = stream != nullptr && !ferror(stream);
+  if (stream != nullptr && fclose(stream) != 0) isWritten = false;
+#if defined(_WIN32)
+  if (isWritten) remove(path);
+#endif
+  if (!isWritten || rename(temp, path) != 0) LOG_WARN(game_log, "Failed to write %s", path);
+}
+
+// Full runs only against the personal best run, as their time is the run's
+static void compare(const splits_Split* split) {
+  const splits_Level* levels = g_splits.isFullRun ? g_splits.pb : g_splits.best;
+  const splits_Split* target = findSplit(&levels[g_splits.level], split->kind, split->ordinal);
+  g_splits.hasDelta          = target != nullptr;
+  if (target == nullptr) return;
+
+  g_splits.delta     = g_splits.isFullRun ? split->runTime - target->runTime : split->levelTime - target->levelTime;
+  g_splits.deltaTime = split->levelTime;
+}
+
+static bool isRunComplete(void) {
+  for (int level = 0; level < maze_getLevelCount(); level++) {
+    if (findSplit(&g_splits.current[level], SPLITS_CLEAR, 1) == nullptr) return false;
+  }
+  return true;
+}
+
+static void clearLevel(const splits_Split* clear) {
+  int  level      = g_splits.level;
+  bool isImproved = false;
+
+  const splits_Split* best = findSplit(&g_splits.best[level], SPLITS_CLEAR, 1);
+  if (best == nullptr || clear->levelTime < best->levelTime) {
+    g_splits.best[level] = g_splits.current[level];
+    isImproved           = true;
+  }
+  // Levels skipped in debug builds never clear, so can't make a personal best
+  if (g_splits.isFullRun && level == maze_getLevelCount() - 1 && isRunComplete()) {
+    const splits_Split* pb = findSplit(&g_splits.pb[level], SPLITS_CLEAR, 1);
+    if (pb == nullptr || clear->runTime < pb->runTime) {
+      memcpy(g_splits.pb, g_splits.current, sizeof(g_splits.pb));
+      isImproved = true;
+      LOG_INFO(game_log, "New personal best run");
+    }
+  }
+
+  g_splits.runTime   += g_splits.levelTime;
+  g_splits.isRunning  = false;
+  if (isImproved && !replay_isPlaying() && !soak_isRunning()) saveSplits();
+}
+
+// --- Splits functions ---
+
+// Keeps the bests in the directory, and shows the timer and deltas
+bool splits_open(const char* dir) {
+  assert(dir != nullptr);
+  assert(!g_splits.isOpen);
+
+  if (!makeDir(dir)) {
+    LOG_ERROR(game_log, "Unable to create splits directory %s", dir);
+    return false;
+  }
+  g_splits.dir    = dir;
+  g_splits.loaded = DIFFICULTY_NONE;
+  g_splits.isOpen = true;
+  LOG_INFO(game_log, "Keeping splits in %s", dir);
+  return true;
+}
+
+// As the player is ready, the start of a run if it's the first level played
+void splits_startLevel(void) {
+  if (!g_splits.isOpen) return;
+
+  int level = game_getLevel();
+  if (level == game_getStartLevel()) {
+    game_Difficulty difficulty = game_getDifficulty();
+    if (difficulty != g_splits.loaded) loadSplits(difficulty);
+    memset(g_splits.current, 0, sizeof(g_splits.current));
+    g_splits.runTime   = 0;
+    g_splits.isFullRun = level == 0;
+  }
+  g_splits.current[level] = (splits_Level) {};
+  g_splits.level          = level;
+  g_splits.levelTime      = 0;
+  g_splits.hasDelta       = false;
+  g_splits.isRunning      = true;
+}
+
+// Whole nanoseconds per step, so long runs don't pick up rounding from adding up doubles
+void splits_tick(double frameTime) {
+  if (g_splits.isRunning) g_splits.levelTime += llround(frameTime * NANOS_PER_SECOND);
+}
+
+// Only the first key splits, the level's clear ends its timing
+void splits_split(splits_Kind kind) {
+  assert(kind >= 0 && kind < SPLITS_KIND_COUNT);
+  if (!g_splits.isRunning) return;
+
+  splits_Level* level   = &g_splits.current[g_splits.level];
+  int           ordinal = countSplits(level, kind) + 1;
+  if (kind == SPLITS_KEY && ordinal > 1) return;
+  // The last slot is kept for the clear
+  if (level->count == MAX_LEVEL_SPLITS - (kind == SPLITS_CLEAR ? 0 : 1)) return;
+
+  splits_Split* split = &level->splits[level->count++];
+  *split              = (splits_Split) { kind, ordinal, g_splits.levelTime, g_splits.runTime + g_splits.levelTime };
+  compare(split);
+  if (kind == SPLITS_CLEAR) clearLevel(split);
+}
+
+void splits_draw(void) {
+  if (!g_splits.isOpen) return;
+
+  // A cleared level's time is already in the run's
+  int64_t levelTime = g_splits.isRunning ? g_splits.levelTime : 0;
+  char    time[TIME_LENGTH];
+  formatTime(g_splits.isFullRun ? g_splits.runTime + levelTime : g_splits.levelTime, false, time);
+  draw_text(TIME_TEXT, time);
+  if (!g_splits.hasDelta || g_splits.levelTime - g_splits.deltaTime > DELTA_TIME * NANOS_PER_SECOND) return;
+
+  char delta[TIME_LENGTH];
+  formatTime(g_splits.delta, true, delta);
+  g_deltaText.colour = g_splits.delta <= 0 ? AHEAD_COLOUR : TEXT_RED;
+  draw_text(g_deltaText, delta);
+}
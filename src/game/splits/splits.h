@@ -0,0 +1,18 @@
+// clang-format Language: C
+#pragma once
+
+// Speedrun splits, timed in whole nanoseconds of game time as the level time is, so a replay reproduces them exactly.
+// Each level splits on its first key, every sword and its last coin. Full runs are compared against the personal best
+// run, runs from a later level against each level's best clear. --splits keeps both in a file per difficulty.
+
+// --- Types ---
+
+typedef enum splits_Kind { SPLITS_KEY, SPLITS_SWORD, SPLITS_CLEAR, SPLITS_KIND_COUNT } splits_Kind;
+
+// --- Splits functions ---
+
+bool splits_open(const char* dir);
+void splits_startLevel(void);
+void splits_tick(double frameTime);
+void splits_split(splits_Kind kind);
+void splits_draw(void);
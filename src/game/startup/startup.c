@@ -0,0 +1,236 @@
+#include "startup.h"
+#include <assert.h>
+#include <log/log.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../internal.h"
+
+// --- Constants ---
+
+constexpr int    MAX_TIMERS  = 128;
+constexpr size_t NAME_LENGTH = 48;
+constexpr size_t LINE_LENGTH = 256;
+
+static const char TOTAL_NAME[] = "Total";
+
+// --- Types ---
+
+typedef struct startup_Timer {
+  char   name[NAME_LENGTH];
+  int    depth;  // Nesting, so the report can show what each stage was made of
+  double start;  // Seconds since the first timer began
+  double seconds;
+} startup_Timer;
+
+// --- Global state ---
+
+static struct {
+  startup_Timer timers[MAX_TIMERS];
+  int           timerCount;
+  int           depth;
+  double        origin;
+  double        total;
+  bool          isFinished;
+} g_startup;
+
+// --- Helper functions ---
+
+static int addTimer(const char* format, va_list args) {
+  if (g_startup.isFinished) return -1;
+  if (g_startup.timerCount == MAX_TIMERS) {
+    LOG_WARN(game_log, "Too many startup timers");
+    return -1;
+  }
+  if (g_startup.timerCount == 0) g_startup.origin = startup_getTime();
+
+  startup_Timer* timer = &g_startup.timers[g_startup.timerCount];
+  vsnprintf(timer->name, NAME_LENGTH, format, args);
+  timer->depth   = g_startup.depth;
+  timer->start   = startup_getTime() - g_startup.origin;
+  timer->seconds = 0.0;
+  return g_startup.timerCount++;
+}
+
+static int compareSeconds(const void* a, const void* b) {
+  double secondsA = (*(const startup_Timer* const*) a)->seconds;
+  double secondsB = (*(const startup_Timer* const*) b)->seconds;
+  return (secondsA < secondsB) - (secondsA > secondsB);
+}
+
+static const startup_Timer* findTimer(const char* name) {
+  for (int i = 0; i < g_startup.timerCount; i++) {
+    if (strcmp(g_startup.timers[i].name, name) == 0) return &g_startup.timers[i];
+  }
+  return nullptr;
+}
+
+static char* trim(char* string) {
+  while (*string == ' ' || *string == '\t') string++;
+  char* end = string + strlen(string);
+  while (end > string && strchr(" \t\r\n", end[-1]) != nullptr) *--end = '\0';
+  return string;
+}
+
+// Names are ours, so only quotes and backslashes need escaping
+static void writeString(FILE* file, const char* string) {
+  fputc('"', file);
+  for (const char* c = string; *c; c++) {
+    if (*c == '"' || *c == '\\') fputc('\\', file);
+    fputc(*c, file);
+  }
+  fputc('"', file);
+}
+
+// --- Startup functions ---
+
+// Times a part of startup until startup_end(), timers nest, nothing is recorded once startup has finished
+int startup_begin(const char* format, ...) {
+  assert(format != nullptr);
+
+  va_list args;
+  va_start(args, format);
+  int timer = addTimer(format, args);
+  va_end(args);
+
+  if (timer != -1) g_startup.depth++;
+  return timer;
+}
+
+void startup_end(int timer) {
+  if (timer == -1) return;
+  assert(timer >= 0 && timer < g_startup.timerCount);
+
+  g_startup.timers[timer].seconds = startup_getTime() - g_startup.origin - g_startup.timers[timer].start;
+  g_startup.depth--;
+}
+
+// For work timed elsewhere, e.g. on another thread
+void startup_add(double seconds, const char* format, ...) {
+  assert(format != nullptr);
+
+  va_list args;
+  va_start(args, format);
+  int timer = addTimer(format, args);
+  va_end(args);
+
+  if (timer != -1) g_startup.timers[timer].seconds = seconds;
+}
+
+// Our own clock, as options are read before the engine is up, safe to call from any thread
+double startup_getTime(void) {
+  struct timespec now;
+  timespec_get(&now, TIME_UTC);
+  return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+void startup_finish(void) {
+  if (g_startup.isFinished) return;
+  g_startup.total      = g_startup.timerCount > 0 ? startup_getTime() - g_startup.origin : 0.0;
+  g_startup.isFinished = true;
+}
+
+double startup_getTotal(void) { return g_startup.total; }
+
+// Slowest first, nested timers are included so a slow stage can be traced to what it was doing
+void startup_report(void) {
+  const startup_Timer* sorted[MAX_TIMERS];
+  for (int i = 0; i < g_startup.timerCount; i++) sorted[i] = &g_startup.timers[i];
+  qsort(sorted, g_startup.timerCount, sizeof(sorted[0]), compareSeconds);
+
+  LOG_INFO(game_log, "Startup took %.1f ms", g_startup.total * 1000.0);
+  for (int i = 0; i < g_startup.timerCount; i++) {
+    LOG_INFO(game_log, "%8.2f ms  %*s%s", sorted[i]->seconds * 1000.0, sorted[i]->depth * 2, "", sorted[i]->name);
+  }
+}
+
+// Timers in the order they started, for comparing runs with tools
+bool startup_writeJSON(const char* file) {
+  assert(file != nullptr);
+
+  FILE* out = fopen(file, "w");
+  if (out == nullptr) {
+    LOG_ERROR(game_log, "Failed to open %s for writing", file);
+    return false;
+  }
+
+  fprintf(out, "{\n  \"total_ms\": %.3f,\n  \"stages\": [\n", g_startup.total * 1000.0);
+  for (int i = 0; i < g_startup.timerCount; i++) {
+    const startup_Timer* timer = &g_startup.timers[i];
+    fputs("    { \"name\": ", out);
+    writeString(out, timer->name);
+    fprintf(
+        out,
+        ", \"depth\": %d, \"start_ms\": %.3f, \"ms\": %.3f }%s\n",
+        timer->depth,
+        timer->start * 1000.0,
+        timer->seconds * 1000.0,
+        i + 1 < g_startup.timerCount ? "," : ""
+    );
+  }
+  fputs("  ]\n}\n", out);
+
+  if (fclose(out) != 0) {
+    LOG_ERROR(game_log, "Failed to write %s", file);
+    return false;
+  }
+  LOG_INFO(game_log, "Startup report written to %s", file);
+  return true;
+}
+
+// Each line is "name = milliseconds", "Total" limits the whole of startup, # starts a comment
+bool startup_checkBudget(const char* file) {
+  assert(file != nullptr);
+
+  FILE* in = fopen(file, "r");
+  if (in == nullptr) {
+    LOG_ERROR(game_log, "Failed to open startup budget %s", file);
+    return false;
+  }
+
+  bool isWithin = true;
+  int  lineNum  = 0;
+  char line[LINE_LENGTH];
+  while (fgets(line, sizeof(line), in) != nullptr) {
+    lineNum++;
+    char* hash = strchr(line, '#');
+    if (hash != nullptr) *hash = '\0';
+    char* equals = strrchr(line, '=');
+    if (equals == nullptr) {
+      if (*trim(line) != '\0') LOG_WARN(game_log, "Syntax error in %s line %d", file, lineNum);
+      continue;
+    }
+
+    *equals       = '\0';
+    char*  name   = trim(line);
+    char*  end    = nullptr;
+    double budget = strtod(equals + 1, &end) / 1000.0;
+    if (end == equals + 1 || *trim(end) != '\0') {
+      LOG_WARN(game_log, "Syntax error in %s line %d", file, lineNum);
+      continue;
+    }
+
+    double seconds = 0.0;
+    if (strcmp(name, TOTAL_NAME) == 0) {
+      seconds = g_startup.total;
+    } else {
+      const startup_Timer* timer = findTimer(name);
+      if (timer == nullptr) {
+        LOG_WARN(game_log, "Startup budget for %s, which was not timed", name);
+        continue;
+      }
+      seconds = timer->seconds;
+    }
+
+    if (seconds > budget) {
+      LOG_ERROR(game_log, "%s took %.2f ms, over its %.2f ms budget", name, seconds * 1000.0, budget * 1000.0);
+      isWithin = false;
+    }
+  }
+  fclose(in);
+
+  if (isWithin) LOG_INFO(game_log, "Startup within budget %s", file);
+  return isWithin;
+}
@@ -0,0 +1,14 @@
+// clang-format Language: C
+#pragma once
+
+// --- Startup functions ---
+
+int    startup_begin(const char* format, ...);
+void   startup_end(int timer);
+void   startup_add(double seconds, const char* format, ...);
+double startup_getTime(void);
+void   startup_finish(void);
+double startup_getTotal(void);
+void   startup_report(void);
+bool   startup_writeJSON(const char* file);
+bool   startup_checkBudget(const char* file);
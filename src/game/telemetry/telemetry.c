@@ -0,0 +1,284 @@
+#include "telemetry.h"
+#include <assert.h>
+#include <errno.h>
+#include <log/log.h>
+#include <raylib.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../internal.h"
+#include "../ring/ring.h"
+
+#if !defined(__EMSCRIPTEN__)
+#define TELEMETRY_THREAD
+#include <pthread.h>
+#if defined(_WIN32)
+#include <direct.h>
+#include <process.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#endif
+
+// --- Constants ---
+
+constexpr unsigned   RING_SIZE      = 65536;  // Events, power of two, 1 MiB covers a segment being compressed
+constexpr int        MAX_RINGS      = 4;      // Threads that can record events, any others are dropped
+constexpr int        SEGMENT_EVENTS = 65536;  // 1 MiB before compression
+constexpr size_t     PATH_LENGTH    = 1024;
+static const char    SEGMENT_FILE[] = "%s/%lld-%d-%06d.mdt";  // Directory, session, process and sequence
+static const double  FLUSH_INTERVAL = 0.01;  // Between draining the rings
+static const int     SEGMENT_AGE    = 30;    // Seconds a part filled segment waits before it is written anyway
+
+// --- Global state ---
+
+atomic_bool g_isTelemetryOn;
+
+// The rings live for the whole session, as threads keep pointers to the ones they claimed, but their events are only
+// allocated while telemetry is on. Each ring's producer is the thread that claimed it, the consumer the flush thread.
+static struct {
+  telemetry_Event* events;  // MAX_RINGS rings of RING_SIZE
+  ring_Ring        rings[MAX_RINGS];
+  atomic_int       ringCount;
+  atomic_uint      dropped;
+  uint32_t         run;  // Numbered and timed by the simulation
+  double           runStart;
+  telemetry_Event* segment;  // Owned by the flush thread
+  int              segmentCount;
+  int              sequence;
+  time_t           segmentStart;
+  long long        session;
+  const char*      dir;
+#if defined(TELEMETRY_THREAD)
+  pthread_t   thread;
+  atomic_bool isQuitting;
+  bool        isRunning;
+#endif
+} g_telemetry;
+
+static thread_local ring_Ring* t_ring;
+static thread_local bool       t_hasClaimed;
+
+// --- Helper functions ---
+
+// For the fields where 0xff means none, which negative values are stored as. Real values have to fit below it.
+static inline uint8_t toByte(int value) {
+  assert(value <= UINT8_MAX);
+  return value >= 0 ? value : UINT8_MAX;
+}
+
+// Every byte is a level, so there's no sentinel to fall back on
+static inline uint8_t toLevel(int level) {
+  static_assert(MAX_LEVELS <= UINT8_MAX + 1);
+  assert(level >= 0 && level < MAX_LEVELS);
+  return level;
+}
+
+static ring_Ring* claimRing(void) {
+  t_hasClaimed = true;
+  int ring     = atomic_fetch_add_explicit(&g_telemetry.ringCount, 1, memory_order_relaxed);
+  if (ring >= MAX_RINGS) {
+    LOG_WARN(game_log, "Too many threads recording telemetry, dropping this one's events");
+    return nullptr;
+  }
+  return &g_telemetry.rings[ring];
+}
+
+#if defined(TELEMETRY_THREAD)
+static void freeBuffers(void) {
+  free(g_telemetry.segment);
+  free(g_telemetry.events);
+  g_telemetry.segment = nullptr;
+  g_telemetry.events  = nullptr;
+}
+
+// Stored as is when it won't compress, or when compression isn't built into raylib
+static void writeSegment(void) {
+  if (g_telemetry.segmentCount == 0) return;
+
+  int            size           = g_telemetry.segmentCount * (int) sizeof(telemetry_Event);
+  int            compressedSize = 0;
+  unsigned char* compressed     = CompressData((const unsigned char*) g_telemetry.segment, size, &compressedSize);
+  bool           isCompressed   = compressed != nullptr && compressedSize > 0 && compressedSize < size;
+
+  telemetry_SegmentHeader header = {
+    .version     = TELEMETRY_VERSION,
+    .eventSize   = sizeof(telemetry_Event),
+    .eventCount  = g_telemetry.segmentCount,
+    .compression = isCompressed ? TELEMETRY_DEFLATE : TELEMETRY_STORED,
+    .dataSize    = isCompressed ? compressedSize : size
+  };
+  memcpy(header.magic, TELEMETRY_MAGIC, sizeof(header.magic));
+  const void* data = isCompressed ? (const void*) compressed : (const void*) g_telemetry.segment;
+
+  char path[PATH_LENGTH];
+  snprintf(path, sizeof(path), SEGMENT_FILE, g_telemetry.dir, g_telemetry.session, getpid(), g_telemetry.sequence++);
+  FILE* stream    = fopen(path, "wb");
+  bool  isWritten = stream != nullptr && fwrite(&header, sizeof(header), 1, stream) == 1 &&
+                   fwrite(data, header.dataSize, 1, stream) == 1;
+  if (stream != nullptr && fclose(stream) != 0) isWritten = false;
+  if (!isWritten) LOG_ERROR(game_log, "Failed to write telemetry segment %s", path);
+
+  MemFree(compressed);
+  g_telemetry.segmentCount = 0;
+}
+
+static inline bool isEarlier(const telemetry_Event* a, const telemetry_Event* b) {
+  return a->run != b->run ? a->run < b->run : a->time < b->time;
+}
+
+// Each ring is already in time order, so taking the earliest of their first events each time merges the threads'
+// events in time order. Gives back what it has copied before writing a full segment, so the game can carry on filling
+// the rings.
+static void drainRings(void) {
+  int ringCount = atomic_load_explicit(&g_telemetry.ringCount, memory_order_relaxed);
+  ringCount     = MIN(ringCount, MAX_RINGS);
+
+  unsigned counts[MAX_RINGS] = {};
+  unsigned taken[MAX_RINGS]  = {};
+  for (int i = 0; i < ringCount; i++) counts[i] = ring_getCount(&g_telemetry.rings[i]);
+
+  for (;;) {
+    const telemetry_Event* earliest = nullptr;
+    int                    ring     = -1;
+    for (int i = 0; i < ringCount; i++) {
+      if (taken[i] == counts[i]) continue;
+      const telemetry_Event* event = ring_get(&g_telemetry.rings[i], taken[i]);
+      if (earliest == nullptr || isEarlier(event, earliest)) {
+        earliest = event;
+        ring     = i;
+      }
+    }
+    if (earliest == nullptr) break;
+
+    if (g_telemetry.segmentCount == 0) g_telemetry.segmentStart = time(nullptr);
+    g_telemetry.segment[g_telemetry.segmentCount++] = *earliest;
+    taken[ring]++;
+    if (g_telemetry.segmentCount == SEGMENT_EVENTS) {
+      for (int i = 0; i < ringCount; i++) {
+        ring_release(&g_telemetry.rings[i], taken[i]);
+        counts[i] -= taken[i];
+        taken[i]   = 0;
+      }
+      writeSegment();
+    }
+  }
+  for (int i = 0; i < ringCount; i++) ring_release(&g_telemetry.rings[i], taken[i]);
+}
+
+// Compresses and writes behind the game, which only ever copies an event into its ring
+static void* flushThread([[maybe_unused]] void* arg) {
+  static const struct timespec INTERVAL = { .tv_nsec = (long) (FLUSH_INTERVAL * 1e9) };
+
+  while (!atomic_load_explicit(&g_telemetry.isQuitting, memory_order_acquire)) {
+    drainRings();
+    if (g_telemetry.segmentCount > 0 && time(nullptr) - g_telemetry.segmentStart >= SEGMENT_AGE) writeSegment();
+    nanosleep(&INTERVAL, nullptr);
+  }
+  drainRings();
+  writeSegment();
+  return nullptr;
+}
+
+static bool makeDir(const char* dir) {
+#if defined(_WIN32)
+  return _mkdir(dir) == 0 || errno == EEXIST;
+#else
+  return mkdir(dir, 0755) == 0 || errno == EEXIST;
+#endif
+}
+#endif
+
+// --- Telemetry functions ---
+
+// Writes segments into the directory until telemetry_close(), on its own thread
+bool telemetry_open(const char* dir) {
+  assert(dir != nullptr);
+#if defined(TELEMETRY_THREAD)
+  assert(!g_telemetry.isRunning);
+
+  if (!makeDir(dir)) {
+    LOG_ERROR(game_log, "Unable to create telemetry directory %s", dir);
+    return false;
+  }
+  g_telemetry.segment = malloc(SEGMENT_EVENTS * sizeof(telemetry_Event));
+  g_telemetry.events  = malloc(MAX_RINGS * RING_SIZE * sizeof(telemetry_Event));
+  if (g_telemetry.segment == nullptr || g_telemetry.events == nullptr) {
+    LOG_ERROR(game_log, "Failed to allocate telemetry buffers");
+    freeBuffers();
+    return false;
+  }
+  for (int i = 0; i < MAX_RINGS; i++) {
+    ring_init(&g_telemetry.rings[i], g_telemetry.events + i * RING_SIZE, sizeof(telemetry_Event), RING_SIZE);
+  }
+  g_telemetry.dir     = dir;
+  g_telemetry.session = time(nullptr);
+  atomic_store(&g_telemetry.isQuitting, false);
+  g_telemetry.isRunning = pthread_create(&g_telemetry.thread, nullptr, flushThread, nullptr) == 0;
+  if (!g_telemetry.isRunning) {
+    LOG_ERROR(game_log, "Failed to start the telemetry thread");
+    freeBuffers();
+    return false;
+  }
+
+  atomic_store_explicit(&g_isTelemetryOn, true, memory_order_release);
+  LOG_INFO(game_log, "Writing telemetry to %s", dir);
+  return true;
+#else
+  LOG_WARN(game_log, "Telemetry isn't supported on this platform");
+  return false;
+#endif
+}
+
+// Copies the event into the calling thread's ring, dropping it rather than waiting if the ring is full
+void telemetry_record(telemetry_Type type, int subject, int detail, game_Tile tile) {
+  assert(type >= 0 && type < TELEMETRY_TYPE_COUNT);
+
+  if (type == TELEMETRY_RUN_START) {
+    g_telemetry.run++;
+    g_telemetry.runStart = game_getTime();
+  }
+  if (t_ring == nullptr && (t_hasClaimed || (t_ring = claimRing()) == nullptr)) {
+    atomic_fetch_add_explicit(&g_telemetry.dropped, 1, memory_order_relaxed);
+    return;
+  }
+
+  telemetry_Event* event = ring_claim(t_ring);
+  if (event == nullptr) {
+    atomic_fetch_add_explicit(&g_telemetry.dropped, 1, memory_order_relaxed);
+    return;
+  }
+
+  *event = (telemetry_Event) {
+    .time       = game_getTime() - g_telemetry.runStart,
+    .run        = g_telemetry.run,
+    .type       = type,
+    .subject    = toByte(subject),
+    .detail     = toByte(detail),
+    .level      = toLevel(game_getLevel()),
+    .difficulty = toByte(game_getDifficulty()),
+    .col        = toByte(tile.col),
+    .row        = toByte(tile.row)
+  };
+  ring_publish(t_ring);
+}
+
+// Call once every thread has stopped recording, writes the last segment
+void telemetry_close(void) {
+#if defined(TELEMETRY_THREAD)
+  if (!g_telemetry.isRunning) return;
+
+  atomic_store_explicit(&g_isTelemetryOn, false, memory_order_relaxed);
+  atomic_store_explicit(&g_telemetry.isQuitting, true, memory_order_release);
+  pthread_join(g_telemetry.thread, nullptr);
+  g_telemetry.isRunning = false;
+  freeBuffers();
+
+  unsigned dropped = atomic_load(&g_telemetry.dropped);
+  if (dropped > 0) LOG_WARN(game_log, "%u telemetry events were dropped", dropped);
+  LOG_INFO(game_log, "Wrote %d telemetry segments", g_telemetry.sequence);
+#endif
+}
@@ -0,0 +1,31 @@
+// clang-format Language: C
+#pragma once
+
+#include <stdatomic.h>
+#include <telemetry/format.h>
+#include "../internal.h"
+
+// --- Helper macros ---
+
+// The arguments are only evaluated while telemetry is on, so while off an event costs one predictable branch
+#define TELEMETRY_EVENT(type, subject, detail, tile)                            \
+  do {                                                                          \
+    if (telemetry_isOn()) telemetry_record((type), (subject), (detail), (tile)); \
+  } while (0)
+
+// --- Constants ---
+
+static const game_Tile TELEMETRY_NOWHERE = { -1, -1 };
+
+// --- Global state ---
+
+extern atomic_bool g_isTelemetryOn;
+
+// --- Telemetry functions ---
+
+// Acquire, so a thread that sees telemetry on also sees the rings it records into
+static inline bool telemetry_isOn(void) { return atomic_load_explicit(&g_isTelemetryOn, memory_order_acquire); }
+
+bool telemetry_open(const char* dir);
+void telemetry_record(telemetry_Type type, int subject, int detail, game_Tile tile);
+void telemetry_close(void);
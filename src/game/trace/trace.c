@@ -0,0 +1,248 @@
+#include "trace.h"
+#include <assert.h>
+#include <log/log.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../internal.h"
+#include "../ring/ring.h"
+
+#if defined(TRACE_SITES) && !defined(__EMSCRIPTEN__)
+#define TRACE_THREAD
+#include <pthread.h>
+#endif
+
+// --- Constants ---
+
+constexpr unsigned  RING_SIZE      = 8192;  // Records, power of two, plenty for the 10 ms between drains
+constexpr int       MAX_RINGS      = 4;     // Threads that can trace, any others are dropped
+constexpr size_t    MESSAGE_LENGTH = 512;
+constexpr size_t    SPEC_LENGTH    = 32;
+static const char   SPEC_FLAGS[]   = "-+ #0123456789.";  // Kept as written, along with width and precision
+static const char   SPEC_LENGTHS[] = "hljztL";           // Replaced to suit the recorded value
+static const double FLUSH_INTERVAL = 0.01;               // Between draining the rings
+
+// --- Types ---
+
+typedef struct trace_Record {
+  const trace_Site* site;
+  double            time;
+  int               count;
+  trace_Value       values[TRACE_MAX_ARGS];
+} trace_Record;
+
+// --- Global state ---
+
+atomic_bool g_isTraceOn;
+
+// Each ring's producer is the thread that claimed it, the consumer the format thread, as with telemetry. The records
+// are only allocated while tracing.
+static struct {
+  trace_Record* records;  // MAX_RINGS rings of RING_SIZE
+  ring_Ring     rings[MAX_RINGS];
+  atomic_int    ringCount;
+  atomic_uint   dropped;
+  FILE*         stream;   // Owned by the format thread
+  long long     written;  // Lines
+#if defined(TRACE_THREAD)
+  pthread_t   thread;
+  atomic_bool isQuitting;
+  bool        isRunning;
+#endif
+} g_trace;
+
+static thread_local ring_Ring* t_ring;
+static thread_local bool       t_hasClaimed;
+
+// --- Helper functions ---
+
+static ring_Ring* claimRing(void) {
+  t_hasClaimed = true;
+  int ring     = atomic_fetch_add_explicit(&g_trace.ringCount, 1, memory_order_relaxed);
+  if (ring >= MAX_RINGS) {
+    LOG_WARN(game_log, "Too many threads tracing, dropping this one's records");
+    return nullptr;
+  }
+  return &g_trace.rings[ring];
+}
+
+#if defined(TRACE_THREAD)
+static void freeRecords(void) {
+  free(g_trace.records);
+  g_trace.records = nullptr;
+}
+
+// As printf would, taking each conversion's argument from the record rather than a va_list
+static void formatMessage(const trace_Record* record, char* message, size_t size) {
+  const char* format = record->site->format;
+  size_t      length = 0;
+  int         arg    = 0;
+
+  while (*format != '\0' && length + 1 < size) {
+    if (*format != '%' || format[1] == '%') {
+      message[length++] = *format;
+      format += *format == '%' ? 2 : 1;
+      continue;
+    }
+
+    char   spec[SPEC_LENGTH] = "%";
+    size_t specLength        = 1;
+    for (format++; *format != '\0' && strchr(SPEC_FLAGS, *format) != nullptr; format++) {
+      if (specLength < SPEC_LENGTH - 4) spec[specLength++] = *format;
+    }
+    while (*format != '\0' && strchr(SPEC_LENGTHS, *format) != nullptr) format++;
+    char conversion = *format;
+    if (conversion == '\0' || arg == record->count) break;
+    format++;
+
+    trace_Value value   = record->values[arg++];
+    bool        isWhole = strchr("diuoxX", conversion) != nullptr;
+    snprintf(spec + specLength, sizeof(spec) - specLength, "%s%c", isWhole ? "ll" : "", conversion);
+
+    char* end       = message + length;
+    int   remaining = (int) (size - length);
+    int   written   = 0;
+    switch (conversion) {
+      case 'd':
+      case 'i': written = snprintf(end, remaining, spec, (long long) value.i); break;
+      case 'u':
+      case 'o':
+      case 'x':
+      case 'X': written = snprintf(end, remaining, spec, (unsigned long long) value.i); break;
+      case 'c': written = snprintf(end, remaining, spec, (int) value.i); break;
+      case 'f':
+      case 'F':
+      case 'e':
+      case 'E':
+      case 'g':
+      case 'G':
+      case 'a':
+      case 'A': written = snprintf(end, remaining, spec, value.f); break;
+      case 's': written = snprintf(end, remaining, spec, value.s != nullptr ? value.s : "(null)"); break;
+      default: written = snprintf(end, remaining, "?"); break;
+    }
+    if (written < 0) break;
+    length = MIN(length + written, size - 1);
+  }
+  message[length] = '\0';
+}
+
+static void drainRing(ring_Ring* ring) {
+  char     message[MESSAGE_LENGTH];
+  unsigned count = ring_getCount(ring);
+  for (unsigned i = 0; i < count; i++) {
+    const trace_Record* record = ring_get(ring, i);
+    formatMessage(record, message, sizeof(message));
+    fprintf(g_trace.stream, "%.4f %s:%d %s\n", record->time, record->site->file, record->site->line, message);
+    g_trace.written++;
+  }
+  ring_release(ring, count);
+}
+
+static void drainRings(void) {
+  int ringCount = atomic_load_explicit(&g_trace.ringCount, memory_order_relaxed);
+  ringCount     = MIN(ringCount, MAX_RINGS);
+  for (int i = 0; i < ringCount; i++) drainRing(&g_trace.rings[i]);
+  fflush(g_trace.stream);
+}
+
+// Does all the formatting and writing, the game only ever copies a site's arguments into its ring
+static void* formatThread([[maybe_unused]] void* arg) {
+  static const struct timespec INTERVAL = { .tv_nsec = (long) (FLUSH_INTERVAL * 1e9) };
+
+  while (!atomic_load_explicit(&g_trace.isQuitting, memory_order_acquire)) {
+    drainRings();
+    nanosleep(&INTERVAL, nullptr);
+  }
+  drainRings();
+  return nullptr;
+}
+#endif
+
+// --- Trace functions ---
+
+// Writes every TRACE() to the file until trace_close(), on its own thread
+bool trace_open([[maybe_unused]] const char* file) {
+  assert(file != nullptr);
+#if defined(TRACE_THREAD)
+  assert(!g_trace.isRunning);
+
+  g_trace.records = malloc(MAX_RINGS * RING_SIZE * sizeof(trace_Record));
+  if (g_trace.records == nullptr) {
+    LOG_ERROR(game_log, "Failed to allocate trace rings");
+    return false;
+  }
+  g_trace.stream = fopen(file, "w");
+  if (g_trace.stream == nullptr) {
+    LOG_ERROR(game_log, "Unable to open trace file %s", file);
+    freeRecords();
+    return false;
+  }
+  for (int i = 0; i < MAX_RINGS; i++) {
+    ring_init(&g_trace.rings[i], g_trace.records + i * RING_SIZE, sizeof(trace_Record), RING_SIZE);
+  }
+  atomic_store(&g_trace.isQuitting, false);
+  g_trace.isRunning = pthread_create(&g_trace.thread, nullptr, formatThread, nullptr) == 0;
+  if (!g_trace.isRunning) {
+    LOG_ERROR(game_log, "Failed to start the trace thread");
+    fclose(g_trace.stream);
+    g_trace.stream = nullptr;
+    freeRecords();
+    return false;
+  }
+
+  atomic_store_explicit(&g_isTraceOn, true, memory_order_release);
+  LOG_INFO(game_log, "Writing trace to %s", file);
+  return true;
+#elif !defined(TRACE_SITES)
+  LOG_WARN(game_log, "Release builds have no trace sites, configure with GAME_TRACE to use them");
+  return false;
+#else
+  LOG_WARN(game_log, "Tracing isn't supported on this platform");
+  return false;
+#endif
+}
+
+// Copies the site and its arguments into the calling thread's ring, dropping them rather than waiting if it's full
+void trace_record(const trace_Site* site, const trace_Value values[], int count) {
+  assert(site != nullptr);
+  assert(count >= 0 && count <= TRACE_MAX_ARGS);
+
+  if (t_ring == nullptr && (t_hasClaimed || (t_ring = claimRing()) == nullptr)) {
+    atomic_fetch_add_explicit(&g_trace.dropped, 1, memory_order_relaxed);
+    return;
+  }
+
+  trace_Record* record = ring_claim(t_ring);
+  if (record == nullptr) {
+    atomic_fetch_add_explicit(&g_trace.dropped, 1, memory_order_relaxed);
+    return;
+  }
+
+  record->site  = site;
+  record->time  = game_getTime();
+  record->count = count;
+  memcpy(record->values, values, count * sizeof(trace_Value));
+  ring_publish(t_ring);
+}
+
+// Call once every thread has stopped tracing, writes what's left
+void trace_close(void) {
+#if defined(TRACE_THREAD)
+  if (!g_trace.isRunning) return;
+
+  atomic_store_explicit(&g_isTraceOn, false, memory_order_relaxed);
+  atomic_store_explicit(&g_trace.isQuitting, true, memory_order_release);
+  pthread_join(g_trace.thread, nullptr);
+  g_trace.isRunning = false;
+  if (fclose(g_trace.stream) != 0) LOG_ERROR(game_log, "Failed to write trace file");
+  g_trace.stream = nullptr;
+  freeRecords();
+
+  unsigned dropped = atomic_load(&g_trace.dropped);
+  if (dropped > 0) LOG_WARN(game_log, "%u trace records were dropped", dropped);
+  LOG_INFO(game_log, "Wrote %lld trace lines", g_trace.written);
+#endif
+}
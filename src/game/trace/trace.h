@@ -0,0 +1,109 @@
+// clang-format Language: C
+#pragma once
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+// Hot paths trace with TRACE() rather than LOG_TRACE(). A site only records its ID and raw arguments, they're formatted
+// on a background thread into the --trace file. Debug builds always have the sites, release builds only when built
+// with GAME_TRACE, otherwise they compile to nothing.
+
+#if !defined(NDEBUG) || defined(GAME_TRACE)
+#define TRACE_SITES
+#endif
+
+// --- Constants ---
+
+constexpr int TRACE_MAX_ARGS = 8;
+
+// --- Types ---
+
+// One per call site, its address is the site's ID
+typedef struct trace_Site {
+  const char* file;
+  int         line;
+  const char* format;
+} trace_Site;
+
+// Taken as whichever its conversion in the format asks for. Strings aren't copied, so must be literals or the game's
+// string tables.
+typedef union trace_Value {
+  int64_t     i;
+  double      f;
+  const char* s;
+} trace_Value;
+
+// --- Helper functions ---
+
+static inline trace_Value trace_int(int64_t value) { return (trace_Value) { .i = value }; }
+static inline trace_Value trace_float(double value) { return (trace_Value) { .f = value }; }
+static inline trace_Value trace_string(const char* value) { return (trace_Value) { .s = value }; }
+
+// Never called, it has the compiler check the format against the arguments as it would LOG_TRACE()'s
+[[gnu::format(printf, 1, 2)]] static inline void trace_checkFormat([[maybe_unused]] const char* format, ...) {}
+
+// --- Helper macros ---
+
+// Anything but a number or a string is a compile error, rather than being traced as an integer
+#define TRACE_VALUE(x)               \
+  _Generic((x),                      \
+      bool: trace_int,               \
+      char: trace_int,               \
+      signed char: trace_int,        \
+      unsigned char: trace_int,      \
+      short: trace_int,              \
+      unsigned short: trace_int,     \
+      int: trace_int,                \
+      unsigned: trace_int,           \
+      long: trace_int,               \
+      unsigned long: trace_int,      \
+      long long: trace_int,          \
+      unsigned long long: trace_int, \
+      float: trace_float,            \
+      double: trace_float,           \
+      char*: trace_string,           \
+      const char*: trace_string)(x)
+
+#define TRACE_COUNT_(_1, _2, _3, _4, _5, _6, _7, _8, count, ...) count
+#define TRACE_COUNT(...) TRACE_COUNT_(__VA_ARGS__ __VA_OPT__(, ) 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+#define TRACE_VALUES_0()
+#define TRACE_VALUES_1(a) TRACE_VALUE(a)
+#define TRACE_VALUES_2(a, ...) TRACE_VALUE(a), TRACE_VALUES_1(__VA_ARGS__)
+#define TRACE_VALUES_3(a, ...) TRACE_VALUE(a), TRACE_VALUES_2(__VA_ARGS__)
+#define TRACE_VALUES_4(a, ...) TRACE_VALUE(a), TRACE_VALUES_3(__VA_ARGS__)
+#define TRACE_VALUES_5(a, ...) TRACE_VALUE(a), TRACE_VALUES_4(__VA_ARGS__)
+#define TRACE_VALUES_6(a, ...) TRACE_VALUE(a), TRACE_VALUES_5(__VA_ARGS__)
+#define TRACE_VALUES_7(a, ...) TRACE_VALUE(a), TRACE_VALUES_6(__VA_ARGS__)
+#define TRACE_VALUES_8(a, ...) TRACE_VALUE(a), TRACE_VALUES_7(__VA_ARGS__)
+#define TRACE_VALUES(...) TRACE_CONCAT(TRACE_VALUES_, TRACE_COUNT(__VA_ARGS__))(__VA_ARGS__)
+
+// The arguments are only evaluated while tracing, and the whole site is gone from builds without them
+#if defined(TRACE_SITES)
+#define TRACE(format, ...)                                                               \
+  do {                                                                                   \
+    static const trace_Site TRACE_SITE = { __FILE__, __LINE__, format };                 \
+    if (false) trace_checkFormat(format __VA_OPT__(, ) __VA_ARGS__);                     \
+    if (atomic_load_explicit(&g_isTraceOn, memory_order_relaxed)) {                      \
+      const trace_Value traceValues[] = { TRACE_VALUES(__VA_ARGS__) __VA_OPT__(, ) {} }; \
+      trace_record(&TRACE_SITE, traceValues, TRACE_COUNT(__VA_ARGS__));                  \
+    }                                                                                    \
+  } while (0)
+#else
+#define TRACE(format, ...)                                           \
+  do {                                                               \
+    if (false) trace_checkFormat(format __VA_OPT__(, ) __VA_ARGS__); \
+  } while (0)
+#endif
+
+// --- Global state ---
+
+extern atomic_bool g_isTraceOn;
+
+// --- Trace functions ---
+
+bool trace_open(const char* file);
+void trace_record(const trace_Site* site, const trace_Value values[], int count);
+void trace_close(void);
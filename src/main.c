@@ -3,17 +3,40 @@
 #include <engine/engine.h>
 #include <game/game.h>
 #include <log/log.h>
+#include <string.h>
+#include <time.h>
+#include "game/audio/audio.h"
+#include "game/flight/flight.h"
+#include "game/leaderboard/leaderboard.h"
+#include "game/metrics/metrics.h"
 #include "game/options/options.h"
+#include "game/render/render.h"
+#include "game/replay/replay.h"
+#include "game/save/save.h"
+#include "game/soak/soak.h"
+#include "game/splits/splits.h"
+#include "game/startup/startup.h"
+#include "game/telemetry/telemetry.h"
+#include "game/trace/trace.h"
 
 #if defined(__EMSCRIPTEN__)
 #include <emscripten/emscripten.h>
 #endif
 
+#if defined(GAME_PIPELINED)
+#include <pthread.h>
+#endif
+
+#if !defined(__EMSCRIPTEN__)
+#include "game/capture/capture.h"
+#endif
+
 // --- Constants ---
 
-static const char* WINDOW_TITLE   = "Mythic Dash";
-static const int   ORG_SCR_WIDTH  = 480;  // Base canvas size
-static const int   ORG_SCR_HEIGHT = 270;
+static const char*  WINDOW_TITLE   = "Mythic Dash";
+static const int    ORG_SCR_WIDTH  = 480;  // Base canvas size
+static const int    ORG_SCR_HEIGHT = 270;
+static const double IDLE_WAIT      = 0.05;  // Static screens still need waking often enough to keep music streaming
 
 static const log_Config LOG_CONFIG = {
   .minLevel      = LOG_LEVEL_DEBUG,
@@ -23,18 +46,49 @@ static const log_Config LOG_CONFIG = {
   .subsystem     = "MAIN"
 };
 
+static const char USAGE[] =
+    "Usage: mythic-dash [--record FILE] [--replay FILE [--capture VIDEO.y4m|DIRECTORY] [--mix AUDIO.wav]] "
+    "[--startup-report FILE.json] [--startup-budget FILE] [--leaderboard [HOST:]PORT] "
+    "[--telemetry DIRECTORY] [--trace FILE] [--metrics [HOST:]PORT|SOCKET] [--soak HOURS [--soak-report FILE.csv]] "
+    "[--splits DIRECTORY]";
+
+// --- Types ---
+
+typedef struct Arguments {
+  const char* recordFile;
+  const char* replayFile;
+  const char* captureOutput;
+  const char* mixOutput;
+  const char* startupReport;
+  const char* startupBudget;  // Checks startup against it, then exits
+  const char* leaderboard;
+  const char* telemetryDir;
+  const char* traceFile;
+  const char* metricsAddress;
+  const char* soakHours;  // Plays itself for this long, then exits
+  const char* soakReport;
+  const char* splitsDir;
+} Arguments;
+
 // --- Global state ---
 
 double g_previousTime;
 
-// --- Helper Functions ---
+#if defined(GAME_PIPELINED)
+static struct {
+  pthread_t       thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t  cond;
+  bool            hasWork;
+  bool            isQuitting;
+  double          delta;
+} g_sim = { .mutex = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER };
+#endif
 
-void mainLoop(void) {
-  game_input();
+// --- Helper Functions ---
 
-  double now     = engine_getTime();
-  double delta   = now - g_previousTime;
-  g_previousTime = now;
+static void update(double delta) {
+  double start = engine_getTime();
   if (game_getDifficulty() == DIFFICULTY_ARCADE) {
     g_accumulator += delta;
     while (g_accumulator >= FRAME_TIME) {
@@ -44,22 +98,258 @@ void mainLoop(void) {
   } else {
     game_update(delta);
   }
+  audio_flushEvents();
+  metrics_addTime(METRICS_UPDATE_TIME, engine_getTime() - start);
+}
 
+// Nothing is drawn, so poll input ourselves and sleep rather than spinning on an unchanged frame
+static void idle(void) {
+  PollInputEvents();
+#if !defined(__EMSCRIPTEN__)
+  WaitTime(IDLE_WAIT);
+#endif
+}
+
+// Times the game's drawing, not the wait on the buffer swap
+static void draw(void) {
+  double start = engine_getTime();
+  game_draw();
+  metrics_addTime(METRICS_DRAW_TIME, engine_getTime() - start);
+}
+
+static void drawFrame(void) {
   engine_beginFrame();
   engine_clearScreen(BLACK);
-  game_draw();
+  draw();
   engine_endFrame();
 }
 
+static double getDelta(void) {
+  double now     = engine_getTime();
+  double delta   = now - g_previousTime;
+  g_previousTime = now;
+  return delta;
+}
+
+// Latches this frame's input and returns its frame time, a replay supplies both
+static double input(void) {
+  bool isReplaying = replay_isPlaying();
+  game_input();
+  double delta = getDelta();
+  metrics_recordFrame(delta);
+  soak_recordFrame(delta);
+  if (isReplaying) {
+    delta = replay_getDelta();
+  } else {
+    replay_recordFrame(delta);
+  }
+  flight_recordFrame(delta);
+  return delta;
+}
+
+static bool parseArguments(int argc, char* argv[], Arguments* args) {
+  for (int i = 1; i < argc; i++) {
+    const char** value = strcmp(argv[i], "--record") == 0           ? &args->recordFile
+                         : strcmp(argv[i], "--replay") == 0         ? &args->replayFile
+                         : strcmp(argv[i], "--capture") == 0        ? &args->captureOutput
+                         : strcmp(argv[i], "--mix") == 0            ? &args->mixOutput
+                         : strcmp(argv[i], "--startup-report") == 0 ? &args->startupReport
+                         : strcmp(argv[i], "--startup-budget") == 0 ? &args->startupBudget
+                         : strcmp(argv[i], "--leaderboard") == 0    ? &args->leaderboard
+                         : strcmp(argv[i], "--telemetry") == 0      ? &args->telemetryDir
+                         : strcmp(argv[i], "--trace") == 0          ? &args->traceFile
+                         : strcmp(argv[i], "--metrics") == 0        ? &args->metricsAddress
+                         : strcmp(argv[i], "--soak") == 0           ? &args->soakHours
+                         : strcmp(argv[i], "--soak-report") == 0    ? &args->soakReport
+                         : strcmp(argv[i], "--splits") == 0         ? &args->splitsDir
+                                                                    : nullptr;
+    if (value == nullptr || i + 1 == argc) return false;
+    *value = argv[++i];
+  }
+  if (args->soakHours != nullptr && args->replayFile != nullptr) return false;
+  if (args->soakReport != nullptr && args->soakHours == nullptr) return false;
+  return (args->captureOutput == nullptr && args->mixOutput == nullptr) || args->replayFile != nullptr;
+}
+
+// Both need the game log, so come after game_load()
+static bool startReplay(const Arguments* args) {
+  if (args->replayFile != nullptr) {
+    if (!replay_play(args->replayFile)) return false;
+    SetRandomSeed(replay_getSeed());
+    if (!game_restoreReplay()) return false;
+  } else if (args->recordFile != nullptr) {
+    unsigned seed = (unsigned) time(nullptr);
+    if (!replay_record(args->recordFile, seed)) return false;
+    SetRandomSeed(seed);
+  }
+  return true;
+}
+
+#if !defined(__EMSCRIPTEN__)
+// Runs the replay as fast as it will go, rasterising on the CPU whenever the next video frame is due, mixing its
+// audio into the already open file, or both
+static bool renderReplay(log_Log* log, const Arguments* args) {
+  bool isCapturing = args->captureOutput != nullptr;
+  bool isMixing    = args->mixOutput != nullptr;
+  if (isCapturing) {
+    if (!render_softInit(ORG_SCR_WIDTH, ORG_SCR_HEIGHT)) return false;
+    if (!capture_open(args->captureOutput, ORG_SCR_WIDTH, ORG_SCR_HEIGHT, (int) TARGET_FPS)) {
+      render_softShutdown();
+      return false;
+    }
+    render_setBackend(render_getSoftBackend());
+  }
+  engine_setMasterVolume(0.0f);
+  audio_setEnabled(isMixing);
+
+  double start      = engine_getTime();
+  double replayTime = 0.0;
+  bool   isOk       = true;
+  while (isOk && replay_isPlaying()) {
+    game_runMainThreadTasks();
+    // Levels start here, the same frame they would when the replay was recorded
+    if (!game_loadStep()) {
+      isOk = false;
+      break;
+    }
+    double delta = input();
+    update(delta);
+    replayTime += delta;
+    if (isMixing) audio_mixFrame(delta);
+
+    if (!isCapturing || replayTime < capture_getFrameCount() * FRAME_TIME) continue;
+    game_draw();
+    while (isOk && replayTime >= capture_getFrameCount() * FRAME_TIME) {
+      isOk = capture_pushFrame(render_getSoftPixels());
+    }
+  }
+
+  if (isCapturing) {
+    capture_close();
+    render_setBackend(nullptr);
+    render_softShutdown();
+  }
+  if (isMixing && !audio_closeMix()) isOk = false;
+
+  double elapsed = engine_getTime() - start;
+  LOG_INFO(log, "Rendered %.2f seconds of replay in %.2f seconds", replayTime, elapsed);
+  if (isCapturing) {
+    int frames = capture_getFrameCount();
+    LOG_INFO(log, "Captured %d frames, %.0f fps", frames, frames / elapsed);
+  }
+  return isOk;
+}
+#endif
+
+#if defined(GAME_PIPELINED)
+static void* simThread([[maybe_unused]] void* arg) {
+  pthread_mutex_lock(&g_sim.mutex);
+  while (true) {
+    while (!g_sim.hasWork && !g_sim.isQuitting) pthread_cond_wait(&g_sim.cond, &g_sim.mutex);
+    if (g_sim.isQuitting) break;
+
+    double delta = g_sim.delta;
+    pthread_mutex_unlock(&g_sim.mutex);
+    update(delta);
+    pthread_mutex_lock(&g_sim.mutex);
+
+    g_sim.hasWork = false;
+    pthread_cond_broadcast(&g_sim.cond);
+  }
+  pthread_mutex_unlock(&g_sim.mutex);
+  return nullptr;
+}
+
+static void startSimulation(double delta) {
+  pthread_mutex_lock(&g_sim.mutex);
+  g_sim.delta   = delta;
+  g_sim.hasWork = true;
+  pthread_cond_broadcast(&g_sim.cond);
+  pthread_mutex_unlock(&g_sim.mutex);
+}
+
+static void waitSimulation(void) {
+  pthread_mutex_lock(&g_sim.mutex);
+  while (g_sim.hasWork) pthread_cond_wait(&g_sim.cond, &g_sim.mutex);
+  pthread_mutex_unlock(&g_sim.mutex);
+}
+
+static void stopSimulation(void) {
+  waitSimulation();
+  pthread_mutex_lock(&g_sim.mutex);
+  g_sim.isQuitting = true;
+  pthread_cond_broadcast(&g_sim.cond);
+  pthread_mutex_unlock(&g_sim.mutex);
+  pthread_join(g_sim.thread, nullptr);
+}
+
+// The frame is recorded and submitted from the state the last update left, then the next update runs on the
+// simulation thread while this thread waits on the buffer swap
+void mainLoop(void) {
+  waitSimulation();
+  game_runMainThreadTasks();
+  game_loadStep();
+  double delta = input();
+
+  // Static screens have next to nothing to update, so do it here and only draw if something changed
+  if (game_isIdle()) {
+    update(delta);
+    if (game_isIdle()) {
+      idle();
+    } else {
+      drawFrame();
+    }
+    return;
+  }
+
+  engine_beginFrame();
+  engine_clearScreen(BLACK);
+  draw();
+  startSimulation(delta);
+  engine_endFrame();
+}
+#else
+void mainLoop(void) {
+  game_loadStep();
+  update(input());
+
+  if (game_isIdle()) {
+    idle();
+  } else {
+    drawFrame();
+  }
+}
+#endif
+
 // --- Main ---
 
-int main(void) {
+int main(int argc, char* argv[]) {
   log_Log* log = log_create(&LOG_CONFIG);
   if (log == nullptr) {
     LOG_FATAL(log, "Failed to create log");
     return 1;
   }
 
+  Arguments args = {};
+  if (!parseArguments(argc, argv, &args)) {
+    LOG_FATAL(log, "%s", USAGE);
+    return 1;
+  }
+#if defined(__EMSCRIPTEN__)
+  if (args.captureOutput != nullptr || args.mixOutput != nullptr) {
+    LOG_FATAL(log, "Capture and mixing are not supported on the web");
+    return 1;
+  }
+#else
+  // Rendering never presents a frame, but the engine still needs a GL context to load textures
+  bool isRendering = args.captureOutput != nullptr || args.mixOutput != nullptr;
+  if (isRendering) SetConfigFlags(FLAG_WINDOW_HIDDEN);
+  // The software renderer draws from a copy of the sprite geometry, kept from the first load
+  if (args.captureOutput != nullptr) render_setTracking(true);
+#endif
+
+  // Options come from the save store, so it opens first
+  save_open();
   options_load();
   int windowMode  = options_getWindowMode();
   int screenScale = options_getScreenScale();
@@ -74,20 +364,91 @@ int main(void) {
     LOG_FATAL(log, "Failed to load game");
     return 1;
   }
-  LOG_INFO(log, "Game loaded");
+#if !defined(__EMSCRIPTEN__)
+  if (args.mixOutput != nullptr && !audio_openMix(args.mixOutput)) {
+    LOG_FATAL(log, "Failed to start mixing");
+    return 1;
+  }
+#endif
+
+  // Replays must see the same frames as the recording, so these load everything before the first one, as does
+  // timing startup, so that it times loading rather than drawing the loading screen
+  bool isTimingStartup = args.startupReport != nullptr || args.startupBudget != nullptr;
+  if (args.recordFile != nullptr || args.replayFile != nullptr || isTimingStartup) {
+    while (!game_isLoaded()) {
+      if (!game_loadStep()) return 1;
+    }
+  }
+  if (args.startupReport != nullptr && !startup_writeJSON(args.startupReport)) return 1;
+  if (args.startupBudget != nullptr) {
+    bool isWithinBudget = startup_checkBudget(args.startupBudget);
+    game_unload();
+    engine_shutdown();
+    log_destroy(&log);
+    return isWithinBudget ? 0 : 1;
+  }
+  // Before the replay, as a checkpoint restores its own
+  g_accumulator = 0.0;
+  flight_open();
+  if (!startReplay(&args)) {
+    LOG_FATAL(log, "Failed to start replay");
+    return 1;
+  }
+  // Playing on without it, the runs are still logged locally
+  if (args.leaderboard != nullptr) leaderboard_open(args.leaderboard, args.recordFile);
+  if (args.telemetryDir != nullptr) telemetry_open(args.telemetryDir);
+  if (args.traceFile != nullptr) trace_open(args.traceFile);
+  if (args.metricsAddress != nullptr) metrics_open(args.metricsAddress);
+  if (args.splitsDir != nullptr) splits_open(args.splitsDir);
+  if (args.soakHours != nullptr && !soak_open(args.soakHours, args.soakReport)) {
+    LOG_FATAL(log, "Failed to start soak");
+    return 1;
+  }
 
-  g_accumulator  = 0.0;
   g_previousTime = engine_getTime();
 
+#if !defined(__EMSCRIPTEN__)
+  if (isRendering) {
+    bool isRendered = renderReplay(log, &args);
+    flight_close();
+    metrics_close();
+    trace_close();
+    telemetry_close();
+    leaderboard_close();
+    replay_close();
+    game_unload();
+    render_setTracking(false);
+    engine_shutdown();
+    log_destroy(&log);
+    return isRendered ? 0 : 1;
+  }
+#endif
+
 #if defined(__EMSCRIPTEN__)
   emscripten_set_main_loop(mainLoop, 0, 1);
+#elif defined(GAME_PIPELINED)
+  if (pthread_create(&g_sim.thread, nullptr, simThread, nullptr) != 0) {
+    LOG_FATAL(log, "Failed to start simulation thread");
+    return 1;
+  }
+  while (!engine_shouldClose() && !soak_isFinished()) {
+    mainLoop();
+  }
+  stopSimulation();
 #else
-  while (!engine_shouldClose()) {
+  while (!engine_shouldClose() && !soak_isFinished()) {
     mainLoop();
   }
 #endif
 
   LOG_INFO(log, "Closing game...");
+  bool isSoakClean = soak_close();
+  flight_close();
+  metrics_close();
+  trace_close();
+  telemetry_close();
+  leaderboard_close();
+  replay_close();
   game_unload();
   LOG_INFO(log, "Game closed");
 
@@ -95,5 +456,5 @@ int main(void) {
 
   log_destroy(&log);
 
-  return 0;
+  return isSoakClean ? 0 : 1;
 }
@@ -0,0 +1,296 @@
+/*
+ * Leaderboard Daemon Tests
+ * Runs the daemon on a local port with an empty directory and talks to it over the wire protocol
+ */
+
+#include <errno.h>
+#include <leaderboard/protocol.h>
+#include <minunit/minunit.h>
+#include <net/address.h>
+#include <netdb.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+// --- Constants ---
+
+constexpr int      TIMEOUT       = 5;  // Seconds any one reply may take
+constexpr int      START_TRIES   = 100;
+constexpr uint32_t PLAYER        = 0x12345678u;
+constexpr int      STALLED_COUNT = 20000;  // Queries left unread, megabytes of replies
+
+static const char HOST[] = "127.0.0.1";
+
+// --- Global state ---
+
+static pid_t g_daemon = -1;
+static char  g_dir[]  = "/tmp/test_leaderboard_XXXXXX";
+static char  g_port[NET_PORT_LENGTH];
+
+// --- Helper functions ---
+
+static int connectDaemon(void) {
+  struct addrinfo  hints = { .ai_family = AF_INET, .ai_socktype = SOCK_STREAM };
+  struct addrinfo* info;
+  if (getaddrinfo(HOST, g_port, &hints, &info) != 0) return -1;
+
+  struct timeval timeout = { .tv_sec = TIMEOUT };
+  int            fd      = socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+  if (fd != -1 && (setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) != 0 ||
+                   connect(fd, info->ai_addr, info->ai_addrlen) != 0)) {
+    close(fd);
+    fd = -1;
+  }
+  freeaddrinfo(info);
+  return fd;
+}
+
+static bool sendMessage(int fd, leaderboard_Type type, const void* data, size_t size) {
+  leaderboard_Header header = { .version = LEADERBOARD_VERSION, .type = type, .size = size };
+  memcpy(header.magic, LEADERBOARD_MAGIC, sizeof(header.magic));
+  return send(fd, &header, sizeof(header), MSG_NOSIGNAL) == (ssize_t) sizeof(header) &&
+         (size == 0 || send(fd, data, size, MSG_NOSIGNAL) == (ssize_t) size);
+}
+
+static bool receiveAll(int fd, void* data, size_t size) {
+  for (size_t received = 0; received < size;) {
+    ssize_t count = recv(fd, (char*) data + received, size - received, 0);
+    if (count <= 0) return false;
+    received += count;
+  }
+  return true;
+}
+
+// The payload's size, or -1 if it isn't the message expected or doesn't fit
+static long receiveMessage(int fd, leaderboard_Type type, void* data, size_t capacity) {
+  leaderboard_Header header;
+  if (!receiveAll(fd, &header, sizeof(header)) || !leaderboard_isValidHeader(&header) || header.type != type ||
+      header.size > capacity || !receiveAll(fd, data, header.size)) {
+    return -1;
+  }
+  return header.size;
+}
+
+static runs_Record makeRecord(double time, int score) {
+  return (runs_Record) { .date = 1, .time = time, .score = score, .player = PLAYER, .level = RUNS_FULL_RUN };
+}
+
+// The runs accepted, or -1 if the daemon didn't answer
+static int submitRuns(int fd, const runs_Record records[], uint32_t count) {
+  unsigned char message[sizeof(count) + 4 * sizeof(leaderboard_Run)];
+  memcpy(message, &count, sizeof(count));
+  for (uint32_t i = 0; i < count; i++) {
+    leaderboard_Run run = { .record = records[i] };
+    memcpy(message + sizeof(count) + i * sizeof(run), &run, sizeof(run));
+  }
+
+  leaderboard_Ack ack;
+  size_t          size = sizeof(count) + count * sizeof(leaderboard_Run);
+  if (!sendMessage(fd, LEADERBOARD_SUBMIT, message, size) ||
+      receiveMessage(fd, LEADERBOARD_ACK, &ack, sizeof(ack)) != sizeof(ack)) {
+    return -1;
+  }
+  return ack.accepted;
+}
+
+static bool queryTop(int fd, runs_Sort sort, leaderboard_Top* top, runs_Record runs[], uint32_t count) {
+  leaderboard_Query query = { .player = RUNS_ALL_PLAYERS, .level = RUNS_FULL_RUN, .sort = sort, .count = count };
+  struct {
+    leaderboard_Top top;
+    runs_Record     runs[LEADERBOARD_MAX_TOP];
+  } reply;
+  if (!sendMessage(fd, LEADERBOARD_QUERY, &query, sizeof(query))) return false;
+  long size = receiveMessage(fd, LEADERBOARD_TOP, &reply, sizeof(reply));
+  if (size < (long) sizeof(reply.top) || reply.top.count > count ||
+      (size_t) size != sizeof(reply.top) + reply.top.count * sizeof(runs_Record)) {
+    return false;
+  }
+  *top = reply.top;
+  memcpy(runs, reply.runs, reply.top.count * sizeof(runs_Record));
+  return true;
+}
+
+// --- Setup and teardown ---
+
+void test_setup(void) {}
+
+void test_teardown(void) {}
+
+// --- Address tests ---
+
+MU_TEST(test_address_forms) {
+  net_Address address;
+  mu_check(net_parseAddress("7878", &address));
+  mu_assert_string_eq(NET_DEFAULT_HOST, address.host);
+  mu_assert_string_eq("7878", address.port);
+
+  mu_check(net_parseAddress(":7879", &address));
+  mu_assert_string_eq(NET_DEFAULT_HOST, address.host);
+  mu_assert_string_eq("7879", address.port);
+
+  mu_check(net_parseAddress("arcade-server:80", &address));
+  mu_assert_string_eq("arcade-server", address.host);
+  mu_assert_string_eq("80", address.port);
+
+  mu_check(net_parseAddress("[::1]:9000", &address));
+  mu_assert_string_eq("::1", address.host);
+  mu_assert_string_eq("9000", address.port);
+}
+
+MU_TEST(test_address_rejected) {
+  net_Address address;
+  mu_check(!net_parseAddress("", &address));
+  mu_check(!net_parseAddress("host:", &address));
+  mu_check(!net_parseAddress("host:0", &address));
+  mu_check(!net_parseAddress("host:65536", &address));
+  mu_check(!net_parseAddress("host:http", &address));
+}
+
+// --- Daemon tests ---
+
+MU_TEST(test_submit_and_query) {
+  int fd = connectDaemon();
+  mu_check(fd != -1);
+
+  runs_Record records[] = { makeRecord(90.0, 300), makeRecord(60.0, 100), makeRecord(75.0, 500) };
+  runs_Record invalid   = makeRecord(-1.0, 100);
+  mu_assert_int_eq(3, submitRuns(fd, records, 3));
+  mu_assert_int_eq(0, submitRuns(fd, &invalid, 1));
+
+  leaderboard_Top top;
+  runs_Record     runs[LEADERBOARD_MAX_TOP];
+  mu_check(queryTop(fd, RUNS_SORT_TIME, &top, runs, 2));
+  mu_assert_int_eq(3, top.total);
+  mu_assert_int_eq(2, top.count);
+  mu_assert_double_eq(60.0, runs[0].time);
+  mu_assert_double_eq(75.0, runs[1].time);
+
+  mu_check(queryTop(fd, RUNS_SORT_SCORE, &top, runs, 10));
+  mu_assert_int_eq(3, top.count);
+  mu_assert_int_eq(500, runs[0].score);
+  mu_assert_int_eq(100, runs[2].score);
+  close(fd);
+}
+
+MU_TEST(test_bad_header_dropped) {
+  int                fd     = connectDaemon();
+  leaderboard_Header header = { .magic = { 'N', 'O', 'P', 'E' }, .version = LEADERBOARD_VERSION };
+  mu_check(fd != -1);
+  mu_check(send(fd, &header, sizeof(header), MSG_NOSIGNAL) == sizeof(header));
+  char byte;
+  mu_assert_int_eq(0, recv(fd, &byte, 1, 0));
+  close(fd);
+}
+
+// A client that never reads its replies mustn't hold up anyone else
+MU_TEST(test_stalled_client) {
+  int stalled = connectDaemon();
+  mu_check(stalled != -1);
+
+  // Fills the board so every reply is as big as it gets
+  for (int i = 0; i < LEADERBOARD_MAX_TOP; i += 4) {
+    runs_Record records[4];
+    for (int j = 0; j < 4; j++) records[j] = makeRecord(100.0 + i + j, i + j);
+    mu_assert_int_eq(4, submitRuns(stalled, records, 4));
+  }
+  leaderboard_Query  query  = { .level = RUNS_FULL_RUN, .count = LEADERBOARD_MAX_TOP };
+  leaderboard_Header header = { .version = LEADERBOARD_VERSION, .type = LEADERBOARD_QUERY, .size = sizeof(query) };
+  memcpy(header.magic, LEADERBOARD_MAGIC, sizeof(header.magic));
+  struct {
+    leaderboard_Header header;
+    leaderboard_Query  query;
+  } message = { header, query };
+
+  // Stops once the daemon has stopped reading and the socket's buffers are full
+  struct timeval timeout = { .tv_usec = 200 * 1000 };
+  setsockopt(stalled, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+  int sent = 0;
+  while (sent < STALLED_COUNT && send(stalled, &message, sizeof(message), MSG_NOSIGNAL) == sizeof(message)) sent++;
+
+  int             fd = connectDaemon();
+  leaderboard_Top top;
+  runs_Record     runs[LEADERBOARD_MAX_TOP];
+  time_t          start = time(nullptr);
+  mu_check(fd != -1);
+  mu_check(queryTop(fd, RUNS_SORT_TIME, &top, runs, 1));
+  mu_check(time(nullptr) - start < TIMEOUT);
+  close(fd);
+  close(stalled);
+}
+
+// --- Test suites ---
+
+MU_TEST_SUITE(address_suite) {
+  MU_SUITE_CONFIGURE(&test_setup, &test_teardown);
+  MU_RUN_TEST(test_address_forms);
+  MU_RUN_TEST(test_address_rejected);
+}
+
+MU_TEST_SUITE(daemon_suite) {
+  MU_SUITE_CONFIGURE(&test_setup, &test_teardown);
+  MU_RUN_TEST(test_submit_and_query);
+  MU_RUN_TEST(test_bad_header_dropped);
+  MU_RUN_TEST(test_stalled_client);
+}
+
+// --- Daemon ---
+
+// On a port of its own so runs of the test don't collide
+static bool startDaemon(void) {
+  if (mkdtemp(g_dir) == nullptr) return false;
+  snprintf(g_port, sizeof(g_port), "%d", 20000 + getpid() % 20000);
+
+  g_daemon = fork();
+  if (g_daemon == 0) {
+    freopen("/dev/null", "w", stdout);
+    execl(LEADERBOARD_PATH, LEADERBOARD_PATH, "serve", g_dir, g_port, (char*) nullptr);
+    _exit(127);
+  }
+  if (g_daemon == -1) return false;
+
+  struct timespec wait = { .tv_nsec = 50 * 1000 * 1000 };
+  for (int i = 0; i < START_TRIES; i++) {
+    int fd = connectDaemon();
+    if (fd != -1) {
+      close(fd);
+      return true;
+    }
+    nanosleep(&wait, nullptr);
+  }
+  return false;
+}
+
+// Killed outright, a daemon stuck on a client would never see a SIGTERM through
+static void stopDaemon(void) {
+  if (g_daemon > 0) {
+    kill(g_daemon, SIGKILL);
+    waitpid(g_daemon, nullptr, 0);
+  }
+  char command[sizeof(g_dir) + 16];
+  snprintf(command, sizeof(command), "rm -rf %s", g_dir);
+  if (system(command) != 0) fprintf(stderr, "Failed to remove %s\n", g_dir);
+}
+
+// --- Main test runner ---
+
+int main(void) {
+  printf("=== Address Tests ===\n");
+  MU_RUN_SUITE(address_suite);
+
+  if (!startDaemon()) {
+    fprintf(stderr, "Failed to start %s\n", LEADERBOARD_PATH);
+    stopDaemon();
+    return 1;
+  }
+  printf("\n=== Leaderboard Daemon Tests ===\n");
+  MU_RUN_SUITE(daemon_suite);
+  stopDaemon();
+
+  MU_REPORT();
+  return MU_EXIT_CODE;
+}
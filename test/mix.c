@@ -0,0 +1,254 @@
+/*
+ * Audio Mix Tests
+ * Mixes synthetic sounds offline and checks where they land in the WAV file, so replays sound the same on every run
+ */
+
+#include <minunit/minunit.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../src/game/asset/asset.h"
+#include "../src/game/audio/audio.h"
+#include "../src/game/audio/internal.h"
+#include "../src/game/internal.h"
+#include "../src/game/options/options.h"
+
+// --- Constants ---
+
+constexpr int RATE       = 48000;  // The mix's own rate, so the sounds aren't resampled
+constexpr int TONE_LEVEL = 16384;  // Half scale, a constant level so every frame mixes to the same sample
+constexpr int WAV_HEADER = 44;
+
+static const char MIX_FILE[]   = "test_mix.wav";
+static const char MUSIC_FILE[] = "test_mix_music.wav";
+
+static const float PAN_LEVEL   = 0.6875f;  // raylib's pan law at the centre
+static const float DUCKED      = 0.25f;
+static const float FADE_RATE   = 4.0f;  // Fully ducked in a quarter of a second
+static const float SOUND_SCALE = 1.0f / 32768.0f;
+
+// --- Global state ---
+
+log_Log* game_log;
+Wave     g_tone;
+Wave     g_longTone;
+float    g_musicVolume;
+
+// --- Mocked functions ---
+
+// The test's sounds carry their waves in place of a device buffer
+const Wave* asset_getSoundWave(Sound sound) { return (const Wave*) sound.stream.buffer; }
+
+void asset_keepSoundWaves(void) {}
+
+const char* asset_getMusicFile(void) { return MUSIC_FILE; }
+
+void asset_getMusicDucking(float* volume, float* duckedVolume, float* fadeInRate, float* fadeOutRate) {
+  *volume       = g_musicVolume;
+  *duckedVolume = g_musicVolume * DUCKED;
+  *fadeInRate   = FADE_RATE;
+  *fadeOutRate  = FADE_RATE;
+}
+
+float options_getMasterVolume(void) { return 1.0f; }
+
+float options_getSfxVolume(void) { return 1.0f; }
+
+float options_getMusicVolume(void) { return 1.0f; }
+
+// --- Helper functions ---
+
+static Wave makeTone(unsigned frameCount) {
+  int16_t* data = malloc(frameCount * 2 * sizeof(int16_t));
+  if (data == nullptr) return (Wave) {};
+  for (unsigned i = 0; i < frameCount * 2; i++) data[i] = TONE_LEVEL;
+  return (Wave) { .frameCount = frameCount, .sampleRate = RATE, .sampleSize = 16, .channels = 2, .data = data };
+}
+
+static Sound makeSound(Wave* wave) {
+  return (Sound) { .stream = { .buffer = (rAudioBuffer*) wave }, .frameCount = wave->frameCount };
+}
+
+static int16_t getLevel(float gain) { return (int16_t) (TONE_LEVEL * SOUND_SCALE * gain * 32767.0f); }
+
+// The left channel of every frame mixed, or nullptr if the file isn't the size its header says
+static int16_t* readMix(uint32_t* frameCount) {
+  FILE* file = fopen(MIX_FILE, "rb");
+  if (file == nullptr) return nullptr;
+
+  unsigned char header[WAV_HEADER];
+  uint32_t      dataSize = 0;
+  bool          isOk     = fread(header, sizeof(header), 1, file) == 1;
+  if (isOk) dataSize = header[40] | header[41] << 8 | header[42] << 16 | (uint32_t) header[43] << 24;
+
+  int16_t* frames = isOk ? malloc(dataSize + 1) : nullptr;
+  isOk            = frames != nullptr && fread(frames, 1, dataSize + 1, file) == dataSize;
+  fclose(file);
+  if (!isOk) {
+    free(frames);
+    return nullptr;
+  }
+
+  *frameCount = dataSize / (2 * sizeof(int16_t));
+  for (uint32_t i = 0; i < *frameCount; i++) frames[i] = frames[i * 2];
+  return frames;
+}
+
+static bool isLevel(const int16_t* frames, uint32_t start, uint32_t end, int16_t level) {
+  for (uint32_t i = start; i < end; i++) {
+    if (abs(frames[i] - level) > 1) return false;
+  }
+  return true;
+}
+
+static void mixFrames(int count) {
+  for (int i = 0; i < count; i++) audio_mixFrame(FRAME_TIME);
+}
+
+// --- Setup and teardown ---
+
+void test_setup(void) {
+  g_musicVolume = 0.0f;
+  mu_check(audio_openMix(MIX_FILE));
+}
+
+void test_teardown(void) {
+  audio_closeMix();
+  remove(MIX_FILE);
+}
+
+// --- Timing tests ---
+
+// However the frame times fall, the file is as long as the time simulated
+MU_TEST(test_length) {
+  audio_mixFrame(0.5);
+  audio_mixFrame(0.25);
+  audio_mixFrame(0.0);
+  audio_mixFrame(0.125);
+  mu_check(audio_closeMix());
+
+  uint32_t frameCount = 0;
+  int16_t* frames     = readMix(&frameCount);
+  mu_check(frames != nullptr);
+  mu_assert_int_eq(RATE * 7 / 8, frameCount);
+  free(frames);
+}
+
+MU_TEST(test_onset) {
+  audio_mixFrame(0.25);
+  mu_check(audio_mixPlay(makeSound(&g_tone), 1.0f, 1.0f, 0.5f, PRIORITY_NORMAL, false) != -1);
+  audio_mixFrame(0.25);
+  mu_check(audio_closeMix());
+
+  uint32_t frameCount = 0;
+  int16_t* frames     = readMix(&frameCount);
+  uint32_t start      = RATE / 4;
+  mu_check(frames != nullptr);
+  mu_check(isLevel(frames, 0, start, 0));
+  mu_check(isLevel(frames, start, start + g_tone.frameCount, getLevel(PAN_LEVEL)));
+  mu_check(isLevel(frames, start + g_tone.frameCount, frameCount, 0));
+  free(frames);
+}
+
+// Twice the pitch plays through the samples in half the time
+MU_TEST(test_pitch) {
+  mu_check(audio_mixPlay(makeSound(&g_tone), 1.0f, 2.0f, 0.5f, PRIORITY_NORMAL, false) != -1);
+  audio_mixFrame(0.25);
+  mu_check(audio_closeMix());
+
+  uint32_t frameCount = 0;
+  int16_t* frames     = readMix(&frameCount);
+  uint32_t end        = g_tone.frameCount / 2;
+  mu_check(frames != nullptr);
+  mu_check(isLevel(frames, 0, end, getLevel(PAN_LEVEL)));
+  mu_check(isLevel(frames, end, frameCount, 0));
+  free(frames);
+}
+
+// The same frames mix to the same bytes, whatever ran before
+MU_TEST(test_repeatable) {
+  uint32_t frameCounts[2] = {};
+  int16_t* frames[2]      = {};
+  for (int run = 0; run < 2; run++) {
+    if (run > 0) mu_check(audio_openMix(MIX_FILE));
+    mixFrames(7);
+    audio_mixPlay(makeSound(&g_tone), 0.5f, 1.5f, 0.25f, PRIORITY_NORMAL, false);
+    mixFrames(5);
+    audio_mixPlay(makeSound(&g_longTone), 1.0f, 0.75f, 0.75f, PRIORITY_LOW, true);
+    mixFrames(60);
+    mu_check(audio_closeMix());
+    frames[run] = readMix(&frameCounts[run]);
+    mu_check(frames[run] != nullptr);
+  }
+
+  mu_assert_int_eq(frameCounts[0], frameCounts[1]);
+  mu_check(memcmp(frames[0], frames[1], frameCounts[0] * sizeof(int16_t)) == 0);
+  free(frames[0]);
+  free(frames[1]);
+}
+
+// --- Ducking tests ---
+
+// The effects are silent, so only the music is heard
+static int16_t getMusicLevel(bool isLooping) {
+  audio_closeMix();
+  g_musicVolume = 1.0f;
+  if (!audio_openMix(MIX_FILE)) return -1;
+
+  audio_mixPlay(makeSound(&g_longTone), 0.0f, 1.0f, 0.5f, PRIORITY_NORMAL, isLooping);
+  mixFrames(30);
+  if (!audio_closeMix()) return -1;
+
+  uint32_t frameCount = 0;
+  int16_t* frames     = readMix(&frameCount);
+  int16_t  level      = frames != nullptr ? frames[frameCount - 1] : -1;
+  free(frames);
+  return level;
+}
+
+MU_TEST(test_effect_ducks) { mu_assert_int_eq(getLevel(PAN_LEVEL * DUCKED), getMusicLevel(false)); }
+
+MU_TEST(test_loop_not_ducked) { mu_assert_int_eq(getLevel(PAN_LEVEL), getMusicLevel(true)); }
+
+// --- Test suites ---
+
+MU_TEST_SUITE(timing_suite) {
+  MU_SUITE_CONFIGURE(&test_setup, &test_teardown);
+  MU_RUN_TEST(test_length);
+  MU_RUN_TEST(test_onset);
+  MU_RUN_TEST(test_pitch);
+  MU_RUN_TEST(test_repeatable);
+}
+
+MU_TEST_SUITE(ducking_suite) {
+  MU_SUITE_CONFIGURE(&test_setup, &test_teardown);
+  MU_RUN_TEST(test_effect_ducks);
+  MU_RUN_TEST(test_loop_not_ducked);
+}
+
+// --- Main test runner ---
+
+int main(void) {
+  g_tone         = makeTone(480);
+  g_longTone     = makeTone(RATE * 2);
+  Wave music     = makeTone(RATE / 10);
+  bool isWritten = music.data != nullptr && ExportWave(music, MUSIC_FILE);
+  UnloadWave(music);
+  if (g_tone.data == nullptr || g_longTone.data == nullptr || !isWritten) {
+    fprintf(stderr, "Failed to make the test sounds\n");
+    return 1;
+  }
+
+  printf("=== Audio Mix Timing Tests ===\n");
+  MU_RUN_SUITE(timing_suite);
+
+  printf("\n=== Audio Mix Ducking Tests ===\n");
+  MU_RUN_SUITE(ducking_suite);
+
+  MU_REPORT();
+  UnloadWave(g_tone);
+  UnloadWave(g_longTone);
+  remove(MUSIC_FILE);
+  return MU_EXIT_CODE;
+}
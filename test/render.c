@@ -0,0 +1,346 @@
+/*
+ * Software Renderer Golden Tests
+ * Rasterises fixed scenes without a GPU and checks each frame against the hash it was accepted with
+ */
+
+#include <minunit/minunit.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "../src/game/internal.h"
+#include "../src/game/metrics/metrics.h"
+#include "../src/game/pack/pack.h"
+#include "../src/game/render/internal.h"
+
+// --- Constants ---
+
+constexpr int WIDTH  = 64;
+constexpr int HEIGHT = 48;
+
+static const char SHEET_FILE[] = "test_render_sheet.png";
+static const char FONT_FILE[]  = "test_render_font.png";
+
+// Accepted by eye from the frames written on a mismatch, update them only for an intended change
+constexpr uint32_t GOLDEN_SHAPES = 0x8f97bb35u;
+constexpr uint32_t GOLDEN_SPRITE = 0x4eb19262u;
+constexpr uint32_t GOLDEN_ANIM   = 0x30b42e03u;
+constexpr uint32_t GOLDEN_TEXT   = 0x3324eeccu;
+
+// --- Global state ---
+
+log_Log*        game_log;
+engine_Texture* g_sheet;
+engine_Font*    g_font;
+
+// --- Mocked functions ---
+
+// The engine is left out, only the software renderer draws, so its objects only need to be distinct
+engine_Texture* engine_textureLoad([[maybe_unused]] const char* file) { return malloc(1); }
+
+void engine_textureUnload(engine_Texture** texture) {
+  free(*texture);
+  *texture = nullptr;
+}
+
+engine_Font* engine_fontLoad(
+    [[maybe_unused]] const char* file,
+    [[maybe_unused]] int         glyphWidth,
+    [[maybe_unused]] int         glyphHeight,
+    [[maybe_unused]] int         firstChar,
+    [[maybe_unused]] int         lastChar,
+    [[maybe_unused]] int         xSpacing,
+    [[maybe_unused]] int         ySpacing
+) {
+  return malloc(1);
+}
+
+void engine_fontUnload(engine_Font** font) {
+  free(*font);
+  *font = nullptr;
+}
+
+engine_Sprite* engine_createSprite(
+    [[maybe_unused]] Vector2 pos, [[maybe_unused]] Vector2 size, [[maybe_unused]] Vector2 offset
+) {
+  return malloc(1);
+}
+
+engine_Sprite* engine_createSpriteFromSheet(
+    [[maybe_unused]] Vector2 pos,
+    [[maybe_unused]] Vector2 size,
+    [[maybe_unused]] int     row,
+    [[maybe_unused]] int     col,
+    [[maybe_unused]] Vector2 inset
+) {
+  return malloc(1);
+}
+
+void engine_destroySprite(engine_Sprite** sprite) {
+  free(*sprite);
+  *sprite = nullptr;
+}
+
+void engine_spriteSetPos([[maybe_unused]] engine_Sprite* sprite, [[maybe_unused]] Vector2 pos) {}
+
+engine_Anim* engine_createAnim(
+    [[maybe_unused]] engine_Sprite* sprite,
+    [[maybe_unused]] int            row,
+    [[maybe_unused]] int            startCol,
+    [[maybe_unused]] int            frameCount,
+    [[maybe_unused]] double         frameTime,
+    [[maybe_unused]] Vector2        inset,
+    [[maybe_unused]] bool           loop
+) {
+  return malloc(1);
+}
+
+void engine_destroyAnim(engine_Anim** anim) {
+  free(*anim);
+  *anim = nullptr;
+}
+
+void engine_resetAnim([[maybe_unused]] engine_Anim* anim) {}
+
+void engine_updateAnim([[maybe_unused]] engine_Anim* anim, [[maybe_unused]] double frameTime) {}
+
+void metrics_add([[maybe_unused]] metrics_Metric metric, [[maybe_unused]] long long amount) {}
+
+long long metrics_get([[maybe_unused]] metrics_Metric metric) { return 0; }
+
+// No asset pack, the sheets are read from their files
+bool pack_findImage([[maybe_unused]] const char* name, [[maybe_unused]] Image* image) { return false; }
+
+bool pack_contains([[maybe_unused]] const void* data) { return false; }
+
+// --- Helper functions ---
+
+// Sheets are made here rather than loaded from the assets, so the goldens only change with the renderer
+static bool writeImage(const char* file, int width, int height, Color (*getPixel)(int x, int y)) {
+  Color* pixels = malloc((size_t) width * height * sizeof(Color));
+  if (pixels == nullptr) return false;
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) pixels[y * width + x] = getPixel(x, y);
+  }
+  Image image = {
+    .data = pixels, .width = width, .height = height, .mipmaps = 1, .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8
+  };
+  bool isWritten = ExportImage(image, file);
+  free(pixels);
+  return isWritten;
+}
+
+// Cells of 8x8 with a 1 pixel inset, every pixel different and some see through
+static Color getSheetPixel(int x, int y) {
+  unsigned char alpha = (x + y) % 7 == 0 ? 0 : (x * y) % 5 == 0 ? 128 : 255;
+  return (Color) { (unsigned char) (x * 6), (unsigned char) (y * 12), (unsigned char) ((x ^ y) * 16), alpha };
+}
+
+// 4x6 glyphs, 8 to a row, each a different pattern
+static Color getFontPixel(int x, int y) {
+  int  glyph = y / 6 * 8 + x / 4;
+  bool isSet = ((glyph * 37 + (x % 4) * 5 + (y % 6) * 11) & 4) != 0;
+  return isSet ? WHITE : BLANK;
+}
+
+// FNV-1a over the frame, a mismatch writes the frame out to compare by eye
+static bool isGolden(const char* name, uint32_t golden) {
+  const unsigned char* pixels = (const unsigned char*) render_getSoftPixels();
+  uint32_t             hash   = 2166136261u;
+  for (size_t i = 0; i < (size_t) WIDTH * HEIGHT * sizeof(Color); i++) hash = (hash ^ pixels[i]) * 16777619u;
+  if (hash == golden) return true;
+
+  char file[64];
+  snprintf(file, sizeof(file), "test_render_%s.png", name);
+  Image image = {
+    .data = (void*) pixels, .width = WIDTH, .height = HEIGHT, .mipmaps = 1, .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8
+  };
+  ExportImage(image, file);
+  printf("\n%s frame hashed 0x%08xu, not 0x%08xu, written to %s", name, hash, golden, file);
+  return false;
+}
+
+static void execute(render_Command command) { render_getSoftBackend()->execute(&command); }
+
+static void drawSprite(engine_Sprite* sprite, Color colour) {
+  execute((render_Command) { .type = RENDER_SPRITE, .colour = colour, .sprite = { g_sheet, sprite } });
+}
+
+// As render_glyphs() pushes them, a command per glyph
+static void drawText(int xPos, int yPos, Color colour, const char* string) {
+  render_Glyph glyphs[32];
+  int          count = render_layoutText(g_font, string, glyphs, COUNT(glyphs));
+  for (int i = 0; i < count; i++) {
+    Vector2 pos = { xPos + glyphs[i].offset.x, yPos + glyphs[i].offset.y };
+    execute((render_Command) { .type = RENDER_GLYPH, .colour = colour, .glyph = { g_font, glyphs[i].source, pos } });
+  }
+}
+
+// --- Test setup ---
+
+void test_setup(void) {
+  render_setTracking(true);
+  mu_check(render_softInit(WIDTH, HEIGHT));
+  g_sheet = render_textureLoad(SHEET_FILE);
+  g_font  = render_fontLoad(FONT_FILE, 4, 6, ' ', '_', 1, 1);
+  render_getSoftBackend()->beginFrame();
+}
+
+void test_teardown(void) {
+  render_fontUnload(&g_font);
+  render_textureUnload(&g_sheet);
+  render_softShutdown();
+  render_setTracking(false);
+}
+
+// --- Golden tests ---
+
+MU_TEST(test_shapes) {
+  execute((render_Command) { .type = RENDER_RECTANGLE, .colour = RED, .rectangle = { 4, 4, 20, 12 } });
+  execute((render_Command) { .type = RENDER_RECTANGLE, .colour = { 0, 0, 255, 128 }, .rectangle = { 14, 8, 20, 20 } });
+  execute((render_Command) { .type = RENDER_RECTANGLE_OUTLINE, .colour = GREEN, .rectangle = { 30, 2, 30, 40 } });
+  execute((render_Command) { .type = RENDER_LINE, .colour = YELLOW, .line = { { 0, 47 }, { 63, 20 }, 1 } });
+  mu_check(isGolden("shapes", GOLDEN_SHAPES));
+}
+
+MU_TEST(test_sprite) {
+  Vector2        size   = { 8, 8 };
+  Vector2        inset  = { 1, 1 };
+  engine_Sprite* plain  = render_createSpriteFromSheet((Vector2) { 2, 3 }, size, 1, 2, inset);
+  engine_Sprite* tinted = render_createSpriteFromSheet((Vector2) { 20, 3 }, size, 0, 0, inset);
+  engine_Sprite* offset = render_createSprite((Vector2) { 40, 20 }, (Vector2) { 16, 16 }, (Vector2) { -4, -4 });
+  render_spriteSetPos(plain, (Vector2) { 6, 30 });
+  drawSprite(plain, WHITE);
+  drawSprite(tinted, (Color) { 255, 128, 64, 200 });
+  drawSprite(offset, WHITE);
+  // Clipped at the canvas edge
+  render_spriteSetPos(tinted, (Vector2) { 60, -3 });
+  drawSprite(tinted, WHITE);
+  mu_check(isGolden("sprite", GOLDEN_SPRITE));
+
+  render_destroySprite(&offset);
+  render_destroySprite(&tinted);
+  render_destroySprite(&plain);
+}
+
+// The sprite shows whichever of its anims was played last, at the frame its time has reached
+MU_TEST(test_anim) {
+  Vector2        inset   = { 1, 1 };
+  engine_Sprite* sprite  = render_createSpriteFromSheet((Vector2) { 4, 4 }, (Vector2) { 8, 8 }, 0, 0, inset);
+  engine_Anim*   walk    = render_createAnim(sprite, 0, 0, 4, 0.1, inset, true);
+  engine_Anim*   die     = render_createAnim(sprite, 2, 1, 3, 0.2, inset, false);
+  Vector2        steps[] = {
+    { 4, 4 },
+    { 16, 4 },
+    { 28, 4 },
+    { 40, 4 }
+  };
+  for (size_t i = 0; i < COUNT(steps); i++) {
+    render_spriteSetPos(sprite, steps[i]);
+    drawSprite(sprite, WHITE);
+    render_updateAnim(walk, 0.15);
+  }
+  render_updateAnim(die, 5.0);
+  render_spriteSetPos(sprite, (Vector2) { 4, 20 });
+  drawSprite(sprite, WHITE);
+  render_resetAnim(walk);
+  render_spriteSetPos(sprite, (Vector2) { 16, 20 });
+  drawSprite(sprite, WHITE);
+  mu_check(isGolden("anim", GOLDEN_ANIM));
+
+  render_destroyAnim(&die);
+  render_destroyAnim(&walk);
+  render_destroySprite(&sprite);
+}
+
+MU_TEST(test_text) {
+  drawText(2, 2, WHITE, "MYTHIC DASH");
+  drawText(2, 12, ORANGE, "SCORE:\n 0123");
+  mu_check(isGolden("text", GOLDEN_TEXT));
+}
+
+// Newlines start a row below, the font's own spacing is kept between glyphs
+MU_TEST(test_layout) {
+  render_Glyph glyphs[8];
+  int          count = render_layoutText(g_font, "AB C\nD", glyphs, COUNT(glyphs));
+  mu_assert_int_eq(5, count);
+  mu_check(glyphs[0].offset.x == 0 && glyphs[0].offset.y == 0);
+  mu_check(glyphs[1].offset.x == 5 && glyphs[1].offset.y == 0);
+  mu_check(glyphs[2].offset.x == 10 && glyphs[2].offset.y == 0);
+  mu_check(glyphs[4].offset.x == 0 && glyphs[4].offset.y == 7);
+
+  // 'A' is the 33rd glyph from ' ', the second of the fifth row of eight
+  mu_check(glyphs[0].source.x == 4 && glyphs[0].source.y == 24);
+  mu_check(glyphs[0].source.width == 4 && glyphs[0].source.height == 6);
+  mu_assert_int_eq(2, render_layoutText(g_font, "ABCD", glyphs, 2));
+}
+
+// --- Tracking tests ---
+
+// Far more than the tables start with, churned so they rehash over their tombstones
+MU_TEST(test_tracking_growth) {
+  constexpr int   SPRITE_COUNT = 20000;
+  engine_Sprite** sprites      = malloc(SPRITE_COUNT * sizeof(engine_Sprite*));
+  mu_check(sprites != nullptr);
+  for (int i = 0; i < SPRITE_COUNT; i++) {
+    sprites[i] = render_createSprite((Vector2) { i, -i }, (Vector2) { 8, 8 }, (Vector2) {});
+  }
+  for (int i = 0; i < SPRITE_COUNT; i += 2) render_destroySprite(&sprites[i]);
+  for (int i = 0; i < SPRITE_COUNT; i += 2) {
+    sprites[i] = render_createSprite((Vector2) { i, -i }, (Vector2) { 8, 8 }, (Vector2) {});
+  }
+
+  bool isFound = true;
+  for (int i = 0; i < SPRITE_COUNT; i++) {
+    render_SpriteInfo info;
+    isFound = isFound && render_getSpriteInfo(sprites[i], &info) && info.pos.x == i && info.pos.y == -i;
+  }
+  mu_check(isFound);
+  for (int i = 0; i < SPRITE_COUNT; i++) render_destroySprite(&sprites[i]);
+  free(sprites);
+}
+
+// Without tracking nothing is kept, only the engine backend can draw
+MU_TEST(test_tracking_off) {
+  render_setTracking(false);
+  engine_Sprite*    sprite = render_createSprite((Vector2) {}, (Vector2) { 8, 8 }, (Vector2) {});
+  render_SpriteInfo info;
+  mu_check(!render_getSpriteInfo(sprite, &info));
+  render_destroySprite(&sprite);
+  render_setTracking(true);
+}
+
+// --- Test suites ---
+
+MU_TEST_SUITE(golden_suite) {
+  MU_SUITE_CONFIGURE(&test_setup, &test_teardown);
+  MU_RUN_TEST(test_shapes);
+  MU_RUN_TEST(test_sprite);
+  MU_RUN_TEST(test_anim);
+  MU_RUN_TEST(test_text);
+  MU_RUN_TEST(test_layout);
+}
+
+MU_TEST_SUITE(tracking_suite) {
+  MU_SUITE_CONFIGURE(&test_setup, &test_teardown);
+  MU_RUN_TEST(test_tracking_growth);
+  MU_RUN_TEST(test_tracking_off);
+}
+
+// --- Main test runner ---
+
+int main(void) {
+  if (!writeImage(SHEET_FILE, 50, 40, getSheetPixel) || !writeImage(FONT_FILE, 32, 48, getFontPixel)) {
+    fprintf(stderr, "Failed to write the test sheets\n");
+    return 1;
+  }
+  printf("=== Software Renderer Golden Tests ===\n");
+  MU_RUN_SUITE(golden_suite);
+
+  printf("\n=== Sprite Tracking Tests ===\n");
+  MU_RUN_SUITE(tracking_suite);
+
+  MU_REPORT();
+  remove(SHEET_FILE);
+  remove(FONT_FILE);
+  return MU_EXIT_CODE;
+}
@@ -0,0 +1,176 @@
+/*
+ * Replay Checkpoint Tests
+ * Dumps the flight recorder from a crashing child and plays the dump back from its checkpoint, stepping Arcade's fixed
+ * update as the game does, so a replay takes the same steps on the same frames as the recording did
+ */
+
+#include <minunit/minunit.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include "../src/game/flight/flight.h"
+#include "../src/game/internal.h"
+#include "../src/game/replay/replay.h"
+
+// --- Constants ---
+
+constexpr int FRAME_COUNT      = 240;
+constexpr int CHECKPOINT_FRAME = 97;  // Part way through a step, so the accumulator isn't empty
+constexpr int DUMP_TRIES       = 2;   // The dump is named by the second, which may have ticked over
+
+static const char   DUMP_FILE[] = "crash-%lld.mdr";
+static const double REFRESH     = 1.0 / 144.0;  // Faster than the fixed step, so most frames carry time over
+
+// --- Global state ---
+
+log_Log* game_log;
+Game     g_game;
+double   g_accumulator;
+
+static double            g_deltas[FRAME_COUNT];
+static int               g_steps[FRAME_COUNT];  // As recorded
+static replay_Checkpoint g_checkpoint;
+static char              g_dump[64];
+
+// --- Mocked functions ---
+
+input_Frame input_getFrame(void) { return (input_Frame) {}; }
+
+bool input_setFrame([[maybe_unused]] const input_Frame* frame) { return false; }
+
+void* save_copyImage([[maybe_unused]] size_t* size) { return nullptr; }
+
+double game_getTime(void) { return 0.0; }
+
+int player_getLives(void) { return 0; }
+
+int player_getScore(void) { return 0; }
+
+int player_getCoinsCollected(void) { return 0; }
+
+game_PlayerState player_getState(void) { return 0; }
+
+Vector2 player_getPos(void) { return (Vector2) {}; }
+
+Vector2 creature_getPos([[maybe_unused]] int id) { return (Vector2) {}; }
+
+// --- Helper functions ---
+
+// As main.c's update() steps Arcade, the number of fixed steps the frame takes
+static int stepFrame(double* accumulator, double delta) {
+  int steps     = 0;
+  *accumulator += delta;
+  while (*accumulator >= FRAME_TIME) {
+    steps++;
+    *accumulator -= FRAME_TIME;
+  }
+  return steps;
+}
+
+// A frame rate that wanders either side of the refresh rate
+static void makeDeltas(void) {
+  for (int i = 0; i < FRAME_COUNT; i++) g_deltas[i] = REFRESH * (1.0 + 0.1 * ((i * 7) % 5 - 2));
+}
+
+// Records from boot to the checkpoint and on, then has a child crash so the recorder is dumped
+static bool recordDump(void) {
+  long long before = time(nullptr);
+  flight_open();
+  long long after = time(nullptr);
+
+  double accumulator = 0.0;
+  for (int i = 0; i < CHECKPOINT_FRAME; i++) stepFrame(&accumulator, g_deltas[i]);
+  g_checkpoint = (replay_Checkpoint) {
+    .seed        = 12345,
+    .difficulty  = DIFFICULTY_ARCADE,
+    .level       = 2,
+    .startLevel  = 1,
+    .gameTime    = 42.5,
+    .accumulator = accumulator
+  };
+  flight_checkpoint(&g_checkpoint);
+  for (int i = CHECKPOINT_FRAME; i < FRAME_COUNT; i++) {
+    flight_recordFrame(g_deltas[i]);
+    g_steps[i] = stepFrame(&accumulator, g_deltas[i]);
+  }
+
+  pid_t child = fork();
+  if (child == 0) raise(SIGABRT);
+  flight_close();
+  int status = 0;
+  if (child == -1 || waitpid(child, &status, 0) != child || !WIFSIGNALED(status)) return false;
+
+  for (int i = 0; i < DUMP_TRIES; i++) {
+    snprintf(g_dump, sizeof(g_dump), DUMP_FILE, i == 0 ? before : after);
+    if (access(g_dump, F_OK) == 0) return true;
+  }
+  return false;
+}
+
+// --- Setup and teardown ---
+
+void test_setup(void) {}
+
+void test_teardown(void) { replay_close(); }
+
+// --- Checkpoint tests ---
+
+MU_TEST(test_checkpoint_dumped) {
+  mu_check(replay_play(g_dump));
+
+  const replay_Checkpoint* checkpoint = replay_getCheckpoint();
+  mu_check(checkpoint != nullptr);
+  mu_check(memcmp(checkpoint, &g_checkpoint, sizeof(g_checkpoint)) == 0);
+  mu_check(checkpoint->accumulator > 0.0);
+  mu_assert_int_eq(FRAME_COUNT - CHECKPOINT_FRAME, replay_getFrameCount());
+}
+
+// Each frame takes the steps it did while recording, which it wouldn't from an empty accumulator
+MU_TEST(test_steps_from_checkpoint) {
+  mu_check(replay_play(g_dump));
+  const replay_Checkpoint* checkpoint = replay_getCheckpoint();
+  mu_check(checkpoint != nullptr);
+
+  double accumulator = checkpoint->accumulator;
+  double fromEmpty   = 0.0;
+  bool   isSame      = true;
+  bool   isSameEmpty = true;
+  for (int i = CHECKPOINT_FRAME; replay_isPlaying(); i++) {
+    replay_applyFrame();
+    double delta = replay_getDelta();
+    mu_check(delta == g_deltas[i]);
+    isSame      &= stepFrame(&accumulator, delta) == g_steps[i];
+    isSameEmpty &= stepFrame(&fromEmpty, delta) == g_steps[i];
+  }
+  mu_check(isSame);
+  mu_check(!isSameEmpty);
+}
+
+// --- Test suites ---
+
+MU_TEST_SUITE(checkpoint_suite) {
+  MU_SUITE_CONFIGURE(&test_setup, &test_teardown);
+  MU_RUN_TEST(test_checkpoint_dumped);
+  MU_RUN_TEST(test_steps_from_checkpoint);
+}
+
+// --- Main test runner ---
+
+int main(void) {
+  makeDeltas();
+  if (!recordDump()) {
+    fprintf(stderr, "Failed to dump the flight recorder\n");
+    remove(g_dump);
+    return 1;
+  }
+
+  printf("=== Replay Checkpoint Tests ===\n");
+  MU_RUN_SUITE(checkpoint_suite);
+
+  MU_REPORT();
+  remove(g_dump);
+  return MU_EXIT_CODE;
+}
@@ -0,0 +1,355 @@
+/*
+ * Run Log Tests
+ * Appends runs to a log in an empty directory and checks the best runs and ranks against a sort of the runs added, with
+ * the runs in the tail, indexed in runs.idx, merged from the two and after reopening with an index that can't be used
+ */
+
+#include <minunit/minunit.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "../src/game/internal.h"
+#include "../src/game/runs/runs.h"
+
+// --- Constants ---
+
+constexpr int INDEX_RUNS = 4096;  // runs.c's MAX_TAIL, the tail that has the index rebuilt
+constexpr int MAX_RUNS   = 2 * INDEX_RUNS;
+constexpr int LEVELS     = 3;  // Few, so each level has plenty of runs and ties
+constexpr int TOP_COUNT  = 20;
+
+static const char RUNS_FILE[]  = "runs.dat";
+static const char INDEX_FILE[] = "runs.idx";
+static const char SAVED_FILE[] = "runs.idx.saved";
+
+// --- Global state ---
+
+log_Log* game_log;
+
+static char        g_dir[] = "/tmp/test_runs_XXXXXX";
+static runs_Record g_added[MAX_RUNS];  // In the order added, as the log has them
+static int         g_addedCount;
+
+// --- Helper functions ---
+
+static game_Difficulty getDifficulty(int run) { return run % 5 == 0 ? DIFFICULTY_ARCADE : DIFFICULTY_NORMAL; }
+
+static int getLevel(int run) { return run % 7 == 0 ? RUNS_FULL_RUN : run % LEVELS; }
+
+// Spread out and repeating, so best runs turn up in the tail as well as the index and results tie
+static void addRuns(int count) {
+  for (int run = g_addedCount; run < g_addedCount + count; run++) {
+    double time  = 30.0 + ((run * 37) % 101) * 0.25;
+    int    score = ((run * 53) % 97) * 10;
+    g_added[run] = runs_add(getDifficulty(run), getLevel(run), time, score, run % 4);
+  }
+  g_addedCount += count;
+}
+
+static bool isMatch(const runs_Record* record, runs_Query query) {
+  return record->difficulty == query.difficulty && record->level == query.level &&
+         (query.player == RUNS_ALL_PLAYERS || record->player == query.player);
+}
+
+// The earlier run wins a tie, as in the log
+static int compareAdded(runs_Sort sort, int a, int b) {
+  const runs_Record* recordA = &g_added[a];
+  const runs_Record* recordB = &g_added[b];
+  int                result  = runs_compareResults(sort, recordA->time, recordA->score, recordB->time, recordB->score);
+  return result != 0 ? result : (a > b) - (a < b);
+}
+
+// The best runs matching the query, by insertion sort of the runs added
+static int getExpected(runs_Query query, int runs[], int count) {
+  int found = 0;
+  for (int i = 0; i < g_addedCount; i++) {
+    if (!isMatch(&g_added[i], query)) continue;
+
+    int position = found < count ? found++ : count;
+    while (position > 0 && compareAdded(query.sort, i, runs[position - 1]) < 0) {
+      if (position < count) runs[position] = runs[position - 1];
+      position--;
+    }
+    if (position < count) runs[position] = i;
+  }
+  return found;
+}
+
+static int getExpectedCount(runs_Query query) {
+  int count = 0;
+  for (int i = 0; i < g_addedCount; i++) {
+    if (isMatch(&g_added[i], query)) count++;
+  }
+  return count;
+}
+
+// Every level and sort of the difficulty, checking the top runs, the count and a rank against the runs added
+static bool isMatchingAdded(game_Difficulty difficulty) {
+  for (int level = 0; level <= LEVELS; level++) {
+    for (runs_Sort sort = 0; sort < RUNS_SORT_COUNT; sort++) {
+      runs_Query  query = { difficulty, level == LEVELS ? RUNS_FULL_RUN : level, sort, RUNS_ALL_PLAYERS };
+      runs_Record top[TOP_COUNT];
+      int         expected[TOP_COUNT];
+      int         found = runs_getTop(query, top, TOP_COUNT);
+      if (found != getExpected(query, expected, TOP_COUNT)) return false;
+      for (int i = 0; i < found; i++) {
+        if (memcmp(&top[i], &g_added[expected[i]], sizeof(runs_Record)) != 0) return false;
+      }
+      if (runs_getCount(query) != getExpectedCount(query)) return false;
+      if (found == 0) continue;
+
+      // The runs at least as good as the middle one, which is itself and any it ties with
+      const runs_Record* middle = &g_added[expected[found / 2]];
+      int                rank   = 0;
+      for (int i = 0; i < g_addedCount; i++) {
+        const runs_Record* record = &g_added[i];
+        if (!isMatch(record, query)) continue;
+        if (runs_compareResults(sort, record->time, record->score, middle->time, middle->score) <= 0) rank++;
+      }
+      if (runs_getRank(query, middle->time, middle->score) != rank) return false;
+    }
+  }
+  return true;
+}
+
+static bool isMatchingAll(void) {
+  return isMatchingAdded(DIFFICULTY_NORMAL) && isMatchingAdded(DIFFICULTY_ARCADE) &&
+         isMatchingAdded(DIFFICULTY_EASY);
+}
+
+static long readIndex(runs_IndexHeader* header) {
+  FILE* file = fopen(INDEX_FILE, "rb");
+  if (file == nullptr) return -1;
+  bool isRead = fread(header, sizeof(*header), 1, file) == 1;
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fclose(file);
+  return isRead ? size : -1;
+}
+
+static bool copyFile(const char* from, const char* to) {
+  FILE* in       = fopen(from, "rb");
+  FILE* out      = fopen(to, "wb");
+  bool  isCopied = in != nullptr && out != nullptr;
+  char  buffer[4096];
+  for (size_t size; isCopied && (size = fread(buffer, 1, sizeof(buffer), in)) > 0;) {
+    isCopied = fwrite(buffer, 1, size, out) == size;
+  }
+  if (in != nullptr) fclose(in);
+  if (out != nullptr && fclose(out) != 0) isCopied = false;
+  return isCopied;
+}
+
+// Writes value over the index at offset from the start, or from the end if negative
+static bool patchIndex(long offset, uint32_t value) {
+  FILE* file = fopen(INDEX_FILE, "r+b");
+  if (file == nullptr) return false;
+  bool isPatched = fseek(file, offset, offset < 0 ? SEEK_END : SEEK_SET) == 0 && fwrite(&value, 4, 1, file) == 1;
+  if (fclose(file) != 0) isPatched = false;
+  return isPatched;
+}
+
+// Indexes every run added so far, then adds a few more for the tail
+static bool makeIndexed(int tailCount) {
+  runs_open();
+  addRuns(INDEX_RUNS);
+  runs_close();
+  runs_IndexHeader header;
+  if (readIndex(&header) < 0 || header.recordCount != (uint32_t) INDEX_RUNS) return false;
+
+  runs_open();
+  addRuns(tailCount);
+  return true;
+}
+
+// --- Setup and teardown ---
+
+void test_setup(void) {
+  remove(RUNS_FILE);
+  remove(INDEX_FILE);
+  remove(SAVED_FILE);
+  g_addedCount = 0;
+}
+
+void test_teardown(void) { runs_close(); }
+
+// --- Log tests ---
+
+MU_TEST(test_append) {
+  runs_open();
+  addRuns(100);
+  mu_check(isMatchingAll());
+  mu_check(access(INDEX_FILE, F_OK) != 0);
+
+  runs_close();
+  runs_open();
+  mu_check(isMatchingAll());
+}
+
+MU_TEST(test_player) {
+  runs_open();
+  setenv("USER", "first", 1);
+  addRuns(50);
+  uint32_t first = g_added[0].player;
+  setenv("USER", "second", 1);
+  addRuns(50);
+  mu_check(first != g_added[50].player);
+
+  runs_Query  query = { DIFFICULTY_NORMAL, 1, RUNS_SORT_SCORE, first };
+  runs_Record top[TOP_COUNT];
+  int         expected[TOP_COUNT];
+  int         found = runs_getTop(query, top, TOP_COUNT);
+  mu_assert_int_eq(getExpected(query, expected, TOP_COUNT), found);
+  for (int i = 0; i < found; i++) mu_check(memcmp(&top[i], &g_added[expected[i]], sizeof(runs_Record)) == 0);
+}
+
+// --- Index tests ---
+
+MU_TEST(test_index_built) {
+  runs_open();
+  addRuns(INDEX_RUNS);
+  mu_check(isMatchingAll());
+  runs_close();
+
+  runs_IndexHeader header;
+  mu_check(readIndex(&header) > (long) sizeof(header));
+  mu_check(memcmp(header.magic, RUNS_INDEX_MAGIC, sizeof(header.magic)) == 0);
+  mu_assert_int_eq(INDEX_RUNS, header.recordCount);
+
+  runs_open();
+  mu_check(isMatchingAll());
+}
+
+MU_TEST(test_index_and_tail) {
+  mu_check(makeIndexed(300));
+  mu_check(isMatchingAll());
+
+  runs_close();
+  runs_open();
+  mu_check(isMatchingAll());
+}
+
+// A second build merges the tail into the index it was given
+MU_TEST(test_index_rebuilt) {
+  mu_check(makeIndexed(INDEX_RUNS));
+  mu_check(isMatchingAll());
+  runs_close();
+
+  runs_IndexHeader header;
+  mu_check(readIndex(&header) > 0);
+  mu_assert_int_eq(MAX_RUNS, header.recordCount);
+
+  runs_open();
+  mu_check(isMatchingAll());
+}
+
+// --- Bad index tests ---
+
+// An index of more runs than the log has, left by a log that was replaced
+MU_TEST(test_stale_index) {
+  mu_check(makeIndexed(0));
+  runs_close();
+  mu_check(copyFile(INDEX_FILE, SAVED_FILE));
+
+  remove(RUNS_FILE);
+  remove(INDEX_FILE);
+  g_addedCount = 0;
+  runs_open();
+  addRuns(200);
+  runs_close();
+  mu_check(rename(SAVED_FILE, INDEX_FILE) == 0);
+
+  runs_open();
+  mu_check(isMatchingAll());
+}
+
+MU_TEST(test_index_bad_record) {
+  mu_check(makeIndexed(100));
+  runs_close();
+  mu_check(patchIndex(-4, INDEX_RUNS + 50));
+
+  runs_open();
+  mu_check(isMatchingAll());
+}
+
+// The first key's best two runs swapped, so its runs are out of order
+MU_TEST(test_index_out_of_order) {
+  mu_check(makeIndexed(100));
+  runs_close();
+
+  runs_IndexHeader header;
+  mu_check(readIndex(&header) > 0);
+  long     first = sizeof(header) + (long) header.keyCount * sizeof(runs_Key);
+  uint32_t best[2];
+  FILE*    file  = fopen(INDEX_FILE, "rb");
+  mu_check(file != nullptr && fseek(file, first, SEEK_SET) == 0 && fread(best, sizeof(best), 1, file) == 1);
+  if (file != nullptr) fclose(file);
+  mu_check(patchIndex(first, best[1]) && patchIndex(first + 4, best[0]));
+
+  runs_open();
+  mu_check(isMatchingAll());
+}
+
+MU_TEST(test_index_bad_header) {
+  mu_check(makeIndexed(100));
+  runs_close();
+  mu_check(patchIndex(offsetof(runs_IndexHeader, keyCount), 0xffffffu));
+
+  runs_open();
+  mu_check(isMatchingAll());
+}
+
+MU_TEST(test_index_truncated) {
+  mu_check(makeIndexed(100));
+  runs_close();
+  runs_IndexHeader header;
+  long             size = readIndex(&header);
+  mu_check(size > 0 && truncate(INDEX_FILE, size / 2) == 0);
+
+  runs_open();
+  mu_check(isMatchingAll());
+}
+
+// --- Test suites ---
+
+MU_TEST_SUITE(log_suite) {
+  MU_SUITE_CONFIGURE(&test_setup, &test_teardown);
+  MU_RUN_TEST(test_append);
+  MU_RUN_TEST(test_player);
+}
+
+MU_TEST_SUITE(index_suite) {
+  MU_SUITE_CONFIGURE(&test_setup, &test_teardown);
+  MU_RUN_TEST(test_index_built);
+  MU_RUN_TEST(test_index_and_tail);
+  MU_RUN_TEST(test_index_rebuilt);
+}
+
+MU_TEST_SUITE(bad_index_suite) {
+  MU_SUITE_CONFIGURE(&test_setup, &test_teardown);
+  MU_RUN_TEST(test_stale_index);
+  MU_RUN_TEST(test_index_bad_record);
+  MU_RUN_TEST(test_index_out_of_order);
+  MU_RUN_TEST(test_index_bad_header);
+  MU_RUN_TEST(test_index_truncated);
+}
+
+// --- Main test runner ---
+
+int main(void) {
+  if (mkdtemp(g_dir) == nullptr || chdir(g_dir) != 0) {
+    fprintf(stderr, "Failed to make a directory for the run log\n");
+    return 1;
+  }
+
+  printf("=== Run Log Tests ===\n");
+  MU_RUN_SUITE(log_suite);
+  MU_RUN_SUITE(index_suite);
+  MU_RUN_SUITE(bad_index_suite);
+
+  MU_REPORT();
+  test_setup();
+  if (chdir("/") != 0 || rmdir(g_dir) != 0) fprintf(stderr, "Failed to remove %s\n", g_dir);
+  return MU_EXIT_CODE;
+}
@@ -0,0 +1,129 @@
+/*
+ * Startup Timing Tests
+ * Checks fixed stage timings against budget files and the JSON report written for them
+ */
+
+#include <minunit/minunit.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../src/game/internal.h"
+#include "../src/game/startup/startup.h"
+
+// --- Constants ---
+
+static const char BUDGET_FILE[] = "test_startup_budget.txt";
+static const char REPORT_FILE[] = "test_startup.json";
+constexpr size_t  REPORT_SIZE   = 4096;
+
+// --- Global state ---
+
+log_Log* game_log;
+
+// --- Helper functions ---
+
+static bool checkBudget(const char* budget) {
+  FILE* file = fopen(BUDGET_FILE, "w");
+  if (file == nullptr) return false;
+  fputs(budget, file);
+  fclose(file);
+  return startup_checkBudget(BUDGET_FILE);
+}
+
+// The whole report, or an empty string if it couldn't be read
+static const char* readReport(void) {
+  static char report[REPORT_SIZE];
+  report[0]  = '\0';
+  FILE* file = fopen(REPORT_FILE, "r");
+  if (file == nullptr) return report;
+  size_t size  = fread(report, 1, sizeof(report) - 1, file);
+  report[size] = '\0';
+  fclose(file);
+  return report;
+}
+
+// --- Setup and teardown ---
+
+void test_setup(void) {}
+
+void test_teardown(void) {
+  remove(BUDGET_FILE);
+  remove(REPORT_FILE);
+}
+
+// --- Budget tests ---
+
+MU_TEST(test_within_budget) {
+  mu_check(checkBudget("# Stage name = milliseconds\nStage Title = 20\nMap 1 parse (background) = 30.5  # Overlaps\n"));
+}
+
+MU_TEST(test_over_budget) {
+  mu_check(!checkBudget("Stage Title = 20\nStage Sounds = 99\n"));
+  mu_check(!checkBudget("Stage Sounds = 99.999\n"));
+}
+
+// The total can't be set here, but no startup takes less than no time
+MU_TEST(test_total) {
+  mu_check(checkBudget("Total = 60000\n"));
+  mu_check(!checkBudget("Total = -1\n"));
+}
+
+// Lines that can't be read, and stages that were never timed, are warned about rather than failed
+MU_TEST(test_skipped_lines) {
+  mu_check(checkBudget("Stage Title\nStage Sounds = fast\nStage Sounds = 10 ms\n\n   \nStage Missing = 0\n"));
+}
+
+MU_TEST(test_missing_budget) { mu_check(!startup_checkBudget("test_startup_missing.txt")); }
+
+// --- Report tests ---
+
+MU_TEST(test_report) {
+  mu_check(startup_writeJSON(REPORT_FILE));
+  const char* report = readReport();
+  mu_check(strstr(report, "\"total_ms\": ") != nullptr);
+  mu_check(strstr(report, "{ \"name\": \"Stage Title\", \"depth\": 0, \"start_ms\": ") != nullptr);
+  mu_check(strstr(report, "\"ms\": 10.000 },\n") != nullptr);
+  mu_check(strstr(report, "\"ms\": 100.000 }\n  ]\n}\n") != nullptr);
+}
+
+MU_TEST(test_report_escapes) {
+  mu_check(startup_writeJSON(REPORT_FILE));
+  mu_check(strstr(readReport(), "\"name\": \"Texture \\\"odd\\\\name\\\".png\"") != nullptr);
+}
+
+// --- Test suites ---
+
+MU_TEST_SUITE(budget_suite) {
+  MU_SUITE_CONFIGURE(&test_setup, &test_teardown);
+  MU_RUN_TEST(test_within_budget);
+  MU_RUN_TEST(test_over_budget);
+  MU_RUN_TEST(test_total);
+  MU_RUN_TEST(test_skipped_lines);
+  MU_RUN_TEST(test_missing_budget);
+}
+
+MU_TEST_SUITE(report_suite) {
+  MU_SUITE_CONFIGURE(&test_setup, &test_teardown);
+  MU_RUN_TEST(test_report);
+  MU_RUN_TEST(test_report_escapes);
+}
+
+// --- Main test runner ---
+
+// Times are added rather than measured, so every run sees the same stages
+int main(void) {
+  startup_add(0.010, "Stage %s", "Title");
+  startup_add(0.025, "Map %d parse (background)", 1);
+  startup_add(0.005, "Texture \"odd\\name\".png");
+  startup_add(0.100, "Stage %s", "Sounds");
+  startup_finish();
+
+  printf("=== Startup Budget Tests ===\n");
+  MU_RUN_SUITE(budget_suite);
+
+  printf("\n=== Startup Report Tests ===\n");
+  MU_RUN_SUITE(report_suite);
+
+  MU_REPORT();
+  return MU_EXIT_CODE;
+}
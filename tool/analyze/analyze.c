@@ -0,0 +1,641 @@
+/*
+ * analyze.c: Aggregates the game's telemetry for the designers. Segments are memory mapped and each session's are
+ * folded on a worker thread, one session at a time, then the workers' totals are summed and written out as per-level
+ * heatmaps on the maze grid and the distributions of clear times and lives lost.
+ *
+ * Usage: mythic-analyze [-j THREADS] OUTPUT_DIR TELEMETRY_DIR|SEGMENT...
+ */
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <game/game.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <telemetry/format.h>
+#include <unistd.h>
+
+// Both from raylib's source tree, which the game's own compression uses
+#define SINFL_IMPLEMENTATION
+#include <external/sinfl.h>
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <external/stb_image_write.h>
+
+// --- Constants ---
+
+constexpr int      GRID_COLS       = 29;  // The mazes' size in tiles
+constexpr int      GRID_ROWS       = 15;
+constexpr int      MAX_LEVEL_COUNT = 256;  // As the game's MAX_LEVELS
+constexpr int      MAX_THREADS     = 64;
+constexpr int      MAX_LIVES_LOST  = 15;   // Attempts that lost more are counted with these
+constexpr int      CLEAR_BUCKETS   = 600;  // A second each, slower clears are counted in the last
+constexpr uint32_t MAX_EVENTS      = 16 * 1024 * 1024;  // In one segment, anything larger is corrupt
+constexpr int      TILE_PIXELS     = 16;
+constexpr int      BAR_HEIGHT      = 64;  // Of each difficulty's clear time histogram
+constexpr size_t   PATH_LENGTH     = 1024;
+constexpr size_t   NAME_LENGTH     = 64;  // Of an output file, within the output directory
+
+static const char  SEGMENT_EXTENSION[]                = ".mdt";
+static const char* DIFFICULTY_NAMES[DIFFICULTY_COUNT] = { "easy", "normal", "arcade" };
+
+// --- Types ---
+
+typedef enum analyze_Heatmap {
+  HEATMAP_DEATHS,
+  HEATMAP_TRAPS,
+  HEATMAP_FALLS,
+  HEATMAP_CATCHES,
+  HEATMAP_TIME,
+  HEATMAP_COUNT
+} analyze_Heatmap;
+
+static const char* HEATMAP_NAMES[HEATMAP_COUNT] = { "deaths", "traps", "falls", "catches", "time" };
+
+// Heatmaps are across difficulties, the distributions by difficulty
+typedef struct analyze_Level {
+  double   heat[HEATMAP_COUNT][GRID_ROWS][GRID_COLS];  // Counts, or seconds for time
+  uint32_t attempts[DIFFICULTY_COUNT];                 // Ended by a clear or a game over
+  uint32_t clears[DIFFICULTY_COUNT];
+  double   clearTime[DIFFICULTY_COUNT];  // Total, for the mean
+  uint32_t clearTimes[DIFFICULTY_COUNT][CLEAR_BUCKETS];
+  uint32_t livesLost[DIFFICULTY_COUNT][MAX_LIVES_LOST + 1];
+} analyze_Level;
+
+typedef struct analyze_Stats {
+  analyze_Level* levels[MAX_LEVEL_COUNT];  // Only those played
+  uint64_t       events;
+  uint32_t       runs;
+  uint32_t       segments;
+  uint32_t       badSegments;
+} analyze_Stats;
+
+// The level attempt being followed through a session's events
+typedef struct analyze_Run {
+  uint32_t id;
+  bool     isPlaying;
+  int      level;
+  int      difficulty;
+  int      livesLost;
+  double   time;      // Spent moving, which is the player's clock less the ready screens
+  bool     isMoving;  // Since the last tile was entered
+  int      col;
+  int      row;
+  float    since;
+} analyze_Run;
+
+// Segments sharing a session and process, in order, folded on one thread as runs cross segments
+typedef struct analyze_Session {
+  int first;
+  int count;
+} analyze_Session;
+
+// --- Global state ---
+
+static struct {
+  char**           paths;  // Sorted, so each session's segments are together and in order
+  int              pathCount;
+  int              pathCapacity;
+  analyze_Session* sessions;
+  int              sessionCount;
+  atomic_int       nextSession;
+  analyze_Stats    stats[MAX_THREADS];
+} g_analyze;
+
+// --- Helper functions ---
+
+static bool addPath(const char* path) {
+  if (g_analyze.pathCount == g_analyze.pathCapacity) {
+    int    capacity = g_analyze.pathCapacity == 0 ? 256 : g_analyze.pathCapacity * 2;
+    char** paths    = realloc(g_analyze.paths, capacity * sizeof(*paths));
+    if (paths == nullptr) return false;
+    g_analyze.paths        = paths;
+    g_analyze.pathCapacity = capacity;
+  }
+  char* copy = strdup(path);
+  if (copy == nullptr) return false;
+  g_analyze.paths[g_analyze.pathCount++] = copy;
+  return true;
+}
+
+static bool isSegment(const char* name) {
+  size_t length = strlen(name);
+  size_t suffix = sizeof(SEGMENT_EXTENSION) - 1;
+  return length > suffix && strcmp(name + length - suffix, SEGMENT_EXTENSION) == 0;
+}
+
+// A telemetry directory's segments, or a segment itself
+static bool addInput(const char* path) {
+  struct stat info;
+  if (stat(path, &info) != 0) {
+    fprintf(stderr, "Unable to open %s (%s)\n", path, strerror(errno));
+    return false;
+  }
+  if (!S_ISDIR(info.st_mode)) return addPath(path);
+
+  DIR* dir = opendir(path);
+  if (dir == nullptr) {
+    fprintf(stderr, "Unable to open %s (%s)\n", path, strerror(errno));
+    return false;
+  }
+  bool           isOk  = true;
+  struct dirent* entry = nullptr;
+  while (isOk && (entry = readdir(dir)) != nullptr) {
+    if (!isSegment(entry->d_name)) continue;
+    char segment[PATH_LENGTH];
+    snprintf(segment, sizeof(segment), "%s/%s", path, entry->d_name);
+    isOk = addPath(segment);
+  }
+  closedir(dir);
+  return isOk;
+}
+
+static int comparePaths(const void* a, const void* b) { return strcmp(*(char* const*) a, *(char* const*) b); }
+
+// Segments are named session-process-sequence, so the session is everything before the last dash
+static size_t getSessionLength(const char* path) {
+  const char* dash = strrchr(path, '-');
+  return dash != nullptr ? (size_t) (dash - path) : strlen(path);
+}
+
+static bool groupSessions(void) {
+  qsort(g_analyze.paths, g_analyze.pathCount, sizeof(*g_analyze.paths), comparePaths);
+  g_analyze.sessions = malloc(g_analyze.pathCount * sizeof(*g_analyze.sessions));
+  if (g_analyze.sessions == nullptr) return false;
+
+  for (int i = 0; i < g_analyze.pathCount; i++) {
+    const char* path   = g_analyze.paths[i];
+    size_t      length = getSessionLength(path);
+    if (i > 0) {
+      const char* previous = g_analyze.paths[i - 1];
+      if (getSessionLength(previous) == length && memcmp(previous, path, length) == 0) {
+        g_analyze.sessions[g_analyze.sessionCount - 1].count++;
+        continue;
+      }
+    }
+    g_analyze.sessions[g_analyze.sessionCount++] = (analyze_Session) { .first = i, .count = 1 };
+  }
+  return true;
+}
+
+static analyze_Level* getLevel(analyze_Stats* stats, int level) {
+  if (level < 0 || level >= MAX_LEVEL_COUNT) return nullptr;
+  if (stats->levels[level] == nullptr) stats->levels[level] = calloc(1, sizeof(analyze_Level));
+  return stats->levels[level];
+}
+
+static inline bool isOnGrid(int col, int row) { return col >= 0 && col < GRID_COLS && row >= 0 && row < GRID_ROWS; }
+
+// Time on the tile the player was last seen entering
+static void leaveTile(analyze_Stats* stats, analyze_Run* run, float time) {
+  if (!run->isMoving) return;
+  run->isMoving = false;
+
+  double elapsed = time - run->since;
+  if (elapsed <= 0.0) return;
+  run->time            += elapsed;
+  analyze_Level* level  = getLevel(stats, run->level);
+  if (level != nullptr && isOnGrid(run->col, run->row)) level->heat[HEATMAP_TIME][run->row][run->col] += elapsed;
+}
+
+static void endAttempt(analyze_Stats* stats, analyze_Run* run, bool isCleared) {
+  analyze_Level* level = getLevel(stats, run->level);
+  run->isPlaying       = false;
+  if (level == nullptr || run->difficulty < 0 || run->difficulty >= DIFFICULTY_COUNT) return;
+
+  int difficulty = run->difficulty;
+  level->attempts[difficulty]++;
+  level->livesLost[difficulty][run->livesLost < MAX_LIVES_LOST ? run->livesLost : MAX_LIVES_LOST]++;
+  if (!isCleared) return;
+
+  int bucket = (int) run->time;
+  level->clears[difficulty]++;
+  level->clearTime[difficulty] += run->time;
+  level->clearTimes[difficulty][bucket < CLEAR_BUCKETS ? bucket : CLEAR_BUCKETS - 1]++;
+}
+
+static void addHeat(analyze_Stats* stats, analyze_Heatmap heatmap, const telemetry_Event* event) {
+  analyze_Level* level = getLevel(stats, event->level);
+  if (level != nullptr && isOnGrid(event->col, event->row)) level->heat[heatmap][event->row][event->col] += 1.0;
+}
+
+static void foldEvent(analyze_Stats* stats, analyze_Run* run, const telemetry_Event* event) {
+  stats->events++;
+  if (event->type == TELEMETRY_RUN_START) {
+    *run = (analyze_Run) { .id = event->run };
+    stats->runs++;
+  }
+  if (event->run != run->id) return;  // From a run that started before the first segment
+
+  switch (event->type) {
+    case TELEMETRY_RUN_START:
+    case TELEMETRY_LEVEL_START:
+      *run = (analyze_Run) {
+        .id = event->run, .isPlaying = true, .level = event->level, .difficulty = event->difficulty
+      };
+      break;
+
+    case TELEMETRY_TILE:
+      if (!run->isPlaying) break;
+      leaveTile(stats, run, event->time);
+      run->isMoving = true;
+      run->col      = event->col;
+      run->row      = event->row;
+      run->since    = event->time;
+      break;
+
+    case TELEMETRY_DEATH:
+      addHeat(stats, HEATMAP_DEATHS, event);
+      if (event->subject == TELEMETRY_DEATH_CREATURE) {
+        addHeat(stats, HEATMAP_CATCHES, event);
+      } else if (event->subject == TELEMETRY_DEATH_FALL) {
+        addHeat(stats, HEATMAP_FALLS, event);
+      } else {
+        addHeat(stats, HEATMAP_TRAPS, event);
+      }
+      if (!run->isPlaying) break;
+      leaveTile(stats, run, event->time);
+      run->livesLost++;
+      break;
+
+    case TELEMETRY_LEVEL_CLEAR:
+    case TELEMETRY_GAME_OVER:
+      if (!run->isPlaying) break;
+      leaveTile(stats, run, event->time);
+      endAttempt(stats, run, event->type == TELEMETRY_LEVEL_CLEAR);
+      break;
+
+    default: break;
+  }
+}
+
+static bool isValidHeader(const telemetry_SegmentHeader* header, size_t size) {
+  size_t eventsSize = (size_t) header->eventCount * sizeof(telemetry_Event);
+  return memcmp(header->magic, TELEMETRY_MAGIC, sizeof(header->magic)) == 0 && header->version == TELEMETRY_VERSION &&
+         header->eventSize == sizeof(telemetry_Event) && header->eventCount <= MAX_EVENTS &&
+         header->dataSize <= size - sizeof(*header) &&
+         (header->compression == TELEMETRY_DEFLATE ||
+          (header->compression == TELEMETRY_STORED && header->dataSize == eventsSize));
+}
+
+// Events are copied out as they're folded, the buffer only holds inflated segments and grows to the largest
+static bool foldSegment(analyze_Stats* stats, analyze_Run* run, const char* path, void** buffer, size_t* capacity) {
+  int fd = open(path, O_RDONLY);
+  if (fd == -1) return false;
+  struct stat info;
+  if (fstat(fd, &info) != 0 || (size_t) info.st_size < sizeof(telemetry_SegmentHeader)) {
+    close(fd);
+    return false;
+  }
+  size_t size    = info.st_size;
+  void*  mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) return false;
+  madvise(mapping, size, MADV_SEQUENTIAL);
+
+  telemetry_SegmentHeader header;
+  memcpy(&header, mapping, sizeof(header));
+  const unsigned char* data   = (const unsigned char*) mapping + sizeof(header);
+  const unsigned char* events = nullptr;
+  if (isValidHeader(&header, size)) {
+    size_t eventsSize = (size_t) header.eventCount * sizeof(telemetry_Event);
+    if (header.compression == TELEMETRY_STORED) {
+      events = data;
+    } else {
+      if (eventsSize > *capacity) {
+        free(*buffer);
+        *capacity = eventsSize;
+        *buffer   = malloc(eventsSize);
+      }
+      if (*buffer != nullptr && sinflate(*buffer, (int) eventsSize, data, (int) header.dataSize) == (int) eventsSize) {
+        events = *buffer;
+      }
+    }
+  }
+
+  if (events != nullptr) {
+    for (uint32_t i = 0; i < header.eventCount; i++) {
+      telemetry_Event event;
+      memcpy(&event, events + i * sizeof(event), sizeof(event));
+      foldEvent(stats, run, &event);
+    }
+  }
+  munmap(mapping, size);
+  return events != nullptr;
+}
+
+static void* workerThread(void* arg) {
+  analyze_Stats* stats    = arg;
+  void*          buffer   = nullptr;
+  size_t         capacity = 0;
+
+  int session;
+  while ((session = atomic_fetch_add_explicit(&g_analyze.nextSession, 1, memory_order_relaxed)) <
+         g_analyze.sessionCount) {
+    analyze_Run run = {};
+    for (int i = 0; i < g_analyze.sessions[session].count; i++) {
+      const char* path = g_analyze.paths[g_analyze.sessions[session].first + i];
+      if (foldSegment(stats, &run, path, &buffer, &capacity)) {
+        stats->segments++;
+      } else {
+        fprintf(stderr, "Skipping %s, it isn't a telemetry segment from this version\n", path);
+        stats->badSegments++;
+      }
+    }
+  }
+  free(buffer);
+  return nullptr;
+}
+
+// Into the first worker's
+static void reduceStats(int threadCount) {
+  analyze_Stats* total = &g_analyze.stats[0];
+  for (int t = 1; t < threadCount; t++) {
+    analyze_Stats* stats  = &g_analyze.stats[t];
+    total->events        += stats->events;
+    total->runs          += stats->runs;
+    total->segments      += stats->segments;
+    total->badSegments   += stats->badSegments;
+
+    for (int l = 0; l < MAX_LEVEL_COUNT; l++) {
+      analyze_Level* from = stats->levels[l];
+      if (from == nullptr) continue;
+      analyze_Level* to = total->levels[l];
+      if (to == nullptr) {
+        total->levels[l] = from;
+        stats->levels[l] = nullptr;
+        continue;
+      }
+
+      double* toHeat = &to->heat[0][0][0];
+      for (size_t i = 0; i < sizeof(to->heat) / sizeof(double); i++) toHeat[i] += (&from->heat[0][0][0])[i];
+      for (int d = 0; d < DIFFICULTY_COUNT; d++) {
+        to->attempts[d]  += from->attempts[d];
+        to->clears[d]    += from->clears[d];
+        to->clearTime[d] += from->clearTime[d];
+        for (int b = 0; b < CLEAR_BUCKETS; b++) to->clearTimes[d][b] += from->clearTimes[d][b];
+        for (int n = 0; n <= MAX_LIVES_LOST; n++) to->livesLost[d][n] += from->livesLost[d][n];
+      }
+      free(from);
+      stats->levels[l] = nullptr;
+    }
+  }
+}
+
+// --- Output functions ---
+
+static FILE* openOutput(const char* dir, const char* name) {
+  char path[PATH_LENGTH];
+  snprintf(path, sizeof(path), "%s/%s", dir, name);
+  FILE* stream = fopen(path, "w");
+  if (stream == nullptr) fprintf(stderr, "Unable to create %s (%s)\n", path, strerror(errno));
+  return stream;
+}
+
+static bool closeOutput(FILE* stream, const char* name) {
+  if (fclose(stream) == 0) return true;
+  fprintf(stderr, "Failed to write %s\n", name);
+  return false;
+}
+
+// Black through red and yellow to white
+static void heatColour(double value, unsigned char* pixel) {
+  double scaled = value * 3.0;
+  for (int channel = 0; channel < 3; channel++) {
+    pixel[channel] = (unsigned char) (fmax(fmin(scaled - channel, 1.0), 0.0) * 255.0);
+  }
+}
+
+static bool writeHeatmapImage(
+  const char* dir, int level, analyze_Heatmap heatmap, const double heat[GRID_ROWS][GRID_COLS]
+) {
+  static unsigned char pixels[GRID_ROWS * TILE_PIXELS][GRID_COLS * TILE_PIXELS][3];
+
+  double highest = 0.0;
+  for (int row = 0; row < GRID_ROWS; row++) {
+    for (int col = 0; col < GRID_COLS; col++) highest = fmax(highest, heat[row][col]);
+  }
+  for (int y = 0; y < GRID_ROWS * TILE_PIXELS; y++) {
+    for (int x = 0; x < GRID_COLS * TILE_PIXELS; x++) {
+      double value = highest > 0.0 ? heat[y / TILE_PIXELS][x / TILE_PIXELS] / highest : 0.0;
+      heatColour(value, pixels[y][x]);
+    }
+  }
+
+  char path[PATH_LENGTH];
+  snprintf(path, sizeof(path), "%s/level%02d-%s.png", dir, level + 1, HEATMAP_NAMES[heatmap]);
+  if (stbi_write_png(path, GRID_COLS * TILE_PIXELS, GRID_ROWS * TILE_PIXELS, 3, pixels, sizeof(pixels[0])) != 0) {
+    return true;
+  }
+  fprintf(stderr, "Failed to write %s\n", path);
+  return false;
+}
+
+// Rows and columns as the maze, with the image alongside
+static bool writeHeatmap(const char* dir, int level, analyze_Heatmap heatmap, const double heat[GRID_ROWS][GRID_COLS]) {
+  char file[NAME_LENGTH];
+  snprintf(file, sizeof(file), "level%02d-%s.csv", level + 1, HEATMAP_NAMES[heatmap]);
+  FILE* stream = openOutput(dir, file);
+  if (stream == nullptr) return false;
+
+  for (int row = 0; row < GRID_ROWS; row++) {
+    for (int col = 0; col < GRID_COLS; col++) {
+      fprintf(stream, heatmap == HEATMAP_TIME ? "%.2f%s" : "%.0f%s", heat[row][col], col < GRID_COLS - 1 ? "," : "\n");
+    }
+  }
+  return closeOutput(stream, file) && writeHeatmapImage(dir, level, heatmap, heat);
+}
+
+// A bar per second for each difficulty, one above the other, each scaled to its own most common time
+static bool writeClearTimesImage(const char* dir, int level, const analyze_Level* stats) {
+  static unsigned char pixels[DIFFICULTY_COUNT * BAR_HEIGHT][CLEAR_BUCKETS][3];
+  static const unsigned char COLOURS[DIFFICULTY_COUNT][3] = {
+    { 80, 200, 120 },
+    { 240, 200, 80 },
+    { 230, 90, 80 }
+  };
+
+  memset(pixels, 0, sizeof(pixels));
+  for (int d = 0; d < DIFFICULTY_COUNT; d++) {
+    uint32_t highest = 0;
+    for (int b = 0; b < CLEAR_BUCKETS; b++) {
+      if (stats->clearTimes[d][b] > highest) highest = stats->clearTimes[d][b];
+    }
+    if (highest == 0) continue;
+
+    for (int b = 0; b < CLEAR_BUCKETS; b++) {
+      int height = (int) ((uint64_t) stats->clearTimes[d][b] * (BAR_HEIGHT - 1) / highest);
+      for (int y = 0; y < height; y++) memcpy(pixels[(d + 1) * BAR_HEIGHT - 1 - y][b], COLOURS[d], 3);
+    }
+  }
+
+  char path[PATH_LENGTH];
+  snprintf(path, sizeof(path), "%s/level%02d-clear-times.png", dir, level + 1);
+  if (stbi_write_png(path, CLEAR_BUCKETS, DIFFICULTY_COUNT * BAR_HEIGHT, 3, pixels, sizeof(pixels[0])) != 0) {
+    return true;
+  }
+  fprintf(stderr, "Failed to write %s\n", path);
+  return false;
+}
+
+// The bucket that count / fraction of the clears are at or below
+static int getPercentile(const uint32_t clearTimes[CLEAR_BUCKETS], uint32_t count, double fraction) {
+  uint64_t target = (uint64_t) (count * fraction + 0.5);
+  uint64_t seen   = 0;
+  for (int b = 0; b < CLEAR_BUCKETS; b++) {
+    seen += clearTimes[b];
+    if (seen >= target && seen > 0) return b;
+  }
+  return CLEAR_BUCKETS - 1;
+}
+
+static bool writeSummary(const char* dir, const analyze_Stats* stats) {
+  static const char NAME[] = "levels.csv";
+  FILE*             stream = openOutput(dir, NAME);
+  if (stream == nullptr) return false;
+
+  fprintf(
+      stream,
+      "level,difficulty,attempts,clears,clear_rate,mean_clear_time,median_clear_time,p90_clear_time,mean_lives_lost\n"
+  );
+  for (int l = 0; l < MAX_LEVEL_COUNT; l++) {
+    const analyze_Level* level = stats->levels[l];
+    if (level == nullptr) continue;
+    for (int d = 0; d < DIFFICULTY_COUNT; d++) {
+      if (level->attempts[d] == 0) continue;
+
+      uint64_t livesLost = 0;
+      for (int n = 0; n <= MAX_LIVES_LOST; n++) livesLost += (uint64_t) n * level->livesLost[d][n];
+      uint32_t clears = level->clears[d];
+      fprintf(
+          stream,
+          "%d,%s,%u,%u,%.3f,",
+          l + 1,
+          DIFFICULTY_NAMES[d],
+          level->attempts[d],
+          clears,
+          (double) clears / level->attempts[d]
+      );
+      if (clears > 0) {
+        fprintf(
+            stream,
+            "%.2f,%d,%d,",
+            level->clearTime[d] / clears,
+            getPercentile(level->clearTimes[d], clears, 0.5),
+            getPercentile(level->clearTimes[d], clears, 0.9)
+        );
+      } else {
+        fprintf(stream, ",,,");
+      }
+      fprintf(stream, "%.3f\n", (double) livesLost / level->attempts[d]);
+    }
+  }
+  return closeOutput(stream, NAME);
+}
+
+// Long form, a row for each count, as spreadsheets and plotting tools prefer
+static bool writeDistributions(const char* dir, const analyze_Stats* stats) {
+  static const char CLEAR_NAME[] = "clear-times.csv";
+  static const char LIVES_NAME[] = "lives-lost.csv";
+  FILE*             clearTimes   = openOutput(dir, CLEAR_NAME);
+  FILE*             livesLost    = openOutput(dir, LIVES_NAME);
+  if (clearTimes == nullptr || livesLost == nullptr) {
+    if (clearTimes != nullptr) fclose(clearTimes);
+    if (livesLost != nullptr) fclose(livesLost);
+    return false;
+  }
+
+  fprintf(clearTimes, "level,difficulty,seconds,clears\n");
+  fprintf(livesLost, "level,difficulty,lives_lost,attempts\n");
+  for (int l = 0; l < MAX_LEVEL_COUNT; l++) {
+    const analyze_Level* level = stats->levels[l];
+    if (level == nullptr) continue;
+    for (int d = 0; d < DIFFICULTY_COUNT; d++) {
+      for (int b = 0; b < CLEAR_BUCKETS; b++) {
+        if (level->clearTimes[d][b] > 0) {
+          fprintf(clearTimes, "%d,%s,%d,%u\n", l + 1, DIFFICULTY_NAMES[d], b, level->clearTimes[d][b]);
+        }
+      }
+      for (int n = 0; n <= MAX_LIVES_LOST; n++) {
+        if (level->livesLost[d][n] > 0) {
+          fprintf(livesLost, "%d,%s,%d,%u\n", l + 1, DIFFICULTY_NAMES[d], n, level->livesLost[d][n]);
+        }
+      }
+    }
+  }
+  bool isClearTimesOk = closeOutput(clearTimes, CLEAR_NAME);
+  return closeOutput(livesLost, LIVES_NAME) && isClearTimesOk;
+}
+
+static bool writeOutput(const char* dir, const analyze_Stats* stats) {
+  if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+    fprintf(stderr, "Unable to create %s (%s)\n", dir, strerror(errno));
+    return false;
+  }
+
+  bool isOk = writeSummary(dir, stats) && writeDistributions(dir, stats);
+  for (int l = 0; isOk && l < MAX_LEVEL_COUNT; l++) {
+    const analyze_Level* level = stats->levels[l];
+    if (level == nullptr) continue;
+    for (int h = 0; isOk && h < HEATMAP_COUNT; h++) isOk = writeHeatmap(dir, l, h, level->heat[h]);
+    if (isOk) isOk = writeClearTimesImage(dir, l, level);
+  }
+  return isOk;
+}
+
+// --- Main ---
+
+int main(int argc, char* argv[]) {
+  int threadCount = (int) sysconf(_SC_NPROCESSORS_ONLN);
+  int arg         = 1;
+  if (argc > 2 && strcmp(argv[1], "-j") == 0) {
+    threadCount  = atoi(argv[2]);
+    arg         += 2;
+  }
+  if (argc - arg < 2 || threadCount < 1) {
+    fprintf(stderr, "Usage: %s [-j THREADS] OUTPUT_DIR TELEMETRY_DIR|SEGMENT...\n", argv[0]);
+    return 1;
+  }
+  const char* outputDir = argv[arg++];
+
+  for (; arg < argc; arg++) {
+    if (!addInput(argv[arg])) return 1;
+  }
+  if (g_analyze.pathCount == 0) {
+    fprintf(stderr, "No telemetry segments found\n");
+    return 1;
+  }
+  if (!groupSessions()) {
+    fprintf(stderr, "Out of memory\n");
+    return 1;
+  }
+
+  if (threadCount > MAX_THREADS) threadCount = MAX_THREADS;
+  if (threadCount > g_analyze.sessionCount) threadCount = g_analyze.sessionCount;
+  pthread_t threads[MAX_THREADS];
+  int       started = 0;
+  for (; started < threadCount; started++) {
+    if (pthread_create(&threads[started], nullptr, workerThread, &g_analyze.stats[started]) != 0) break;
+  }
+  for (int t = 0; t < started; t++) pthread_join(threads[t], nullptr);
+  if (started == 0) workerThread(&g_analyze.stats[0]);  // Fold everything here instead
+  reduceStats(started > 0 ? started : 1);
+
+  const analyze_Stats* total = &g_analyze.stats[0];
+  if (!writeOutput(outputDir, total)) return 1;
+  printf(
+      "Folded %llu events from %u runs in %u segments on %d threads",
+      (unsigned long long) total->events,
+      total->runs,
+      total->segments,
+      started > 0 ? started : 1
+  );
+  if (total->badSegments > 0) printf(", skipped %u", total->badSegments);
+  printf("\n");
+  return 0;
+}
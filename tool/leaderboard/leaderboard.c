@@ -0,0 +1,683 @@
+/*
+ * leaderboard.c: A leaderboard shared by the cabinets on one network. Takes batches of runs from the game, keeps the
+ * best of them under each key in memory to answer top-N queries and appends new runs to a log every few seconds.
+ *
+ * Usage: leaderboard serve DIR [[HOST:]PORT]
+ *        leaderboard top DIFFICULTY LEVEL time|score [COUNT] [[HOST:]PORT]
+ *        leaderboard submit RUNS_FILE [[HOST:]PORT]
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <game/game.h>
+#include <leaderboard/protocol.h>
+#include <math.h>
+#include <net/address.h>
+#include <netdb.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+// --- Constants ---
+
+constexpr int    MAX_CLIENTS       = 64;
+constexpr int    MAX_LEVEL_COUNT   = 256;  // As the game's MAX_LEVELS
+constexpr int    SNAPSHOT_INTERVAL = 10 * 1000;  // Milliseconds between writing new runs to the log
+constexpr int    SUBMIT_BATCH      = 256;
+constexpr int    TIMEOUT           = 5000;  // Milliseconds for top and submit to send or hear back
+constexpr size_t PATH_LENGTH       = 1024;
+constexpr size_t READ_SIZE         = 64 * 1024;
+constexpr size_t MAX_PENDING       = 256 * 1024;  // Replies held for a client before its requests are left unread
+
+static const char  RUNS_FILE[]       = "runs.dat";
+static const char  REPLAY_DIR[]      = "replays";
+static const char  REPLAY_MAGIC[4]   = { 'M', 'D', 'R', 'P' };
+static const char* DIFFICULTY_NAMES[DIFFICULTY_COUNT] = { "easy", "normal", "arcade" };
+static const char* SORT_NAMES[RUNS_SORT_COUNT]        = { "time", "score" };
+
+// --- Types ---
+
+typedef struct leaderboard_Board {
+  runs_Key key;
+  uint32_t total;
+  int      topCount;
+  uint32_t top[LEADERBOARD_MAX_TOP];  // Record numbers, best first
+} leaderboard_Board;
+
+typedef struct leaderboard_Buffer {
+  unsigned char* data;
+  size_t         size;
+  size_t         capacity;
+} leaderboard_Buffer;
+
+// Sockets don't block, so a client that stops reading only fills its own output
+typedef struct leaderboard_Client {
+  int                fd;
+  leaderboard_Buffer input;
+  leaderboard_Buffer output;
+} leaderboard_Client;
+
+// --- Global state ---
+
+static struct {
+  runs_Record*       records;
+  uint32_t           recordCount;
+  uint32_t           recordCapacity;
+  uint32_t           savedCount;  // Records already in the log
+  FILE*              stream;
+  leaderboard_Board* boards;  // Sorted by key
+  int                boardCount;
+  int                boardCapacity;
+  const char*        dir;
+} g_board;
+
+static leaderboard_Client    g_clients[MAX_CLIENTS];
+static volatile sig_atomic_t g_isQuitting;
+
+// --- Helper functions ---
+
+static int64_t getMilliseconds(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (int64_t) now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+static void quit([[maybe_unused]] int signal) { g_isQuitting = true; }
+
+// The default port on this machine without one
+static int openSocket(const char* text, bool isServer) {
+  char defaultPort[NET_PORT_LENGTH];
+  snprintf(defaultPort, sizeof(defaultPort), "%u", LEADERBOARD_PORT);
+  net_Address address;
+  if (!net_parseAddress(text != nullptr ? text : defaultPort, &address)) {
+    fprintf(stderr, "Not an address: %s\n", text);
+    return -1;
+  }
+  const char* host = address.host;
+  const char* port = address.port;
+
+  struct addrinfo  hints = { .ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM, .ai_flags = AI_PASSIVE * isServer };
+  struct addrinfo* info;
+  int              error = getaddrinfo(host, port, &hints, &info);
+  if (error != 0) {
+    fprintf(stderr, "Unable to resolve %s:%s (%s)\n", host, port, gai_strerror(error));
+    return -1;
+  }
+
+  // Clients give up on a daemon that stops answering rather than hanging
+  struct timeval timeout = { .tv_sec = TIMEOUT / 1000, .tv_usec = TIMEOUT % 1000 * 1000 };
+  int            fd      = -1;
+  for (struct addrinfo* item = info; fd == -1 && item != nullptr; item = item->ai_next) {
+    fd = socket(item->ai_family, item->ai_socktype, item->ai_protocol);
+    if (fd == -1) continue;
+
+    int  reuse    = 1;
+    bool isOpened = isServer ? setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) == 0 &&
+                                   bind(fd, item->ai_addr, item->ai_addrlen) == 0 && listen(fd, MAX_CLIENTS) == 0
+                             : setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)) == 0 &&
+                                   setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) == 0 &&
+                                   connect(fd, item->ai_addr, item->ai_addrlen) == 0;
+    if (!isOpened) {
+      close(fd);
+      fd = -1;
+    }
+  }
+  freeaddrinfo(info);
+
+  if (fd == -1) {
+    const char* action = isServer ? "listen on" : "connect to";
+    fprintf(stderr, "Unable to %s %s:%s (%s)\n", action, host, port, strerror(errno));
+  }
+  return fd;
+}
+
+static bool reserve(leaderboard_Buffer* buffer, size_t size) {
+  if (buffer->capacity - buffer->size >= size) return true;
+
+  size_t         capacity = buffer->size + size + READ_SIZE;
+  unsigned char* data     = realloc(buffer->data, capacity);
+  if (data == nullptr) return false;
+  buffer->data     = data;
+  buffer->capacity = capacity;
+  return true;
+}
+
+static void consume(leaderboard_Buffer* buffer, size_t size) {
+  memmove(buffer->data, buffer->data + size, buffer->size - size);
+  buffer->size -= size;
+}
+
+static bool sendAll(int fd, const void* data, size_t size) {
+  const unsigned char* bytes = data;
+  while (size > 0) {
+    ssize_t sent = send(fd, bytes, size, 0);
+    if (sent < 0 && errno == EINTR) continue;
+    if (sent <= 0) return false;
+    bytes += sent;
+    size  -= sent;
+  }
+  return true;
+}
+
+static bool receiveAll(int fd, void* data, size_t size) {
+  unsigned char* bytes = data;
+  while (size > 0) {
+    ssize_t received = recv(fd, bytes, size, 0);
+    if (received < 0 && errno == EINTR) continue;
+    if (received <= 0) return false;
+    bytes += received;
+    size  -= received;
+  }
+  return true;
+}
+
+// In one send, a header sent on its own waits on the peer's delayed ack. For top and submit, which can wait on it.
+static bool sendMessage(int fd, leaderboard_Type type, const void* data, size_t size) {
+  unsigned char* message = malloc(sizeof(leaderboard_Header) + size);
+  if (message == nullptr) return false;
+  leaderboard_Header header = { .version = LEADERBOARD_VERSION, .type = type, .size = size };
+  memcpy(header.magic, LEADERBOARD_MAGIC, sizeof(header.magic));
+  memcpy(message, &header, sizeof(header));
+  memcpy(message + sizeof(header), data, size);
+  bool isSent = sendAll(fd, message, sizeof(header) + size);
+  free(message);
+  return isSent;
+}
+
+// The daemon's side, sent as the client's socket has room
+static bool queueMessage(leaderboard_Client* client, leaderboard_Type type, const void* data, size_t size) {
+  if (!reserve(&client->output, sizeof(leaderboard_Header) + size)) return false;
+
+  leaderboard_Header header = { .version = LEADERBOARD_VERSION, .type = type, .size = size };
+  memcpy(header.magic, LEADERBOARD_MAGIC, sizeof(header.magic));
+  memcpy(client->output.data + client->output.size, &header, sizeof(header));
+  memcpy(client->output.data + client->output.size + sizeof(header), data, size);
+  client->output.size += sizeof(header) + size;
+  return true;
+}
+
+// Waits for the reply of the given type, returning its payload for the caller to free
+static void* receiveMessage(int fd, leaderboard_Type type, size_t* size) {
+  leaderboard_Header header;
+  if (!receiveAll(fd, &header, sizeof(header)) || !leaderboard_isValidHeader(&header) || header.type != type) {
+    return nullptr;
+  }
+
+  void* data = malloc(header.size > 0 ? header.size : 1);
+  if (data == nullptr || !receiveAll(fd, data, header.size)) {
+    free(data);
+    return nullptr;
+  }
+  *size = header.size;
+  return data;
+}
+
+static runs_Key makeKey(uint32_t player, int difficulty, int level, runs_Sort sort) {
+  return (runs_Key) { .player = player, .level = level, .difficulty = difficulty, .sort = sort };
+}
+
+static int compareKeys(const runs_Key* a, const runs_Key* b) {
+  if (a->player != b->player) return a->player < b->player ? -1 : 1;
+  if (a->difficulty != b->difficulty) return a->difficulty < b->difficulty ? -1 : 1;
+  if (a->level != b->level) return a->level < b->level ? -1 : 1;
+  return (a->sort > b->sort) - (a->sort < b->sort);
+}
+
+// Binary search of the sorted boards, adding the key where it belongs if asked to
+static leaderboard_Board* findBoard(runs_Key key, bool isAdded) {
+  int low  = 0;
+  int high = g_board.boardCount;
+  while (low < high) {
+    int middle = low + (high - low) / 2;
+    int order  = compareKeys(&g_board.boards[middle].key, &key);
+    if (order == 0) return &g_board.boards[middle];
+    if (order < 0) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  if (!isAdded) return nullptr;
+
+  if (g_board.boardCount == g_board.boardCapacity) {
+    int                capacity = g_board.boardCapacity > 0 ? g_board.boardCapacity * 2 : 64;
+    leaderboard_Board* boards   = realloc(g_board.boards, capacity * sizeof(leaderboard_Board));
+    if (boards == nullptr) return nullptr;
+    g_board.boards        = boards;
+    g_board.boardCapacity = capacity;
+  }
+  leaderboard_Board* board = &g_board.boards[low];
+  memmove(board + 1, board, (g_board.boardCount - low) * sizeof(leaderboard_Board));
+  g_board.boardCount++;
+  *board = (leaderboard_Board) { .key = key };
+  return board;
+}
+
+static void addToBoard(leaderboard_Board* board, uint32_t record) {
+  board->total++;
+
+  int       position = board->topCount;
+  runs_Sort sort     = board->key.sort;
+  while (position > 0 && runs_compareRecords(g_board.records, sort, record, board->top[position - 1]) < 0) position--;
+  if (position == LEADERBOARD_MAX_TOP) return;
+
+  int moved = (board->topCount < LEADERBOARD_MAX_TOP ? board->topCount : LEADERBOARD_MAX_TOP - 1) - position;
+  memmove(&board->top[position + 1], &board->top[position], moved * sizeof(uint32_t));
+  board->top[position] = record;
+  if (board->topCount < LEADERBOARD_MAX_TOP) board->topCount++;
+}
+
+// Under everyone's keys and the player's, for each sort
+static bool addRecord(const runs_Record* record) {
+  if (g_board.recordCount == g_board.recordCapacity) {
+    uint32_t     capacity = g_board.recordCapacity > 0 ? g_board.recordCapacity * 2 : 4096;
+    runs_Record* records  = realloc(g_board.records, capacity * sizeof(runs_Record));
+    if (records == nullptr) return false;
+    g_board.records        = records;
+    g_board.recordCapacity = capacity;
+  }
+  uint32_t number         = g_board.recordCount++;
+  g_board.records[number] = *record;
+
+  // One at a time, adding a board moves the others
+  for (runs_Sort sort = 0; sort < RUNS_SORT_COUNT; sort++) {
+    uint32_t players[] = { RUNS_ALL_PLAYERS, record->player };
+    for (size_t i = 0; i < sizeof(players) / sizeof(players[0]); i++) {
+      leaderboard_Board* board = findBoard(makeKey(players[i], record->difficulty, record->level, sort), true);
+      if (board == nullptr) return false;
+      addToBoard(board, number);
+    }
+  }
+  return true;
+}
+
+// Anything the game couldn't have produced is dropped. A replay is kept so the run can be checked by playing it back.
+static bool isValidRun(const runs_Record* record, const unsigned char* replay, uint32_t replaySize) {
+  if (record->difficulty >= DIFFICULTY_COUNT || record->player == RUNS_ALL_PLAYERS) return false;
+  if (record->level >= MAX_LEVEL_COUNT && record->level != RUNS_FULL_RUN) return false;
+  if (!isfinite(record->time) || record->time <= 0.0 || record->score < 0) return false;
+  return replaySize == 0 || (replaySize >= sizeof(REPLAY_MAGIC) && memcmp(replay, REPLAY_MAGIC, 4) == 0);
+}
+
+static void saveReplay(uint32_t record, const unsigned char* replay, uint32_t replaySize) {
+  char path[PATH_LENGTH];
+  snprintf(path, sizeof(path), "%s/%s/%08u.mdr", g_board.dir, REPLAY_DIR, record);
+  FILE* stream    = fopen(path, "wb");
+  bool  isWritten = stream != nullptr && fwrite(replay, replaySize, 1, stream) == 1;
+  if (stream != nullptr && fclose(stream) != 0) isWritten = false;
+  if (!isWritten) fprintf(stderr, "Failed to write %s\n", path);
+}
+
+static bool openLog(void) {
+  char path[PATH_LENGTH];
+  snprintf(path, sizeof(path), "%s/%s", g_board.dir, RUNS_FILE);
+
+  runs_Header header = {};
+  g_board.stream     = fopen(path, "r+b");
+  if (g_board.stream == nullptr) {
+    header = (runs_Header) { .version = RUNS_VERSION, .recordSize = sizeof(runs_Record) };
+    memcpy(header.magic, RUNS_MAGIC, sizeof(header.magic));
+    g_board.stream = fopen(path, "w+b");
+    if (g_board.stream == nullptr || fwrite(&header, sizeof(header), 1, g_board.stream) != 1 ||
+        fflush(g_board.stream) != 0) {
+      fprintf(stderr, "Unable to create %s\n", path);
+      return false;
+    }
+    return true;
+  }
+
+  if (fread(&header, sizeof(header), 1, g_board.stream) != 1 ||
+      memcmp(header.magic, RUNS_MAGIC, sizeof(header.magic)) != 0 || header.version != RUNS_VERSION ||
+      header.recordSize != sizeof(runs_Record)) {
+    fprintf(stderr, "%s isn't a run log from this version\n", path);
+    return false;
+  }
+
+  // A record cut short is written over by the next snapshot
+  runs_Record record;
+  while (fread(&record, sizeof(record), 1, g_board.stream) == 1) {
+    if (!addRecord(&record)) {
+      fprintf(stderr, "Out of memory loading %s\n", path);
+      return false;
+    }
+  }
+  g_board.savedCount = g_board.recordCount;
+  printf("Loaded %u runs from %s\n", g_board.recordCount, path);
+  return true;
+}
+
+// The log is append only, so a snapshot is the runs since the last one
+static void writeSnapshot(void) {
+  if (g_board.savedCount == g_board.recordCount) return;
+
+  long   offset  = (long) (sizeof(runs_Header) + (size_t) g_board.savedCount * sizeof(runs_Record));
+  size_t count   = g_board.recordCount - g_board.savedCount;
+  bool   isSaved = fseek(g_board.stream, offset, SEEK_SET) == 0 &&
+                 fwrite(&g_board.records[g_board.savedCount], sizeof(runs_Record), count, g_board.stream) == count &&
+                 fflush(g_board.stream) == 0 && fsync(fileno(g_board.stream)) == 0;
+  if (!isSaved) {
+    fprintf(stderr, "Failed to write %zu runs to %s, will try again\n", count, RUNS_FILE);
+    return;
+  }
+  g_board.savedCount = g_board.recordCount;
+}
+
+static bool handleSubmit(leaderboard_Client* client, const unsigned char* payload, size_t size) {
+  uint32_t count;
+  if (size < sizeof(count)) return false;
+  memcpy(&count, payload, sizeof(count));
+
+  size_t   offset   = sizeof(count);
+  uint32_t accepted = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    leaderboard_Run run;
+    if (size - offset < sizeof(run)) return false;
+    memcpy(&run, payload + offset, sizeof(run));
+    offset += sizeof(run);
+    if (run.replaySize > size - offset) return false;
+
+    const unsigned char* replay = payload + offset;
+    offset                     += run.replaySize;
+    if (!isValidRun(&run.record, replay, run.replaySize)) continue;
+
+    uint32_t number = g_board.recordCount;
+    if (!addRecord(&run.record)) return false;
+    if (run.replaySize > 0) saveReplay(number, replay, run.replaySize);
+    accepted++;
+  }
+
+  leaderboard_Ack ack = { .accepted = accepted };
+  return queueMessage(client, LEADERBOARD_ACK, &ack, sizeof(ack));
+}
+
+static bool handleQuery(leaderboard_Client* client, const unsigned char* payload, size_t size) {
+  leaderboard_Query query;
+  if (size != sizeof(query)) return false;
+  memcpy(&query, payload, sizeof(query));
+  if (query.sort >= RUNS_SORT_COUNT) return false;
+
+  const leaderboard_Board* board = findBoard(makeKey(query.player, query.difficulty, query.level, query.sort), false);
+  struct {
+    leaderboard_Top top;
+    runs_Record     runs[LEADERBOARD_MAX_TOP];
+  } reply = {};
+  if (board != nullptr) {
+    reply.top.total = board->total;
+    reply.top.count = query.count < (uint32_t) board->topCount ? query.count : (uint32_t) board->topCount;
+    for (uint32_t i = 0; i < reply.top.count; i++) reply.runs[i] = g_board.records[board->top[i]];
+  }
+  return queueMessage(client, LEADERBOARD_TOP, &reply, sizeof(reply.top) + reply.top.count * sizeof(runs_Record));
+}
+
+static void dropClient(leaderboard_Client* client) {
+  close(client->fd);
+  free(client->input.data);
+  free(client->output.data);
+  *client = (leaderboard_Client) { .fd = -1 };
+}
+
+static bool isWouldBlock(void) { return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR; }
+
+// Handles every whole message in the input while there's room for the replies, false if the client broke the protocol
+static bool handleMessages(leaderboard_Client* client) {
+  while (client->input.size >= sizeof(leaderboard_Header) && client->output.size < MAX_PENDING) {
+    leaderboard_Header header;
+    memcpy(&header, client->input.data, sizeof(header));
+    if (!leaderboard_isValidHeader(&header)) return false;
+    size_t messageSize = sizeof(header) + header.size;
+    if (client->input.size < messageSize) break;
+
+    const unsigned char* payload = client->input.data + sizeof(header);
+    bool                 isOk    = header.type == LEADERBOARD_SUBMIT ? handleSubmit(client, payload, header.size)
+                                   : header.type == LEADERBOARD_QUERY ? handleQuery(client, payload, header.size)
+                                                                      : false;
+    if (!isOk) return false;
+    consume(&client->input, messageSize);
+  }
+  return true;
+}
+
+// False if the client went away
+static bool readClient(leaderboard_Client* client) {
+  if (!reserve(&client->input, READ_SIZE)) return false;
+  ssize_t received = recv(client->fd, client->input.data + client->input.size, READ_SIZE, 0);
+  if (received < 0) return isWouldBlock();
+  if (received == 0) return false;
+  client->input.size += received;
+  return handleMessages(client);
+}
+
+// Sends what the socket will take, then picks up any requests left waiting on room for their replies
+static bool writeClient(leaderboard_Client* client) {
+  ssize_t sent = send(client->fd, client->output.data, client->output.size, MSG_NOSIGNAL);
+  if (sent < 0) return isWouldBlock();
+  consume(&client->output, sent);
+  return handleMessages(client);
+}
+
+static void acceptClient(int listener) {
+  int fd = accept(listener, nullptr, nullptr);
+  if (fd == -1) return;
+
+  for (int i = 0; i < MAX_CLIENTS; i++) {
+    if (g_clients[i].fd == -1 && fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) == 0) {
+      g_clients[i].fd = fd;
+      return;
+    }
+  }
+  fprintf(stderr, "Too many clients, dropping a connection\n");
+  close(fd);
+}
+
+static int serve(const char* dir, const char* address) {
+  g_board.dir = dir;
+  char replayDir[PATH_LENGTH];
+  snprintf(replayDir, sizeof(replayDir), "%s/%s", dir, REPLAY_DIR);
+  if ((mkdir(dir, 0755) != 0 && errno != EEXIST) || (mkdir(replayDir, 0755) != 0 && errno != EEXIST)) {
+    fprintf(stderr, "Unable to create %s\n", replayDir);
+    return 1;
+  }
+  if (!openLog()) return 1;
+
+  int listener = openSocket(address, true);
+  if (listener == -1) return 1;
+  for (int i = 0; i < MAX_CLIENTS; i++) g_clients[i].fd = -1;
+  signal(SIGPIPE, SIG_IGN);
+  signal(SIGINT, quit);
+  signal(SIGTERM, quit);
+  printf("Serving %d boards\n", g_board.boardCount);
+
+  int64_t lastSnapshot = getMilliseconds();
+  while (!g_isQuitting) {
+    struct pollfd fds[MAX_CLIENTS + 1] = { { .fd = listener, .events = POLLIN } };
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+      const leaderboard_Client* client = &g_clients[i];
+      short events = (client->output.size < MAX_PENDING ? POLLIN : 0) | (client->output.size > 0 ? POLLOUT : 0);
+      fds[i + 1]   = (struct pollfd) { .fd = client->fd, .events = events };
+    }
+
+    int ready = poll(fds, MAX_CLIENTS + 1, SNAPSHOT_INTERVAL);
+    if (ready < 0 && errno != EINTR) {
+      fprintf(stderr, "poll failed (%s)\n", strerror(errno));
+      break;
+    }
+    for (int i = 0; ready > 0 && i < MAX_CLIENTS; i++) {
+      short revents = fds[i + 1].revents;
+      bool  isOk    = (revents & (POLLERR | POLLNVAL)) == 0;
+      if (isOk && (revents & POLLOUT)) isOk = writeClient(&g_clients[i]);
+      if (isOk && (revents & (POLLIN | POLLHUP))) isOk = readClient(&g_clients[i]);
+      if (!isOk) dropClient(&g_clients[i]);
+    }
+    if (ready > 0 && (fds[0].revents & POLLIN)) acceptClient(listener);
+
+    if (getMilliseconds() - lastSnapshot >= SNAPSHOT_INTERVAL) {
+      writeSnapshot();
+      lastSnapshot = getMilliseconds();
+    }
+  }
+
+  writeSnapshot();
+  for (int i = 0; i < MAX_CLIENTS; i++) {
+    if (g_clients[i].fd != -1) dropClient(&g_clients[i]);
+  }
+  close(listener);
+  fclose(g_board.stream);
+  printf("Saved %u runs\n", g_board.savedCount);
+  return 0;
+}
+
+static int parseDifficulty(const char* name) {
+  for (int i = 0; i < DIFFICULTY_COUNT; i++) {
+    if (strcmp(name, DIFFICULTY_NAMES[i]) == 0) return i;
+  }
+  return -1;
+}
+
+static int parseSort(const char* name) {
+  for (int i = 0; i < RUNS_SORT_COUNT; i++) {
+    if (strcmp(name, SORT_NAMES[i]) == 0) return i;
+  }
+  return -1;
+}
+
+static int top(int argc, char* argv[]) {
+  int difficulty = parseDifficulty(argv[2]);
+  int level      = strcmp(argv[3], "full") == 0 ? RUNS_FULL_RUN : atoi(argv[3]) - 1;
+  int sort       = parseSort(argv[4]);
+  int count      = argc > 5 ? atoi(argv[5]) : 10;
+  if (difficulty == -1 || level < 0 || sort == -1 || count <= 0) {
+    fprintf(stderr, "Difficulty is easy, normal or arcade, level a number or full, sort time or score\n");
+    return 1;
+  }
+
+  int fd = openSocket(argc > 6 ? argv[6] : nullptr, false);
+  if (fd == -1) return 1;
+
+  leaderboard_Query query = {
+    .player     = RUNS_ALL_PLAYERS,
+    .level      = level,
+    .difficulty = difficulty,
+    .sort       = sort,
+    .count      = count
+  };
+  size_t         size  = 0;
+  unsigned char* reply = sendMessage(fd, LEADERBOARD_QUERY, &query, sizeof(query))
+                             ? receiveMessage(fd, LEADERBOARD_TOP, &size)
+                             : nullptr;
+  close(fd);
+  leaderboard_Top result;
+  if (reply == nullptr || size < sizeof(result)) {
+    fprintf(stderr, "No reply from the leaderboard\n");
+    free(reply);
+    return 1;
+  }
+  memcpy(&result, reply, sizeof(result));
+  if (size != sizeof(result) + (size_t) result.count * sizeof(runs_Record)) {
+    fprintf(stderr, "Bad reply from the leaderboard\n");
+    free(reply);
+    return 1;
+  }
+
+  printf("Rank        Time  Score  Lives  Player    Date\n");
+  for (uint32_t i = 0; i < result.count; i++) {
+    runs_Record run;
+    memcpy(&run, reply + sizeof(result) + i * sizeof(run), sizeof(run));
+    char      date[32];
+    time_t    seconds = (time_t) run.date;
+    struct tm local;
+    strftime(date, sizeof(date), "%Y-%m-%d %H:%M", localtime_r(&seconds, &local));
+    printf(
+        "%4u  %d:%06.3f  %5d  %5d  %08x  %s\n",
+        i + 1,
+        (int) run.time / 60,
+        fmod(run.time, 60.0),
+        run.score,
+        run.lives,
+        run.player,
+        date
+    );
+  }
+  printf("%u of %u runs\n", result.count, result.total);
+  free(reply);
+  return 0;
+}
+
+// Sends a cabinet's run log in batches, e.g. to seed a new leaderboard
+static int submit(int argc, char* argv[]) {
+  FILE* stream = fopen(argv[2], "rb");
+  if (stream == nullptr) {
+    fprintf(stderr, "Unable to open %s\n", argv[2]);
+    return 1;
+  }
+  runs_Header header;
+  if (fread(&header, sizeof(header), 1, stream) != 1 || memcmp(header.magic, RUNS_MAGIC, sizeof(header.magic)) != 0 ||
+      header.version != RUNS_VERSION || header.recordSize != sizeof(runs_Record)) {
+    fprintf(stderr, "%s isn't a run log from this version\n", argv[2]);
+    fclose(stream);
+    return 1;
+  }
+
+  int fd = openSocket(argc > 3 ? argv[3] : nullptr, false);
+  if (fd == -1) {
+    fclose(stream);
+    return 1;
+  }
+
+  // Packed by hand, the runs follow the count without padding
+  static unsigned char batch[sizeof(uint32_t) + SUBMIT_BATCH * sizeof(leaderboard_Run)];
+  uint32_t             sent     = 0;
+  uint32_t             accepted = 0;
+  bool                 isOk     = true;
+  while (isOk) {
+    uint32_t        count = 0;
+    leaderboard_Run run   = {};
+    while (count < SUBMIT_BATCH && fread(&run.record, sizeof(run.record), 1, stream) == 1) {
+      memcpy(batch + sizeof(count) + count * sizeof(run), &run, sizeof(run));
+      count++;
+    }
+    if (count == 0) break;
+    memcpy(batch, &count, sizeof(count));
+
+    size_t           messageSize = sizeof(count) + count * sizeof(leaderboard_Run);
+    size_t           size        = 0;
+    leaderboard_Ack* ack         = nullptr;
+    if (sendMessage(fd, LEADERBOARD_SUBMIT, batch, messageSize)) ack = receiveMessage(fd, LEADERBOARD_ACK, &size);
+    isOk = ack != nullptr && size == sizeof(*ack);
+    if (isOk) {
+      sent     += count;
+      accepted += ack->accepted;
+    }
+    free(ack);
+  }
+  close(fd);
+  fclose(stream);
+
+  printf("Submitted %u runs, %u accepted\n", sent, accepted);
+  if (!isOk) fprintf(stderr, "Lost the connection to the leaderboard\n");
+  return isOk ? 0 : 1;
+}
+
+// --- Main ---
+
+int main(int argc, char* argv[]) {
+  if (argc >= 3 && argc <= 4 && strcmp(argv[1], "serve") == 0) return serve(argv[2], argc > 3 ? argv[3] : nullptr);
+  if (argc >= 5 && argc <= 7 && strcmp(argv[1], "top") == 0) return top(argc, argv);
+  if (argc >= 3 && argc <= 4 && strcmp(argv[1], "submit") == 0) return submit(argc, argv);
+
+  fprintf(
+      stderr,
+      "Usage: %s serve DIR [[HOST:]PORT]\n"
+      "       %s top easy|normal|arcade LEVEL|full time|score [COUNT] [[HOST:]PORT]\n"
+      "       %s submit RUNS_FILE [[HOST:]PORT]\n",
+      argv[0],
+      argv[0],
+      argv[0]
+  );
+  return 1;
+}
@@ -0,0 +1,341 @@
+/*
+ * pack.c: Packs the asset directory into a single indexed file for the game to map at startup. Sounds and images are
+ * decoded here with raylib, as the game would decode them, so the game uses their samples and pixels in place.
+ *
+ * Usage: pack ASSET_DIR OUTPUT
+ *        pack --embed PACK OUTPUT.c
+ */
+
+#include <dirent.h>
+#include <pack/format.h>
+#include <raylib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+// --- Constants ---
+
+constexpr size_t PATH_LENGTH = 1024;
+
+// Music is streamed from disk while playing, so stays a loose file
+static const char* SKIP_DIRS[]       = { "music" };
+static const char* SKIP_EXTENSIONS[] = { ".pack" };
+
+// Sounds are only packed decoded, images are also packed as the file for the engine, which loads them by name
+static const char* SOUND_EXTENSIONS[] = { ".wav", ".mp3", ".ogg", ".flac", ".qoa" };
+static const char* IMAGE_EXTENSIONS[] = { ".png" };
+
+// --- Types ---
+
+typedef struct pack_File {
+  pack_Entry     entry;
+  char           path[PATH_LENGTH];
+  unsigned char* data;  // Decoded, or null to copy the file
+} pack_File;
+
+// --- Global state ---
+
+// Grown as the directory is walked, a catalog of hundreds of levels has as many files
+static pack_File* g_files;
+static int        g_fileCount;
+static int        g_fileCapacity;
+
+// --- Helper functions ---
+
+static bool hasExtension(const char* name, const char* extensions[], size_t count) {
+  const char* extension = strrchr(name, '.');
+  if (extension == nullptr) return false;
+  for (size_t i = 0; i < count; i++) {
+    if (strcmp(extension, extensions[i]) == 0) return true;
+  }
+  return false;
+}
+
+static bool isSkipped(const char* name, bool isDir) {
+  if (isDir) {
+    for (size_t i = 0; i < sizeof(SKIP_DIRS) / sizeof(SKIP_DIRS[0]); i++) {
+      if (strcmp(name, SKIP_DIRS[i]) == 0) return true;
+    }
+    return false;
+  }
+  return hasExtension(name, SKIP_EXTENSIONS, sizeof(SKIP_EXTENSIONS) / sizeof(SKIP_EXTENSIONS[0]));
+}
+
+static pack_File* newFile(const char* name, const char* path, pack_Type type) {
+  if (g_fileCount == g_fileCapacity) {
+    int        capacity = g_fileCapacity > 0 ? 2 * g_fileCapacity : 256;
+    pack_File* files    = realloc(g_files, capacity * sizeof(pack_File));
+    if (files == nullptr) {
+      fprintf(stderr, "Out of memory adding %s\n", name);
+      return nullptr;
+    }
+    g_files        = files;
+    g_fileCapacity = capacity;
+  }
+
+  pack_File* file = &g_files[g_fileCount++];
+  *file           = (pack_File) { .entry = { .type = type } };
+  strcpy(file->entry.name, name);
+  strcpy(file->path, path);
+  return file;
+}
+
+// The entry is the header followed by the samples or pixels
+static bool storeDecoded(pack_File* file, const void* header, size_t headerSize, const void* data, size_t size) {
+  if (headerSize + size > UINT32_MAX) {
+    fprintf(stderr, "Decoded %s is too large\n", file->path);
+    return false;
+  }
+  file->data = malloc(headerSize + size);
+  if (file->data == nullptr) {
+    fprintf(stderr, "Out of memory decoding %s\n", file->path);
+    return false;
+  }
+  memcpy(file->data, header, headerSize);
+  memcpy(file->data + headerSize, data, size);
+  file->entry.size = headerSize + size;
+  return true;
+}
+
+static bool decodeWave(pack_File* file) {
+  Wave wave = LoadWave(file->path);
+  if (wave.data == nullptr) {
+    fprintf(stderr, "Unable to decode %s\n", file->path);
+    return false;
+  }
+
+  size_t    size   = (size_t) wave.frameCount * wave.channels * (wave.sampleSize / 8);
+  pack_Wave header = {
+    .frameCount = wave.frameCount,
+    .sampleRate = wave.sampleRate,
+    .sampleSize = wave.sampleSize,
+    .channels   = wave.channels
+  };
+  bool isOk = storeDecoded(file, &header, sizeof(header), wave.data, size);
+  UnloadWave(wave);
+  return isOk;
+}
+
+// Converted to the one format the game takes packed images in
+static bool decodeImage(pack_File* file) {
+  Image image = LoadImage(file->path);
+  if (image.data != nullptr) ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+  if (image.data == nullptr) {
+    fprintf(stderr, "Unable to decode %s\n", file->path);
+    return false;
+  }
+
+  pack_Image header = { .width = image.width, .height = image.height };
+  bool       isOk   = storeDecoded(file, &header, sizeof(header), image.data, (size_t) image.width * image.height * 4);
+  UnloadImage(image);
+  return isOk;
+}
+
+static bool addFile(const char* name, const char* path, off_t size) {
+  if (strlen(name) >= PACK_NAME_LENGTH || size > UINT32_MAX) {
+    fprintf(stderr, "Name too long, or file too large: %s\n", name);
+    return false;
+  }
+
+  bool isSound = hasExtension(name, SOUND_EXTENSIONS, sizeof(SOUND_EXTENSIONS) / sizeof(SOUND_EXTENSIONS[0]));
+  bool isImage = hasExtension(name, IMAGE_EXTENSIONS, sizeof(IMAGE_EXTENSIONS) / sizeof(IMAGE_EXTENSIONS[0]));
+  if (!isSound) {
+    pack_File* file = newFile(name, path, PACK_FILE);
+    if (file == nullptr) return false;
+    file->entry.size = size;
+  }
+  if (isSound || isImage) {
+    pack_File* file = newFile(name, path, isSound ? PACK_WAVE : PACK_IMAGE);
+    if (file == nullptr) return false;
+    return isSound ? decodeWave(file) : decodeImage(file);
+  }
+  return true;
+}
+
+static void freeFiles(void) {
+  for (int i = 0; i < g_fileCount; i++) free(g_files[i].data);
+  free(g_files);
+}
+
+// Walks the directory, naming each file by its path relative to the asset directory
+static bool addDirectory(const char* root, const char* relative) {
+  char dirPath[PATH_LENGTH];
+  snprintf(dirPath, sizeof(dirPath), "%s%s%s", root, *relative ? "/" : "", relative);
+
+  DIR* dir = opendir(dirPath);
+  if (dir == nullptr) {
+    fprintf(stderr, "Unable to open directory %s\n", dirPath);
+    return false;
+  }
+
+  bool           isOk = true;
+  struct dirent* item;
+  while (isOk && (item = readdir(dir)) != nullptr) {
+    if (item->d_name[0] == '.') continue;
+
+    char name[PATH_LENGTH];
+    char path[PATH_LENGTH];
+    int  nameLength = snprintf(name, sizeof(name), "%s%s%s", relative, *relative ? "/" : "", item->d_name);
+    int  pathLength = snprintf(path, sizeof(path), "%s/%s", root, name);
+
+    struct stat info;
+    if (nameLength >= (int) sizeof(name) || pathLength >= (int) sizeof(path)) {
+      fprintf(stderr, "Path too long: %s\n", name);
+      isOk = false;
+    } else if (stat(path, &info) != 0) {
+      fprintf(stderr, "Unable to stat %s\n", path);
+      isOk = false;
+    } else if (S_ISDIR(info.st_mode)) {
+      if (!isSkipped(item->d_name, true)) isOk = addDirectory(root, name);
+    } else if (!isSkipped(item->d_name, false)) {
+      isOk = addFile(name, path, info.st_size);
+    }
+  }
+
+  closedir(dir);
+  return isOk;
+}
+
+// The game binary searches the index, by name then type
+static int compareFiles(const void* a, const void* b) {
+  const pack_Entry* entryA = &((const pack_File*) a)->entry;
+  const pack_Entry* entryB = &((const pack_File*) b)->entry;
+  int               order  = strcmp(entryA->name, entryB->name);
+  return order != 0 ? order : (int) entryA->type - (int) entryB->type;
+}
+
+static uint32_t align(uint32_t offset) { return (offset + PACK_ALIGNMENT - 1) / PACK_ALIGNMENT * PACK_ALIGNMENT; }
+
+static bool copyFile(FILE* out, const pack_File* file) {
+  FILE* in = fopen(file->path, "rb");
+  if (in == nullptr) {
+    fprintf(stderr, "Unable to open %s\n", file->path);
+    return false;
+  }
+
+  unsigned char buffer[65536];
+  size_t        total = 0;
+  size_t        count;
+  while ((count = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+    if (fwrite(buffer, 1, count, out) != count) {
+      fprintf(stderr, "Failed to copy %s\n", file->path);
+      fclose(in);
+      return false;
+    }
+    total += count;
+  }
+  bool isRead = !ferror(in);
+  fclose(in);
+
+  if (!isRead) {
+    fprintf(stderr, "Failed to read %s\n", file->path);
+    return false;
+  }
+  if (total != file->entry.size) {
+    fprintf(stderr, "Size of %s changed while packing\n", file->path);
+    return false;
+  }
+  return true;
+}
+
+// Offsets are 32 bits, so the whole pack has to fit in 4 GiB
+static bool writePack(const char* output) {
+  uint64_t offset = align(sizeof(pack_Header) + g_fileCount * sizeof(pack_Entry));
+  for (int i = 0; i < g_fileCount; i++) {
+    if (offset > UINT32_MAX) break;
+    g_files[i].entry.offset = offset;
+    offset                  = align(offset + g_files[i].entry.size);
+  }
+  if (offset > UINT32_MAX) {
+    fprintf(stderr, "Too much to pack into %s, over 4 GiB\n", output);
+    return false;
+  }
+
+  FILE* out = fopen(output, "wb");
+  if (out == nullptr) {
+    fprintf(stderr, "Unable to open %s for writing\n", output);
+    return false;
+  }
+
+  pack_Header header = { .version = PACK_VERSION, .entryCount = g_fileCount };
+  memcpy(header.magic, PACK_MAGIC, sizeof(header.magic));
+  bool isOk = fwrite(&header, sizeof(header), 1, out) == 1;
+  for (int i = 0; isOk && i < g_fileCount; i++) isOk = fwrite(&g_files[i].entry, sizeof(pack_Entry), 1, out) == 1;
+
+  static const unsigned char PADDING[PACK_ALIGNMENT] = {};
+  for (int i = 0; isOk && i < g_fileCount; i++) {
+    long   position = ftell(out);
+    size_t padding  = g_files[i].entry.offset - position;
+    isOk            = position != -1 && padding < PACK_ALIGNMENT && fwrite(PADDING, 1, padding, out) == padding;
+    if (isOk && g_files[i].data != nullptr) {
+      isOk = fwrite(g_files[i].data, 1, g_files[i].entry.size, out) == g_files[i].entry.size;
+    } else if (isOk) {
+      isOk = copyFile(out, &g_files[i]);
+    }
+  }
+
+  if (fclose(out) != 0 || !isOk) {
+    fprintf(stderr, "Failed to write %s\n", output);
+    remove(output);
+    return false;
+  }
+  printf("Packed %d entries, %u bytes, into %s\n", g_fileCount, (uint32_t) offset, output);
+  return true;
+}
+
+// The pack as a byte array, for GAME_EMBED_ASSETS builds to compile into the game
+static bool writeSource(const char* packFile, const char* output) {
+  FILE* in = fopen(packFile, "rb");
+  if (in == nullptr) {
+    fprintf(stderr, "Unable to open %s\n", packFile);
+    return false;
+  }
+  FILE* out = fopen(output, "w");
+  if (out == nullptr) {
+    fprintf(stderr, "Unable to open %s for writing\n", output);
+    fclose(in);
+    return false;
+  }
+
+  // Errors stick to the stream, so are checked once at the end
+  fprintf(out, "// Generated from %s by the pack tool, don't edit\n\n#include <stddef.h>\n\n", packFile);
+  fprintf(out, "alignas(%u) const unsigned char pack_embeddedData[] = {", PACK_ALIGNMENT);
+  size_t total = 0;
+  int    byte;
+  while ((byte = fgetc(in)) != EOF) {
+    fprintf(out, total % 16 == 0 ? "\n  0x%02x," : " 0x%02x,", byte);
+    total++;
+  }
+  fprintf(out, "\n};\nconst size_t pack_embeddedSize = sizeof(pack_embeddedData);\n");
+  bool isOk = !ferror(in) && !ferror(out);
+  fclose(in);
+
+  if (fclose(out) != 0 || !isOk || total < sizeof(pack_Header)) {
+    fprintf(stderr, "Failed to write %s\n", output);
+    remove(output);
+    return false;
+  }
+  printf("Embedded %zu bytes from %s into %s\n", total, packFile, output);
+  return true;
+}
+
+// --- Main ---
+
+int main(int argc, char* argv[]) {
+  if (argc == 4 && strcmp(argv[1], "--embed") == 0) return writeSource(argv[2], argv[3]) ? 0 : 1;
+  if (argc != 3) {
+    fprintf(stderr, "Usage: %s ASSET_DIR OUTPUT\n       %s --embed PACK OUTPUT.c\n", argv[0], argv[0]);
+    return 1;
+  }
+
+  SetTraceLogLevel(LOG_WARNING);
+  bool isOk = addDirectory(argv[1], "");
+  if (isOk) {
+    qsort(g_files, g_fileCount, sizeof(g_files[0]), compareFiles);
+    isOk = writePack(argv[2]);
+  }
+  freeFiles();
+  return isOk ? 0 : 1;
+}